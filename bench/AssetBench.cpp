@@ -0,0 +1,279 @@
+#include "AssetPack.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+using Clock = std::chrono::steady_clock;
+
+struct AssetBenchOptions
+{
+    std::string directory = "asset_bench_data";
+    uint32_t assets = 4096;
+    uint32_t iterations = 10;
+    // Asset sizes are log-uniform in this range
+    uint32_t minSize = 512;
+    uint32_t maxSize = 128 * 1024;
+};
+
+
+static double elapsedMs(const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+
+static double median(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+// Reads every byte, a mapping is only paged in when touched
+static uint64_t checksum(const ByteView bytes)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < bytes.size; i++)
+    {
+        sum += static_cast<uint8_t>(bytes.data[i]);
+    }
+    return sum;
+}
+
+
+static std::string assetName(const uint32_t index)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "loose/asset_%05u.bin", index);
+    return name;
+}
+
+
+// Half the assets repeat words from a small vocabulary like SPIR-V or index data, the other half are noise
+static std::vector<char> generateAsset(std::mt19937& rng, const AssetBenchOptions& options, const uint32_t index)
+{
+    std::uniform_real_distribution<double> logSize(std::log(static_cast<double>(options.minSize)), std::log(static_cast<double>(options.maxSize)));
+    std::vector<char> data(static_cast<size_t>(std::exp(logSize(rng))) / 4 * 4);
+    
+    std::uniform_int_distribution<uint32_t> word(0, UINT32_MAX);
+    std::vector<uint32_t> vocabulary(64);
+    for (uint32_t& entry : vocabulary)
+    {
+        entry = word(rng) & 0xffff;
+    }
+    
+    for (size_t i = 0; i < data.size(); i += 4)
+    {
+        const uint32_t value = index % 2 == 0 ? vocabulary[word(rng) % vocabulary.size()] : word(rng);
+        std::memcpy(data.data() + i, &value, sizeof(value));
+    }
+    
+    return data;
+}
+
+
+// Drops the files from the page cache, where the platform allows it without privileges
+static bool evictFiles(const std::vector<std::string>& paths)
+{
+#ifdef POSIX_FADV_DONTNEED
+    for (const auto& path : paths)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0 || posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            return false;
+        }
+        close(fd);
+    }
+    return true;
+#else
+    (void)paths;
+    return false;
+#endif
+}
+
+
+static void writeFile(const std::string& path, const std::vector<char>& data)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file.good())
+    {
+        throw std::runtime_error("Failed to write " + path + "!");
+    }
+}
+
+
+static bool parseOptions(int argc, char** argv, AssetBenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--directory" && hasValue)
+        {
+            options.directory = argv[++i];
+        } else if (arg == "--assets" && hasValue)
+        {
+            options.assets = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--iterations" && hasValue)
+        {
+            options.iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--max-size" && hasValue)
+        {
+            options.maxSize = static_cast<uint32_t>(std::max(static_cast<int>(options.minSize), std::atoi(argv[++i])));
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+// Time to load every asset from loose files with utils::readFile, from a mapped pack of stored entries and from
+// one of LZ4 entries. Cold runs evict the files from the page cache first, warm runs follow a cold one
+int main(int argc, char** argv)
+{
+    AssetBenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--directory DIR] [--assets N] [--iterations N] [--max-size BYTES]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    const std::string storedPack = options.directory + "/stored.vpak";
+    const std::string lz4Pack = options.directory + "/lz4.vpak";
+    std::vector<std::string> names;
+    std::vector<std::string> loosePaths;
+    uint64_t totalBytes = 0;
+    uint64_t expectedSum = 0;
+    
+    try
+    {
+        mkdir(options.directory.c_str(), 0755);
+        mkdir((options.directory + "/loose").c_str(), 0755);
+        
+        std::mt19937 rng(42);
+        std::vector<PackedAsset> stored;
+        std::vector<PackedAsset> compressed;
+        for (uint32_t i = 0; i < options.assets; i++)
+        {
+            const std::vector<char> data = generateAsset(rng, options, i);
+            names.push_back(assetName(i));
+            loosePaths.push_back(options.directory + "/" + names.back());
+            totalBytes += data.size();
+            expectedSum += checksum(data);
+            
+            writeFile(loosePaths.back(), data);
+            stored.push_back(assets::packAsset(names.back(), data, AssetCompression::None));
+            compressed.push_back(assets::packAsset(names.back(), data, AssetCompression::Lz4));
+        }
+        
+        assets::writePack(storedPack, stored);
+        assets::writePack(lz4Pack, compressed);
+    } catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    sync();
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "[assets] " << options.assets << " assets, " << totalBytes / (1024.0 * 1024.0) << " MB in " << options.directory << std::endl;
+    
+    const auto loadLoose = [&]()
+    {
+        uint64_t sum = 0;
+        for (const auto& path : loosePaths)
+        {
+            sum += checksum(utils::readFile(path));
+        }
+        return sum;
+    };
+    
+    const auto loadPack = [&](const std::string& path)
+    {
+        AssetPack pack;
+        pack.openPack(path);
+        uint64_t sum = 0;
+        for (const auto& name : names)
+        {
+            sum += checksum(pack.getAsset(name));
+        }
+        pack.closePack();
+        return sum;
+    };
+    
+    struct Variant
+    {
+        const char* name;
+        std::vector<std::string> files;
+        std::function<uint64_t()> load;
+    };
+    const Variant variants[] = {
+        {"loose files", loosePaths, loadLoose},
+        {"pack, stored", {storedPack}, [&]() { return loadPack(storedPack); }},
+        {"pack, lz4", {lz4Pack}, [&]() { return loadPack(lz4Pack); }},
+    };
+    
+    bool matches = true;
+    for (const Variant& variant : variants)
+    {
+        std::vector<double> cold;
+        std::vector<double> warm;
+        for (uint32_t i = 0; i < options.iterations; i++)
+        {
+            if (evictFiles(variant.files))
+            {
+                const auto start = Clock::now();
+                matches &= variant.load() == expectedSum;
+                cold.push_back(elapsedMs(start));
+            }
+            
+            const auto start = Clock::now();
+            matches &= variant.load() == expectedSum;
+            warm.push_back(elapsedMs(start));
+        }
+        
+        std::cout << "[assets]   " << variant.name << ": cold ";
+        if (cold.empty())
+        {
+            std::cout << "n/a";
+        } else
+        {
+            std::cout << median(cold) << " ms";
+        }
+        std::cout << ", warm " << median(warm) << " ms" << std::endl;
+    }
+    
+    if (!matches)
+    {
+        std::cerr << "Loaded assets differ from the generated ones!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+
+using Clock = std::chrono::steady_clock;
+
+struct CullingBenchOptions
+{
+    uint32_t minObjects = 10000;
+    uint32_t maxObjects = 10000000;
+    uint32_t iterations = 20;
+    uint32_t workers = CULL_WORKERS;
+    // Objects moved before each refit, as a fraction of the scene
+    float movedFraction = 0.01f;
+};
+
+constexpr float WORLD_EXTENT = 1000.0f;
+
+
+static double elapsedMs(const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+
+static double median(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+static Bounds randomBounds(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-WORLD_EXTENT, WORLD_EXTENT);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    
+    Bounds box;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        box.min[axis] = position(rng);
+        box.max[axis] = box.min[axis] + size(rng);
+    }
+    
+    return box;
+}
+
+
+// Camera at the centre of the scene, turning a little every iteration
+static Frustum cameraFrustum(const uint32_t iteration)
+{
+    const float angle = 0.1f * static_cast<float>(iteration);
+    const float eye[3] = {0.0f, 0.0f, 0.0f};
+    const float forward[3] = {std::sin(angle), 0.0f, std::cos(angle)};
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    
+    return Frustum::fromPerspective(eye, forward, up, 1.0472f, 16.0f / 9.0f, 0.1f, WORLD_EXTENT);
+}
+
+
+static bool sameSet(std::vector<uint32_t> visible, const std::vector<uint32_t>& reference)
+{
+    std::sort(visible.begin(), visible.end());
+    return visible == reference;
+}
+
+
+static bool benchObjectCount(const CullingBenchOptions& options, const uint32_t objectCount)
+{
+    std::mt19937 rng(objectCount);
+    std::vector<Bounds> bounds(objectCount);
+    for (auto& box : bounds)
+    {
+        box = randomBounds(rng);
+    }
+    
+    FrustumCuller culler;
+    
+    auto start = Clock::now();
+    culler.build(bounds);
+    const double buildMs = elapsedMs(start);
+    
+    // Incremental refit after moving a slice of the scene
+    const uint32_t movedCount = std::max(1u, static_cast<uint32_t>(objectCount * options.movedFraction));
+    std::uniform_int_distribution<uint32_t> pick(0, objectCount - 1);
+    for (uint32_t i = 0; i < movedCount; i++)
+    {
+        const uint32_t object = pick(rng);
+        bounds[object] = randomBounds(rng);
+        culler.setBounds(object, bounds[object]);
+    }
+    
+    start = Clock::now();
+    culler.refit();
+    const double refitMs = elapsedMs(start);
+    
+    std::vector<std::vector<uint32_t>> references(options.iterations);
+    std::vector<double> bruteSamples;
+    for (uint32_t i = 0; i < options.iterations; i++)
+    {
+        start = Clock::now();
+        FrustumCuller::cullBruteForce(bounds, cameraFrustum(i), references[i]);
+        bruteSamples.push_back(elapsedMs(start));
+    }
+    
+    std::cout << "[culling] " << objectCount << " objects, " << culler.getNodeCount() << " nodes, " << references[0].size() << " visible"
+              << ": build " << buildMs << " ms, refit of " << movedCount << " " << refitMs << " ms, brute force " << median(bruteSamples) << " ms" << std::endl;
+    
+    bool matches = true;
+    const SimdKernel best = simd::detectKernel();
+    
+    for (const SimdKernel kernel : {SimdKernel::Scalar, best})
+    {
+        for (const uint32_t workers : {0u, options.workers})
+        {
+            culler.setKernel(kernel);
+            culler.setupCuller(workers);
+            
+            std::vector<double> samples;
+            uint32_t mismatches = 0;
+            for (uint32_t i = 0; i < options.iterations; i++)
+            {
+                start = Clock::now();
+                const std::vector<uint32_t>& visible = culler.cull(cameraFrustum(i));
+                samples.push_back(elapsedMs(start));
+                
+                mismatches += sameSet(visible, references[i]) ? 0 : 1;
+            }
+            
+            culler.destroyCuller();
+            matches &= mismatches == 0;
+            
+            std::cout << "[culling]   " << simd::getKernelName(kernel) << ", " << workers + 1 << " threads: " << median(samples) << " ms"
+                      << (mismatches > 0 ? ", DIFFERS FROM BRUTE FORCE" : "") << std::endl;
+        }
+        
+        if (best == SimdKernel::Scalar)
+        {
+            break;
+        }
+    }
+    
+    return matches;
+}
+
+
+static bool parseOptions(int argc, char** argv, CullingBenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--min-objects" && hasValue)
+        {
+            options.minObjects = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--max-objects" && hasValue)
+        {
+            options.maxObjects = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--iterations" && hasValue)
+        {
+            options.iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--workers" && hasValue)
+        {
+            options.workers = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+// Culling time from 10k to 10M objects, every visible list checked against the brute force one
+int main(int argc, char** argv)
+{
+    CullingBenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--min-objects N] [--max-objects N] [--iterations N] [--workers N]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::cout << std::fixed << std::setprecision(3);
+    
+    bool matches = true;
+    for (uint32_t objectCount = options.minObjects; objectCount <= options.maxObjects; objectCount *= 10)
+    {
+        matches &= benchObjectCount(options, objectCount);
+    }
+    
+    if (!matches)
+    {
+        std::cerr << "BVH culling differs from the brute force reference!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,371 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using Clock = std::chrono::steady_clock;
+
+struct JobBenchOptions
+{
+    uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    uint32_t elements = 1 << 22;
+    uint32_t jobs = 1 << 18;
+    // Jobs spawning two children each, down to 2^depth leaves
+    uint32_t treeDepth = 16;
+    uint32_t iterations = 10;
+    bool pinThreads = JOB_PIN_THREADS;
+};
+
+// Spin iterations of one tiny job, about a hundred nanoseconds
+constexpr uint32_t TINY_JOB_WORK = 64;
+
+
+static double elapsedMs(const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+
+static double median(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+static uint32_t tinyWork(uint32_t seed)
+{
+    for (uint32_t i = 0; i < TINY_JOB_WORK; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+    }
+    return seed;
+}
+
+
+// The baseline: one std::deque of std::function behind one mutex, which every submit and every take goes through
+class MutexJobQueue
+{
+public:
+    MutexJobQueue() = default;
+    MutexJobQueue(const MutexJobQueue&) =  delete;
+    MutexJobQueue& operator=(const MutexJobQueue&) = delete;
+    MutexJobQueue(MutexJobQueue&&) = delete;
+    MutexJobQueue& operator=(MutexJobQueue&&) = delete;
+    
+    void setupQueue(const uint32_t workerCount)
+    {
+        running = true;
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back([this]
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    jobAvailable.wait(lock, [this] { return !jobs.empty() || !running; });
+                    if (!running)
+                    {
+                        return;
+                    }
+                    
+                    runFront(lock);
+                }
+            });
+        }
+    }
+    
+    void destroyQueue(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        jobAvailable.notify_all();
+        
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+    }
+    
+    void submit(std::function<void(void)> job)
+    {
+        pending.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        jobAvailable.notify_one();
+    }
+    
+    // The caller helps until every submitted job has run
+    void wait(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (pending.load() > 0)
+        {
+            if (jobs.empty())
+            {
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+                continue;
+            }
+            
+            runFront(lock);
+        }
+    }
+    
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void(void)>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::atomic<uint32_t> pending{0};
+    bool running = false;
+    
+    void runFront(std::unique_lock<std::mutex>& lock)
+    {
+        std::function<void(void)> job = std::move(jobs.front());
+        jobs.pop_front();
+        
+        lock.unlock();
+        job();
+        pending.fetch_sub(1);
+        lock.lock();
+    }
+};
+
+
+static void spawnTree(JobSystem& jobs, JobCounter& counter, std::atomic<uint32_t>& leaves, const uint32_t depth)
+{
+    if (depth == 0)
+    {
+        leaves.fetch_add(tinyWork(depth) != 0 ? 1 : 0, std::memory_order_relaxed);
+        return;
+    }
+    
+    for (uint32_t child = 0; child < 2; child++)
+    {
+        jobs.submit([&jobs, &counter, &leaves, depth]
+        {
+            spawnTree(jobs, counter, leaves, depth - 1);
+        }, &counter);
+    }
+}
+
+
+static void spawnTree(MutexJobQueue& queue, std::atomic<uint32_t>& leaves, const uint32_t depth)
+{
+    if (depth == 0)
+    {
+        leaves.fetch_add(tinyWork(depth) != 0 ? 1 : 0, std::memory_order_relaxed);
+        return;
+    }
+    
+    for (uint32_t child = 0; child < 2; child++)
+    {
+        queue.submit([&queue, &leaves, depth]
+        {
+            spawnTree(queue, leaves, depth - 1);
+        });
+    }
+}
+
+
+struct ThreadCountResult
+{
+    double parallelForMs = 0.0;
+    double flatMs = 0.0;
+    double flatMutexMs = 0.0;
+    double treeMs = 0.0;
+    double treeMutexMs = 0.0;
+    bool valid = true;
+};
+
+
+static ThreadCountResult benchThreadCount(const JobBenchOptions& options, const uint32_t threadCount, const std::vector<float>& input, std::vector<float>& output)
+{
+    ThreadCountResult result;
+    std::vector<double> parallelForSamples, flatSamples, flatMutexSamples, treeSamples, treeMutexSamples;
+    const uint32_t leafCount = 1u << options.treeDepth;
+    
+    JobSystem jobs;
+    jobs.setupJobSystem({threadCount - 1, options.pinThreads});
+    
+    for (uint32_t iteration = 0; iteration < options.iterations; iteration++)
+    {
+        // Parallel for: a few dozen flops per element, enough that memory bandwidth is not the limit
+        std::atomic<uint32_t> covered{0};
+        auto start = Clock::now();
+        jobs.parallelFor(0, options.elements, 1024, [&](const uint32_t begin, const uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                float value = input[i];
+                for (uint32_t step = 0; step < 8; step++)
+                {
+                    value = std::sqrt(value * value + 1.0f) * 0.5f;
+                }
+                output[i] = value;
+            }
+            covered.fetch_add(end - begin, std::memory_order_relaxed);
+        });
+        parallelForSamples.push_back(elapsedMs(start));
+        result.valid &= covered.load() == options.elements;
+        
+        // Flat: the calling thread submits every job, the others can only steal
+        std::atomic<uint32_t> flatDone{0};
+        JobCounter counter;
+        start = Clock::now();
+        for (uint32_t i = 0; i < options.jobs; i++)
+        {
+            jobs.submit([&flatDone, i]
+            {
+                flatDone.fetch_add(tinyWork(i) != 0 ? 1 : 0, std::memory_order_relaxed);
+            }, &counter);
+        }
+        jobs.wait(counter);
+        flatSamples.push_back(elapsedMs(start));
+        result.valid &= flatDone.load() == options.jobs;
+        
+        // Tree: every job spawns its children, so work starts out on one thread and spreads by stealing
+        std::atomic<uint32_t> leaves{0};
+        JobCounter treeCounter;
+        start = Clock::now();
+        spawnTree(jobs, treeCounter, leaves, options.treeDepth);
+        jobs.wait(treeCounter);
+        treeSamples.push_back(elapsedMs(start));
+        result.valid &= leaves.load() == leafCount;
+    }
+    
+    jobs.destroyJobSystem();
+    
+    MutexJobQueue queue;
+    queue.setupQueue(threadCount - 1);
+    
+    for (uint32_t iteration = 0; iteration < options.iterations; iteration++)
+    {
+        std::atomic<uint32_t> flatDone{0};
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < options.jobs; i++)
+        {
+            queue.submit([&flatDone, i]
+            {
+                flatDone.fetch_add(tinyWork(i) != 0 ? 1 : 0, std::memory_order_relaxed);
+            });
+        }
+        queue.wait();
+        flatMutexSamples.push_back(elapsedMs(start));
+        result.valid &= flatDone.load() == options.jobs;
+        
+        std::atomic<uint32_t> leaves{0};
+        start = Clock::now();
+        spawnTree(queue, leaves, options.treeDepth);
+        queue.wait();
+        treeMutexSamples.push_back(elapsedMs(start));
+        result.valid &= leaves.load() == leafCount;
+    }
+    
+    queue.destroyQueue();
+    
+    result.parallelForMs = median(parallelForSamples);
+    result.flatMs = median(flatSamples);
+    result.flatMutexMs = median(flatMutexSamples);
+    result.treeMs = median(treeSamples);
+    result.treeMutexMs = median(treeMutexSamples);
+    return result;
+}
+
+
+static bool parseOptions(int argc, char** argv, JobBenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--max-threads" && hasValue)
+        {
+            options.maxThreads = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--elements" && hasValue)
+        {
+            options.elements = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--jobs" && hasValue)
+        {
+            options.jobs = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--tree-depth" && hasValue)
+        {
+            options.treeDepth = static_cast<uint32_t>(std::clamp(std::atoi(argv[++i]), 1, 24));
+        } else if (arg == "--iterations" && hasValue)
+        {
+            options.iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--pin")
+        {
+            options.pinThreads = true;
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+// Scaling of the job system from 1 to N threads, and its throughput on tiny jobs next to a mutex-guarded queue
+int main(int argc, char** argv)
+{
+    JobBenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--max-threads N] [--elements N] [--jobs N] [--tree-depth N] [--iterations N] [--pin]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::vector<float> input(options.elements);
+    std::vector<float> output(options.elements);
+    for (uint32_t i = 0; i < options.elements; i++)
+    {
+        input[i] = static_cast<float>(i % 1000) * 0.01f;
+    }
+    
+    const double jobCount = options.jobs;
+    // Inner nodes run as jobs too
+    const double treeJobCount = static_cast<double>((2u << options.treeDepth) - 2);
+    
+    bool valid = true;
+    double singleThreadMs = 0.0;
+    for (uint32_t threadCount = 1; threadCount <= options.maxThreads; threadCount++)
+    {
+        const ThreadCountResult result = benchThreadCount(options, threadCount, input, output);
+        if (threadCount == 1)
+        {
+            singleThreadMs = result.parallelForMs;
+        }
+        valid &= result.valid;
+        
+        std::cout << std::fixed << std::setprecision(2)
+                  << "[jobs] " << threadCount << (threadCount == 1 ? " thread" : " threads") << ": parallel for " << result.parallelForMs << " ms ("
+                  << singleThreadMs / result.parallelForMs << "x), flat " << jobCount / (result.flatMs * 1000.0) << " vs mutex "
+                  << jobCount / (result.flatMutexMs * 1000.0) << " M jobs/s, tree " << treeJobCount / (result.treeMs * 1000.0) << " vs mutex "
+                  << treeJobCount / (result.treeMutexMs * 1000.0) << " M jobs/s" << (result.valid ? "" : ", JOBS LOST") << std::endl;
+    }
+    
+    return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,177 @@
+#include "TransformSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+
+using Clock = std::chrono::steady_clock;
+
+struct TransformBenchOptions
+{
+    uint32_t nodes = 1000000;
+    uint32_t iterations = 50;
+    // Roots of the generated hierarchy, every later node has one of the previous level as parent
+    uint32_t roots = 1024;
+    uint32_t children = 4;
+};
+
+
+// Random local transforms in a fixed-fanout hierarchy, generated in level order
+static void buildHierarchy(const TransformBenchOptions& options, TransformSystem& transforms)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+    
+    transforms.reserve(options.nodes);
+    
+    for (uint32_t node = 0; node < options.nodes; node++)
+    {
+        Transform local;
+        for (int i = 0; i < 3; i++)
+        {
+            local.position[i] = unit(rng);
+            local.scale[i] = scale(rng);
+        }
+        
+        float length = 0.0f;
+        for (int i = 0; i < 4; i++)
+        {
+            local.rotation[i] = unit(rng);
+            length += local.rotation[i] * local.rotation[i];
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            local.rotation[i] /= std::sqrt(length);
+        }
+        
+        const uint32_t parent = node < options.roots ? TransformSystem::NO_PARENT : (node - options.roots) / options.children;
+        transforms.addNode(parent, local);
+    }
+}
+
+
+static bool parseOptions(int argc, char** argv, TransformBenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--nodes" && hasValue)
+        {
+            options.nodes = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--iterations" && hasValue)
+        {
+            options.iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--children" && hasValue)
+        {
+            options.children = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+// Single-threaded, so the throughput is per core. Every SIMD kernel is checked against the scalar one
+int main(int argc, char** argv)
+{
+    TransformBenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--nodes N] [--iterations N] [--children N]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    TransformSystem transforms;
+    buildHierarchy(options, transforms);
+    
+    std::vector<InstanceTransform> reference(options.nodes);
+    std::vector<InstanceTransform> instances(options.nodes);
+    
+    std::cout << "[transforms] " << options.nodes << " nodes in " << transforms.getLevelCount() << " levels, "
+              << options.iterations << " iterations" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    
+    double scalarMedian = 0.0;
+    bool mismatch = false;
+    
+    for (const SimdKernel kernel : {SimdKernel::Scalar, SimdKernel::Sse, SimdKernel::Avx2, SimdKernel::Neon})
+    {
+        if (!simd::isKernelSupported(kernel))
+        {
+            continue;
+        }
+        
+        transforms.setKernel(kernel);
+        std::vector<InstanceTransform>& output = kernel == SimdKernel::Scalar ? reference : instances;
+        
+        // First pass faults the pages in
+        transforms.update(output.data());
+        
+        std::vector<double> samples;
+        for (uint32_t i = 0; i < options.iterations; i++)
+        {
+            const auto start = Clock::now();
+            transforms.update(output.data());
+            samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        
+        std::sort(samples.begin(), samples.end());
+        const double median = samples[samples.size() / 2];
+        if (kernel == SimdKernel::Scalar)
+        {
+            scalarMedian = median;
+        }
+        
+        // Relative to the largest element of the reference matrix once it grows past 1: deep chains reach values where
+        // an absolute 1e-3 is below float precision, and FMA rounding differs most in elements that cancel out
+        float maxError = 0.0f;
+        if (kernel != SimdKernel::Scalar)
+        {
+            for (uint32_t node = 0; node < options.nodes; node++)
+            {
+                float magnitude = 1.0f;
+                for (int row = 0; row < 3; row++)
+                {
+                    for (int column = 0; column < 4; column++)
+                    {
+                        magnitude = std::max(magnitude, std::fabs(reference[node].rows[row][column]));
+                    }
+                }
+                
+                for (int row = 0; row < 3; row++)
+                {
+                    for (int column = 0; column < 4; column++)
+                    {
+                        const float error = std::fabs(output[node].rows[row][column] - reference[node].rows[row][column]);
+                        maxError = std::max(maxError, error / magnitude);
+                    }
+                }
+            }
+        }
+        mismatch |= maxError > 1e-3f;
+        
+        std::cout << "[transforms] " << simd::getKernelName(kernel) << ": " << median << " ms, "
+                  << options.nodes / median * 1e-3 << " M transforms/s per core, " << scalarMedian / median << "x scalar"
+                  << std::scientific << ", max error " << maxError << std::fixed << std::endl;
+    }
+    
+    if (mismatch)
+    {
+        std::cerr << "SIMD transforms differ from the scalar ones!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
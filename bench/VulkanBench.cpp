@@ -0,0 +1,794 @@
+#include "VulkanProject.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t MAX_BENCH_VIEWS = 16;
+
+struct BenchOptions
+{
+    bool headless = false;
+    uint32_t iterations = 10;
+    uint32_t warmPipelines = 4;
+    uint32_t warmupFrames = 100;
+    uint32_t frames = 1000;
+    std::string outputPath = "vulkan_bench.json";
+    std::string baselinePath;
+    // Allowed relative growth of a median before it counts as a regression
+    double tolerance = 0.10;
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::vector<double> samples;
+    double min = 0.0;
+    double median = 0.0;
+    double mean = 0.0;
+    double p95 = 0.0;
+    double max = 0.0;
+};
+
+struct BenchReport
+{
+    std::string deviceName;
+    uint32_t apiVersion = 0;
+    uint32_t driverVersion = 0;
+    std::vector<BenchResult> results;
+    
+    BenchResult& add(const std::string& name)
+    {
+        for (auto& result : results)
+        {
+            if (result.name == name)
+            {
+                return result;
+            }
+        }
+        
+        results.push_back({});
+        results.back().name = name;
+        return results.back();
+    }
+};
+
+
+static double elapsedMs(const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+
+static void summarize(BenchResult& result)
+{
+    if (result.samples.empty())
+    {
+        return;
+    }
+    
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    
+    double sum = 0.0;
+    for (const double sample : sorted)
+    {
+        sum += sample;
+    }
+    
+    const size_t count = sorted.size();
+    result.min = sorted.front();
+    result.max = sorted.back();
+    result.mean = sum / static_cast<double>(count);
+    result.median = (count % 2 == 1) ? sorted[count / 2] : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+    result.p95 = sorted[std::min(count - 1, static_cast<size_t>(0.95 * static_cast<double>(count)))];
+}
+
+
+static void setPlatformHint(const bool headless)
+{
+    if (!headless)
+    {
+        return;
+    }
+
+#if GLFW_VERSION_MAJOR > 3 || GLFW_VERSION_MINOR >= 4
+    // GLFW_PLATFORM_NULL is new in 3.4, it hands out VK_EXT_headless_surface surfaces, which lavapipe supports
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+    throw std::runtime_error("Headless runs need GLFW 3.4 or newer!");
+#endif
+}
+
+
+static VkInstance createInstance(InstanceCapabilities& capabilities)
+{
+    stringVector extensions = Instance::getRequiredInstanceExtensions();
+    capabilities = Instance::negotiateCapabilities(extensions);
+    
+    VkApplicationInfo appInfo{};
+    Instance::populateApplicationInfo(appInfo, capabilities.apiVersion);
+    
+    VkInstanceCreateInfo createInfo{};
+    VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
+    Instance::populateInstanceCreateInfo(createInfo, appInfo, debugCreateInfo, extensions, capabilities);
+    
+    VkInstance instance;
+    if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create instance!");
+    }
+    
+    return instance;
+}
+
+
+// Same HDR scene pass as VulkanProject::createRenderPass, so pipelines built against it match what the app builds
+static VkRenderPass createRenderPass(const VkDevice device)
+{
+    VkAttachmentDescription colorAttachment{};
+    colorAttachment.format = POST_HDR_FORMAT;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    
+    VkAttachmentReference colorAttachmentRef{};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    
+    VkSubpassDependency dependencies[2]{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 2;
+    renderPassInfo.pDependencies = dependencies;
+    
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create render pass!");
+    }
+    
+    return renderPass;
+}
+
+
+static void benchInstance(const BenchOptions& options, BenchReport& report)
+{
+    BenchResult& result = report.add("instance_creation");
+    
+    for (uint32_t i = 0; i < options.iterations; i++)
+    {
+        InstanceCapabilities capabilities;
+        
+        const auto start = Clock::now();
+        const VkInstance instance = createInstance(capabilities);
+        result.samples.push_back(elapsedMs(start));
+        
+        vkDestroyInstance(instance, nullptr);
+    }
+}
+
+
+// Every iteration gets a fresh device, so the first pipeline it builds sees no driver-side state
+static void benchDevice(const BenchOptions& options, const VkInstance instance, const InstanceCapabilities& instanceCapabilities, Window& window, BenchReport& report)
+{
+    const std::vector<char> vertShaderCode = utils::readFile("shaders/vert.spv");
+    const std::vector<char> fragShaderCode = utils::readFile("shaders/frag.spv");
+    
+    for (uint32_t i = 0; i < options.iterations; i++)
+    {
+        Device device;
+        
+        auto start = Clock::now();
+        device.setupDevices(instance, instanceCapabilities, {window.getSurface()});
+        report.add("device_creation").samples.push_back(elapsedMs(start));
+        
+        const VkDevice logicalDevice = device.getLogicalDevice();
+        
+        if (report.deviceName.empty())
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+            report.deviceName = properties.deviceName;
+            report.apiVersion = properties.apiVersion;
+            report.driverVersion = properties.driverVersion;
+        }
+        
+        {
+            SwapChain swapChain;
+            
+            start = Clock::now();
+            swapChain.setupSwapChain(device.getPhysicalDevice(), logicalDevice, window.window, window.getSurface(), device.getQIndices());
+            swapChain.setupImageViews(logicalDevice);
+            report.add("swapchain_creation").samples.push_back(elapsedMs(start));
+            
+            swapChain.destroyImageViews(logicalDevice);
+            swapChain.destroySwapChain(logicalDevice);
+        }
+        
+        start = Clock::now();
+        const VkShaderModule vertShaderModule = Pipeline::createShaderModule(logicalDevice, vertShaderCode);
+        const VkShaderModule fragShaderModule = Pipeline::createShaderModule(logicalDevice, fragShaderCode);
+        report.add("shader_module_creation").samples.push_back(elapsedMs(start));
+        
+        vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
+        vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
+        
+        const VkRenderPass renderPass = createRenderPass(logicalDevice);
+        
+        // Reflection, layouts, module creation and pipeline build, without a VkPipelineCache. A fresh layout
+        // cache each time so the layouts are created again too
+        for (uint32_t p = 0; p <= options.warmPipelines; p++)
+        {
+            PipelineLayoutCache layoutCache;
+            layoutCache.setupLayoutCache(logicalDevice);
+            Pipeline pipeline;
+            
+            start = Clock::now();
+            pipeline.setupGraphicsPipeline(logicalDevice, renderPass, vertShaderCode, fragShaderCode, layoutCache);
+            report.add(p == 0 ? "pipeline_creation_cold" : "pipeline_creation_warm").samples.push_back(elapsedMs(start));
+            
+            pipeline.destroyGraphicsPipeline(logicalDevice);
+            layoutCache.destroyLayoutCache();
+        }
+        
+        vkDestroyRenderPass(logicalDevice, renderPass, nullptr);
+        device.destroyDevices();
+    }
+}
+
+
+static void benchComponents(const BenchOptions& options, BenchReport& report)
+{
+    setPlatformHint(options.headless);
+    
+    Window window;
+    Window::setupPlatform();
+    window.setupWindow();
+    
+    benchInstance(options, report);
+    
+    InstanceCapabilities instanceCapabilities;
+    const VkInstance instance = createInstance(instanceCapabilities);
+    window.setupSurface(instance);
+    
+    benchDevice(options, instance, instanceCapabilities, window, report);
+    
+    window.destroySurface(instance);
+    vkDestroyInstance(instance, nullptr);
+    window.destroyWindow();
+    glfwTerminate();
+}
+
+
+// Serial startup is the baseline for the task graph. Runs after the first start from the pipeline cache file it saved
+static void benchStartup(const BenchOptions& options, BenchReport& report)
+{
+    for (uint32_t i = 0; i < options.iterations; i++)
+    {
+        for (const uint32_t workers : {0u, STARTUP_WORKERS})
+        {
+            setPlatformHint(options.headless);
+            
+            VulkanProject app;
+            app.setupApp(workers);
+            app.drawFrame();
+            report.add(workers == 0 ? "time_to_first_frame_serial" : "time_to_first_frame").samples.push_back(app.getTimeToFirstFrame());
+            
+            app.waitIdle();
+            app.cleanup();
+        }
+    }
+}
+
+
+static void benchFrames(const BenchOptions& options, BenchReport& report)
+{
+    setPlatformHint(options.headless);
+    
+    VulkanProject app;
+    app.setupApp();
+    
+    for (uint32_t i = 0; i < options.warmupFrames; i++)
+    {
+        glfwPollEvents();
+        app.drawFrame();
+    }
+    
+    BenchResult& result = report.add("frame_time");
+    result.samples.reserve(options.frames);
+    
+    for (uint32_t i = 0; i < options.frames; i++)
+    {
+        const auto start = Clock::now();
+        glfwPollEvents();
+        app.drawFrame();
+        result.samples.push_back(elapsedMs(start));
+    }
+    
+    app.waitIdle();
+    app.cleanup();
+}
+
+
+// Same frame loop with 1 to MAX_BENCH_VIEWS windows, all drawn by one submission and one present
+static void benchViews(const BenchOptions& options, BenchReport& report)
+{
+    std::vector<double> medians;
+    
+    for (uint32_t viewCount = 1; viewCount <= MAX_BENCH_VIEWS; viewCount *= 2)
+    {
+        setPlatformHint(options.headless);
+        
+        VulkanProject app;
+        app.setupApp(STARTUP_WORKERS, viewCount);
+        
+        for (uint32_t i = 0; i < options.warmupFrames; i++)
+        {
+            glfwPollEvents();
+            app.drawFrame();
+        }
+        
+        BenchResult& result = report.add("frame_time_views_" + std::to_string(viewCount));
+        result.samples.reserve(options.frames);
+        
+        for (uint32_t i = 0; i < options.frames; i++)
+        {
+            const auto start = Clock::now();
+            glfwPollEvents();
+            app.drawFrame();
+            result.samples.push_back(elapsedMs(start));
+        }
+        
+        app.waitIdle();
+        app.cleanup();
+        
+        std::vector<double> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+        medians.push_back(sorted[sorted.size() / 2]);
+    }
+    
+    // Slope between the smallest and largest view count
+    report.add("per_view_overhead").samples.push_back((medians.back() - medians.front()) / (MAX_BENCH_VIEWS - 1));
+}
+
+
+// Mesh test scene with 32-bit float and with quantized vertices; the scene is sized so vertex fetch bandwidth
+// dominates, which makes the frame time difference mostly the cost of the bytes per vertex
+static void benchMeshScene(const BenchOptions& options, BenchReport& report, const std::string& name, const VertexLayout layout, const MeshShaderFeatures& features)
+{
+    setPlatformHint(options.headless);
+    
+    VulkanProject app;
+    app.setSceneFeatures(features);
+    app.setupApp(STARTUP_WORKERS, 1, layout);
+    
+    for (uint32_t i = 0; i < options.warmupFrames; i++)
+    {
+        glfwPollEvents();
+        app.drawFrame();
+    }
+    
+    BenchResult& result = report.add(name);
+    result.samples.reserve(options.frames);
+    
+    for (uint32_t i = 0; i < options.frames; i++)
+    {
+        const auto start = Clock::now();
+        glfwPollEvents();
+        app.drawFrame();
+        result.samples.push_back(elapsedMs(start));
+    }
+    
+    app.waitIdle();
+    app.cleanup();
+}
+
+
+static void benchVertexFormats(const BenchOptions& options, BenchReport& report)
+{
+    for (const auto& format : {std::make_pair(VertexLayout::Float, "float"), std::make_pair(VertexLayout::Quantized, "quantized")})
+    {
+        benchMeshScene(options, report, std::string("frame_time_mesh_") + format.second, format.first, MeshShaderFeatures{});
+        report.add(std::string("vertex_bytes_") + format.second).samples.push_back(vertex::getVertexStride(format.first));
+    }
+}
+
+
+// The same mesh.frag with its features specialized into the pipeline or read from push constants and branched on,
+// once with every feature and the most lights and once with all of them off
+static void benchShaderVariants(const BenchOptions& options, BenchReport& report)
+{
+    const MeshShaderFeatures full = {8, true, true, false};
+    const MeshShaderFeatures lite = {1, false, false, false};
+    
+    for (const auto& features : {std::make_pair(full, "full"), std::make_pair(lite, "lite")})
+    {
+        for (const bool runtimeBranches : {true, false})
+        {
+            MeshShaderFeatures variant = features.first;
+            variant.runtimeBranches = runtimeBranches;
+            benchMeshScene(options, report, std::string("frame_time_shading_") + (runtimeBranches ? "branching_" : "specialized_") + features.second, VertexLayout::Float, variant);
+        }
+    }
+}
+
+
+// Worst frames of the mesh scene when it switches to feature combinations it has not drawn yet, once building each
+// pipeline whole and once fast-linking it from precompiled parts. Only the frames that switch are recorded, every
+// other frame after a switch gives the background compiles time to finish
+static void benchPipelineHitches(const BenchOptions& options, BenchReport& report)
+{
+    constexpr uint32_t FRAMES_PER_SWITCH = 30;
+    
+    for (const bool library : {false, true})
+    {
+        setPlatformHint(options.headless);
+        
+        VulkanProject app;
+        app.setPipelineLibrary(library);
+        app.setSceneFeatures({1, false, false, false});
+        app.setupApp(STARTUP_WORKERS, 1, VertexLayout::Float);
+        
+        for (uint32_t i = 0; i < options.warmupFrames; i++)
+        {
+            glfwPollEvents();
+            app.drawFrame();
+        }
+        
+        BenchResult& result = report.add(std::string("pipeline_hitch_") + (library ? "library" : "monolithic"));
+        
+        // Every specialized combination but the one set up with, which the warmup frames have drawn
+        for (uint32_t combination = 1; combination < 32; combination++)
+        {
+            const MeshShaderFeatures features = {combination / 4 + 1, (combination & 1) != 0, (combination & 2) != 0, false};
+            
+            const auto start = Clock::now();
+            app.setSceneFeatures(features);
+            glfwPollEvents();
+            app.drawFrame();
+            result.samples.push_back(elapsedMs(start));
+            
+            for (uint32_t i = 1; i < FRAMES_PER_SWITCH; i++)
+            {
+                glfwPollEvents();
+                app.drawFrame();
+            }
+        }
+        
+        app.waitIdle();
+        app.cleanup();
+    }
+}
+
+
+// Frame time with the post chain presented the same frame (serial) and one frame later so it overlaps the next
+// scene (overlapped), plus the GPU time of every effect from the overlapped run
+static void benchPostChain(const BenchOptions& options, BenchReport& report)
+{
+    const char* effectNames[POST_EFFECT_COUNT] = {"bloom_down", "bloom_up", "tonemap", "fxaa"};
+    
+    for (const bool overlap : {false, true})
+    {
+        setPlatformHint(options.headless);
+        
+        VulkanProject app;
+        app.setPostOverlap(overlap);
+        app.setupApp();
+        
+        for (uint32_t i = 0; i < options.warmupFrames; i++)
+        {
+            glfwPollEvents();
+            app.drawFrame();
+        }
+        
+        BenchResult& result = report.add(std::string("frame_time_post_") + (overlap ? "overlapped" : "serial"));
+        result.samples.reserve(options.frames);
+        
+        std::vector<double> effectSamples[POST_EFFECT_COUNT];
+        for (uint32_t i = 0; i < options.frames; i++)
+        {
+            const auto start = Clock::now();
+            glfwPollEvents();
+            app.drawFrame();
+            result.samples.push_back(elapsedMs(start));
+            
+            for (uint32_t e = 0; e < POST_EFFECT_COUNT; e++)
+            {
+                effectSamples[e].push_back(app.getPostTimings().effectMs[e]);
+            }
+        }
+        
+        app.waitIdle();
+        app.cleanup();
+        
+        if (overlap)
+        {
+            for (uint32_t e = 0; e < POST_EFFECT_COUNT; e++)
+            {
+                report.add(std::string("post_gpu_") + effectNames[e]).samples = effectSamples[e];
+            }
+        }
+    }
+}
+
+
+// Frame time without and with the performance HUD, and what the HUD itself costs on the CPU and the GPU
+static void benchHud(const BenchOptions& options, BenchReport& report)
+{
+    for (const bool enabled : {false, true})
+    {
+        setPlatformHint(options.headless);
+        
+        VulkanProject app;
+        app.setHud(enabled);
+        app.setupApp();
+        
+        for (uint32_t i = 0; i < options.warmupFrames; i++)
+        {
+            glfwPollEvents();
+            app.drawFrame();
+        }
+        
+        BenchResult& result = report.add(std::string("frame_time_hud_") + (enabled ? "on" : "off"));
+        result.samples.reserve(options.frames);
+        
+        std::vector<double> cpuSamples, gpuSamples;
+        for (uint32_t i = 0; i < options.frames; i++)
+        {
+            const auto start = Clock::now();
+            glfwPollEvents();
+            app.drawFrame();
+            result.samples.push_back(elapsedMs(start));
+            
+            cpuSamples.push_back(app.getPerfMetrics().hudCpuMs);
+            gpuSamples.push_back(app.getPerfMetrics().hudGpuMs);
+        }
+        
+        app.waitIdle();
+        app.cleanup();
+        
+        if (enabled)
+        {
+            report.add("hud_cpu").samples = cpuSamples;
+            report.add("hud_gpu").samples = gpuSamples;
+        }
+    }
+}
+
+static std::string escapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    
+    return escaped;
+}
+
+
+static void writeJson(std::ostream& os, const BenchOptions& options, const BenchReport& report)
+{
+    os << std::fixed << std::setprecision(4);
+    os << "{\n";
+    os << "  \"device\": \"" << escapeJson(report.deviceName) << "\",\n";
+    os << "  \"api_version\": \"" << VK_API_VERSION_MAJOR(report.apiVersion) << "." << VK_API_VERSION_MINOR(report.apiVersion) << "." << VK_API_VERSION_PATCH(report.apiVersion) << "\",\n";
+    os << "  \"driver_version\": " << report.driverVersion << ",\n";
+    os << "  \"headless\": " << (options.headless ? "true" : "false") << ",\n";
+    os << "  \"iterations\": " << options.iterations << ",\n";
+    os << "  \"frames\": " << options.frames << ",\n";
+    os << "  \"results\": {\n";
+    
+    for (size_t i = 0; i < report.results.size(); i++)
+    {
+        const BenchResult& result = report.results[i];
+        os << "    \"" << result.name << "\": {"
+           << "\"samples\": " << result.samples.size()
+           << ", \"min_ms\": " << result.min
+           << ", \"median_ms\": " << result.median
+           << ", \"mean_ms\": " << result.mean
+           << ", \"p95_ms\": " << result.p95
+           << ", \"max_ms\": " << result.max
+           << "}" << (i + 1 < report.results.size() ? "," : "") << "\n";
+    }
+    
+    os << "  }\n";
+    os << "}\n";
+}
+
+
+// Only reads files this tool wrote, so a key lookup is all the parsing it needs
+static bool findBaselineMedian(const std::string& baseline, const std::string& name, double& median)
+{
+    const size_t entry = baseline.find("\"" + name + "\":");
+    if (entry == std::string::npos)
+    {
+        return false;
+    }
+    
+    const std::string key = "\"median_ms\":";
+    const size_t value = baseline.find(key, entry);
+    if (value == std::string::npos)
+    {
+        return false;
+    }
+    
+    median = std::strtod(baseline.c_str() + value + key.size(), nullptr);
+    return median > 0.0;
+}
+
+
+static bool compareBaseline(const BenchOptions& options, const BenchReport& report)
+{
+    std::ifstream file(options.baselinePath);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open baseline " + options.baselinePath + "!");
+    }
+    
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string baseline = buffer.str();
+    
+    bool regressed = false;
+    std::cout << std::fixed << std::setprecision(3);
+    
+    for (const auto& result : report.results)
+    {
+        double baselineMedian;
+        if (!findBaselineMedian(baseline, result.name, baselineMedian))
+        {
+            std::cout << "[bench] " << result.name << ": no baseline" << std::endl;
+            continue;
+        }
+        
+        const double change = result.median / baselineMedian - 1.0;
+        const bool failed = change > options.tolerance;
+        regressed |= failed;
+        
+        std::cout << "[bench] " << result.name << ": " << result.median << " ms vs " << baselineMedian << " ms ("
+                  << std::showpos << change * 100.0 << std::noshowpos << "%)" << (failed ? " REGRESSION" : "") << std::endl;
+    }
+    
+    return !regressed;
+}
+
+
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--headless] [--iterations N] [--warm-pipelines N] [--warmup-frames N] [--frames N]"
+              << " [--output FILE] [--baseline FILE] [--tolerance FRACTION]" << std::endl;
+}
+
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--headless")
+        {
+            options.headless = true;
+        } else if (arg == "--iterations" && hasValue)
+        {
+            options.iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--warm-pipelines" && hasValue)
+        {
+            options.warmPipelines = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--warmup-frames" && hasValue)
+        {
+            options.warmupFrames = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--frames" && hasValue)
+        {
+            options.frames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--output" && hasValue)
+        {
+            options.outputPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue)
+        {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue)
+        {
+            options.tolerance = std::atof(argv[++i]);
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    BenchReport report;
+    
+    try
+    {
+        benchComponents(options, report);
+        benchStartup(options, report);
+        benchFrames(options, report);
+        benchViews(options, report);
+        benchVertexFormats(options, report);
+        benchShaderVariants(options, report);
+        benchPipelineHitches(options, report);
+        benchPostChain(options, report);
+        benchHud(options, report);
+        
+        for (auto& result : report.results)
+        {
+            summarize(result);
+        }
+        
+        std::ofstream file(options.outputPath);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open " + options.outputPath + "!");
+        }
+        writeJson(file, options, report);
+        writeJson(std::cout, options, report);
+        
+        if (!options.baselinePath.empty() && !compareBaseline(options, report))
+        {
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
@@ -1,2 +1,11 @@
 glslc ./shaders/shader.vert -o ./shaders/vert.spv
 glslc ./shaders/shader.frag -o ./shaders/frag.spv
+glslc ./shaders/shader.comp -o ./shaders/comp.spv
+glslc ./shaders/mesh.vert -o ./shaders/mesh_vert.spv
+glslc ./shaders/mesh.frag -o ./shaders/mesh_frag.spv
+glslc ./shaders/bloom_down.comp -o ./shaders/bloom_down_comp.spv
+glslc ./shaders/bloom_up.comp -o ./shaders/bloom_up_comp.spv
+glslc ./shaders/tonemap.comp -o ./shaders/tonemap_comp.spv
+glslc ./shaders/fxaa.comp -o ./shaders/fxaa_comp.spv
+glslc ./shaders/hud.vert -o ./shaders/hud_vert.spv
+glslc ./shaders/hud.frag -o ./shaders/hud_frag.spv
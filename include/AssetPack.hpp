@@ -0,0 +1,105 @@
+#ifndef ASSETPACK_HPP
+#define ASSETPACK_HPP
+
+#include "Utils.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+
+enum class AssetCompression : uint16_t
+{
+    None,
+    Lz4
+};
+
+// Blobs start on this boundary, enough for SPIR-V words and any vertex or index type
+constexpr uint64_t ASSET_PACK_ALIGNMENT = 64;
+
+struct AssetPackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t assetCount;
+    // Power of two, at most half full
+    uint32_t slotCount;
+    uint64_t tableOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t fileSize;
+};
+
+// One slot of the open-addressing table of contents, empty when nameLength is 0
+struct AssetPackEntry
+{
+    uint64_t hash;
+    uint64_t offset;
+    // Stored bytes, and the bytes after decompression
+    uint64_t size;
+    uint64_t rawSize;
+    uint32_t nameOffset;
+    uint16_t nameLength;
+    AssetCompression compression;
+};
+
+// An asset as the packer writes it
+struct PackedAsset
+{
+    std::string name;
+    AssetCompression compression = AssetCompression::None;
+    uint64_t rawSize = 0;
+    std::vector<char> data;
+};
+
+
+// Read-only archive mapped once, with zero-copy views of stored entries. Compressed entries are inflated on
+// first use, and names missing from the pack are read as loose files, so a build without one keeps working.
+// Either way the view stays valid until closePack
+class AssetPack
+{
+public:
+    AssetPack() = default;
+    AssetPack(const AssetPack&) =  delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+    AssetPack(AssetPack&&) = delete;
+    AssetPack& operator=(AssetPack&&) = delete;
+    
+    // A missing file leaves the pack closed, a damaged one throws
+    void openPack(const std::string& path);
+    void closePack(void);
+    
+    const bool isOpen(void) const;
+    const uint32_t getAssetCount(void) const;
+    const bool contains(const std::string& name) const;
+    // Safe from several threads
+    const ByteView getAsset(const std::string& name);
+    
+private:
+    const char* mapping = nullptr;
+    size_t mappingSize = 0;
+    const AssetPackHeader* header = nullptr;
+    const AssetPackEntry* table = nullptr;
+    const char* names = nullptr;
+    
+    std::mutex ownedMutex;
+    // Node-based, so views of earlier assets survive later insertions
+    std::unordered_map<std::string, std::vector<char>> ownedAssets;
+    
+    const AssetPackEntry* findEntry(const std::string& name) const;
+};
+
+
+namespace assets
+{
+    constexpr uint32_t PACK_VERSION = 1;
+    
+    // 64-bit FNV-1a of the name, the table is indexed by its low bits
+    uint64_t hashName(const std::string& name);
+    
+    // Keeps the data stored unless compression saves at least an eighth
+    PackedAsset packAsset(const std::string& name, std::vector<char> data, const AssetCompression compression);
+    void writePack(const std::string& path, const std::vector<PackedAsset>& packedAssets);
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef BUFFER_HPP
+#define BUFFER_HPP
+
+#include "Config.hpp"
+#include "HostAllocator.hpp"
+
+
+class Buffer
+{
+public:
+    Buffer() = default;
+    Buffer(const Buffer&) =  delete;
+    Buffer& operator=(const Buffer&) = delete;
+    Buffer(Buffer&&) = delete;
+    Buffer& operator=(Buffer&&) = delete;
+    
+    static uint32_t findMemoryType(const VkPhysicalDevice physicalDevice, const uint32_t typeFilter, const VkMemoryPropertyFlags properties);
+    
+    // Buffers shared by more than one queue family are created with concurrent sharing
+    void setupBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties, const std::vector<uint32_t>& queueFamilies = {}, HostAllocator* hostAllocator = nullptr);
+    void destroyBuffer(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    
+    void* map(const VkDevice device);
+    void unmap(const VkDevice device);
+    // Tells a command capture which bytes the host wrote, buffers that stay mapped call it before the submits that
+    // read them
+    void markWritten(const VkDeviceSize offset, const VkDeviceSize size);
+    // Makes device writes visible through the mapping when the memory is not host coherent
+    void invalidate(const VkDevice device);
+    
+    const VkBuffer getBuffer(void) const;
+    const VkDeviceSize getSize(void) const;
+    
+private:
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;
+    
+    void populateBufferCreateInfo(VkBufferCreateInfo& createInfo, const VkBufferUsageFlags usage, const std::vector<uint32_t>& queueFamilies);
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef CAPABILITIES_HPP
+#define CAPABILITIES_HPP
+
+#include "Config.hpp"
+
+#include <ostream>
+#include <set>
+#include <string>
+
+
+// Highest API version the code is written against, newer loaders and drivers are clamped to it
+constexpr uint32_t MAX_API_VERSION = VK_API_VERSION_1_3;
+
+
+// Result of instance negotiation: what vkCreateInstance was asked for
+struct InstanceCapabilities
+{
+    uint32_t apiVersion = VK_API_VERSION_1_0;
+    std::set<std::string> extensions;
+    bool portabilityEnumeration = false;
+    bool physicalDeviceProperties2 = false;
+    
+    bool hasExtension(const std::string& extensionName) const;
+};
+
+
+// Result of device negotiation: only what was both supported and enabled is set
+struct DeviceCapabilities
+{
+    uint32_t apiVersion = VK_API_VERSION_1_0;
+    std::set<std::string> extensions;
+    VkPhysicalDeviceFeatures features{};
+    
+    bool timelineSemaphore = false;
+    bool synchronization2 = false;
+    bool memoryBudget = false;
+    bool pipelineCreationCacheControl = false;
+    bool dynamicRendering = false;
+    bool graphicsPipelineLibrary = false;
+    bool portabilitySubset = false;
+    
+    bool hasExtension(const std::string& extensionName) const;
+    void report(std::ostream& os) const;
+};
+
+#endif
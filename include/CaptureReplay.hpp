@@ -0,0 +1,130 @@
+#ifndef CAPTUREREPLAY_HPP
+#define CAPTUREREPLAY_HPP
+
+#include "Config.hpp"
+#include "Queue.hpp"
+#include "CommandPool.hpp"
+#include "CommandCapture.hpp"
+#include "GpuTimer.hpp"
+
+#include <string>
+#include <unordered_map>
+
+
+struct ReplayFrame
+{
+    // From the end of the previous frame, without the time slept for pacing
+    double cpuMs = 0.0;
+    // First timestamp of the frame's command buffers to the last one
+    double gpuMs = 0.0;
+    // When the frame ended in the capture, from the start of the capture
+    double recordedMs = 0.0;
+};
+
+
+// Replays a command capture on this device without presenting. Objects are created and destroyed as recorded, swap
+// chain images become offscreen images, and the submits of every frame go through the schedulers of the queue in
+// their recorded order and with their recorded timeline waits and signals
+class CaptureReplayer
+{
+public:
+    CaptureReplayer() = default;
+    CaptureReplayer(const CaptureReplayer&) =  delete;
+    CaptureReplayer& operator=(const CaptureReplayer&) = delete;
+    CaptureReplayer(CaptureReplayer&&) = delete;
+    CaptureReplayer& operator=(CaptureReplayer&&) = delete;
+    
+    void setupReplayer(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, Queue& queue, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroyReplayer(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    // Replays the whole file once. paced sleeps between frames so they end at their recorded times, otherwise
+    // frames run back to back. The first frame also carries the uploads made before it
+    void replay(const std::string& path, const bool paced, std::vector<ReplayFrame>& frames);
+    
+    const CaptureHeader& getHeader(void) const;
+    
+private:
+    struct Memory
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        // As captured, the allocation may grow to the requirements of this device
+        VkDeviceSize size = 0;
+        VkMemoryPropertyFlags flags = 0;
+        bool coherent = false;
+        uint8_t* mapped = nullptr;
+    };
+    
+    // Command buffers of the frame that last used the slot and the timeline values that retire them
+    struct FrameSlot
+    {
+        CommandPool graphicsPool;
+        CommandPool computePool;
+        uint32_t graphicsUsed = 0;
+        uint32_t computeUsed = 0;
+        uint64_t graphicsValue = 0;
+        uint64_t computeValue = 0;
+        size_t frame = 0;
+    };
+    
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    const VkAllocationCallbacks* pAllocator = nullptr;
+    Queue* queue = nullptr;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    // Families of buffers and images captured with concurrent sharing
+    std::vector<uint32_t> concurrentFamilies;
+    
+    FrameSlot slots[MAX_FRAMES_IN_FLIGHT];
+    uint32_t currentSlot = 0;
+    GpuTimer graphicsTimer;
+    GpuTimer computeTimer;
+    std::vector<GpuInterval> frameIntervals;
+    
+    CaptureHeader header{};
+    // Handles by capture id, 0 is VK_NULL_HANDLE
+    std::vector<uint64_t> handles;
+    std::vector<std::pair<VkObjectType, uint64_t>> createdObjects;
+    std::unordered_map<uint32_t, Memory> memories;
+    // Memory of the images standing in for swap chain images, by image id
+    std::unordered_map<uint32_t, VkDeviceMemory> swapchainImageMemories;
+    
+    template <typename T>
+    T getHandle(const uint32_t id) const;
+    template <typename T>
+    void setHandle(const uint32_t id, const T handle, const VkObjectType type);
+    
+    void destroyHandle(const VkObjectType type, const uint64_t key);
+    void destroyObjects(void);
+    
+    void replayRecord(const CaptureRecord type, CaptureReader& reader);
+    void createBuffer(CaptureReader& reader);
+    void createImage(CaptureReader& reader);
+    void createSwapchainImage(CaptureReader& reader);
+    // Allocates captured memory when the first resource is bound to it, once its requirements on this device are known
+    VkDeviceMemory allocateMemory(const uint32_t memoryId, const VkMemoryRequirements& requirements, const VkDeviceSize offset);
+    void writeMemory(CaptureReader& reader);
+    void createImageView(CaptureReader& reader);
+    void createRenderPass(CaptureReader& reader);
+    void createFramebuffer(CaptureReader& reader);
+    void createShaderModule(CaptureReader& reader);
+    void createDescriptorSetLayout(CaptureReader& reader);
+    void createPipelineLayout(CaptureReader& reader);
+    void createGraphicsPipeline(CaptureReader& reader);
+    void createComputePipeline(CaptureReader& reader);
+    void createDescriptorPool(CaptureReader& reader);
+    void allocateDescriptorSets(CaptureReader& reader);
+    void updateDescriptorSets(CaptureReader& reader);
+    void createSemaphore(CaptureReader& reader);
+    void submit(CaptureReader& reader);
+    void queueWaitIdle(CaptureReader& reader);
+    void destroyObject(CaptureReader& reader);
+    
+    void recordCommandBuffer(const VkCommandBuffer commandBuffer, CaptureReader& stream);
+    void recordCommand(const VkCommandBuffer commandBuffer, const CaptureCommand op, CaptureReader& reader);
+    
+    // Waits for the command buffers recorded into the slot and adds their GPU time to the frame that used them
+    void retireSlot(FrameSlot& slot);
+    SubmitScheduler& getScheduler(const QueueRole role);
+};
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef COMMANDCAPTURE_HPP
+#define COMMANDCAPTURE_HPP
+
+#include "Config.hpp"
+#include "Queue.hpp"
+
+#include <ostream>
+#include <string>
+
+
+// A capture file is a CaptureHeader followed by records in call order, each a CaptureRecord type, the byte size of
+// its payload and the payload. Handles are written as ids, structs as they are in memory with their pointers
+// cleared and their arrays after them, so a file replays only on builds with the same struct layout
+constexpr char CAPTURE_MAGIC[4] = {'V', 'C', 'A', 'P'};
+constexpr uint32_t CAPTURE_VERSION = 3;
+
+struct CaptureHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t apiVersion;
+    uint32_t driverVersion;
+    char deviceName[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+};
+
+enum class CaptureRecord : uint32_t
+{
+    CreateBuffer,
+    CreateImage,
+    // Stands in for a swap chain image, replayed as an offscreen image with its own memory
+    CreateSwapchainImage,
+    AllocateMemory,
+    BindBufferMemory,
+    BindImageMemory,
+    // Host writes to mapped memory, taken before the next submit or when it is unmapped
+    WriteMemory,
+    CreateImageView,
+    CreateSampler,
+    CreateRenderPass,
+    CreateFramebuffer,
+    CreateShaderModule,
+    CreateDescriptorSetLayout,
+    CreatePipelineLayout,
+    CreateGraphicsPipeline,
+    CreateComputePipeline,
+    CreateDescriptorPool,
+    AllocateDescriptorSets,
+    UpdateDescriptorSets,
+    CreateQueryPool,
+    // Timeline semaphores only, binary ones belong to acquire and present which are not replayed
+    CreateSemaphore,
+    // The command streams of every submitted command buffer as they were when submitted
+    Submit,
+    QueueWaitIdle,
+    // The object type and id of a destroyed or freed object. Swap chain images go with their swap chain, descriptor
+    // sets with their pool without records of their own
+    DestroyObject,
+    EndFrame
+};
+
+// Commands inside a command stream, each a type, the byte size of its payload and the payload
+enum class CaptureCommand : uint32_t
+{
+    BeginRenderPass,
+    EndRenderPass,
+    BindPipeline,
+    BindDescriptorSets,
+    PushConstants,
+    SetViewport,
+    SetScissor,
+    BindVertexBuffers,
+    BindIndexBuffer,
+    Draw,
+    DrawIndexed,
+    Dispatch,
+    PipelineBarrier,
+    CopyBuffer,
+    CopyImage,
+    CopyImageToBuffer,
+    WriteTimestamp,
+    ResetQueryPool
+};
+
+
+// Payload of a record or command under construction
+class CaptureStream
+{
+public:
+    template <typename T>
+    void write(const T& value)
+    {
+        writeBytes(&value, sizeof(T));
+    }
+    
+    // Count first, then the elements
+    template <typename T>
+    void writeArray(const T* values, const uint32_t count)
+    {
+        write(count);
+        writeBytes(values, sizeof(T) * count);
+    }
+    
+    void writeBytes(const void* data, const size_t size);
+    void writeString(const char* text);
+    void clear(void);
+    
+    const std::vector<uint8_t>& getBytes(void) const;
+
+private:
+    std::vector<uint8_t> bytes;
+};
+
+
+// Reads a payload back in the order it was written, throws once it runs past the end
+class CaptureReader
+{
+public:
+    CaptureReader(const uint8_t* data, const size_t size);
+    
+    template <typename T>
+    T read(void)
+    {
+        T value;
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+    
+    template <typename T>
+    void read(T& value)
+    {
+        readBytes(&value, sizeof(T));
+    }
+    
+    template <typename T>
+    std::vector<T> readArray(void)
+    {
+        std::vector<T> values(read<uint32_t>());
+        readBytes(values.data(), sizeof(T) * values.size());
+        return values;
+    }
+    
+    void readBytes(void* data, const size_t size);
+    std::string readString(void);
+    // Skips size bytes and returns where they start, without a copy
+    const uint8_t* readSpan(const size_t size);
+    bool atEnd(void) const;
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+};
+
+
+// Draws, dispatches and pipeline binds recorded through the wrappers, whether a capture is open or not
+struct CommandCounts
+{
+    uint32_t draws = 0;
+    uint32_t dispatches = 0;
+    uint32_t pipelineBinds = 0;
+};
+
+
+// Records the Vulkan calls of the app for capture_replay. The wrappers take the arguments of the Vulkan function
+// they are named after, forward them and record the call while a capture is open. Everything else (instance,
+// surfaces, swap chain acquire and present, queries of results) is not captured
+namespace capture
+{
+    // VULKAN_COMMAND_CAPTURE=<file>, empty when it is unset
+    std::string pathFromEnvironment(void);
+    
+    // Objects created before the capture is opened are unknown to it
+    void openCapture(const std::string& path, const VkPhysicalDevice physicalDevice);
+    // With the device idle, writes the capture out and reports its size
+    void closeCapture(std::ostream& os);
+    bool isCapturing(void);
+    
+    // A queue shared by several roles keeps the first role it is registered with
+    void registerQueue(const VkQueue queue, const QueueRole role);
+    void registerSwapchainImages(const VkSwapchainKHR swapChain, const VkSwapchainCreateInfoKHR& createInfo, const std::vector<VkImage>& images);
+    // Tags the frame with the time since the capture was opened, for paced replays
+    void endFrame(void);
+    // Counts since the last call, from any thread
+    CommandCounts takeCommandCounts(void);
+    
+    VkResult createBuffer(const VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer);
+    VkResult createImage(const VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage);
+    VkResult allocateMemory(const VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory);
+    VkResult bindBufferMemory(const VkDevice device, const VkBuffer buffer, const VkDeviceMemory memory, const VkDeviceSize memoryOffset);
+    VkResult bindImageMemory(const VkDevice device, const VkImage image, const VkDeviceMemory memory, const VkDeviceSize memoryOffset);
+    VkResult mapMemory(const VkDevice device, const VkDeviceMemory memory, const VkDeviceSize offset, const VkDeviceSize size, const VkMemoryMapFlags flags, void** ppData);
+    void unmapMemory(const VkDevice device, const VkDeviceMemory memory);
+    // Everything a new mapping holds is captured with the first submit after it, later writes through a mapping that
+    // stays mapped are only captured when they are marked
+    void markWritten(const VkDeviceMemory memory, const VkDeviceSize offset, const VkDeviceSize size);
+    VkResult createImageView(const VkDevice device, const VkImageViewCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImageView* pView);
+    VkResult createSampler(const VkDevice device, const VkSamplerCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSampler* pSampler);
+    VkResult createRenderPass(const VkDevice device, const VkRenderPassCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkRenderPass* pRenderPass);
+    VkResult createFramebuffer(const VkDevice device, const VkFramebufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFramebuffer* pFramebuffer);
+    VkResult createShaderModule(const VkDevice device, const VkShaderModuleCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkShaderModule* pShaderModule);
+    VkResult createDescriptorSetLayout(const VkDevice device, const VkDescriptorSetLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pSetLayout);
+    VkResult createPipelineLayout(const VkDevice device, const VkPipelineLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineLayout* pPipelineLayout);
+    VkResult createGraphicsPipelines(const VkDevice device, const VkPipelineCache pipelineCache, const uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines);
+    VkResult createComputePipelines(const VkDevice device, const VkPipelineCache pipelineCache, const uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines);
+    VkResult createDescriptorPool(const VkDevice device, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorPool* pDescriptorPool);
+    VkResult allocateDescriptorSets(const VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets);
+    // Descriptor copies are not captured
+    void updateDescriptorSets(const VkDevice device, const uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, const uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies);
+    VkResult createQueryPool(const VkDevice device, const VkQueryPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkQueryPool* pQueryPool);
+    VkResult createSemaphore(const VkDevice device, const VkSemaphoreCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSemaphore* pSemaphore);
+    
+    // The replay destroys the object at the same point, a handle value the driver hands out again gets a new id
+    void destroyBuffer(const VkDevice device, const VkBuffer buffer, const VkAllocationCallbacks* pAllocator);
+    void destroyImage(const VkDevice device, const VkImage image, const VkAllocationCallbacks* pAllocator);
+    void freeMemory(const VkDevice device, const VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator);
+    void destroyImageView(const VkDevice device, const VkImageView imageView, const VkAllocationCallbacks* pAllocator);
+    void destroySampler(const VkDevice device, const VkSampler sampler, const VkAllocationCallbacks* pAllocator);
+    void destroyRenderPass(const VkDevice device, const VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator);
+    void destroyFramebuffer(const VkDevice device, const VkFramebuffer framebuffer, const VkAllocationCallbacks* pAllocator);
+    void destroyShaderModule(const VkDevice device, const VkShaderModule shaderModule, const VkAllocationCallbacks* pAllocator);
+    void destroyDescriptorSetLayout(const VkDevice device, const VkDescriptorSetLayout setLayout, const VkAllocationCallbacks* pAllocator);
+    void destroyPipelineLayout(const VkDevice device, const VkPipelineLayout pipelineLayout, const VkAllocationCallbacks* pAllocator);
+    void destroyPipeline(const VkDevice device, const VkPipeline pipeline, const VkAllocationCallbacks* pAllocator);
+    void destroyDescriptorPool(const VkDevice device, const VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator);
+    void destroyQueryPool(const VkDevice device, const VkQueryPool queryPool, const VkAllocationCallbacks* pAllocator);
+    void destroySemaphore(const VkDevice device, const VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator);
+    // Also destroys the images registered with it
+    void destroySwapchain(const VkDevice device, const VkSwapchainKHR swapChain, const VkAllocationCallbacks* pAllocator);
+    
+    // Starts a new command stream for the buffer
+    VkResult beginCommandBuffer(const VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* pBeginInfo);
+    void cmdBeginRenderPass(const VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo* pRenderPassBegin, const VkSubpassContents contents);
+    void cmdEndRenderPass(const VkCommandBuffer commandBuffer);
+    void cmdBindPipeline(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint pipelineBindPoint, const VkPipeline pipeline);
+    void cmdBindDescriptorSets(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint pipelineBindPoint, const VkPipelineLayout layout, const uint32_t firstSet, const uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, const uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets);
+    void cmdPushConstants(const VkCommandBuffer commandBuffer, const VkPipelineLayout layout, const VkShaderStageFlags stageFlags, const uint32_t offset, const uint32_t size, const void* pValues);
+    void cmdSetViewport(const VkCommandBuffer commandBuffer, const uint32_t firstViewport, const uint32_t viewportCount, const VkViewport* pViewports);
+    void cmdSetScissor(const VkCommandBuffer commandBuffer, const uint32_t firstScissor, const uint32_t scissorCount, const VkRect2D* pScissors);
+    void cmdBindVertexBuffers(const VkCommandBuffer commandBuffer, const uint32_t firstBinding, const uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets);
+    void cmdBindIndexBuffer(const VkCommandBuffer commandBuffer, const VkBuffer buffer, const VkDeviceSize offset, const VkIndexType indexType);
+    void cmdDraw(const VkCommandBuffer commandBuffer, const uint32_t vertexCount, const uint32_t instanceCount, const uint32_t firstVertex, const uint32_t firstInstance);
+    void cmdDrawIndexed(const VkCommandBuffer commandBuffer, const uint32_t indexCount, const uint32_t instanceCount, const uint32_t firstIndex, const int32_t vertexOffset, const uint32_t firstInstance);
+    void cmdDispatch(const VkCommandBuffer commandBuffer, const uint32_t groupCountX, const uint32_t groupCountY, const uint32_t groupCountZ);
+    void cmdPipelineBarrier(const VkCommandBuffer commandBuffer, const VkPipelineStageFlags srcStageMask, const VkPipelineStageFlags dstStageMask, const VkDependencyFlags dependencyFlags, const uint32_t memoryBarrierCount, const VkMemoryBarrier* pMemoryBarriers, const uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers, const uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers);
+    void cmdCopyBuffer(const VkCommandBuffer commandBuffer, const VkBuffer srcBuffer, const VkBuffer dstBuffer, const uint32_t regionCount, const VkBufferCopy* pRegions);
+    void cmdCopyImage(const VkCommandBuffer commandBuffer, const VkImage srcImage, const VkImageLayout srcImageLayout, const VkImage dstImage, const VkImageLayout dstImageLayout, const uint32_t regionCount, const VkImageCopy* pRegions);
+    void cmdCopyImageToBuffer(const VkCommandBuffer commandBuffer, const VkImage srcImage, const VkImageLayout srcImageLayout, const VkBuffer dstBuffer, const uint32_t regionCount, const VkBufferImageCopy* pRegions);
+    void cmdWriteTimestamp(const VkCommandBuffer commandBuffer, const VkPipelineStageFlagBits pipelineStage, const VkQueryPool queryPool, const uint32_t query);
+    void cmdResetQueryPool(const VkCommandBuffer commandBuffer, const VkQueryPool queryPool, const uint32_t firstQuery, const uint32_t queryCount);
+    
+    VkResult queueSubmit(const VkQueue queue, const uint32_t submitCount, const VkSubmitInfo* pSubmits, const VkFence fence);
+    VkResult queueSubmit2(const PFN_vkQueueSubmit2KHR pfnQueueSubmit2, const VkQueue queue, const uint32_t submitCount, const VkSubmitInfo2KHR* pSubmits, const VkFence fence);
+    VkResult queueWaitIdle(const VkQueue queue);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef COMMANDPOOL_HPP
+#define COMMANDPOOL_HPP
+
+#include "Config.hpp"
+
+
+class CommandPool
+{
+public:
+    CommandPool() = default;
+    CommandPool(const CommandPool&) =  delete;
+    CommandPool& operator=(const CommandPool&) = delete;
+    CommandPool(CommandPool&&) = delete;
+    CommandPool& operator=(CommandPool&&) = delete;
+    
+    void setupCommandPool(const VkDevice device, const uint32_t queueFamilyIndex, const VkAllocationCallbacks* pAllocator = nullptr);
+    void setupCommandBuffers(const VkDevice device, const uint32_t count);
+    void destroyCommandPool(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    VkCommandBuffer beginSingleTimeCommands(const VkDevice device);
+    void endSingleTimeCommands(const VkDevice device, const VkQueue queue, VkCommandBuffer commandBuffer);
+    
+    const VkCommandPool getCommandPool(void) const;
+    const VkCommandBuffer getCommandBuffer(const uint32_t idx) const;
+    
+private:
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> commandBuffers;
+};
+
+#endif
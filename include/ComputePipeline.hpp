@@ -0,0 +1,35 @@
+#ifndef COMPUTEPIPELINE_HPP
+#define COMPUTEPIPELINE_HPP
+
+#include "Config.hpp"
+#include "Pipeline.hpp"
+
+
+class ComputePipeline
+{
+public:
+    ComputePipeline() = default;
+    ComputePipeline(const ComputePipeline&) =  delete;
+    ComputePipeline& operator=(const ComputePipeline&) = delete;
+    ComputePipeline(ComputePipeline&&) = delete;
+    ComputePipeline& operator=(ComputePipeline&&) = delete;
+    
+    // Takes effect at the next setupComputePipeline
+    void setShaderVariant(const ShaderVariant& variant);
+    
+    // The layout is reflected from the shader and owned by layoutCache
+    void setupComputePipeline(const VkDevice device, const ByteView shaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache = VK_NULL_HANDLE, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroyComputePipeline(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    const VkPipeline getPipeline(void) const;
+    const VkPipelineLayout getPipelineLayout(void) const;
+    
+private:
+    VkPipelineLayout computePipelineLayout = VK_NULL_HANDLE;
+    VkPipeline computePipeline = VK_NULL_HANDLE;
+    ShaderVariant variant;
+    
+    void populateShaderStageCreateInfo(VkPipelineShaderStageCreateInfo& shaderStageInfo, VkSpecializationInfo& specializationInfo, const VkShaderModule shaderModule);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <stdexcept>
 #include <vector>
 
 constexpr uint32_t WIDTH = 800;
@@ -17,6 +18,88 @@ using stringVector = std::vector<const char*>;
     constexpr bool enableValidationLayers = true;
 #endif
 
-constexpr bool MOLTEN_VK = true;
+constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+
+// Run the particle simulation on a dedicated compute family when the device has one
+constexpr bool ASYNC_COMPUTE = true;
+constexpr uint32_t PARTICLE_COUNT = 16384;
+// Specialized into shader.comp, so it can be tuned per device without touching the shader
+constexpr uint32_t PARTICLE_WORKGROUP_SIZE = 256;
+
+// Frames between two GPU timing reports
+constexpr uint32_t TIMING_REPORT_INTERVAL = 600;
+
+// Windows rendered by one process, each with its own surface and swap chain
+constexpr uint32_t VIEW_COUNT = 1;
+
+// Worker threads for the startup task graph, 0 runs every step serially on the main thread
+constexpr uint32_t STARTUP_WORKERS = 3;
+constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
+// Graphics pipelines are linked from separately compiled parts on devices with VK_EXT_graphics_pipeline_library,
+// so a new shader variant costs a link instead of a full compile. VULKAN_PIPELINE_LIBRARY=on|off overrides it
+constexpr bool PIPELINE_LIBRARY = true;
+
+// Mapped at startup when present, built next to the shaders by asset_packer. Without it assets are loose files
+constexpr const char* ASSET_PACK_PATH = "assets.vpak";
+
+// Readback buffers and encoder threads of frame capture, a 1080p slot takes 8 MB
+constexpr uint32_t CAPTURE_RING_SIZE = MAX_FRAMES_IN_FLIGHT + 4;
+constexpr uint32_t CAPTURE_WORKERS = 2;
+
+// Threads traversing the culling BVH next to the caller, which splits it into this many subtrees per thread
+constexpr uint32_t CULL_WORKERS = 3;
+constexpr uint32_t CULL_TASKS_PER_THREAD = 4;
+
+// Job system: per-thread deque and job pool sizes, failed steal rounds before an idle worker sleeps, and whether
+// workers are pinned to one core each. VULKAN_JOB_WORKERS and VULKAN_JOB_AFFINITY override the count and pinning.
+// The pool is larger than the deque so a thread that filled its deque still finds free jobs
+constexpr uint32_t JOB_DEQUE_CAPACITY = 4096;
+constexpr uint32_t JOB_POOL_SIZE = 8192;
+constexpr uint32_t JOB_IDLE_SPINS = 64;
+constexpr bool JOB_PIN_THREADS = false;
+
+// Test scene drawn when setupApp gets a vertex layout: a dense sphere instanced in a grid, so small on screen
+// that fetching its vertices rather than shading them bounds the frame
+constexpr uint32_t MESH_SCENE_RINGS = 512;
+constexpr uint32_t MESH_SCENE_SEGMENTS = 1024;
+constexpr uint32_t MESH_SCENE_INSTANCES = 16;
+
+// The scene is rendered in HDR and post-processed on the compute queue before it is copied to the swap chain
+constexpr VkFormat POST_HDR_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+// Workgroup width and height of every post shader
+constexpr uint32_t POST_TILE_SIZE = 8;
+// Bloom mips from half the scene size down, fewer on targets too small for them
+constexpr uint32_t POST_BLOOM_LEVELS = 5;
+constexpr float POST_BLOOM_THRESHOLD = 1.0f;
+constexpr float POST_BLOOM_STRENGTH = 0.05f;
+// Present the post chain of the previous frame so it runs while this one renders, one frame of extra latency
+constexpr bool POST_OVERLAP = true;
+
+// Draw only when the scene animates or input, a resize or markDirty changed something, see FramePacer
+constexpr bool RENDER_ON_DEMAND = true;
+// Longest the idle loop blocks in glfwWaitEventsTimeout before it checks again whether to close
+constexpr double PACER_IDLE_TIMEOUT = 0.5;
+// Share of a core frames drawn for input may take, costlier frames lower the frame rate cap towards PACER_MIN_FPS
+constexpr double PACER_CPU_BUDGET = 0.25;
+constexpr uint32_t PACER_MIN_FPS = 10;
+constexpr uint32_t PACER_MAX_FPS = 60;
+
+// Fixed rate of the simulation thread. Ticks missed by more than SIMULATION_MAX_CATCHUP_TICKS are dropped
+constexpr uint32_t SIMULATION_TICK_RATE = 60;
+constexpr uint32_t SIMULATION_MAX_CATCHUP_TICKS = 4;
+// Key events in flight from the event loop to the simulation thread, a power of two
+constexpr uint32_t SIMULATION_KEY_QUEUE_SIZE = 64;
+
+// Performance HUD drawn over every view, VULKAN_HUD=on|off overrides it. The graph shows the last
+// HUD_GRAPH_FRAMES frame times, and each frame slot has room for HUD_MAX_QUADS quads in the vertex ring
+constexpr bool HUD_ENABLED = true;
+constexpr uint32_t HUD_GRAPH_FRAMES = 120;
+constexpr uint32_t HUD_MAX_QUADS = 1024;
+// Frames between two memory budget queries, which may go to the kernel
+constexpr uint32_t HUD_MEMORY_INTERVAL = 30;
+
+// Command buffers capture_replay records per queue and frame slot before it waits for the slot to finish early
+constexpr uint32_t REPLAY_COMMAND_BUFFERS = 32;
 
 #endif
@@ -0,0 +1,111 @@
+#ifndef DEBUGLOG_HPP
+#define DEBUGLOG_HPP
+
+#include "Config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+
+struct DebugLogStats
+{
+    uint64_t received = 0;
+    uint64_t filtered = 0;
+    uint64_t dropped = 0;
+    uint64_t suppressed = 0;
+    uint64_t written = 0;
+    uint64_t performance = 0;
+};
+
+
+// Debug messenger sink. The callback only copies the message into a lock-free ring,
+// a background thread filters, rate-limits and writes it out
+class DebugLog
+{
+public:
+    DebugLog() = default;
+    DebugLog(const DebugLog&) =  delete;
+    DebugLog& operator=(const DebugLog&) = delete;
+    DebugLog(DebugLog&&) = delete;
+    DebugLog& operator=(DebugLog&&) = delete;
+    
+    void setupLog(std::ostream& os);
+    // Writes everything still queued before returning
+    void destroyLog(void);
+    
+    // Safe to call from any thread, never blocks
+    void push(const VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData);
+    
+    // INFO is only subscribed to when set before ValidationLayers::setupDebugMessenger
+    void setSeverityFilter(const VkDebugUtilsMessageSeverityFlagsEXT severities);
+    VkDebugUtilsMessageSeverityFlagsEXT getSeverityFilter(void) const;
+    void setTypeFilter(const VkDebugUtilsMessageTypeFlagsEXT types);
+    // Messages per message id and second, 0 disables rate limiting
+    void setRateLimit(const uint32_t messagesPerSecond);
+    
+    DebugLogStats getStats(void) const;
+    void reportPerformance(std::ostream& os) const;
+    
+private:
+    static constexpr size_t RING_SIZE = 256;
+    static constexpr size_t ID_NAME_SIZE = 64;
+    static constexpr size_t MESSAGE_SIZE = 1024;
+    
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+        VkDebugUtilsMessageTypeFlagsEXT type;
+        int32_t messageId;
+        char idName[ID_NAME_SIZE];
+        char message[MESSAGE_SIZE];
+    };
+    
+    struct MessageIdState
+    {
+        std::string name;
+        std::chrono::steady_clock::time_point windowStart;
+        uint32_t windowCount = 0;
+        uint64_t suppressed = 0;
+        uint64_t performanceCount = 0;
+    };
+    
+    std::ostream* os = nullptr;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> enqueuePos{0};
+    uint64_t dequeuePos = 0;
+    
+    std::atomic<VkDebugUtilsMessageSeverityFlagsEXT> severityFilter{VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT};
+    std::atomic<VkDebugUtilsMessageTypeFlagsEXT> typeFilter{VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT};
+    std::atomic<uint32_t> rateLimit{5};
+    
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> filtered{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> performance{0};
+    
+    // Owned by the writer thread, the mutex only guards reportPerformance
+    mutable std::mutex idMutex;
+    std::unordered_map<int32_t, MessageIdState> messageIds;
+    
+    std::thread writer;
+    std::atomic<bool> running{false};
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    
+    void writerLoop(void);
+    bool drain(void);
+    void write(const Slot& slot);
+    void flushSuppressed(MessageIdState& state);
+};
+
+#endif
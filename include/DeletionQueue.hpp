@@ -0,0 +1,58 @@
+#ifndef DELETIONQUEUE_HPP
+#define DELETIONQUEUE_HPP
+
+#include "Config.hpp"
+#include "Sync.hpp"
+
+#include <functional>
+#include <mutex>
+
+
+// Holds destroyed handles until the GPU has finished using them. Entries are either
+// tagged with a timeline value or with the frame slot that last used them
+class DeletionQueue
+{
+public:
+    using Deleter = std::function<void(const VkDevice)>;
+    
+    DeletionQueue() = default;
+    DeletionQueue(const DeletionQueue&) =  delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+    DeletionQueue(DeletionQueue&&) = delete;
+    DeletionQueue& operator=(DeletionQueue&&) = delete;
+    
+    // Released once the timeline has reached value
+    void push(const TimelineSemaphore& timeline, const uint64_t value, Deleter deleter);
+    // Released the next time this frame slot is reused
+    void pushFrame(const uint32_t frame, Deleter deleter);
+    
+    // Shortcuts for pushFrame, used when swap chains and the targets sized after them are rebuilt
+    void deferSwapchain(const uint32_t frame, const VkSwapchainKHR swapChain, const VkAllocationCallbacks* pAllocator = nullptr);
+    void deferImage(const uint32_t frame, const VkImage image, const VkAllocationCallbacks* pAllocator = nullptr);
+    void deferImageView(const uint32_t frame, const VkImageView imageView, const VkAllocationCallbacks* pAllocator = nullptr);
+    void deferFramebuffer(const uint32_t frame, const VkFramebuffer framebuffer, const VkAllocationCallbacks* pAllocator = nullptr);
+    void deferMemory(const uint32_t frame, const VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator = nullptr);
+    void deferDescriptorPool(const uint32_t frame, const VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator = nullptr);
+    void deferSemaphore(const uint32_t frame, const VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    // Call after waiting for the frame slot, releases everything that slot and the timelines have passed
+    void collect(const VkDevice device, const uint32_t frame);
+    // Shutdown only, the device must be idle
+    void flush(const VkDevice device);
+    
+    size_t getPendingCount(void) const;
+    
+private:
+    struct TimelineEntry
+    {
+        const TimelineSemaphore* timeline;
+        uint64_t value;
+        Deleter deleter;
+    };
+    
+    mutable std::mutex mutex;
+    std::vector<TimelineEntry> timelineEntries;
+    std::vector<Deleter> frameEntries[MAX_FRAMES_IN_FLIGHT];
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef DESCRIPTORBINDER_HPP
+#define DESCRIPTORBINDER_HPP
+
+#include "Config.hpp"
+#include "PipelineLayoutCache.hpp"
+
+
+// Tracks the descriptor sets bound in one command buffer and leaves out binds that would not change anything:
+// a set stays valid across pipelines whose layouts are compatible up to its number
+class DescriptorBinder
+{
+public:
+    DescriptorBinder() = default;
+    DescriptorBinder(const DescriptorBinder&) =  delete;
+    DescriptorBinder& operator=(const DescriptorBinder&) = delete;
+    DescriptorBinder(DescriptorBinder&&) = delete;
+    DescriptorBinder& operator=(DescriptorBinder&&) = delete;
+    
+    // At the start of every command buffer, a new one has nothing bound
+    void reset(void);
+    void cmdBindSets(const VkCommandBuffer commandBuffer, const PipelineLayoutCache& layoutCache, const VkPipelineBindPoint bindPoint, const VkPipelineLayout pipelineLayout, const uint32_t firstSet, const std::vector<VkDescriptorSet>& sets);
+    
+    // Counted since the last resetStats, in sets
+    const uint64_t getBoundCount(void) const;
+    const uint64_t getSkippedCount(void) const;
+    void resetStats(void);
+    
+private:
+    struct BoundSet
+    {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    };
+    
+    // Graphics and compute
+    std::vector<BoundSet> boundSets[2];
+    uint64_t boundCount = 0;
+    uint64_t skippedCount = 0;
+};
+
+#endif
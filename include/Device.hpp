@@ -3,6 +3,25 @@
 
 #include "Config.hpp"
 #include "Queue.hpp"
+#include "Capabilities.hpp"
+
+#include <string>
+#include <utility>
+
+
+struct OptionalDeviceExtension
+{
+    const char* name;
+    // Extensions it depends on, each with the API version that made it core
+    std::vector<std::pair<const char*, uint32_t>> dependencies;
+};
+
+// Summed over the device-local heaps, in bytes
+struct MemoryUsage
+{
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+};
 
 
 class Device
@@ -15,27 +34,38 @@ public:
     Device& operator=(Device&&) = delete;
     
     static const stringVector deviceExtensions;
+    static const std::vector<OptionalDeviceExtension> optionalDeviceExtensions;
     
-    void setupDevices(const VkInstance instance, const VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator = nullptr);
+    // Every surface must be presentable from the selected device and present family
+    void setupDevices(const VkInstance instance, const InstanceCapabilities& instanceCapabilities, const std::vector<VkSurfaceKHR>& surfaces, const VkAllocationCallbacks* pAllocator = nullptr);
     void destroyDevices(const VkAllocationCallbacks* pAllocator = nullptr);
     
     const VkDevice getLogicalDevice(void) const;
     const VkPhysicalDevice getPhysicalDevice(void) const;
     const QueueFamilyIndices getQIndices(void) const;
+    const DeviceCapabilities& getCapabilities(void) const;
+    // What the process uses and may use with memoryBudget. Without it usage is unknown and left 0, and the budget
+    // is the size of the heaps
+    const MemoryUsage queryMemoryUsage(void) const;
     
 private:
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice logicalDevice = VK_NULL_HANDLE;
     QueueFamilyIndices qIndices;
+    DeviceCapabilities capabilities;
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+    
+    static std::vector<VkExtensionProperties> getAvailableExtensions(const VkPhysicalDevice device);
     
-    int rateDeviceSuitability(const VkPhysicalDevice device, const VkSurfaceKHR surface);
-    bool isDeviceSuitable(const VkPhysicalDevice device, const VkSurfaceKHR surface);
+    int rateDeviceSuitability(const VkPhysicalDevice device, const std::vector<VkSurfaceKHR>& surfaces);
+    bool isDeviceSuitable(const VkPhysicalDevice device, const std::vector<VkSurfaceKHR>& surfaces);
     bool checkDeviceExtensionSupport(const VkPhysicalDevice device);
     
-    void populateDeviceCreateInfo(VkDeviceCreateInfo& createInfo, const std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos, const VkPhysicalDeviceFeatures& deviceFeatures, stringVector& extensions);
+    void populateDeviceCreateInfo(VkDeviceCreateInfo& createInfo, const std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos, const VkPhysicalDeviceFeatures* pDeviceFeatures, const stringVector& extensions);
+    stringVector negotiateExtensions(const InstanceCapabilities& instanceCapabilities);
     
-    void pickPhysicalDevice(const VkInstance instance, const VkSurfaceKHR surface);
-    void createLogicalDevice(const VkAllocationCallbacks* pAllocator);
+    void pickPhysicalDevice(const VkInstance instance, const std::vector<VkSurfaceKHR>& surfaces);
+    void createLogicalDevice(const VkInstance instance, const InstanceCapabilities& instanceCapabilities, const VkAllocationCallbacks* pAllocator);
 };
 
 #endif
@@ -0,0 +1,126 @@
+#ifndef FRAMECAPTURE_HPP
+#define FRAMECAPTURE_HPP
+
+#include "Config.hpp"
+#include "Buffer.hpp"
+#include "SwapChain.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+
+enum class CaptureFormat
+{
+    None,
+    Raw,
+    Ppm,
+    Y4m
+};
+
+struct CaptureConfig
+{
+    CaptureFormat format = CaptureFormat::None;
+    // File path, "%u" in it writes one file per frame. A leading '|' pipes the stream into a command
+    std::string output;
+    uint32_t ringSize = CAPTURE_RING_SIZE;
+    uint32_t workerCount = CAPTURE_WORKERS;
+    uint32_t frameRate = 60;
+};
+
+
+// Copies presented images into a ring of persistently mapped readback buffers. Slots are picked up
+// once the graphics timeline passes their frame, and worker threads encode them in frame order
+class FrameCapture
+{
+public:
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture&) =  delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    FrameCapture(FrameCapture&&) = delete;
+    FrameCapture& operator=(FrameCapture&&) = delete;
+    
+    // VULKAN_CAPTURE=<raw|ppm|y4m>:<output>, capture stays off when it is unset
+    static CaptureConfig configFromEnvironment(void);
+    
+    void setupCapture(const VkPhysicalDevice physicalDevice, const VkDevice device, const SwapChainConfig& swapChainConfig, const CaptureConfig& config, HostAllocator* hostAllocator = nullptr);
+    // The device must be idle; frames still in the ring are written out first
+    void destroyCapture(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    
+    bool isEnabled(void) const;
+    
+    // Recorded after the render pass. Counts a dropped frame when the encoders hold every slot, or when the image is
+    // not the size capture started with, since a stream keeps its size
+    void cmdCapture(const VkCommandBuffer commandBuffer, const VkImage image, const VkExtent2D imageExtent);
+    // Tags the frame recorded by cmdCapture with the timeline value its submission signals
+    void commitFrame(const uint64_t timelineValue);
+    // Hands every slot whose copy has completed to the encoder threads, never waits on the GPU
+    void poll(const VkDevice device, const uint64_t completedValue);
+    
+    // Final numbers are in once destroyCapture has drained the ring
+    void report(std::ostream& os) const;
+    
+private:
+    enum class SlotState
+    {
+        Free,
+        Recorded,
+        InFlight,
+        Encoding
+    };
+    
+    struct Slot
+    {
+        Buffer buffer;
+        const uint8_t* data = nullptr;
+        SlotState state = SlotState::Free;
+        uint64_t timelineValue = 0;
+        uint64_t frameNumber = 0;
+    };
+    
+    CaptureConfig config;
+    VkExtent2D extent = {0, 0};
+    bool swapRedBlue = false;
+    bool perFrameFiles = false;
+    
+    std::unique_ptr<Slot[]> slots;
+    uint32_t recordedSlot = 0;
+    bool hasRecordedSlot = false;
+    uint64_t nextFrameNumber = 0;
+    
+    std::mutex mutex;
+    std::condition_variable jobCondition;
+    std::deque<uint32_t> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    
+    std::mutex writeMutex;
+    std::condition_variable writeCondition;
+    uint64_t nextWriteFrame = 0;
+    
+    FILE* stream = nullptr;
+    bool streamIsPipe = false;
+    
+    std::atomic<uint64_t> capturedFrames{0};
+    std::atomic<uint64_t> writtenFrames{0};
+    std::atomic<uint64_t> droppedFrames{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::chrono::steady_clock::time_point startTime;
+    
+    const size_t getFrameSize(void) const;
+    
+    void openStream(void);
+    void closeStream(void);
+    void workerLoop(void);
+    void encode(const Slot& slot, std::vector<uint8_t>& scratch);
+    void write(const uint64_t frameNumber, const uint8_t* data, const size_t size);
+};
+
+#endif
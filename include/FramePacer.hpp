@@ -0,0 +1,112 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+#include "Config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <ostream>
+
+
+enum class PacingMode
+{
+    Continuous,     // Polls events and draws every loop iteration, the frame rate is bound by present
+    OnDemand        // Draws only when something changed, blocks in glfwWaitEventsTimeout otherwise
+};
+
+enum class PacerState
+{
+    Idle,       // Nothing changed, blocked waiting for events
+    Capped,     // Input, resize or posted changes, drawn at most at the adaptive cap
+    Active,     // The scene animates, every iteration draws
+    Count
+};
+
+struct KeyEvent
+{
+    int key = 0;
+    int action = 0;
+    int mods = 0;
+};
+
+// Why a frame has to be drawn, bits of the dirty mask
+enum class DirtyFlag : uint32_t
+{
+    Scene = 1,
+    Input = 2,
+    Resize = 4
+};
+
+
+// Decides when the main loop draws. On demand it blocks while the windows show an up to date frame, coalesces input
+// and resize events into frames no faster than a cap that keeps the CPU cost of drawing within PACER_CPU_BUDGET,
+// and draws uncapped while the scene animates. markDirty may be called from any thread and wakes the loop
+class FramePacer
+{
+public:
+    FramePacer() = default;
+    FramePacer(const FramePacer&) =  delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+    FramePacer(FramePacer&&) = delete;
+    FramePacer& operator=(FramePacer&&) = delete;
+    
+    // VULKAN_FRAME_PACING=continuous|on-demand overrides the compiled-in default
+    static PacingMode modeFromEnvironment(const PacingMode defaultMode);
+    
+    // Installs input, resize and refresh callbacks on the windows, which must outlive the pacer. settleFrames are
+    // drawn after the last change, so frames presented with a delay still get on screen. Key events are passed on
+    // to keyHandler on the thread polling events
+    void setupPacer(const PacingMode mode, const std::vector<GLFWwindow*>& windows, const uint32_t settleFrames, std::function<void(const KeyEvent&)> keyHandler = nullptr);
+    
+    // Processes events and returns true when a frame is due, the caller then draws and calls endFrame. false
+    // wakeups let the caller check whether to close
+    bool waitForFrame(void);
+    void endFrame(void);
+    
+    void markDirty(const DirtyFlag flag);
+    // A framebuffer changed size, unlike a refresh this also needs new swap chains
+    void markResized(void);
+    // Whether a framebuffer changed size since the last call
+    bool takeResized(void);
+    void handleKey(const KeyEvent& event);
+    // While the scene does not animate it only redraws on changes
+    void setAnimating(const bool animating);
+    bool isAnimating(void) const;
+    
+    void report(std::ostream& os) const;
+    
+private:
+    struct StateStats
+    {
+        double wallSeconds = 0.0;
+        double cpuSeconds = 0.0;
+        uint64_t wakeups = 0;
+        uint64_t frames = 0;
+    };
+    
+    PacingMode mode = PacingMode::Continuous;
+    PacerState state = PacerState::Idle;
+    std::atomic<uint32_t> dirtyMask{0};
+    std::atomic<bool> resized{false};
+    std::atomic<bool> animating{true};
+    uint32_t settleFrames = 0;
+    uint32_t settleFramesLeft = 0;
+    std::function<void(const KeyEvent&)> keyHandler;
+    
+    // Process CPU time per drawn frame, smoothed, and the interval it caps capped frames to
+    double frameCpuSeconds = 0.0;
+    double capInterval = 0.0;
+    double frameStartCpu = 0.0;
+    std::chrono::steady_clock::time_point lastFrameStart;
+    
+    // Every loop iteration is accounted to the state it started in
+    StateStats stats[static_cast<uint32_t>(PacerState::Count)];
+    std::chrono::steady_clock::time_point lastAccountWall;
+    double lastAccountCpu = 0.0;
+    
+    void accountTime(void);
+    bool beginFrame(void);
+};
+
+#endif
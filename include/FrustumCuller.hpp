@@ -0,0 +1,144 @@
+#ifndef FRUSTUMCULLER_HPP
+#define FRUSTUMCULLER_HPP
+
+#include "Config.hpp"
+#include "Simd.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+struct Bounds
+{
+    float min[3];
+    float max[3];
+};
+
+// Planes a x + b y + c z + d >= 0 on the inside, normalized
+struct Frustum
+{
+    float planes[6][4];
+    
+    // Column-major view-projection matrix with Vulkan's 0 to 1 clip depth
+    static Frustum fromViewProjection(const float matrix[16]);
+    // Camera at eye looking along forward, with forward and up perpendicular unit vectors
+    static Frustum fromPerspective(const float eye[3], const float forward[3], const float up[3], const float fovY, const float aspect, const float nearPlane, const float farPlane);
+};
+
+constexpr uint32_t CULL_NODE_WIDTH = 8;
+
+// Eight child boxes stored as structure of arrays, so one test covers all of them
+struct alignas(32) CullNode
+{
+    // min x, min y, min z, max x, max y, max z of every child
+    float bounds[6][CULL_NODE_WIDTH];
+    // Node index of an inner child, first leaf-order object of a leaf child
+    uint32_t child[CULL_NODE_WIDTH];
+    // Objects in a leaf child, 0 for an inner child
+    uint32_t count[CULL_NODE_WIDTH];
+    uint32_t childCount;
+    uint32_t parent;
+    // Leaf-order objects under this node
+    uint32_t first;
+    uint32_t end;
+};
+
+// Tests CULL_NODE_WIDTH consecutive boxes against the frustum. Returns the boxes not outside any plane,
+// insideMask gets those inside every plane
+using CullBoxesFunction = uint32_t (*)(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask);
+
+
+// BVH of eight-wide nodes over object bounds. Traversal starts from a frontier of subtrees that worker
+// threads take one at a time, each writing its own list, which are joined into one visible list
+class FrustumCuller
+{
+public:
+    FrustumCuller() = default;
+    FrustumCuller(const FrustumCuller&) =  delete;
+    FrustumCuller& operator=(const FrustumCuller&) = delete;
+    FrustumCuller(FrustumCuller&&) = delete;
+    FrustumCuller& operator=(FrustumCuller&&) = delete;
+    
+    void setupCuller(const uint32_t workerCount = CULL_WORKERS);
+    void destroyCuller(void);
+    
+    void setKernel(const SimdKernel kernel);
+    SimdKernel getKernel(void) const;
+    
+    // Object i gets bounds[i]
+    void build(const std::vector<Bounds>& bounds);
+    // Takes effect in the next refit, the tree keeps its shape
+    void setBounds(const uint32_t object, const Bounds& bounds);
+    // Grows and shrinks only the nodes above objects moved since the last refit
+    void refit(void);
+    
+    // Indices of the objects whose bounds intersect the frustum, valid until the next cull
+    const std::vector<uint32_t>& cull(const Frustum& frustum);
+    
+    uint32_t getObjectCount(void) const;
+    uint32_t getNodeCount(void) const;
+    
+    // Plain loop over every object, as reference for the tree
+    static void cullBruteForce(const std::vector<Bounds>& bounds, const Frustum& frustum, std::vector<uint32_t>& visible);
+    
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+    
+    struct CullTask
+    {
+        uint32_t node;
+        std::vector<uint32_t> stack;
+        std::vector<uint32_t> visible;
+    };
+    
+    std::vector<CullNode> nodes;
+    // Object bounds in leaf order, padded so a leaf test may read a full node width
+    std::vector<float> objectBounds[6];
+    // Leaf order to object index and back
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> leafSlots;
+    // Node holding the leaf of every object
+    std::vector<uint32_t> objectNodes;
+    std::vector<uint8_t> dirtyNodes;
+    bool dirty = false;
+    
+    SimdKernel kernel = simd::detectKernel();
+    CullBoxesFunction cullBoxes = nullptr;
+    
+    Frustum frustum;
+    std::vector<uint32_t> visible;
+    std::vector<CullTask> tasks;
+    std::vector<uint32_t> frontierVisible;
+    std::atomic<uint32_t> nextTask{0};
+    
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    std::vector<std::thread> workers;
+    uint64_t generation = 0;
+    uint32_t activeWorkers = 0;
+    bool stopping = false;
+    
+    uint32_t buildNode(const std::vector<Bounds>& bounds, const uint32_t begin, const uint32_t end, const uint32_t parent);
+    void refitNode(const uint32_t node);
+    void markDirty(uint32_t node);
+    
+    void emitRange(const uint32_t first, const uint32_t end, std::vector<uint32_t>& output) const;
+    // Tests the children of node; visible inner children go to next, visible objects to output
+    void visitNode(const uint32_t node, std::vector<uint32_t>& next, std::vector<uint32_t>& output) const;
+    void traverse(CullTask& task) const;
+    void runTasks(void);
+    // startGeneration is the generation when setupCuller started the worker
+    void workerLoop(const uint64_t startGeneration);
+};
+
+
+// Kernel entry points, defined only where the target has the instruction set
+uint32_t cullBoxesScalar(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask);
+uint32_t cullBoxesSse(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask);
+uint32_t cullBoxesAvx2(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask);
+uint32_t cullBoxesNeon(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask);
+
+#endif
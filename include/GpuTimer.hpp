@@ -0,0 +1,70 @@
+#ifndef GPUTIMER_HPP
+#define GPUTIMER_HPP
+
+#include "Config.hpp"
+
+#include <ostream>
+
+
+struct GpuInterval
+{
+    double beginNs = 0.0;
+    double endNs = 0.0;
+    
+    double durationMs(void) const;
+};
+
+
+// Timestamp pair per frame slot, written at the start and end of a command buffer. Splits in between divide
+// the slot into consecutive sections, each ending once all work recorded before its split has completed
+class GpuTimer
+{
+public:
+    GpuTimer() = default;
+    GpuTimer(const GpuTimer&) =  delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+    GpuTimer(GpuTimer&&) = delete;
+    GpuTimer& operator=(GpuTimer&&) = delete;
+    
+    void setupTimer(const VkPhysicalDevice physicalDevice, const VkDevice device, const uint32_t queueFamilyIndex, const uint32_t slotCount, const uint32_t sectionCount = 1, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroyTimer(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    void cmdBegin(const VkCommandBuffer commandBuffer, const uint32_t slot);
+    // Ends section and starts the next one, for sections below sectionCount - 1
+    void cmdSplit(const VkCommandBuffer commandBuffer, const uint32_t slot, const uint32_t section);
+    void cmdEnd(const VkCommandBuffer commandBuffer, const uint32_t slot);
+    
+    // Only call once the work recorded into the slot has completed. The interval spans every section
+    bool readInterval(const VkDevice device, const uint32_t slot, GpuInterval& interval);
+    bool readSections(const VkDevice device, const uint32_t slot, std::vector<GpuInterval>& sections);
+    
+    bool isSupported(void) const;
+    
+private:
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    double timestampPeriod = 1.0;
+    uint64_t timestampMask = 0;
+    uint32_t sectionCount = 1;
+    std::vector<bool> slotWritten;
+};
+
+
+// Accumulates per-frame compute and graphics intervals to show how much compute time hides behind rendering
+class OverlapStats
+{
+public:
+    void addFrame(const GpuInterval& compute, const GpuInterval& graphics, const double cpuFrameMs);
+    void report(std::ostream& os, const bool asyncCompute) const;
+    void reset(void);
+    
+    uint32_t getFrameCount(void) const;
+    
+private:
+    uint32_t frameCount = 0;
+    double computeMs = 0.0;
+    double graphicsMs = 0.0;
+    double overlapMs = 0.0;
+    double cpuFrameMs = 0.0;
+};
+
+#endif
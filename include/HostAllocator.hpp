@@ -0,0 +1,108 @@
+#ifndef HOSTALLOCATOR_HPP
+#define HOSTALLOCATOR_HPP
+
+#include "Config.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+
+enum class HostAllocatorMode
+{
+    Driver,     // nullptr callbacks, the driver's own allocator
+    Tracking,   // Counts bytes and calls per object type and allocation scope
+    Arena       // Tracking, with COMMAND-scope allocations served from a per-frame arena
+};
+
+
+// VkAllocationCallbacks for host-side driver allocations. Each object type gets its own
+// callbacks so allocations are attributed to the object that caused them
+class HostAllocator
+{
+public:
+    HostAllocator() = default;
+    HostAllocator(const HostAllocator&) =  delete;
+    HostAllocator& operator=(const HostAllocator&) = delete;
+    HostAllocator(HostAllocator&&) = delete;
+    HostAllocator& operator=(HostAllocator&&) = delete;
+    
+    // VULKAN_HOST_ALLOCATOR=driver|tracking|arena overrides the compiled-in default
+    static HostAllocatorMode modeFromEnvironment(const HostAllocatorMode defaultMode);
+    
+    void setupAllocator(const HostAllocatorMode mode, const size_t arenaBlockSize = 256 * 1024);
+    void destroyAllocator(void);
+    
+    // nullptr in Driver mode. Must be passed to the matching vkDestroy* call as well
+    const VkAllocationCallbacks* getCallbacks(const VkObjectType objectType);
+    // For setup functions that create objects of several types and take the allocator optionally, nullptr without one
+    static const VkAllocationCallbacks* callbacksFor(HostAllocator* hostAllocator, const VkObjectType objectType);
+    
+    // Rewinds the COMMAND-scope arena, skipped while a driver call still holds arena memory
+    void resetArena(void);
+    void report(std::ostream& os) const;
+    
+    HostAllocatorMode getMode(void) const;
+
+private:
+    static constexpr uint32_t SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+    
+    struct ScopeCounters
+    {
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> reallocations{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<uint64_t> arenaAllocations{0};
+        std::atomic<uint64_t> totalBytes{0};
+        std::atomic<int64_t> liveBytes{0};
+        std::atomic<int64_t> peakBytes{0};
+    };
+    
+    // pUserData of the callbacks handed out for one object type
+    struct TypeSlot
+    {
+        HostAllocator* owner;
+        VkObjectType objectType;
+        VkAllocationCallbacks callbacks;
+        ScopeCounters scopes[SCOPE_COUNT];
+    };
+    
+    struct ArenaBlock
+    {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    
+    HostAllocatorMode mode = HostAllocatorMode::Driver;
+    // Guards the list, not the slots: startup tasks ask for callbacks from several threads at once
+    mutable std::mutex slotMutex;
+    std::vector<std::unique_ptr<TypeSlot>> slots;
+    
+    std::atomic<uint64_t> internalAllocations[SCOPE_COUNT] = {};
+    std::atomic<int64_t> internalLiveBytes[SCOPE_COUNT] = {};
+    
+    mutable std::mutex arenaMutex;
+    std::vector<ArenaBlock> arenaBlocks;
+    size_t arenaBlockSize = 0;
+    size_t arenaBlock = 0;
+    size_t arenaOffset = 0;
+    size_t arenaPeakBytes = 0;
+    size_t arenaFrameBytes = 0;
+    std::atomic<int64_t> arenaLiveAllocations{0};
+    uint64_t arenaResets = 0;
+    uint64_t arenaSkippedResets = 0;
+    
+    TypeSlot& getSlot(const VkObjectType objectType);
+    void* allocate(TypeSlot& slot, const size_t size, const size_t alignment, const VkSystemAllocationScope scope);
+    void* allocateFromArena(const size_t size, const size_t alignment);
+    void release(TypeSlot& slot, void* pMemory);
+    
+    static VKAPI_ATTR void* VKAPI_CALL allocationCallback(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void* VKAPI_CALL reallocationCallback(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL freeCallback(void* pUserData, void* pMemory);
+    static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope scope);
+};
+
+#endif
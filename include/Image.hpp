@@ -0,0 +1,44 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include "Config.hpp"
+#include "HostAllocator.hpp"
+#include "DeletionQueue.hpp"
+
+
+// 2D device-local image with a view of every mip level and one of the whole chain
+class Image
+{
+public:
+    Image() = default;
+    Image(const Image&) =  delete;
+    Image& operator=(const Image&) = delete;
+    Image(Image&&) = delete;
+    Image& operator=(Image&&) = delete;
+    
+    // Images shared by more than one queue family are created with concurrent sharing
+    void setupImage(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkExtent2D extent, const VkFormat format, const uint32_t mipLevels, const VkImageUsageFlags usage, const std::vector<uint32_t>& queueFamilies = {}, HostAllocator* hostAllocator = nullptr);
+    void destroyImage(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    // Hands the handles over to be destroyed once frame's slot is reused, the image can be set up again right away
+    void deferDestroy(DeletionQueue& deletionQueue, const uint32_t frame, HostAllocator* hostAllocator = nullptr);
+    
+    const VkImage getImage(void) const;
+    const VkImageView getView(void) const;
+    const VkImageView getMipView(const uint32_t mipLevel) const;
+    const VkExtent2D getExtent(const uint32_t mipLevel = 0) const;
+    const VkFormat getFormat(void) const;
+    const uint32_t getMipLevels(void) const;
+    
+private:
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    std::vector<VkImageView> mipViews;
+    VkExtent2D extent = {0, 0};
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    
+    void populateImageCreateInfo(VkImageCreateInfo& createInfo, const uint32_t mipLevels, const VkImageUsageFlags usage, const std::vector<uint32_t>& queueFamilies);
+    VkImageView createView(const VkDevice device, const uint32_t baseMipLevel, const uint32_t levelCount, const VkAllocationCallbacks* pAllocator);
+};
+
+#endif
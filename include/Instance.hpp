@@ -2,14 +2,18 @@
 #define INSTANCE_HPP
 
 #include "Config.hpp"
+#include "Capabilities.hpp"
 
 namespace Instance
 {
     stringVector getRequiredInstanceExtensions(void);
     
-    void populateInstanceCreateInfo(VkInstanceCreateInfo& createInfo, VkApplicationInfo& appInfo, VkDebugUtilsMessengerCreateInfoEXT& debugCreateInfo, stringVector& extensions);
+    // Probes the loader and appends every available optional extension to extensions
+    InstanceCapabilities negotiateCapabilities(stringVector& extensions);
     
-    void populateApplicationInfo(VkApplicationInfo& appInfo);
+    void populateInstanceCreateInfo(VkInstanceCreateInfo& createInfo, VkApplicationInfo& appInfo, VkDebugUtilsMessengerCreateInfoEXT& debugCreateInfo, stringVector& extensions, const InstanceCapabilities& capabilities);
+    
+    void populateApplicationInfo(VkApplicationInfo& appInfo, const uint32_t apiVersion);
 };
 
 #endif
@@ -0,0 +1,186 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+#include "Config.hpp"
+#include "WorkStealingDeque.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+struct JobSystemConfig
+{
+    // Threads next to the one calling setupJobSystem, which takes part whenever it waits
+    uint32_t workerCount = 0;
+    // Worker i runs on core i + 1 and the calling thread on core 0. Linux only, ignored elsewhere
+    bool pinThreads = JOB_PIN_THREADS;
+};
+
+// Unfinished jobs of a batch. Every job submitted with the counter adds one, waiting on it runs other jobs until
+// it is back at zero. The first exception thrown by one of the jobs is rethrown by the wait
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) =  delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+    JobCounter(JobCounter&&) = delete;
+    JobCounter& operator=(JobCounter&&) = delete;
+    
+    bool isDone(void) const;
+    
+private:
+    friend class JobSystem;
+    
+    std::atomic<uint32_t> pending{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr failure;
+    
+    void fail(std::exception_ptr error);
+};
+
+// A job lives in the pool of the thread that submitted it and carries its callable inline, so submitting never
+// allocates. The slot is handed back once the job has run
+struct alignas(64) Job
+{
+    static constexpr size_t PAYLOAD_SIZE = 96;
+    
+    void (*function)(Job& job) = nullptr;
+    JobCounter* counter = nullptr;
+    std::atomic<bool> inUse{false};
+    alignas(16) unsigned char payload[PAYLOAD_SIZE];
+};
+
+struct JobStats
+{
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+    // Submitted while the deque was full and run on the spot
+    uint64_t runInline = 0;
+    uint64_t sleeps = 0;
+};
+
+
+// Work-stealing job system. Every thread owns a Chase-Lev deque and a pool of jobs: new jobs go to the bottom of
+// the submitting thread's deque, which it drains newest first while idle threads steal the oldest from the top.
+// Only the thread that set the system up and its workers can submit or wait
+class JobSystem
+{
+public:
+    JobSystem() = default;
+    JobSystem(const JobSystem&) =  delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    JobSystem(JobSystem&&) = delete;
+    JobSystem& operator=(JobSystem&&) = delete;
+    
+    // VULKAN_JOB_WORKERS=<count> and VULKAN_JOB_AFFINITY=on|off over the given defaults
+    static JobSystemConfig configFromEnvironment(const uint32_t defaultWorkers);
+    // One worker per core besides the calling thread
+    static uint32_t getCoreWorkerCount(void);
+    
+    void setupJobSystem(const JobSystemConfig& config);
+    // Jobs nobody has waited for yet are dropped
+    void destroyJobSystem(void);
+    
+    template <typename Function>
+    void submit(Function&& function, JobCounter* counter = nullptr)
+    {
+        using Stored = std::decay_t<Function>;
+        static_assert(sizeof(Stored) <= Job::PAYLOAD_SIZE && alignof(Stored) <= 16, "Job captures too large, capture a pointer to them instead");
+        
+        Job& job = allocateJob();
+        new (job.payload) Stored(std::forward<Function>(function));
+        job.function = [](Job& self)
+        {
+            struct Guard
+            {
+                Stored& stored;
+                ~Guard() { stored.~Stored(); }
+            } guard{*std::launder(reinterpret_cast<Stored*>(self.payload))};
+            guard.stored();
+        };
+        job.counter = counter;
+        pushJob(job);
+    }
+    
+    // Runs queued jobs on the calling thread until the counter is back at zero
+    void wait(JobCounter& counter);
+    // Runs one queued job on the calling thread, false when there was none to take
+    bool runPendingJob(void);
+    
+    // Calls function(chunkBegin, chunkEnd) over disjoint chunks of [begin, end) and returns once all of them have
+    // run. A range is only split while some thread may be idle to take half of it, and never below minChunk
+    template <typename Function>
+    void parallelFor(const uint32_t begin, const uint32_t end, const uint32_t minChunk, const Function& function)
+    {
+        RangeFunction range;
+        range.context = &function;
+        range.call = [](const void* context, const uint32_t chunkBegin, const uint32_t chunkEnd)
+        {
+            (*static_cast<const Function*>(context))(chunkBegin, chunkEnd);
+        };
+        runParallelFor(begin, end, minChunk, range);
+    }
+    
+    const uint32_t getWorkerCount(void) const;
+    // Summed over every thread
+    JobStats getStats(void) const;
+    void report(std::ostream& os) const;
+    
+private:
+    struct RangeFunction
+    {
+        void (*call)(const void* context, const uint32_t chunkBegin, const uint32_t chunkEnd) = nullptr;
+        const void* context = nullptr;
+    };
+    
+    struct alignas(64) ThreadState
+    {
+        WorkStealingDeque<Job*, JOB_DEQUE_CAPACITY> deque;
+        std::unique_ptr<Job[]> pool;
+        uint32_t nextJob = 0;
+        uint32_t stealSeed = 0;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> runInline{0};
+        std::atomic<uint64_t> sleeps{0};
+    };
+    
+    JobSystemConfig config;
+    // Index 0 is the thread that called setupJobSystem
+    std::unique_ptr<ThreadState[]> threadStates;
+    uint32_t threadCount = 0;
+    std::vector<std::thread> workers;
+    
+    std::atomic<bool> running{false};
+    // Jobs sitting in any deque, which is what idle workers sleep on
+    std::atomic<int32_t> queuedCount{0};
+    std::atomic<uint32_t> sleepingCount{0};
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    
+    JobSystem* previousSystem = nullptr;
+    uint32_t previousIndex = 0;
+    
+    uint32_t getThreadIndex(void) const;
+    Job& allocateJob(void);
+    void pushJob(Job& job);
+    Job* findJob(const uint32_t index);
+    void runJob(Job& job);
+    void runParallelFor(const uint32_t begin, const uint32_t end, const uint32_t minChunk, const RangeFunction& range);
+    void runRange(uint32_t begin, uint32_t end, const uint32_t grain, const RangeFunction& range, JobCounter& counter);
+    void pinThread(const uint32_t index) const;
+    void workerLoop(const uint32_t index);
+};
+
+#endif
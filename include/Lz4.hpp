@@ -0,0 +1,16 @@
+#ifndef LZ4_HPP
+#define LZ4_HPP
+
+#include "Utils.hpp"
+
+
+// LZ4 block format (no frame header), readable by the reference lz4 library. The compressor is the greedy
+// single-probe one: fast enough to pack at build time, and decompression runs at memory speed either way
+namespace lz4
+{
+    std::vector<char> compress(const ByteView input);
+    // Throws on corrupt input or when it does not decode to exactly output.size bytes
+    void decompress(const ByteView input, char* output, const size_t outputSize);
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+struct MeshVertex
+{
+    float position[3];
+    float normal[3];
+    // w is the bitangent sign
+    float tangent[4];
+    float uv[2];
+    float color[4];
+};
+
+// 24 instead of 64 bytes, decoded by the vertex input unit and shaders/mesh.vert
+struct QuantizedVertex
+{
+    // SNORM16 within the mesh bounds, w holds the tangent's bitangent sign
+    int16_t position[4];
+    // Octahedral SNORM16 unit vectors
+    int16_t normal[2];
+    int16_t tangent[2];
+    // UNORM16 within the UV bounds
+    uint16_t uv[2];
+    uint8_t color[4];
+};
+
+// Maps normalized attributes back to mesh space, vec4-aligned to sit in a push constant block
+struct VertexDequantization
+{
+    float positionScale[4] = {1.0f, 1.0f, 1.0f, 0.0f};
+    float positionOffset[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float uvScale[2] = {1.0f, 1.0f};
+    float uvOffset[2] = {0.0f, 0.0f};
+};
+
+enum class VertexLayout : uint32_t
+{
+    // No vertex buffer, the shader builds its vertices
+    None,
+    Float,
+    Quantized,
+    // Screen-space HUD vertices (OverlayVertex), never the layout of a mesh
+    Overlay
+};
+
+// Index range of one level of detail; error is relative to the mesh extent
+struct MeshLod
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t meshletOffset;
+    uint32_t meshletCount;
+    float error;
+};
+
+// Up to MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles with local 8-bit indices.
+// The cone culls the whole meshlet when dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff
+struct Meshlet
+{
+    uint32_t vertexOffset;
+    uint32_t triangleOffset;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    float center[3];
+    float radius;
+    float coneApex[3];
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// Every level of detail indexes the same vertex array, meshlets refer to it through meshletVertices.
+// Only the array matching vertexLayout is filled
+struct MeshData
+{
+    VertexLayout vertexLayout = VertexLayout::Float;
+    std::vector<MeshVertex> vertices;
+    std::vector<QuantizedVertex> quantizedVertices;
+    VertexDequantization dequantization;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+};
+
+
+namespace mesh
+{
+    // .vmesh files as written by the mesh_optimizer tool
+    void saveMesh(const std::string& path, const MeshData& mesh);
+    MeshData loadMesh(const std::string& path);
+    
+    // UV sphere with every attribute filled, vertex fetch dominates when it covers few pixels
+    MeshData createSphere(const uint32_t rings, const uint32_t segments);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include "Mesh.hpp"
+
+
+// Post-transform cache simulation over an index buffer
+struct VertexCacheStats
+{
+    // Vertices shaded per triangle, 0.5 at best and 3 at worst
+    float acmr = 0.0f;
+    // Vertices shaded per referenced vertex, 1 at best
+    float atvr = 0.0f;
+    uint32_t misses = 0;
+};
+
+
+// Preprocessing passes for triangle lists, run offline by the mesh_optimizer tool
+namespace mesh
+{
+    constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+    
+    // FIFO cache of cacheSize entries, as on most current GPUs
+    VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, const uint32_t vertexCount, const uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+    
+    // Forsyth's linear-speed reordering for vertex cache locality
+    void optimizeVertexCache(std::vector<uint32_t>& indices, const uint32_t vertexCount);
+    // Sorts the clusters left by optimizeVertexCache outside-in, keeps the old order if ACMR grows by more than threshold
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, const float threshold = 1.05f);
+    // Per-vertex tangent frames from the UV layout, with the bitangent sign in w. Vertices without a usable
+    // UV gradient get any tangent perpendicular to their normal
+    void generateTangents(const std::vector<uint32_t>& indices, std::vector<MeshVertex>& vertices);
+    
+    // Renumbers vertices in first-use order and drops unused ones
+    void optimizeVertexFetch(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices);
+    
+    // Quadric edge collapse down to targetIndexCount or targetError (relative to the mesh extent), whichever
+    // comes first. Border and attribute-seam vertices stay in place so the result has no new holes
+    std::vector<uint32_t> simplify(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, const size_t targetIndexCount, const float targetError, float& resultError);
+    
+    // Greedy split in index order, appended to the meshlet arrays of mesh
+    void buildMeshlets(const std::vector<uint32_t>& indices, const uint32_t indexOffset, const uint32_t indexCount, MeshData& mesh);
+};
+
+#endif
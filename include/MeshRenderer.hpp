@@ -0,0 +1,68 @@
+#ifndef MESHRENDERER_HPP
+#define MESHRENDERER_HPP
+
+#include "Config.hpp"
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "Pipeline.hpp"
+
+
+// Shading done by shaders/mesh.frag, specialized into the pipeline
+struct MeshShaderFeatures
+{
+    // Up to 8
+    uint32_t lightCount = 1;
+    bool bumpMapping = true;
+    bool vertexColors = true;
+    // Pushes the features as constants and branches on them per fragment instead, like an ubershader
+    bool runtimeBranches = false;
+};
+
+
+// One indexed mesh in device-local buffers with the pipeline for its vertex layout
+class MeshRenderer
+{
+public:
+    MeshRenderer() = default;
+    MeshRenderer(const MeshRenderer&) =  delete;
+    MeshRenderer& operator=(const MeshRenderer&) = delete;
+    MeshRenderer(MeshRenderer&&) = delete;
+    MeshRenderer& operator=(MeshRenderer&&) = delete;
+    
+    // Before setup, or at runtime between frames, which switches to the pipeline variant of the features and
+    // builds it the first time
+    void setShaderFeatures(const MeshShaderFeatures& features);
+    // Before setup, see Pipeline::setPipelineLibrary. With the library the fragment parts of every specialized
+    // feature combination are compiled as jobs during setup
+    void setPipelineLibrary(const bool enabled, JobSystem* jobSystem = nullptr);
+    
+    // Float meshes are quantized on upload when layout asks for it. The upload is submitted to graphicsQueue
+    // and waited for, so nothing else may use that queue meanwhile
+    void setupMeshRenderer(const VkPhysicalDevice physicalDevice, const VkDevice device, const uint32_t graphicsFamily, const VkQueue graphicsQueue, const VkRenderPass renderPass, const MeshData& mesh, const VertexLayout layout, const ByteView vertShaderCode, const ByteView fragShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache = VK_NULL_HANDLE, HostAllocator* hostAllocator = nullptr);
+    void destroyMeshRenderer(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    
+    // Once per frame, see Pipeline::updatePipelines
+    void updatePipelines(DeletionQueue& deletionQueue, const uint32_t frame);
+    
+    // Draws instanceCount copies in a grid fitted to extent, inside a render pass with viewport and scissor set
+    void cmdDraw(const VkCommandBuffer commandBuffer, const VkExtent2D extent, const uint32_t instanceCount) const;
+    
+    const VkDeviceSize getVertexBufferSize(void) const;
+    void report(std::ostream& os) const;
+    
+private:
+    Pipeline pipeline;
+    Buffer vertexBuffer;
+    Buffer indexBuffer;
+    CommandPool commandPool;
+    VertexDequantization dequantization;
+    MeshShaderFeatures features;
+    ShaderVariant vertexVariant;
+    uint32_t indexCount = 0;
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+    
+    void uploadBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkQueue graphicsQueue, Buffer& buffer, const void* data, const VkDeviceSize size, const VkBufferUsageFlags usage, HostAllocator* hostAllocator);
+};
+
+#endif
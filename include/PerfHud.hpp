@@ -0,0 +1,127 @@
+#ifndef PERFHUD_HPP
+#define PERFHUD_HPP
+
+#include "Config.hpp"
+#include "Buffer.hpp"
+#include "GpuTimer.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "Utils.hpp"
+#include "VertexFormat.hpp"
+
+#include <ostream>
+
+
+// Everything the HUD shows, read by headless runs through VulkanProject::getPerfMetrics. GPU times are of the
+// latest frame whose slot has completed, 0 where the device has no timestamps
+struct PerfMetrics
+{
+    // Between the starts of this frame and the previous one
+    double frameMs = 0.0;
+    // Of the previous drawFrame, without the time it waited for frame slots
+    double cpuMs = 0.0;
+    double gpuGraphicsMs = 0.0;
+    double gpuComputeMs = 0.0;
+    double gpuPostMs = 0.0;
+    // Recorded by the previous frame, see capture::takeCommandCounts
+    uint32_t draws = 0;
+    uint32_t dispatches = 0;
+    uint32_t pipelineBinds = 0;
+    // Device-local heaps, see Device::queryMemoryUsage
+    VkDeviceSize memoryUsage = 0;
+    VkDeviceSize memoryBudget = 0;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    // What the HUD itself cost: building its vertices on the CPU, drawing them on the GPU
+    double hudCpuMs = 0.0;
+    double hudGpuMs = 0.0;
+};
+
+// Push constants of shaders/hud.vert
+struct HudPushConstants
+{
+    float scale[2];
+    float offset[2];
+};
+
+// Swap chain image the HUD is drawn over, with a framebuffer made for getRenderPass
+struct HudTarget
+{
+    VkFramebuffer framebuffer;
+    VkExtent2D extent;
+};
+
+
+// Overlay with a frame time graph, the CPU/GPU split, command counts, memory usage and present mode. Each frame
+// slot writes its quads into its part of a mapped vertex ring, drawn with one draw per view; text comes from the
+// 1-bit font atlas baked into shaders/hud.frag
+class PerfHud
+{
+public:
+    PerfHud() = default;
+    PerfHud(const PerfHud&) =  delete;
+    PerfHud& operator=(const PerfHud&) = delete;
+    PerfHud(PerfHud&&) = delete;
+    PerfHud& operator=(PerfHud&&) = delete;
+    
+    // VULKAN_HUD=on|off over the default
+    static bool enabledFromEnvironment(const bool defaultEnabled);
+    static const char* getPresentModeName(const VkPresentModeKHR presentMode);
+    
+    // outputFormat is the format of the swap chains drawn over, which the composite leaves in PRESENT_SRC_KHR
+    void setupHud(const VkPhysicalDevice physicalDevice, const VkDevice device, const uint32_t graphicsFamily, const VkFormat outputFormat, const ByteView vertShaderCode, const ByteView fragShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache = VK_NULL_HANDLE, HostAllocator* hostAllocator = nullptr);
+    void destroyHud(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    
+    // Once per frame, also without setupHud so the metrics are there with the HUD off. Keeps the HUD's own costs
+    void addFrame(const PerfMetrics& metrics);
+    // Only call once the work recorded into the slot has completed
+    void readTimings(const VkDevice device, const uint32_t slot);
+    // Writes the quads of the latest metrics into the slot's part of the ring, after the slot has been waited for
+    void buildFrame(const uint32_t slot);
+    
+    // At the start of the command buffer that writes the images the HUD is drawn over
+    void cmdBegin(const VkCommandBuffer commandBuffer, const uint32_t slot);
+    // Once those writes are recorded. Leaves every image in PRESENT_SRC_KHR
+    void cmdDraw(const VkCommandBuffer commandBuffer, const uint32_t slot, const std::vector<HudTarget>& targets);
+    
+    const VkRenderPass getRenderPass(void) const;
+    const PerfMetrics& getMetrics(void) const;
+    // Averages and maxima since the first frame
+    void report(std::ostream& os) const;
+    
+private:
+    Pipeline pipeline;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    // HUD_MAX_QUADS quads per frame slot, mapped for the life of the HUD
+    Buffer vertexRing;
+    OverlayVertex* vertices = nullptr;
+    uint32_t vertexCounts[MAX_FRAMES_IN_FLIGHT] = {};
+    // Composite and HUD sections, so the HUD's time does not include the copies before it
+    GpuTimer timer;
+    
+    PerfMetrics metrics;
+    // Frame times of the graph, oldest at historyHead once it is full
+    float frameHistory[HUD_GRAPH_FRAMES] = {};
+    uint32_t historyHead = 0;
+    uint32_t historyCount = 0;
+    
+    uint32_t frameCount = 0;
+    double frameMsTotal = 0.0;
+    double frameMsMax = 0.0;
+    double cpuMsTotal = 0.0;
+    uint32_t hudCpuFrames = 0;
+    double hudCpuMsTotal = 0.0;
+    double hudCpuMsMax = 0.0;
+    uint32_t hudGpuFrames = 0;
+    double hudGpuMsTotal = 0.0;
+    double hudGpuMsMax = 0.0;
+    
+    void createRenderPass(const VkDevice device, const VkFormat outputFormat, HostAllocator* hostAllocator);
+    
+    // Colors are 0xRRGGBBAA
+    void pushQuad(const uint32_t slot, const float x0, const float y0, const float x1, const float y1, const float u0, const float v0, const float u1, const float v1, const uint32_t color);
+    void pushRect(const uint32_t slot, const float x0, const float y0, const float x1, const float y1, const uint32_t color);
+    // Lower case is drawn in upper case, anything else the atlas lacks as '?'
+    void pushText(const uint32_t slot, const float x, const float y, const char* text, const uint32_t color);
+};
+
+#endif
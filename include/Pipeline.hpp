@@ -2,10 +2,32 @@
 #define PIPELINE_HPP
 
 #include "Config.hpp"
+#include "DeletionQueue.hpp"
+#include "JobSystem.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "ShaderVariant.hpp"
+#include "Utils.hpp"
+#include "VertexFormat.hpp"
 
+#include <deque>
+#include <mutex>
+#include <ostream>
 
-using VkAllocationCallbacksPair = std::pair<const VkAllocationCallbacks*, const VkAllocationCallbacks*>;
 
+// Variants built so far and the worst time one took on the thread that asked for it
+struct PipelineStats
+{
+    uint32_t monolithicCount = 0;
+    uint32_t linkedCount = 0;
+    uint32_t optimizedCount = 0;
+    double worstBuildMs = 0.0;
+};
+
+
+// Graphics pipeline with one variant per pair of vertex and fragment specializations. With the pipeline library
+// its four parts are compiled on their own: vertex input and fragment output once, the two shader stages once per
+// variant of that stage. A new variant is then fast-linked from parts while the optimized link is compiled as a
+// job and swapped in by updatePipelines
 class Pipeline
 {
 public:
@@ -15,22 +37,95 @@ public:
     Pipeline(Pipeline&&) = delete;
     Pipeline& operator=(Pipeline&&) = delete;
     
-    void setupGraphicsPipeline(const VkDevice device, const VkRenderPass renderPass, const VkAllocationCallbacksPair pAllocators = {nullptr, nullptr});
-    void destroyGraphicsPipeline(const VkDevice device, const VkAllocationCallbacksPair pAllocators = {nullptr, nullptr});
+    static VkShaderModule createShaderModule(const VkDevice device, const ByteView code);
+    
+    // VULKAN_PIPELINE_LIBRARY=on|off over the default
+    static bool libraryFromEnvironment(const bool defaultEnabled);
+    
+    // All three take effect at the next setupGraphicsPipeline. Layouts other than None feed one vertex binding,
+    // whose attributes must cover the inputs of the vertex shader
+    void setVertexLayout(const VertexLayout layout);
+    // Vertex or fragment stage, an empty variant leaves every constant at its shader default
+    void setShaderVariant(const VkShaderStageFlagBits stage, const ShaderVariant& variant);
+    // Only on devices with graphicsPipelineLibrary. Without a job system nothing is compiled in the background
+    // and the fast-linked pipelines stay
+    void setPipelineLibrary(const bool enabled, JobSystem* jobSystem = nullptr);
+    
+    // The layout is reflected from the shaders and shared through layoutCache, which keeps ownership of it
+    void setupGraphicsPipeline(const VkDevice device, const VkRenderPass renderPass, const ByteView vertShaderCode, const ByteView fragShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache = VK_NULL_HANDLE, const VkAllocationCallbacks* pAllocator = nullptr);
+    // Waits for the jobs still compiling
+    void destroyGraphicsPipeline(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    // Makes the variant current, building it on the calling thread the first time it is selected
+    void selectVariant(const ShaderVariant& vertexVariant, const ShaderVariant& fragmentVariant);
+    // Compiles the library part of one stage ahead of the variants that will use it, as a job when there is a
+    // job system. Does nothing without the library
+    void precompileStage(const VkShaderStageFlagBits stage, const ShaderVariant& variant);
+    // Once per frame after its slot has been waited for: swaps in the optimized pipelines that are ready and
+    // retires the fast-linked ones with the slot
+    void updatePipelines(DeletionQueue& deletionQueue, const uint32_t frame);
+    
+    const PipelineStats getStats(void) const;
+    void report(std::ostream& os, const char* label) const;
+    
+    // Of the current variant, only from the thread that selects variants and calls updatePipelines
+    const VkPipeline getPipeline(void) const;
+    const VkPipelineLayout getPipelineLayout(void) const;
+    const VertexLayout getVertexLayout(void) const;
     
 private:
+    struct PipelineState;
+    struct ShaderStage;
+    
+    struct Variant
+    {
+        ShaderVariant vertex;
+        ShaderVariant fragment;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        // Set by the optimizing job under mutex, until updatePipelines swaps it in
+        VkPipeline optimized = VK_NULL_HANDLE;
+    };
+    
+    VkDevice device = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    const VkAllocationCallbacks* pAllocator = nullptr;
+    VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+    VkShaderModule fragShaderModule = VK_NULL_HANDLE;
     VkPipelineLayout graphicsPipelineLayout = VK_NULL_HANDLE;
-    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    VertexLayout vertexLayout = VertexLayout::None;
+    ShaderVariant vertexVariant;
+    ShaderVariant fragmentVariant;
+    
+    // A deque so the jobs can hold on to their variant while new ones are added. Few enough to search in order
+    std::deque<Variant> variants;
+    Variant* current = nullptr;
+    PipelineStats stats;
+    
+    bool useLibrary = false;
+    JobSystem* jobSystem = nullptr;
+    JobCounter compileJobs;
+    // Guards the stage parts and the optimized handles, which jobs fill in
+    mutable std::mutex mutex;
+    VkPipeline vertexInputPart = VK_NULL_HANDLE;
+    VkPipeline fragmentOutputPart = VK_NULL_HANDLE;
+    std::vector<std::pair<ShaderVariant, VkPipeline>> preRasterizationParts;
+    std::vector<std::pair<ShaderVariant, VkPipeline>> fragmentShaderParts;
     
-    VkShaderModule createShaderModule(const VkDevice device, const std::vector<char>& code);
-    void populateVertexCreateInfo(VkPipelineVertexInputStateCreateInfo& vertexInputInfo);
+    void populateState(PipelineState& state);
+    void populateShaderStage(ShaderStage& shaderStage, const VkShaderStageFlagBits stage, const ShaderVariant& variant);
+    VkPipeline createMonolithicPipeline(const ShaderVariant& vertexVariant, const ShaderVariant& fragmentVariant);
+    VkPipeline createLibraryPart(const VkGraphicsPipelineLibraryFlagsEXT part, const ShaderVariant& variant);
+    VkPipeline getStagePart(const VkShaderStageFlagBits stage, const ShaderVariant& variant);
+    VkPipeline linkParts(const VkPipeline vertexPart, const VkPipeline fragmentPart, const bool optimize);
+    void submitOptimizedLink(Variant& variant, const VkPipeline vertexPart, const VkPipeline fragmentPart);
+    void populateVertexCreateInfo(VkPipelineVertexInputStateCreateInfo& vertexInputInfo, VkVertexInputBindingDescription& bindingDescription, std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
     void populateAssemblyCreateInfo(VkPipelineInputAssemblyStateCreateInfo& inputAssembly);
     void populateViewportCreateInfo(VkPipelineViewportStateCreateInfo& viewportState);
     void  populateDynamicCreateInfo(std::vector<VkDynamicState>& dynamicStates, VkPipelineDynamicStateCreateInfo& dynamicState);
     void populateRasterizationCreateInfo(VkPipelineRasterizationStateCreateInfo& rasterizer);
     void populateMultisampleCreateInfo(VkPipelineMultisampleStateCreateInfo& multisampling);
     void populateColorBlendCreateInfo(VkPipelineColorBlendAttachmentState& colorBlendAttachment, VkPipelineColorBlendStateCreateInfo& colorBlending);
-    void populatePipelineLayoutCreateInfo(VkPipelineLayoutCreateInfo& pipelineLayoutInfo);
 };
 
 #endif
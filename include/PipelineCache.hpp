@@ -0,0 +1,34 @@
+#ifndef PIPELINECACHE_HPP
+#define PIPELINECACHE_HPP
+
+#include "Config.hpp"
+
+#include <string>
+
+
+class PipelineCache
+{
+public:
+    PipelineCache() = default;
+    PipelineCache(const PipelineCache&) =  delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+    PipelineCache(PipelineCache&&) = delete;
+    PipelineCache& operator=(PipelineCache&&) = delete;
+    
+    // File I/O only, so it can run before the device exists. A missing file leaves the cache empty
+    void loadCacheFile(const std::string& path);
+    void saveCacheFile(const VkDevice device, const std::string& path) const;
+    
+    void setupCache(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroyCache(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    const VkPipelineCache getCache(void) const;
+    
+private:
+    std::vector<char> initialData;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    
+    static bool isCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties);
+};
+
+#endif
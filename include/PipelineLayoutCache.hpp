@@ -0,0 +1,60 @@
+#ifndef PIPELINELAYOUTCACHE_HPP
+#define PIPELINELAYOUTCACHE_HPP
+
+#include "Config.hpp"
+#include "HostAllocator.hpp"
+#include "ShaderReflection.hpp"
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+
+// Canonical descriptor set and pipeline layouts, one handle per distinct description. Set layouts take every
+// stage of their bind point, so a set declared by the vertex shader of one pipeline and the fragment shader of
+// another is the same layout and stays bound across the switch
+class PipelineLayoutCache
+{
+public:
+    PipelineLayoutCache() = default;
+    PipelineLayoutCache(const PipelineLayoutCache&) =  delete;
+    PipelineLayoutCache& operator=(const PipelineLayoutCache&) = delete;
+    PipelineLayoutCache(PipelineLayoutCache&&) = delete;
+    PipelineLayoutCache& operator=(PipelineLayoutCache&&) = delete;
+    
+    // Layouts are created on first request with device and the callbacks of hostAllocator for their type
+    void setupLayoutCache(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    void destroyLayoutCache(void);
+    
+    // Safe from several threads. The set of the bindings is ignored, all of them go into one layout
+    const VkDescriptorSetLayout getSetLayout(const VkPipelineBindPoint bindPoint, const std::vector<ReflectedBinding>& bindings);
+    // Empty layouts fill the sets a pipeline skips
+    const VkPipelineLayout getPipelineLayout(const VkPipelineBindPoint bindPoint, const ShaderReflection& reflection);
+    
+    const VkDescriptorSetLayout getPipelineSetLayout(const VkPipelineLayout pipelineLayout, const uint32_t set) const;
+    // Sets bound through one layout are still valid for the other: same set layouts up to set, same push constants
+    const bool isCompatible(const VkPipelineLayout a, const VkPipelineLayout b, const uint32_t set) const;
+    
+    const uint32_t getSetLayoutCount(void) const;
+    const uint32_t getPipelineLayoutCount(void) const;
+    
+private:
+    struct LayoutInfo
+    {
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        std::vector<VkPushConstantRange> pushConstantRanges;
+    };
+    
+    VkDevice device = VK_NULL_HANDLE;
+    HostAllocator* hostAllocator = nullptr;
+    
+    mutable std::mutex cacheMutex;
+    // Keyed by the serialized description
+    std::map<std::vector<uint64_t>, VkDescriptorSetLayout> setLayouts;
+    std::map<std::vector<uint64_t>, VkPipelineLayout> pipelineLayouts;
+    std::unordered_map<VkPipelineLayout, LayoutInfo> layoutInfos;
+    
+    const VkDescriptorSetLayout getSetLayoutLocked(const VkPipelineBindPoint bindPoint, const std::vector<ReflectedBinding>& bindings);
+};
+
+#endif
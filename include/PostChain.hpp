@@ -0,0 +1,130 @@
+#ifndef POSTCHAIN_HPP
+#define POSTCHAIN_HPP
+
+#include "Config.hpp"
+#include "Queue.hpp"
+#include "Image.hpp"
+#include "CommandPool.hpp"
+#include "ComputePipeline.hpp"
+#include "GpuTimer.hpp"
+
+#include <array>
+#include <memory>
+#include <ostream>
+
+
+enum class PostEffect : uint32_t
+{
+    BloomDownsample,
+    BloomUpsample,
+    Tonemap,
+    Fxaa
+};
+
+constexpr uint32_t POST_EFFECT_COUNT = 4;
+
+// Shared by every post shader
+struct PostPushConstants
+{
+    // Of the image a pass samples, of the destination for the bloom upsample
+    float texelSize[2];
+    // First bloom downsample only
+    float threshold;
+    float bloomStrength;
+};
+
+struct PostTimings
+{
+    double effectMs[POST_EFFECT_COUNT] = {};
+    GpuInterval chain;
+};
+
+
+// Averages per-effect GPU times and how much of the chain ran while the graphics queue was busy
+class PostStats
+{
+public:
+    void addFrame(const PostTimings& timings, const GpuInterval& graphics);
+    void report(std::ostream& os, const bool overlapped) const;
+    void reset(void);
+    
+    uint32_t getFrameCount(void) const;
+    
+private:
+    uint32_t frameCount = 0;
+    double effectMs[POST_EFFECT_COUNT] = {};
+    double chainMs = 0.0;
+    double overlapMs = 0.0;
+};
+
+
+// Post-processing of the scene on the compute queue: bloom down and up a mip chain, tonemapping and FXAA.
+// Every view has a target per frame slot, the scene is rendered into its HDR image and the result is copied
+// into the swap chain image by the graphics queue
+class PostChain
+{
+public:
+    PostChain() = default;
+    PostChain(const PostChain&) =  delete;
+    PostChain& operator=(const PostChain&) = delete;
+    PostChain(PostChain&&) = delete;
+    PostChain& operator=(PostChain&&) = delete;
+    
+    static const char* getEffectName(const PostEffect effect);
+    
+    // One extent per view. renderPass renders into the POST_HDR_FORMAT scene images, outputFormat is the format of
+    // the swap chains and must be 8-bit RGBA or BGRA
+    void setupPostChain(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const VkRenderPass renderPass, const std::vector<VkExtent2D>& extents, const VkFormat outputFormat, const std::array<ByteView, POST_EFFECT_COUNT>& shaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache = VK_NULL_HANDLE, HostAllocator* hostAllocator = nullptr);
+    void destroyPostChain(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    // New targets for swap chains that were recreated with other extents. The old ones are destroyed once frame's
+    // slot is reused, so frames still in flight keep theirs
+    void resizeTargets(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const VkRenderPass renderPass, const std::vector<VkExtent2D>& extents, PipelineLayoutCache& layoutCache, DeletionQueue& deletionQueue, const uint32_t frame, HostAllocator* hostAllocator = nullptr);
+    
+    // For the compute queue once the scene of frame is rendered. The caller must have waited for the work that
+    // last used this frame's slot
+    const VkCommandBuffer recordFrame(const uint64_t frame);
+    // For the graphics queue once the chain of frame has run, image is left in PRESENT_SRC_KHR
+    void cmdComposite(const VkCommandBuffer commandBuffer, const uint32_t view, const uint64_t frame, const VkImage image) const;
+    bool readTimings(const VkDevice device, const uint32_t slot, PostTimings& timings);
+    
+    const VkFramebuffer getFramebuffer(const uint32_t view, const uint64_t frame) const;
+    
+private:
+    struct Target
+    {
+        Image scene;
+        // Half the scene size and down from there
+        Image bloom;
+        uint32_t bloomLevels = 0;
+        Image tonemapped;
+        Image output;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> downsampleSets;
+        std::vector<VkDescriptorSet> upsampleSets;
+        VkDescriptorSet tonemapSet = VK_NULL_HANDLE;
+        VkDescriptorSet fxaaSet = VK_NULL_HANDLE;
+    };
+    
+    // MAX_FRAMES_IN_FLIGHT per view
+    std::unique_ptr<Target[]> targets;
+    uint32_t viewCount = 0;
+    ComputePipeline pipelines[POST_EFFECT_COUNT];
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    CommandPool commandPool;
+    GpuTimer timer;
+    
+    void createTargets(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const VkRenderPass renderPass, const std::vector<VkExtent2D>& extents, HostAllocator* hostAllocator);
+    // With the descriptor pool their sets come from
+    void destroyTargets(const VkDevice device, HostAllocator* hostAllocator);
+    void retireTargets(DeletionQueue& deletionQueue, const uint32_t frame, HostAllocator* hostAllocator);
+    void createSampler(const VkDevice device, HostAllocator* hostAllocator);
+    void createDescriptorSets(const VkDevice device, PipelineLayoutCache& layoutCache, HostAllocator* hostAllocator);
+    void writeDescriptorSet(const VkDevice device, const VkDescriptorSet set, const std::vector<VkDescriptorImageInfo>& sampledImages, const VkImageView storageView);
+    void cmdDispatch(const VkCommandBuffer commandBuffer, const PostEffect effect, const VkDescriptorSet set, const VkExtent2D extent, const PostPushConstants& constants);
+    void recordCommandBuffer(const VkCommandBuffer commandBuffer, const uint64_t frame);
+    
+    const uint32_t getTargetIndex(const uint32_t view, const uint64_t frame) const;
+};
+
+#endif
@@ -2,16 +2,46 @@
 #define QUEUE_HPP
 
 #include "Config.hpp"
+#include "SubmitScheduler.hpp"
 
+#include <map>
 #include <optional>
 
 
+enum class QueueRole : uint32_t
+{
+    Graphics,
+    Present,
+    Compute,
+    Transfer,
+    Count
+};
+
+// Where the queue serving a role lives; roles may share a slot
+struct QueueSlot
+{
+    uint32_t family = 0;
+    uint32_t index = 0;
+};
+
 struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> computeFamily;
+    std::optional<uint32_t> transferFamily;
+    
+    // Priorities of the queues to create in each family, and the queue each role uses
+    std::map<uint32_t, std::vector<float>> queuePriorities;
+    QueueSlot slots[static_cast<uint32_t>(QueueRole::Count)];
     
     bool isComplete(void);
+    bool hasAsyncCompute(void) const;
+    bool hasDedicatedTransfer(void) const;
+    // Graphics and present on one family, so swapchain images can use exclusive sharing
+    bool isUnified(void) const;
+    
+    const QueueSlot getSlot(const QueueRole role) const;
 };
 
 
@@ -24,14 +54,36 @@ public:
     Queue(Queue&&) = delete;
     Queue& operator=(Queue&&) = delete;
     
-    static QueueFamilyIndices findQueueFamilies(const VkPhysicalDevice device, const VkSurfaceKHR surface);
+    // The present family has to support every surface
+    static QueueFamilyIndices findQueueFamilies(const VkPhysicalDevice device, const std::vector<VkSurfaceKHR>& surfaces);
     static void populateDeviceQueueCreateInfo(std::vector<VkDeviceQueueCreateInfo>& createInfos, const QueueFamilyIndices& indices);
     
-    void setupQueues(const VkDevice logicalDevice, const QueueFamilyIndices& indices);
+    void setupQueues(const VkDevice logicalDevice, const QueueFamilyIndices& indices, const bool synchronization2, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroyQueues(const VkDevice logicalDevice, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    // Submits everything enqueued on the compute and graphics schedulers, compute first
+    void flush(void);
+    void endFrame(void);
+    
+    const VkQueue getQueue(const QueueRole role) const;
+    const VkQueue getGraphicsQueue(void) const;
+    const VkQueue getPresentQueue(void) const;
+    const VkQueue getComputeQueue(void) const;
+    const VkQueue getTransferQueue(void) const;
+    
+    SubmitScheduler& getGraphicsScheduler(void);
+    // Same scheduler as graphics when both families share a queue
+    SubmitScheduler& getComputeScheduler(void);
     
 private:
-    VkQueue graphicsQueue = VK_NULL_HANDLE;
-    VkQueue presentQueue = VK_NULL_HANDLE;
+    VkQueue queues[static_cast<uint32_t>(QueueRole::Count)] = {};
+    
+    SubmitScheduler graphicsScheduler;
+    SubmitScheduler computeScheduler;
+    
+    static void assignSlot(QueueFamilyIndices& indices, const QueueRole role, const uint32_t family, const uint32_t queueCount, const float priority);
+    
+    bool sharedScheduler(void) const;
 };
 
 #endif
@@ -0,0 +1,56 @@
+#ifndef SHADERREFLECTION_HPP
+#define SHADERREFLECTION_HPP
+
+#include "Config.hpp"
+#include "Utils.hpp"
+
+
+struct ReflectedBinding
+{
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType descriptorType;
+    uint32_t descriptorCount;
+    VkShaderStageFlags stageFlags;
+};
+
+enum class NumericType : uint32_t
+{
+    Float,
+    Sint,
+    Uint
+};
+
+// A user-defined input of the vertex stage, built-ins are left out
+struct ReflectedInput
+{
+    uint32_t location;
+    uint32_t componentCount;
+    NumericType numericType;
+};
+
+// What a pipeline layout and vertex input state have to provide for a set of shader stages
+struct ShaderReflection
+{
+    VkShaderStageFlags stageFlags = 0;
+    // Sorted by set, then binding
+    std::vector<ReflectedBinding> bindings;
+    // At most one range, covering the push constant block of every stage that declares one
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    std::vector<ReflectedInput> vertexInputs;
+};
+
+
+// Load-time reflection straight from the SPIR-V words, enough for the resources GLSL shaders declare
+namespace spirv
+{
+    // Throws on anything that is not a single-entry-point SPIR-V module
+    ShaderReflection reflectShader(const ByteView code);
+    // Bindings declared by several stages must agree on type and count, their stage flags are combined
+    ShaderReflection mergeStages(const std::vector<ShaderReflection>& stages);
+    
+    // Throws unless every vertex input is fed by an attribute with a matching numeric type
+    void checkVertexInputs(const ShaderReflection& reflection, const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
+};
+
+#endif
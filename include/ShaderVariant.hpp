@@ -0,0 +1,41 @@
+#ifndef SHADERVARIANT_HPP
+#define SHADERVARIANT_HPP
+
+#include "Config.hpp"
+
+
+// Specialization constant values of one shader stage. Constants stay sorted by id, so two variants with the
+// same values compare and hash equal however they were built, and the variant can key a pipeline map
+class ShaderVariant
+{
+public:
+    // Every scalar constant takes one 32-bit word, bool as VkBool32
+    ShaderVariant& set(const uint32_t constantId, const bool value);
+    ShaderVariant& set(const uint32_t constantId, const int32_t value);
+    ShaderVariant& set(const uint32_t constantId, const uint32_t value);
+    ShaderVariant& set(const uint32_t constantId, const float value);
+    
+    const bool empty(void) const;
+    const size_t getHash(void) const;
+    bool operator==(const ShaderVariant& other) const;
+    bool operator!=(const ShaderVariant& other) const;
+    
+    // Points into this variant, which must outlive the pipeline creation
+    void populateSpecializationInfo(VkSpecializationInfo& specializationInfo) const;
+    
+private:
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<uint32_t> data;
+    
+    ShaderVariant& setWord(const uint32_t constantId, const uint32_t word);
+};
+
+struct ShaderVariantHash
+{
+    size_t operator()(const ShaderVariant& variant) const
+    {
+        return variant.getHash();
+    }
+};
+
+#endif
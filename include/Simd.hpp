@@ -0,0 +1,32 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define SIMD_X86
+#elif defined(__aarch64__)
+    #define SIMD_NEON
+#endif
+
+
+// Instruction sets the CPU kernels are built for. SSE2 and NEON are part of their base
+// instruction sets, AVX2 kernels live in files of their own and run only after a CPU check
+enum class SimdKernel
+{
+    Scalar,
+    Sse,
+    Avx2,
+    Neon
+};
+
+
+namespace simd
+{
+    // Widest kernel the CPU runs
+    SimdKernel detectKernel(void);
+    bool isKernelSupported(const SimdKernel kernel);
+    const std::string getKernelName(const SimdKernel kernel);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include "Config.hpp"
+#include "Queue.hpp"
+#include "Buffer.hpp"
+#include "CommandPool.hpp"
+#include "ComputePipeline.hpp"
+#include "GpuTimer.hpp"
+
+
+struct Particle
+{
+    float position[2];
+    float velocity[2];
+};
+
+struct SimulationPushConstants
+{
+    float deltaTime;
+    uint32_t particleCount;
+};
+
+
+// Particle simulation used as the sample async compute workload. Frame N integrates
+// particles[N % 2] into particles[(N + 1) % 2] while graphics frame N draws particles[N % 2]
+class Simulation
+{
+public:
+    Simulation() = default;
+    Simulation(const Simulation&) =  delete;
+    Simulation& operator=(const Simulation&) = delete;
+    Simulation(Simulation&&) = delete;
+    Simulation& operator=(Simulation&&) = delete;
+    
+    void setupSimulation(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const Queue& queue, const ByteView compShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache = VK_NULL_HANDLE, HostAllocator* hostAllocator = nullptr);
+    void destroySimulation(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    
+    // The caller must have waited for the compute work that last used this frame's command buffer
+    const VkCommandBuffer recordFrame(const uint64_t frame, const float deltaTime);
+    bool readTimings(const VkDevice device, const uint32_t slot, GpuInterval& interval);
+    
+    const VkDescriptorSet getRenderSet(const uint64_t frame) const;
+    
+private:
+    Buffer particleBuffers[2];
+    // Owned by the layout cache
+    VkDescriptorSetLayout computeSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout renderSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet computeSets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkDescriptorSet renderSets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    ComputePipeline computePipeline;
+    CommandPool commandPool;
+    GpuTimer timer;
+    
+    void createParticleBuffers(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const Queue& queue, HostAllocator* hostAllocator);
+    void createDescriptorSetLayouts(PipelineLayoutCache& layoutCache);
+    void createDescriptorSets(const VkDevice device, HostAllocator* hostAllocator);
+    void recordCommandBuffer(const VkCommandBuffer commandBuffer, const uint64_t frame, const float deltaTime);
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SIMULATIONTHREAD_HPP
+#define SIMULATIONTHREAD_HPP
+
+#include "Config.hpp"
+#include "FramePacer.hpp"
+#include "SpscQueue.hpp"
+#include "TripleBuffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <thread>
+
+
+// Intervals between the iterations of a loop, to tell a steady loop from one that stutters
+struct JitterStats
+{
+    uint64_t count = 0;
+    double sumMs = 0.0;
+    double sumSquaresMs = 0.0;
+    double maxMs = 0.0;
+    
+    void add(const double intervalMs);
+    double meanMs(void) const;
+    // Standard deviation of the intervals
+    double jitterMs(void) const;
+    void report(std::ostream& os, const char* label) const;
+};
+
+// Scene state owned by the simulation thread. The render thread only ever sees copies
+struct SimulationState
+{
+    uint64_t tick = 0;
+    // Simulated seconds, advanced by every tick the scene is not paused
+    double time = 0.0;
+    bool paused = false;
+};
+
+// What one tick publishes: the state before and after it, so the render thread can interpolate between the two
+// without keeping a history of its own
+struct SimulationSnapshot
+{
+    SimulationState previous;
+    SimulationState current;
+    std::chrono::steady_clock::time_point publishedAt;
+    JitterStats tickJitter;
+    uint64_t droppedTicks = 0;
+};
+
+
+// Advances the scene at SIMULATION_TICK_RATE on its own thread. Key events come in through an SPSC queue and
+// every tick is handed to the render thread through a triple buffer, so a slow tick never stalls a frame and a
+// slow frame never holds up the simulation
+class SimulationThread
+{
+public:
+    SimulationThread() = default;
+    SimulationThread(const SimulationThread&) =  delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+    SimulationThread(SimulationThread&&) = delete;
+    SimulationThread& operator=(SimulationThread&&) = delete;
+    
+    // The pacer is told when the scene pauses or resumes and must outlive the thread
+    void startThread(FramePacer& pacer);
+    void stopThread(void);
+    
+    // From the thread polling events only, false when the queue is full and the event is dropped
+    bool pushKey(const KeyEvent& event);
+    // From the render thread only, valid until its next call
+    const SimulationSnapshot& acquireSnapshot(void);
+    
+    // The state at time now, one tick behind the simulation
+    static SimulationState interpolate(const SimulationSnapshot& snapshot, const std::chrono::steady_clock::time_point now);
+    
+private:
+    std::thread thread;
+    std::atomic<bool> running{false};
+    FramePacer* pacer = nullptr;
+    
+    SpscQueue<KeyEvent, SIMULATION_KEY_QUEUE_SIZE> keyQueue;
+    TripleBuffer<SimulationSnapshot> snapshots;
+    
+    void run(void);
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+
+
+// Bounded lock-free ring for one producer thread and one consumer thread. Capacity must be a power of two
+template <typename T, uint32_t Capacity>
+class SpscQueue
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+    
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) =  delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    SpscQueue(SpscQueue&&) = delete;
+    SpscQueue& operator=(SpscQueue&&) = delete;
+    
+    // Producer only, false when the queue is full
+    bool push(const T& value)
+    {
+        const uint32_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+        
+        items[position & (Capacity - 1)] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer only, false when the queue is empty
+    bool pop(T& value)
+    {
+        const uint32_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        
+        value = items[position & (Capacity - 1)];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+private:
+    T items[Capacity] = {};
+    alignas(64) std::atomic<uint32_t> head{0};
+    alignas(64) std::atomic<uint32_t> tail{0};
+};
+
+#endif
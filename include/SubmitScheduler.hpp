@@ -0,0 +1,119 @@
+#ifndef SUBMITSCHEDULER_HPP
+#define SUBMITSCHEDULER_HPP
+
+#include "Config.hpp"
+#include "Sync.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+
+struct SubmitRequest
+{
+    std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<VkSemaphoreSubmitInfoKHR> waitSemaphores;
+    std::vector<VkSemaphoreSubmitInfoKHR> signalSemaphores;
+    
+    void addWait(const VkSemaphore semaphore, const VkPipelineStageFlags2KHR stageMask, const uint64_t value = 0);
+    void addSignal(const VkSemaphore semaphore, const VkPipelineStageFlags2KHR stageMask, const uint64_t value = 0);
+};
+
+
+struct SubmitStats
+{
+    uint64_t frames = 0;
+    uint64_t submitCalls = 0;
+    uint64_t submitInfos = 0;
+    uint64_t requests = 0;
+    uint64_t commandBuffers = 0;
+    uint32_t lastFrameSubmitCalls = 0;
+    uint32_t lastFrameRequests = 0;
+    uint32_t maxBatchRequests = 0;
+    
+    void report(std::ostream& os, const char* name) const;
+};
+
+
+// Collects submissions from any thread and hands them to the queue in as few
+// vkQueueSubmit2 calls as possible. Each flush signals one timeline value, which
+// replaces the per-submit fence
+class SubmitScheduler
+{
+public:
+    SubmitScheduler() = default;
+    SubmitScheduler(const SubmitScheduler&) =  delete;
+    SubmitScheduler& operator=(const SubmitScheduler&) = delete;
+    SubmitScheduler(SubmitScheduler&&) = delete;
+    SubmitScheduler& operator=(SubmitScheduler&&) = delete;
+    
+    void setupScheduler(const VkDevice device, const VkQueue queue, const bool synchronization2, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroyScheduler(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    // Thread-safe. Returns the timeline value signaled once the request has executed
+    uint64_t enqueue(SubmitRequest request);
+    
+    // Owning thread only
+    uint64_t flush(void);
+    void endFrame(void);
+    const SubmitStats& getStats(void) const;
+    
+    void waitFor(const VkDevice device, const uint64_t value) const;
+    const TimelineSemaphore& getTimeline(void) const;
+    
+private:
+    struct PendingRequest
+    {
+        SubmitRequest request;
+        uint64_t value;
+        uint64_t sequence;
+    };
+    
+    // One lane per producer thread, so producers only share a lock with the flushing thread
+    struct Lane
+    {
+        std::mutex mutex;
+        std::vector<PendingRequest> requests;
+    };
+    
+    // Consecutive requests share one VkSubmitInfo2 unless that would move a wait or a signal
+    struct SubmitGroup
+    {
+        size_t firstCommandBuffer;
+        size_t commandBufferCount;
+        size_t firstWait;
+        size_t waitCount;
+        size_t firstSignal;
+        size_t signalCount;
+    };
+    
+    VkQueue queue = VK_NULL_HANDLE;
+    TimelineSemaphore timeline;
+    PFN_vkQueueSubmit2KHR pfnQueueSubmit2 = nullptr;
+    
+    uint64_t schedulerId = 0;
+    std::atomic<uint64_t> pendingValue{1};
+    std::atomic<uint64_t> sequence{0};
+    uint64_t submittedValue = 0;
+    
+    std::mutex lanesMutex;
+    std::vector<std::unique_ptr<Lane>> lanes;
+    std::vector<PendingRequest> batch;
+    std::vector<VkCommandBufferSubmitInfoKHR> planCommandBuffers;
+    std::vector<VkSemaphoreSubmitInfoKHR> planWaits;
+    std::vector<VkSemaphoreSubmitInfoKHR> planSignals;
+    std::vector<SubmitGroup> planGroups;
+    
+    SubmitStats stats;
+    uint32_t frameSubmitCalls = 0;
+    uint32_t frameRequests = 0;
+    
+    Lane& getLane(void);
+    void collectBatch(const uint64_t value);
+    void buildPlan(const uint64_t value);
+    void submitBatch2(void);
+    void submitBatch(void);
+};
+
+#endif
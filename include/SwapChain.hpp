@@ -2,6 +2,8 @@
 #define SWAPCHAIN_HPP
 
 #include "Config.hpp"
+#include "Queue.hpp"
+#include "DeletionQueue.hpp"
 
 
 struct SwapChainSupportDetails
@@ -16,6 +18,7 @@ struct SwapChainConfig
     VkExtent2D extent;
     VkSurfaceFormatKHR surfaceFormat;
     VkPresentModeKHR presentMode;
+    VkImageUsageFlags imageUsage;
 };
 
 
@@ -30,17 +33,29 @@ public:
     
     static SwapChainSupportDetails querySwapChainSupport(const VkPhysicalDevice device, const VkSurfaceKHR surface);
     
-    void setupSwapChain(const VkPhysicalDevice physicalDevice, const VkDevice logicalDevice, GLFWwindow* window, const VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator = nullptr);
+    // Takes the device's queue families, which were chosen against every surface in use. After retireSwapChain the
+    // retired swap chain is passed as oldSwapchain
+    void setupSwapChain(const VkPhysicalDevice physicalDevice, const VkDevice logicalDevice, GLFWwindow* window, const VkSurfaceKHR surface, const QueueFamilyIndices& indices, const VkAllocationCallbacks* pAllocator = nullptr);
     void setupImageViews(const VkDevice device, std::vector<const VkAllocationCallbacks*> pAllocators = {nullptr});
     void destroySwapChain(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
     void destroyImageViews(const VkDevice device, std::vector<const VkAllocationCallbacks*> pAllocators = {nullptr});
+    void setupFramebuffers(const VkDevice device, const VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroyFramebuffers(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    // Hands the swap chain, its image views and framebuffers over to be destroyed once frame's slot is reused
+    void retireSwapChain(DeletionQueue& deletionQueue, const uint32_t frame, const VkAllocationCallbacks* pSwapChainAllocator = nullptr, const VkAllocationCallbacks* pImageViewAllocator = nullptr, const VkAllocationCallbacks* pFramebufferAllocator = nullptr);
     
     const SwapChainConfig getSwapChainConfig(void) const;
+    const VkSwapchainKHR getSwapChain(void) const;
+    const VkFramebuffer getFramebuffer(const uint32_t imageIndex) const;
+    const VkImage getImage(const uint32_t imageIndex) const;
     
 private:
     VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+    // Still valid until the deletion queue releases it
+    VkSwapchainKHR retiredSwapChain = VK_NULL_HANDLE;
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
+    std::vector<VkFramebuffer> swapChainFramebuffers;
     SwapChainConfig scConfig;
     
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
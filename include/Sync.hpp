@@ -0,0 +1,60 @@
+#ifndef SYNC_HPP
+#define SYNC_HPP
+
+#include "Config.hpp"
+
+#include <limits>
+
+
+class DeletionQueue;
+
+class TimelineSemaphore
+{
+public:
+    TimelineSemaphore() = default;
+    TimelineSemaphore(const TimelineSemaphore&) =  delete;
+    TimelineSemaphore& operator=(const TimelineSemaphore&) = delete;
+    TimelineSemaphore(TimelineSemaphore&&) = delete;
+    TimelineSemaphore& operator=(TimelineSemaphore&&) = delete;
+    
+    void setupSemaphore(const VkDevice device, const uint64_t initialValue = 0, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroySemaphore(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    void wait(const VkDevice device, const uint64_t value, const uint64_t timeout = std::numeric_limits<uint64_t>::max()) const;
+    uint64_t getValue(const VkDevice device) const;
+    
+    const VkSemaphore getSemaphore(void) const;
+    
+private:
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    PFN_vkWaitSemaphoresKHR pfnWaitSemaphores = nullptr;
+    PFN_vkGetSemaphoreCounterValueKHR pfnGetSemaphoreCounterValue = nullptr;
+    
+    void loadFunctions(const VkDevice device);
+};
+
+
+class FrameSync
+{
+public:
+    FrameSync() = default;
+    FrameSync(const FrameSync&) =  delete;
+    FrameSync& operator=(const FrameSync&) = delete;
+    FrameSync(FrameSync&&) = delete;
+    FrameSync& operator=(FrameSync&&) = delete;
+    
+    void setupSyncObjects(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    void destroySyncObjects(const VkDevice device, const VkAllocationCallbacks* pAllocator = nullptr);
+    // Hands the semaphores over to be destroyed once frame's slot is reused, for a fresh set after a failed acquire
+    // left some of them signalled
+    void retireSyncObjects(DeletionQueue& deletionQueue, const uint32_t frame, const VkAllocationCallbacks* pAllocator = nullptr);
+    
+    const VkSemaphore getImageAvailableSemaphore(const uint32_t frame) const;
+    const VkSemaphore getRenderFinishedSemaphore(const uint32_t frame) const;
+    
+private:
+    std::vector<VkSemaphore> imageAvailableSemaphores;
+    std::vector<VkSemaphore> renderFinishedSemaphores;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef TASKGRAPH_HPP
+#define TASKGRAPH_HPP
+
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// One-shot dependency graph of tasks run as jobs of a job system
+class TaskGraph
+{
+public:
+    using TaskId = uint32_t;
+    
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) =  delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+    TaskGraph(TaskGraph&&) = delete;
+    TaskGraph& operator=(TaskGraph&&) = delete;
+    
+    // Dependencies must already be in the graph. Main-thread tasks run on the thread calling run(),
+    // for calls such as GLFW window management that are restricted to it
+    TaskId addTask(const std::string& name, std::function<void(void)> work, const std::vector<TaskId>& dependencies = {}, const bool mainThread = false);
+    
+    // Blocks until every task has finished, the calling thread running main-thread tasks and helping with the
+    // rest. It must be the thread that set the job system up. The first exception stops scheduling and is
+    // rethrown once running tasks have drained
+    void run(JobSystem& jobSystem);
+    // On a job system of its own, with no workers everything runs on the calling thread
+    void run(const uint32_t workerCount);
+    
+    void report(std::ostream& os) const;
+    
+private:
+    struct Task
+    {
+        std::string name;
+        std::function<void(void)> work;
+        std::vector<TaskId> dependents;
+        uint32_t pendingDependencies = 0;
+        bool mainThread = false;
+        double startMs = 0.0;
+        double endMs = 0.0;
+    };
+    
+    std::vector<Task> tasks;
+    std::deque<TaskId> readyMainTasks;
+    JobSystem* jobSystem = nullptr;
+    // Every task handed to the job system, run or skipped after a failure
+    JobCounter taskJobs;
+    
+    std::mutex mutex;
+    std::condition_variable readyCondition;
+    size_t finishedCount = 0;
+    size_t runningCount = 0;
+    std::exception_ptr failure;
+    
+    uint32_t workers = 0;
+    std::chrono::steady_clock::time_point startTime;
+    double totalMs = 0.0;
+    
+    bool isDone(void) const;
+    // Main-thread tasks are queued for the calling thread, the others are returned to be submitted as jobs
+    // once the mutex is released
+    void pushReady(const TaskId id, std::vector<TaskId>& jobTasks);
+    void submitTasks(const std::vector<TaskId>& jobTasks);
+    void execute(const TaskId id);
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef TRANSFORMKERNELS_HPP
+#define TRANSFORMKERNELS_HPP
+
+#include "TransformSystem.hpp"
+
+// Shared body of every transform kernel. Lanes supplies the vector type and its WIDTH, load, store,
+// set1, add, sub, mul, madd (a * b + c), gather and storeInstances (transposes 12 rows of lanes into
+// WIDTH instances). Each kernel file includes this after switching on its instruction set and
+// instantiates it with a Lanes type of its own, so no instantiation is shared between files
+
+
+// Reads the nodes [first, first + WIDTH) and their parents from streams, stores at output in world and instances
+template <typename Lanes>
+void transformBatch(const TransformStreams& streams, const uint32_t first, const bool hasParents, float* const* world, const uint32_t output, InstanceTransform* instances)
+{
+    using V = typename Lanes::V;
+    
+    const V x = Lanes::load(streams.rotation[0] + first);
+    const V y = Lanes::load(streams.rotation[1] + first);
+    const V z = Lanes::load(streams.rotation[2] + first);
+    const V w = Lanes::load(streams.rotation[3] + first);
+    
+    const V two = Lanes::set1(2.0f);
+    const V one = Lanes::set1(1.0f);
+    const V x2 = Lanes::mul(x, two);
+    const V y2 = Lanes::mul(y, two);
+    const V z2 = Lanes::mul(z, two);
+    
+    const V xx = Lanes::mul(x, x2);
+    const V yy = Lanes::mul(y, y2);
+    const V zz = Lanes::mul(z, z2);
+    const V xy = Lanes::mul(x, y2);
+    const V xz = Lanes::mul(x, z2);
+    const V yz = Lanes::mul(y, z2);
+    const V wx = Lanes::mul(w, x2);
+    const V wy = Lanes::mul(w, y2);
+    const V wz = Lanes::mul(w, z2);
+    
+    const V sx = Lanes::load(streams.scale[0] + first);
+    const V sy = Lanes::load(streams.scale[1] + first);
+    const V sz = Lanes::load(streams.scale[2] + first);
+    
+    // Local matrix is translation * rotation * scale
+    V local[12];
+    local[0] = Lanes::mul(Lanes::sub(one, Lanes::add(yy, zz)), sx);
+    local[1] = Lanes::mul(Lanes::sub(xy, wz), sy);
+    local[2] = Lanes::mul(Lanes::add(xz, wy), sz);
+    local[3] = Lanes::load(streams.position[0] + first);
+    local[4] = Lanes::mul(Lanes::add(xy, wz), sx);
+    local[5] = Lanes::mul(Lanes::sub(one, Lanes::add(xx, zz)), sy);
+    local[6] = Lanes::mul(Lanes::sub(yz, wx), sz);
+    local[7] = Lanes::load(streams.position[1] + first);
+    local[8] = Lanes::mul(Lanes::sub(xz, wy), sx);
+    local[9] = Lanes::mul(Lanes::add(yz, wx), sy);
+    local[10] = Lanes::mul(Lanes::sub(one, Lanes::add(xx, yy)), sz);
+    local[11] = Lanes::load(streams.position[2] + first);
+    
+    V result[12];
+    if (hasParents)
+    {
+        const uint32_t* parent = streams.parent + first;
+        
+        for (int row = 0; row < 3; row++)
+        {
+            const V p0 = Lanes::gather(streams.world[row * 4 + 0], parent);
+            const V p1 = Lanes::gather(streams.world[row * 4 + 1], parent);
+            const V p2 = Lanes::gather(streams.world[row * 4 + 2], parent);
+            const V p3 = Lanes::gather(streams.world[row * 4 + 3], parent);
+            
+            for (int column = 0; column < 4; column++)
+            {
+                V value = Lanes::mul(p0, local[column]);
+                value = Lanes::madd(p1, local[4 + column], value);
+                value = Lanes::madd(p2, local[8 + column], value);
+                result[row * 4 + column] = column == 3 ? Lanes::add(value, p3) : value;
+            }
+        }
+    } else
+    {
+        for (int i = 0; i < 12; i++)
+        {
+            result[i] = local[i];
+        }
+    }
+    
+    for (int i = 0; i < 12; i++)
+    {
+        Lanes::store(world[i] + output, result[i]);
+    }
+    Lanes::storeInstances(result, instances + output);
+}
+
+
+template <typename Lanes>
+void transformLevel(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances)
+{
+    uint32_t first = begin;
+    for (; first + Lanes::WIDTH <= end; first += Lanes::WIDTH)
+    {
+        transformBatch<Lanes>(streams, first, hasParents, streams.world, first, instances);
+    }
+    
+    const uint32_t remaining = end - first;
+    if (remaining == 0)
+    {
+        return;
+    }
+    
+    // The tail runs as one padded batch on copies, so the kernel never reads or writes past a level
+    float tailInputs[10][Lanes::WIDTH];
+    float tailWorld[12][Lanes::WIDTH];
+    uint32_t tailParents[Lanes::WIDTH];
+    InstanceTransform tailInstances[Lanes::WIDTH];
+    
+    TransformStreams tail = streams;
+    for (int i = 0; i < 3; i++)
+    {
+        tail.position[i] = tailInputs[i];
+        tail.scale[i] = tailInputs[3 + i];
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        tail.rotation[i] = tailInputs[6 + i];
+    }
+    tail.parent = tailParents;
+    
+    for (uint32_t lane = 0; lane < Lanes::WIDTH; lane++)
+    {
+        // Padding lanes repeat the last node
+        const uint32_t node = first + (lane < remaining ? lane : remaining - 1);
+        
+        for (int i = 0; i < 3; i++)
+        {
+            tailInputs[i][lane] = streams.position[i][node];
+            tailInputs[3 + i][lane] = streams.scale[i][node];
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            tailInputs[6 + i][lane] = streams.rotation[i][node];
+        }
+        tailParents[lane] = hasParents ? streams.parent[node] : 0;
+    }
+    
+    // Parents are still gathered from the real world arrays, results land in the copies
+    float* tailOutput[12];
+    for (int i = 0; i < 12; i++)
+    {
+        tailOutput[i] = tailWorld[i];
+    }
+    transformBatch<Lanes>(tail, 0, hasParents, tailOutput, 0, tailInstances);
+    
+    for (uint32_t lane = 0; lane < remaining; lane++)
+    {
+        for (int i = 0; i < 12; i++)
+        {
+            streams.world[i][first + lane] = tailWorld[i][lane];
+        }
+        instances[first + lane] = tailInstances[lane];
+    }
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef TRANSFORMSYSTEM_HPP
+#define TRANSFORMSYSTEM_HPP
+
+#include "Config.hpp"
+#include "Buffer.hpp"
+#include "Simd.hpp"
+
+#include <string>
+
+
+struct Transform
+{
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    // Unit quaternion, x y z w
+    float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+};
+
+// Rows of the affine world matrix, read as vec4 rows[3] per instance
+struct InstanceTransform
+{
+    float rows[3][4];
+};
+
+// Node data as seen by the kernels, one array per component
+struct TransformStreams
+{
+    const float* position[3];
+    const float* rotation[4];
+    const float* scale[3];
+    const uint32_t* parent;
+    float* world[12];
+};
+
+// Computes the world matrices of the nodes [begin, end), whose parents are all in earlier levels
+using TransformLevelFunction = void (*)(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances);
+
+
+// Scene hierarchy stored as structure of arrays. Nodes are kept ordered by hierarchy level, so a
+// level is a contiguous range that batch kernels process several nodes at a time
+class TransformSystem
+{
+public:
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+    
+    TransformSystem() = default;
+    TransformSystem(const TransformSystem&) =  delete;
+    TransformSystem& operator=(const TransformSystem&) = delete;
+    TransformSystem(TransformSystem&&) = delete;
+    TransformSystem& operator=(TransformSystem&&) = delete;
+    
+    void setKernel(const SimdKernel kernel);
+    SimdKernel getKernel(void) const;
+    
+    void reserve(const uint32_t count);
+    // The parent must already exist
+    uint32_t addNode(const uint32_t parent, const Transform& local);
+    void setLocal(const uint32_t node, const Transform& local);
+    // Restores level order after nodes were added below a shallower level. Returns the new index of every old one
+    std::vector<uint32_t> sortByLevel(void);
+    
+    uint32_t getNodeCount(void) const;
+    uint32_t getLevelCount(void) const;
+    
+    // Writes one InstanceTransform per node, in node order
+    void update(InstanceTransform* instances);
+    // World matrix from the last update
+    void getWorld(const uint32_t node, InstanceTransform& world) const;
+    
+    // One host-visible buffer per frame in flight, sized for the current node count
+    void setupInstanceBuffers(const VkPhysicalDevice physicalDevice, const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    void destroyInstanceBuffers(const VkDevice device, HostAllocator* hostAllocator = nullptr);
+    // The caller must have waited for the frame that last read this slot
+    void updateFrame(const uint32_t slot);
+    const VkBuffer getInstanceBuffer(const uint32_t slot) const;
+    
+private:
+    std::vector<float> position[3];
+    std::vector<float> rotation[4];
+    std::vector<float> scale[3];
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> levels;
+    std::vector<float> world[12];
+    
+    // levelOffsets[l] is the first node of level l, the last entry is the node count
+    std::vector<uint32_t> levelOffsets = {0};
+    bool sorted = true;
+    
+    SimdKernel kernel = simd::detectKernel();
+    TransformLevelFunction levelFunction = nullptr;
+    
+    Buffer instanceBuffers[MAX_FRAMES_IN_FLIGHT];
+    InstanceTransform* mappedInstances[MAX_FRAMES_IN_FLIGHT] = {};
+    
+    TransformStreams getStreams(void);
+    
+    // Calls function on every per-node array, parents and levels included
+    template <typename Function>
+    void forEachStream(Function function)
+    {
+        for (auto& stream : position)
+        {
+            function(stream);
+        }
+        for (auto& stream : rotation)
+        {
+            function(stream);
+        }
+        for (auto& stream : scale)
+        {
+            function(stream);
+        }
+        for (auto& stream : world)
+        {
+            function(stream);
+        }
+        function(parents);
+        function(levels);
+    }
+};
+
+
+// Kernel entry points, defined only where the target has the instruction set
+void transformLevelScalar(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances);
+void transformLevelSse(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances);
+void transformLevelAvx2(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances);
+void transformLevelNeon(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances);
+
+#endif
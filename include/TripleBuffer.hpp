@@ -0,0 +1,54 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+
+// Lock-free handoff of the latest value from one writer thread to one reader thread. The writer fills the back
+// slot and publishes it, the reader takes whatever was published last; neither ever waits for the other, and
+// values the reader did not get to in time are overwritten
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) =  delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+    TripleBuffer(TripleBuffer&&) = delete;
+    TripleBuffer& operator=(TripleBuffer&&) = delete;
+    
+    // Writer only, the slot stays the writer's until publish
+    T& getBack(void)
+    {
+        return slots[back];
+    }
+    
+    void publish(void)
+    {
+        back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    
+    // Reader only. Valid until the next acquire, the default value until the first publish
+    const T& acquire(void)
+    {
+        if (middle.load(std::memory_order_relaxed) & FRESH_BIT)
+        {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        
+        return slots[front];
+    }
+    
+private:
+    static constexpr uint32_t FRESH_BIT = 4;
+    static constexpr uint32_t INDEX_MASK = 3;
+    
+    T slots[3] = {};
+    // Index of the slot between the two threads, with FRESH_BIT while the reader has not taken it
+    alignas(64) std::atomic<uint32_t> middle{1};
+    alignas(64) uint32_t back = 0;
+    alignas(64) uint32_t front = 2;
+};
+
+#endif
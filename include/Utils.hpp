@@ -1,10 +1,23 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <cstddef>
 #include <vector>
 #include <string>
 
 
+// Non-owning bytes, such as a file read into a vector or an entry of a mapped asset pack
+struct ByteView
+{
+    const char* data = nullptr;
+    size_t size = 0;
+    
+    ByteView() = default;
+    ByteView(const char* data, const size_t size) : data(data), size(size) {}
+    ByteView(const std::vector<char>& bytes) : data(bytes.data()), size(bytes.size()) {}
+};
+
+
 namespace utils
 {
     std::vector<char> readFile(const std::string& filename);
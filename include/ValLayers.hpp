@@ -2,6 +2,7 @@
 #define VALLAYERS_HPP
 
 #include "Config.hpp"
+#include "DebugLog.hpp"
 
 #include <vector>
 
@@ -30,8 +31,11 @@ public:
     void setupDebugMessenger(const VkInstance instance, const VkAllocationCallbacks* pAllocator = nullptr);
     void destroyDebugMessenger(const VkInstance instance, const VkAllocationCallbacks* pAllocator = nullptr);
     
+    DebugLog& getDebugLog(void);
+    
 private:
     VkDebugUtilsMessengerEXT debugMessenger = VK_NULL_HANDLE;
+    DebugLog debugLog;
     
     VkResult CreateDebugUtilsMessengerEXT(const VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator);
     
@@ -0,0 +1,46 @@
+#ifndef VERTEXFORMAT_HPP
+#define VERTEXFORMAT_HPP
+
+#include "Config.hpp"
+#include "Mesh.hpp"
+
+
+// Push constants of shaders/mesh.vert and mesh.frag, 128 bytes so every device can hold them
+struct MeshPushConstants
+{
+    float viewProjection[16];
+    VertexDequantization dequantization;
+    // Instances are laid out in a grid of x columns, y apart
+    float instanceGrid[2];
+    // Shading features for the fragment shader when they are not specialized, see MeshShaderFeatures
+    uint32_t lightCount;
+    uint32_t featureFlags;
+};
+
+// Vertex of the performance HUD, in pixels from the top left. uv addresses the font atlas of shaders/hud.frag in
+// texels, a negative u fills the quad with the color
+struct OverlayVertex
+{
+    float position[2];
+    float uv[2];
+    uint8_t color[4];
+};
+
+
+namespace vertex
+{
+    uint32_t getVertexStride(const VertexLayout layout);
+    // One interleaved binding at 0; locations are position, normal, tangent, uv and color in that order, or
+    // position, uv and color for Overlay
+    void populateVertexInputDescriptions(const VertexLayout layout, VkVertexInputBindingDescription& binding, std::vector<VkVertexInputAttributeDescription>& attributes);
+    
+    void encodeOctahedral(const float direction[3], int16_t encoded[2]);
+    void decodeOctahedral(const int16_t encoded[2], float direction[3]);
+    
+    // Positions are scaled per axis to the bounds of the vertices and UVs to their range
+    VertexDequantization quantizeVertices(const std::vector<MeshVertex>& vertices, std::vector<QuantizedVertex>& quantized);
+    // Switches mesh over to the quantized layout, no-op when it already is
+    void quantizeMesh(MeshData& mesh);
+};
+
+#endif
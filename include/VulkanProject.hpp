@@ -0,0 +1,166 @@
+#ifndef VULKANPROJECT_HPP
+#define VULKANPROJECT_HPP
+
+#include "Config.hpp"
+#include "Window.hpp"
+#include "Instance.hpp"
+#include "ValLayers.hpp"
+#include "Device.hpp"
+#include "Queue.hpp"
+#include "SwapChain.hpp"
+#include "Pipeline.hpp"
+#include "PipelineCache.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "DescriptorBinder.hpp"
+#include "CommandPool.hpp"
+#include "Sync.hpp"
+#include "GpuTimer.hpp"
+#include "Simulation.hpp"
+#include "DeletionQueue.hpp"
+#include "FrameCapture.hpp"
+#include "HostAllocator.hpp"
+#include "MeshRenderer.hpp"
+#include "PostChain.hpp"
+#include "AssetPack.hpp"
+#include "FramePacer.hpp"
+#include "SimulationThread.hpp"
+#include "JobSystem.hpp"
+#include "PerfHud.hpp"
+
+#include <chrono>
+#include <memory>
+
+
+// One window on the shared device, with its own surface, swap chain and presentation semaphores
+struct View
+{
+    Window window;
+    SwapChain swapChain;
+    FrameSync frameSync;
+    uint32_t imageIndex = 0;
+};
+
+
+class VulkanProject
+{
+public:
+    VulkanProject() = default;
+    VulkanProject(const VulkanProject&) =  delete;
+    VulkanProject& operator=(const VulkanProject&) = delete;
+    VulkanProject(VulkanProject&&) = delete;
+    VulkanProject& operator=(VulkanProject&&) = delete;
+    
+    void run(void);
+    
+    // The steps of run(), public so vulkan_bench can time frames on their own. A scene layout other than None
+    // adds the mesh test scene, drawn from vertices in that layout
+    void setupApp(const uint32_t startupWorkers = STARTUP_WORKERS, const uint32_t viewCount = VIEW_COUNT, const VertexLayout sceneLayout = VertexLayout::None);
+    // Shading of the mesh test scene, before setupApp or between frames
+    void setSceneFeatures(const MeshShaderFeatures& features);
+    // Before setupApp, whether graphics pipelines are fast-linked from library parts where the device can.
+    // VULKAN_PIPELINE_LIBRARY overrides it
+    void setPipelineLibrary(const bool enabled);
+    // Before setupApp, whether the post chain of one frame runs while the next one renders
+    void setPostOverlap(const bool overlap);
+    // Before setupApp, whether the performance HUD is drawn. VULKAN_HUD overrides it, the metrics are kept either way
+    void setHud(const bool enabled);
+    void drawFrame(void);
+    void waitIdle(void);
+    void cleanup(void);
+    // From any thread, the on-demand loop draws a frame even when nothing else changed
+    void requestFrame(void);
+    
+    // From the start of setupApp until the first present returns, 0 before that
+    const double getTimeToFirstFrame(void) const;
+    // Of the latest frame whose post chain has completed
+    const PostTimings& getPostTimings(void) const;
+    // What the HUD shows, for runs that dump it instead
+    const PerfMetrics& getPerfMetrics(void) const;
+    
+private:
+    HostAllocator hostAllocator;
+    std::unique_ptr<View[]> views;
+    uint32_t viewCount = 0;
+    VkInstance instance;
+    InstanceCapabilities instanceCapabilities;
+    ValidationLayers VL;
+    Device device;
+    Queue queue;
+    VkRenderPass renderPass;
+    Pipeline pipeline;
+    PipelineCache pipelineCache;
+    PipelineLayoutCache layoutCache;
+    DescriptorBinder descriptorBinder;
+    CommandPool commandPool;
+    GpuTimer graphicsTimer;
+    Simulation simulation;
+    OverlapStats overlapStats;
+    DeletionQueue deletionQueue;
+    FrameCapture frameCapture;
+    FramePacer framePacer;
+    SimulationThread simulationThread;
+    // Runs the startup graph and stays up for the life of the app
+    JobSystem jobSystem;
+    JitterStats renderJitter;
+    // Simulated time the last frame advanced the particles to
+    double renderedSimulationTime = 0.0;
+    MeshRenderer meshRenderer;
+    PostChain postChain;
+    PostStats postStats;
+    PostTimings postTimings;
+    bool hasPostTimings = false;
+    bool postOverlap = POST_OVERLAP;
+    bool pipelineLibrary = PIPELINE_LIBRARY;
+    PerfHud hud;
+    bool hudEnabled = HUD_ENABLED;
+    // CPU time of the last drawFrame without its waits for frame slots
+    double lastCpuMs = 0.0;
+    VertexLayout sceneLayout = VertexLayout::None;
+    MeshData sceneMesh;
+    
+    uint32_t currentFrame = 0;
+    uint64_t frameIndex = 0;
+    // Set when acquire or present reports the swap chains out of date or suboptimal
+    bool swapChainsOutOfDate = false;
+    // Overlapped, the first frame after the post chain targets were made has no chain to present
+    uint64_t chainStartFrame = 0;
+    
+    // Scheduler timeline values each frame slot waits on before it is reused
+    uint64_t computeValues[MAX_FRAMES_IN_FLIGHT] = {};
+    uint64_t graphicsValues[MAX_FRAMES_IN_FLIGHT] = {};
+    // Post chain value of each frame slot, the composite of that frame waits on it
+    uint64_t postValues[MAX_FRAMES_IN_FLIGHT] = {};
+    uint64_t lastComputeValue = 0;
+    uint64_t lastGeometryValue = 0;
+    std::chrono::steady_clock::time_point lastFrameTime;
+    
+    // Views into the asset pack (or loose files), read off the main thread during startup and released once
+    // the pipelines exist
+    AssetPack assetPack;
+    ByteView vertShaderCode;
+    ByteView fragShaderCode;
+    ByteView compShaderCode;
+    ByteView meshVertShaderCode;
+    ByteView meshFragShaderCode;
+    std::array<ByteView, POST_EFFECT_COUNT> postShaderCode;
+    ByteView hudVertShaderCode;
+    ByteView hudFragShaderCode;
+    
+    std::chrono::steady_clock::time_point startupTime;
+    double timeToFirstFrameMs = 0.0;
+    
+    void createInstance(void);
+    void initVulkan(const uint32_t startupWorkers);
+    void createRenderPass(void);
+    bool windowsMinimized(void) const;
+    // Swap chains, post chain targets and HUD framebuffers at the current window sizes. Only waits for the frame slot
+    // it reuses, the old ones are released through the deletion queue
+    void recreateSwapChains(void);
+    void recordCommandBuffer(const VkCommandBuffer commandBuffer);
+    void recordCompositeCommandBuffer(const VkCommandBuffer commandBuffer, const uint64_t frame);
+    void collectTimings(const double cpuFrameMs, const SimulationSnapshot& snapshot);
+    bool shouldClose(void) const;
+    void mainLoop(void);
+};
+
+#endif
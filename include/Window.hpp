@@ -15,11 +15,13 @@ public:
     
     GLFWwindow* window = nullptr;
     
-    void setupWindow(void);
-    void setupSurface(const VkInstance instance, VkAllocationCallbacks* pAllocator = nullptr);
+    // Must precede setupWindow and any instance creation, on the main thread
+    static void setupPlatform(void);
+    void setupWindow(const char* title = "Vulkan");
+    void setupSurface(const VkInstance instance, const VkAllocationCallbacks* pAllocator = nullptr);
     
     void destroyWindow(void);
-    void destroySurface(const VkInstance instance, VkAllocationCallbacks* pAllocator = nullptr);
+    void destroySurface(const VkInstance instance, const VkAllocationCallbacks* pAllocator = nullptr);
     
     const VkSurfaceKHR getSurface(void) const;
     
@@ -0,0 +1,92 @@
+#ifndef WORKSTEALINGDEQUE_HPP
+#define WORKSTEALINGDEQUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+
+// Bounded Chase-Lev deque. The owning thread pushes and pops at the bottom, any other thread steals from the
+// top, and only the last item is ever contended. Capacity must be a power of two
+template <typename T, uint32_t Capacity>
+class WorkStealingDeque
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "WorkStealingDeque capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque items are copied through atomics");
+    
+    WorkStealingDeque() = default;
+    WorkStealingDeque(const WorkStealingDeque&) =  delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+    WorkStealingDeque(WorkStealingDeque&&) = delete;
+    WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+    
+    // Owner only, false when the deque is full
+    bool push(const T& value)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(Capacity))
+        {
+            return false;
+        }
+        
+        items[b & (Capacity - 1)].store(value, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Owner only, newest item first. False when the deque is empty or a thief took the last item
+    bool pop(T& value)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        
+        value = items[b & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (t < b)
+        {
+            return true;
+        }
+        
+        // Last item: whoever moves top first gets it
+        const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    
+    // Any thread, oldest item first. False when the deque is empty or another thread got there first
+    bool steal(T& value)
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return false;
+        }
+        
+        value = items[t & (Capacity - 1)].load(std::memory_order_relaxed);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+    
+    // A snapshot, only exact while no other thread touches the deque
+    bool isEmpty(void) const
+    {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+    
+private:
+    std::atomic<T> items[Capacity] = {};
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+};
+
+#endif
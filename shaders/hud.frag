@@ -0,0 +1,58 @@
+#version 450
+
+// Font atlas: 5x7 glyphs of ASCII 32 to 95 in a 16x4 grid, 80x28 texels at one bit each. A row of texels is three
+// words, texel x in bit x % 32 of word x / 32
+const uint FONT_ATLAS[84] = uint[]
+(
+    0x86452880u, 0x00004821u, 0x00000000u,
+    0x67e52880u, 0x02108422u, 0x00008000u,
+    0x505fa880u, 0x02550201u, 0x00004000u,
+    0x88e50080u, 0x0fb90200u, 0x0000203eu,
+    0x454f8080u, 0x62550205u, 0x00001000u,
+    0x72f50000u, 0x42108402u, 0x00000980u,
+    0xb0450080u, 0x20004805u, 0x00000180u,
+    0x3e8fb88eu, 0x8001cefbu, 0x00007080u,
+    0x82c444d1u, 0x431a3180u, 0x00008900u,
+    0x5ea24099u, 0x231a3140u, 0x0000823eu,
+    0xe0942095u, 0x1003ce23u, 0x00004400u,
+    0x61f81093u, 0x231a1114u, 0x0000223eu,
+    0x62888891u, 0x42191114u, 0x00000100u,
+    0x9c877dceu, 0x8100ce13u, 0x00002080u,
+    0xfe773dceu, 0x18f1d177u, 0x00007462u,
+    0x4298c631u, 0x14a09188u, 0x00008c76u,
+    0x4310c630u, 0x12a09108u, 0x00008ceau,
+    0xdf10bff6u, 0x11a09febu, 0x00008d6au,
+    0x4310c635u, 0x12a09188u, 0x00008e62u,
+    0x4298c635u, 0x14a49188u, 0x00008c62u,
+    0x7e773e2eu, 0xf899d1f0u, 0x00007463u,
+    0x63ff3dcfu, 0x077e318cu, 0x0000011cu,
+    0x6240c631u, 0x1142318cu, 0x00000290u,
+    0x6240c631u, 0x21214a8cu, 0x00000450u,
+    0x62473e2fu, 0x411084acu, 0x00000010u,
+    0x624816a1u, 0x81088aacu, 0x00000010u,
+    0xa2482521u, 0x010491aau, 0x00000011u,
+    0x1c47c6c1u, 0x077c9151u, 0x0000f81cu
+);
+
+const ivec2 FONT_ATLAS_SIZE = ivec2(80, 28);
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    // Glyphs are drawn at whole multiples of their size, so every pixel falls inside one texel
+    if (fragUv.x >= 0.0)
+    {
+        ivec2 texel = clamp(ivec2(fragUv), ivec2(0), FONT_ATLAS_SIZE - 1);
+        uint bits = FONT_ATLAS[texel.y * 3 + texel.x / 32];
+        if (((bits >> uint(texel.x % 32)) & 1u) == 0u)
+        {
+            discard;
+        }
+    }
+
+    outColor = fragColor;
+}
@@ -0,0 +1,24 @@
+#version 450
+
+// HudPushConstants in PerfHud.hpp
+layout(push_constant) uniform HudConstants
+{
+    // Pixels to normalized device coordinates
+    vec2 scale;
+    vec2 offset;
+} constants;
+
+// OverlayVertex in VertexFormat.hpp
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUv;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out vec4 fragColor;
+
+void main()
+{
+    gl_Position = vec4(inPosition * constants.scale + constants.offset, 0.0, 1.0);
+    fragUv = inUv;
+    fragColor = inColor;
+}
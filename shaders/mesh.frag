@@ -0,0 +1,60 @@
+#version 450
+
+// MeshShaderFeatures, set through VkSpecializationInfo by MeshRenderer so every variant is compiled with its
+// dead code removed. With RUNTIME_FEATURES they come from push constants instead and are branched on
+layout(constant_id = 1) const bool RUNTIME_FEATURES = false;
+layout(constant_id = 2) const uint LIGHT_COUNT = 1;
+layout(constant_id = 3) const bool BUMP_MAPPING = true;
+layout(constant_id = 4) const bool VERTEX_COLORS = true;
+
+const uint MAX_LIGHTS = 8;
+const uint FEATURE_BUMP_MAPPING = 1;
+const uint FEATURE_VERTEX_COLORS = 2;
+
+// The tail of MeshPushConstants in VertexFormat.hpp
+layout(push_constant) uniform MeshConstants
+{
+    layout(offset = 120) uint lightCount;
+    uint featureFlags;
+} constants;
+
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec4 fragTangent;
+layout(location = 2) in vec2 fragUv;
+layout(location = 3) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    uint lightCount = min(RUNTIME_FEATURES ? constants.lightCount : LIGHT_COUNT, MAX_LIGHTS);
+    bool bumpMapping = RUNTIME_FEATURES ? (constants.featureFlags & FEATURE_BUMP_MAPPING) != 0 : BUMP_MAPPING;
+    bool vertexColors = RUNTIME_FEATURES ? (constants.featureFlags & FEATURE_VERTEX_COLORS) != 0 : VERTEX_COLORS;
+    
+    vec3 normal = normalize(fragNormal);
+    if (bumpMapping)
+    {
+        // Stripes along the UVs bend the normal through the tangent frame
+        vec3 tangent = normalize(fragTangent.xyz);
+        vec3 bitangent = cross(normal, tangent) * fragTangent.w;
+        vec2 bump = 0.3 * sin(fragUv * vec2(64.0, 32.0));
+        normal = normalize(normal + tangent * bump.x + bitangent * bump.y);
+    }
+    
+    vec3 albedo = vertexColors ? fragColor.rgb : vec3(0.8);
+    vec3 light = vec3(0.15);
+    
+    // Lights on a cone around the original one, Blinn-Phong against a viewer looking down +z
+    for (uint i = 0; i < lightCount; i++)
+    {
+        float angle = float(i) * 0.785398;
+        vec3 direction = normalize(vec3(0.3 + 0.4 * cos(angle), -0.6 + 0.4 * sin(angle), -0.7));
+        vec3 color = (0.6 + 0.4 * cos(vec3(0.0, 2.1, 4.2) + angle)) / float(lightCount);
+        
+        float diffuse = max(dot(normal, direction), 0.0);
+        float specular = pow(max(dot(normal, normalize(direction + vec3(0.0, 0.0, -1.0))), 0.0), 32.0);
+        light += color * (diffuse + 0.3 * specular);
+    }
+    
+    outColor = vec4(albedo * light, fragColor.a);
+}
@@ -0,0 +1,61 @@
+#version 450
+
+// Set through VkSpecializationInfo by MeshRenderer for VertexLayout::Quantized
+layout(constant_id = 0) const bool QUANTIZED = false;
+
+// MeshPushConstants in VertexFormat.hpp
+layout(push_constant) uniform MeshConstants
+{
+    mat4 viewProjection;
+    vec4 positionScale;
+    vec4 positionOffset;
+    vec2 uvScale;
+    vec2 uvOffset;
+    vec2 instanceGrid;
+    uint lightCount;
+    uint featureFlags;
+} constants;
+
+// Quantized: SNORM16 position with the bitangent sign in w, octahedral SNORM16 normal and tangent,
+// UNORM16 uv and UNORM8 color, all normalized to float by the vertex input unit
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inNormal;
+layout(location = 2) in vec4 inTangent;
+layout(location = 3) in vec2 inUv;
+layout(location = 4) in vec4 inColor;
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec4 fragTangent;
+layout(location = 2) out vec2 fragUv;
+layout(location = 3) out vec4 fragColor;
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-direction.z, 0.0);
+    direction.xy += mix(vec2(t), vec2(-t), greaterThanEqual(direction.xy, vec2(0.0)));
+    return normalize(direction);
+}
+
+void main()
+{
+    vec3 position;
+    if (QUANTIZED)
+    {
+        position = inPosition.xyz * constants.positionScale.xyz + constants.positionOffset.xyz;
+        fragNormal = decodeOctahedral(inNormal.xy);
+        fragTangent = vec4(decodeOctahedral(inTangent.xy), inPosition.w < 0.0 ? -1.0 : 1.0);
+        fragUv = inUv * constants.uvScale + constants.uvOffset;
+    } else
+    {
+        position = inPosition.xyz;
+        fragNormal = inNormal.xyz;
+        fragTangent = inTangent;
+        fragUv = inUv;
+    }
+    fragColor = inColor;
+    
+    int columns = int(constants.instanceGrid.x);
+    vec2 cell = vec2(gl_InstanceIndex % columns, gl_InstanceIndex / columns);
+    gl_Position = constants.viewProjection * vec4(position + vec3(cell * constants.instanceGrid.y, 0.0), 1.0);
+}
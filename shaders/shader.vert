@@ -1,5 +1,16 @@
 #version 450
 
+struct Particle
+{
+    vec2 position;
+    vec2 velocity;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles
+{
+    Particle particles[];
+};
+
 layout(location = 0) out vec3 fragColor;
 
 vec2 positions[3] = vec2[]
@@ -18,6 +29,7 @@ vec3 colors[3] = vec3[]
 
 void main()
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    vec2 offset = particles[gl_InstanceIndex].position;
+    gl_Position = vec4(positions[gl_VertexIndex] * 0.02 + offset, 0.0, 1.0);
     fragColor = colors[gl_VertexIndex];
 }
@@ -0,0 +1,305 @@
+#include "AssetPack.hpp"
+#include "Lz4.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static constexpr char PACK_MAGIC[4] = {'V', 'P', 'A', 'K'};
+
+
+static uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+
+void AssetPack::openPack(const std::string& path)
+{
+    closePack();
+    
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+    
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(AssetPackHeader))
+    {
+        close(fd);
+        throw std::runtime_error(path + " is not an asset pack!");
+    }
+    
+    // The mapping outlives the descriptor
+    void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map " + path + "!");
+    }
+    
+    mapping = static_cast<const char*>(data);
+    mappingSize = static_cast<size_t>(status.st_size);
+    header = reinterpret_cast<const AssetPackHeader*>(mapping);
+    
+    // Entries are checked against the file size when they are looked up, the layout once here
+    const uint64_t tableSize = static_cast<uint64_t>(header->slotCount) * sizeof(AssetPackEntry);
+    if (std::memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header->version != assets::PACK_VERSION || header->fileSize != mappingSize
+        || header->slotCount == 0 || (header->slotCount & (header->slotCount - 1)) != 0 || header->tableOffset % alignof(AssetPackEntry) != 0
+        || header->tableOffset > mappingSize || tableSize > mappingSize - header->tableOffset
+        || header->namesOffset > mappingSize || header->namesSize > mappingSize - header->namesOffset)
+    {
+        closePack();
+        throw std::runtime_error(path + " is not a version " + std::to_string(assets::PACK_VERSION) + " asset pack!");
+    }
+    
+    table = reinterpret_cast<const AssetPackEntry*>(mapping + header->tableOffset);
+    names = mapping + header->namesOffset;
+}
+
+
+void AssetPack::closePack(void)
+{
+    if (mapping != nullptr)
+    {
+        munmap(const_cast<char*>(mapping), mappingSize);
+    }
+    
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    table = nullptr;
+    names = nullptr;
+    
+    std::lock_guard<std::mutex> lock(ownedMutex);
+    ownedAssets.clear();
+}
+
+
+const bool AssetPack::isOpen(void) const
+{
+    return mapping != nullptr;
+}
+
+
+const uint32_t AssetPack::getAssetCount(void) const
+{
+    return header != nullptr ? header->assetCount : 0;
+}
+
+
+const bool AssetPack::contains(const std::string& name) const
+{
+    return findEntry(name) != nullptr;
+}
+
+
+const ByteView AssetPack::getAsset(const std::string& name)
+{
+    const AssetPackEntry* entry = findEntry(name);
+    if (entry != nullptr && entry->compression == AssetCompression::None)
+    {
+        return ByteView(mapping + entry->offset, entry->size);
+    }
+    
+    std::lock_guard<std::mutex> lock(ownedMutex);
+    
+    const auto owned = ownedAssets.find(name);
+    if (owned != ownedAssets.end())
+    {
+        return owned->second;
+    }
+    
+    std::vector<char> data;
+    if (entry == nullptr)
+    {
+        data = utils::readFile(name);
+    } else if (entry->compression == AssetCompression::Lz4)
+    {
+        data.resize(entry->rawSize);
+        lz4::decompress(ByteView(mapping + entry->offset, entry->size), data.data(), data.size());
+    } else
+    {
+        throw std::runtime_error(name + " uses an unknown compression!");
+    }
+    
+    return ownedAssets.emplace(name, std::move(data)).first->second;
+}
+
+
+const AssetPackEntry* AssetPack::findEntry(const std::string& name) const
+{
+    if (table == nullptr)
+    {
+        return nullptr;
+    }
+    
+    const uint64_t hash = assets::hashName(name);
+    const uint32_t mask = header->slotCount - 1;
+    
+    // Linear probing, ends at the first empty slot since the table is never full
+    for (uint32_t probe = 0, slot = hash & mask; probe < header->slotCount; probe++, slot = (slot + 1) & mask)
+    {
+        const AssetPackEntry& entry = table[slot];
+        if (entry.nameLength == 0)
+        {
+            return nullptr;
+        }
+        
+        if (entry.hash != hash || entry.nameLength != name.size() || entry.nameOffset + static_cast<uint64_t>(entry.nameLength) > header->namesSize
+            || std::memcmp(names + entry.nameOffset, name.data(), name.size()) != 0)
+        {
+            continue;
+        }
+        
+        if (entry.offset > mappingSize || entry.size > mappingSize - entry.offset)
+        {
+            throw std::runtime_error(name + " lies outside its asset pack!");
+        }
+        return &entry;
+    }
+    
+    return nullptr;
+}
+
+
+uint64_t assets::hashName(const std::string& name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : name)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+
+PackedAsset assets::packAsset(const std::string& name, std::vector<char> data, const AssetCompression compression)
+{
+    PackedAsset asset;
+    asset.name = name;
+    asset.rawSize = data.size();
+    
+    if (compression == AssetCompression::Lz4 && !data.empty())
+    {
+        std::vector<char> compressed = lz4::compress(data);
+        if (compressed.size() <= data.size() - data.size() / 8)
+        {
+            asset.compression = AssetCompression::Lz4;
+            asset.data = std::move(compressed);
+            return asset;
+        }
+    }
+    
+    asset.data = std::move(data);
+    return asset;
+}
+
+
+void assets::writePack(const std::string& path, const std::vector<PackedAsset>& packedAssets)
+{
+    uint32_t slotCount = 1;
+    while (slotCount < packedAssets.size() * 2)
+    {
+        slotCount *= 2;
+    }
+    
+    AssetPackHeader header{};
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.assetCount = static_cast<uint32_t>(packedAssets.size());
+    header.slotCount = slotCount;
+    header.tableOffset = alignUp(sizeof(AssetPackHeader), ASSET_PACK_ALIGNMENT);
+    header.namesOffset = header.tableOffset + slotCount * sizeof(AssetPackEntry);
+    
+    std::vector<AssetPackEntry> table(slotCount);
+    std::string nameData;
+    uint64_t offset = 0;
+    
+    for (const PackedAsset& asset : packedAssets)
+    {
+        if (asset.name.empty() || asset.name.size() > UINT16_MAX)
+        {
+            throw std::runtime_error("Asset name \"" + asset.name + "\" is empty or too long!");
+        }
+        
+        const uint64_t hash = hashName(asset.name);
+        uint32_t slot = hash & (slotCount - 1);
+        while (table[slot].nameLength != 0)
+        {
+            if (table[slot].hash == hash && nameData.compare(table[slot].nameOffset, table[slot].nameLength, asset.name) == 0)
+            {
+                throw std::runtime_error("Asset " + asset.name + " is packed twice!");
+            }
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        
+        AssetPackEntry& entry = table[slot];
+        entry.hash = hash;
+        entry.offset = offset;
+        entry.size = asset.data.size();
+        entry.rawSize = asset.rawSize;
+        entry.nameOffset = static_cast<uint32_t>(nameData.size());
+        entry.nameLength = static_cast<uint16_t>(asset.name.size());
+        entry.compression = asset.compression;
+        
+        nameData += asset.name;
+        offset = alignUp(offset + asset.data.size(), ASSET_PACK_ALIGNMENT);
+    }
+    
+    header.namesSize = nameData.size();
+    
+    // Offsets were relative to the first blob until the names are known
+    const uint64_t dataOffset = alignUp(header.namesOffset + header.namesSize, ASSET_PACK_ALIGNMENT);
+    for (AssetPackEntry& entry : table)
+    {
+        if (entry.nameLength != 0)
+        {
+            entry.offset += dataOffset;
+        }
+    }
+    
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing!");
+    }
+    
+    const auto pad = [&file](const uint64_t position)
+    {
+        static const char zeros[ASSET_PACK_ALIGNMENT] = {};
+        const uint64_t current = static_cast<uint64_t>(file.tellp());
+        file.write(zeros, static_cast<std::streamsize>(position - current));
+    };
+    
+    // The header goes last, once the file size is known
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(header.tableOffset);
+    file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(AssetPackEntry)));
+    file.write(nameData.data(), static_cast<std::streamsize>(nameData.size()));
+    
+    uint64_t position = dataOffset;
+    for (const PackedAsset& asset : packedAssets)
+    {
+        pad(position);
+        file.write(asset.data.data(), static_cast<std::streamsize>(asset.data.size()));
+        position = alignUp(position + asset.data.size(), ASSET_PACK_ALIGNMENT);
+    }
+    
+    header.fileSize = static_cast<uint64_t>(file.tellp());
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    if (!file.good())
+    {
+        throw std::runtime_error("Failed to write " + path + "!");
+    }
+}
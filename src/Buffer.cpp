@@ -0,0 +1,146 @@
+#include "Buffer.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+
+
+uint32_t Buffer::findMemoryType(const VkPhysicalDevice physicalDevice, const uint32_t typeFilter, const VkMemoryPropertyFlags properties)
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+    
+    throw std::runtime_error("Failed to find suitable memory type!");
+}
+
+
+void Buffer::populateBufferCreateInfo(VkBufferCreateInfo& createInfo, const VkBufferUsageFlags usage, const std::vector<uint32_t>& queueFamilies)
+{
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size = size;
+    createInfo.usage = usage;
+    
+    if (queueFamilies.size() > 1)
+    {
+        createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+        createInfo.pQueueFamilyIndices = queueFamilies.data();
+    } else
+    {
+        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        createInfo.queueFamilyIndexCount = 0; // Optional
+        createInfo.pQueueFamilyIndices = nullptr; // Optional
+    }
+}
+
+
+void Buffer::setupBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties, const std::vector<uint32_t>& queueFamilies, HostAllocator* hostAllocator)
+{
+    this->size = size;
+    
+    std::vector<uint32_t> uniqueFamilies;
+    for (uint32_t family : queueFamilies)
+    {
+        if (std::find(uniqueFamilies.begin(), uniqueFamilies.end(), family) == uniqueFamilies.end())
+        {
+            uniqueFamilies.push_back(family);
+        }
+    }
+    
+    VkBufferCreateInfo createInfo{};
+    populateBufferCreateInfo(createInfo, usage, uniqueFamilies);
+    
+    if (capture::createBuffer(device, &createInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_BUFFER), &buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create buffer!");
+    }
+    
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+    
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
+    
+    if (capture::allocateMemory(device, &allocInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DEVICE_MEMORY), &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate buffer memory!");
+    }
+    
+    capture::bindBufferMemory(device, buffer, memory, 0);
+}
+
+
+void Buffer::destroyBuffer(const VkDevice device, HostAllocator* hostAllocator)
+{
+    if (mapped != nullptr)
+    {
+        unmap(device);
+    }
+    
+    if (buffer != VK_NULL_HANDLE)
+    {
+        capture::destroyBuffer(device, buffer, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_BUFFER));
+    }
+    
+    if (memory != VK_NULL_HANDLE)
+    {
+        capture::freeMemory(device, memory, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+}
+
+
+void* Buffer::map(const VkDevice device)
+{
+    if (mapped == nullptr)
+    {
+        capture::mapMemory(device, memory, 0, size, 0, &mapped);
+    }
+    
+    return mapped;
+}
+
+
+void Buffer::unmap(const VkDevice device)
+{
+    capture::unmapMemory(device, memory);
+    mapped = nullptr;
+}
+
+
+void Buffer::markWritten(const VkDeviceSize offset, const VkDeviceSize size)
+{
+    capture::markWritten(memory, offset, size);
+}
+
+
+void Buffer::invalidate(const VkDevice device)
+{
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = memory;
+    range.offset = 0;
+    range.size = VK_WHOLE_SIZE;
+    
+    vkInvalidateMappedMemoryRanges(device, 1, &range);
+}
+
+
+const VkBuffer Buffer::getBuffer(void) const
+{
+    return buffer;
+}
+
+
+const VkDeviceSize Buffer::getSize(void) const
+{
+    return size;
+}
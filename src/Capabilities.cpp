@@ -0,0 +1,26 @@
+#include "Capabilities.hpp"
+
+
+bool InstanceCapabilities::hasExtension(const std::string& extensionName) const
+{
+    return extensions.count(extensionName) > 0;
+}
+
+
+bool DeviceCapabilities::hasExtension(const std::string& extensionName) const
+{
+    return extensions.count(extensionName) > 0;
+}
+
+
+void DeviceCapabilities::report(std::ostream& os) const
+{
+    os << "[caps] Vulkan " << VK_API_VERSION_MAJOR(apiVersion) << "." << VK_API_VERSION_MINOR(apiVersion) << "." << VK_API_VERSION_PATCH(apiVersion)
+       << " | timeline semaphore: " << (timelineSemaphore ? "on" : "off")
+       << " | synchronization2: " << (synchronization2 ? "on" : "off")
+       << " | memory budget: " << (memoryBudget ? "on" : "off")
+       << " | pipeline cache control: " << (pipelineCreationCacheControl ? "on" : "off")
+       << " | dynamic rendering: " << (dynamicRendering ? "on" : "off")
+       << " | pipeline library: " << (graphicsPipelineLibrary ? "on" : "off")
+       << " | portability subset: " << (portabilitySubset ? "yes" : "no") << '\n';
+}
@@ -0,0 +1,1435 @@
+#include "CaptureReplay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+
+// Nothing is presented, images captured in the present layout are kept in the general layout instead
+static VkImageLayout replayLayout(const VkImageLayout layout)
+{
+    return layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR ? VK_IMAGE_LAYOUT_GENERAL : layout;
+}
+
+
+static void applySharing(const std::vector<uint32_t>& families, VkSharingMode& sharingMode, uint32_t& queueFamilyIndexCount, const uint32_t*& pQueueFamilyIndices)
+{
+    if (sharingMode == VK_SHARING_MODE_CONCURRENT && families.size() > 1)
+    {
+        queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+        pQueueFamilyIndices = families.data();
+    } else
+    {
+        sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        queueFamilyIndexCount = 0;
+        pQueueFamilyIndices = nullptr;
+    }
+}
+
+
+// The captured memory type may not exist on this device. Keep the properties the app relied on, host access first
+static uint32_t findReplayMemoryType(const VkPhysicalDeviceMemoryProperties& memoryProperties, const uint32_t typeFilter, const VkMemoryPropertyFlags capturedFlags)
+{
+    const VkMemoryPropertyFlags hostFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkMemoryPropertyFlags candidates[] = {
+        capturedFlags,
+        capturedFlags & (hostFlags | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        capturedFlags & hostFlags,
+        capturedFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        0
+    };
+    
+    for (const VkMemoryPropertyFlags flags : candidates)
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+            {
+                return i;
+            }
+        }
+    }
+    
+    throw std::runtime_error("Failed to find suitable memory type!");
+}
+
+
+// Handles are kept as 64-bit keys whether they are pointers or non-dispatchable integers
+template <typename T>
+static T toHandle(const uint64_t key)
+{
+    T handle;
+    std::memcpy(&handle, &key, sizeof(T));
+    return handle;
+}
+
+
+template <typename T>
+static uint64_t toKey(const T handle)
+{
+    uint64_t key = 0;
+    std::memcpy(&key, &handle, sizeof(T));
+    return key;
+}
+
+
+template <typename T>
+T CaptureReplayer::getHandle(const uint32_t id) const
+{
+    if (id >= handles.size())
+    {
+        throw std::runtime_error("Capture uses an object it did not create!");
+    }
+    
+    return toHandle<T>(handles[id]);
+}
+
+
+// Objects created with VK_OBJECT_TYPE_UNKNOWN are not destroyed on their own
+template <typename T>
+void CaptureReplayer::setHandle(const uint32_t id, const T handle, const VkObjectType type)
+{
+    if (id >= handles.size())
+    {
+        handles.resize(id + 1, 0);
+    }
+    
+    handles[id] = toKey(handle);
+    
+    if (type != VK_OBJECT_TYPE_UNKNOWN)
+    {
+        createdObjects.push_back({type, handles[id]});
+    }
+}
+
+
+void CaptureReplayer::setupReplayer(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, Queue& queue, const VkAllocationCallbacks* pAllocator)
+{
+    this->physicalDevice = physicalDevice;
+    this->device = device;
+    this->pAllocator = pAllocator;
+    this->queue = &queue;
+    
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    
+    const uint32_t graphicsFamily = indices.graphicsFamily.value();
+    const uint32_t computeFamily = indices.computeFamily.value();
+    concurrentFamilies = {graphicsFamily};
+    if (computeFamily != graphicsFamily)
+    {
+        concurrentFamilies.push_back(computeFamily);
+    }
+    
+    for (FrameSlot& slot : slots)
+    {
+        slot.graphicsPool.setupCommandPool(device, graphicsFamily, pAllocator);
+        slot.graphicsPool.setupCommandBuffers(device, REPLAY_COMMAND_BUFFERS);
+        slot.computePool.setupCommandPool(device, computeFamily, pAllocator);
+        slot.computePool.setupCommandBuffers(device, REPLAY_COMMAND_BUFFERS);
+    }
+    
+    graphicsTimer.setupTimer(physicalDevice, device, graphicsFamily, MAX_FRAMES_IN_FLIGHT * REPLAY_COMMAND_BUFFERS, 1, pAllocator);
+    computeTimer.setupTimer(physicalDevice, device, computeFamily, MAX_FRAMES_IN_FLIGHT * REPLAY_COMMAND_BUFFERS, 1, pAllocator);
+}
+
+
+void CaptureReplayer::destroyReplayer(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    vkDeviceWaitIdle(device);
+    destroyObjects();
+    
+    computeTimer.destroyTimer(device, pAllocator);
+    graphicsTimer.destroyTimer(device, pAllocator);
+    
+    for (FrameSlot& slot : slots)
+    {
+        slot.computePool.destroyCommandPool(device, pAllocator);
+        slot.graphicsPool.destroyCommandPool(device, pAllocator);
+    }
+}
+
+
+void CaptureReplayer::destroyHandle(const VkObjectType type, const uint64_t key)
+{
+    switch (type)
+    {
+        case VK_OBJECT_TYPE_BUFFER: vkDestroyBuffer(device, toHandle<VkBuffer>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_IMAGE: vkDestroyImage(device, toHandle<VkImage>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_DEVICE_MEMORY: vkFreeMemory(device, toHandle<VkDeviceMemory>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_IMAGE_VIEW: vkDestroyImageView(device, toHandle<VkImageView>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_SAMPLER: vkDestroySampler(device, toHandle<VkSampler>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_RENDER_PASS: vkDestroyRenderPass(device, toHandle<VkRenderPass>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_FRAMEBUFFER: vkDestroyFramebuffer(device, toHandle<VkFramebuffer>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_SHADER_MODULE: vkDestroyShaderModule(device, toHandle<VkShaderModule>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: vkDestroyDescriptorSetLayout(device, toHandle<VkDescriptorSetLayout>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_PIPELINE_LAYOUT: vkDestroyPipelineLayout(device, toHandle<VkPipelineLayout>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_PIPELINE: vkDestroyPipeline(device, toHandle<VkPipeline>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_POOL: vkDestroyDescriptorPool(device, toHandle<VkDescriptorPool>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_QUERY_POOL: vkDestroyQueryPool(device, toHandle<VkQueryPool>(key), pAllocator); break;
+        case VK_OBJECT_TYPE_SEMAPHORE: vkDestroySemaphore(device, toHandle<VkSemaphore>(key), pAllocator); break;
+        default: break;
+    }
+}
+
+
+void CaptureReplayer::destroyObjects(void)
+{
+    for (auto it = createdObjects.rbegin(); it != createdObjects.rend(); it++)
+    {
+        destroyHandle(it->first, it->second);
+    }
+    
+    createdObjects.clear();
+    handles.clear();
+    memories.clear();
+    swapchainImageMemories.clear();
+}
+
+
+void CaptureReplayer::replay(const std::string& path, const bool paced, std::vector<ReplayFrame>& frames)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    
+    std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file.good() || data.size() < sizeof(CaptureHeader))
+    {
+        throw std::runtime_error(path + " is truncated!");
+    }
+    
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0 || header.version != CAPTURE_VERSION)
+    {
+        throw std::runtime_error(path + " is not a version " + std::to_string(CAPTURE_VERSION) + " command capture!");
+    }
+    
+    destroyObjects();
+    handles.assign(1, 0);
+    frames.assign(1, ReplayFrame{});
+    frameIntervals.assign(1, GpuInterval{});
+    for (FrameSlot& slot : slots)
+    {
+        slot.frame = 0;
+    }
+    
+    CaptureReader reader(data.data() + sizeof(header), data.size() - sizeof(header));
+    auto frameStart = std::chrono::steady_clock::now();
+    auto pacingStart = frameStart;
+    double firstRecordedMs = 0.0;
+    
+    while (!reader.atEnd())
+    {
+        const CaptureRecord type = reader.read<CaptureRecord>();
+        const uint32_t size = reader.read<uint32_t>();
+        CaptureReader record(reader.readSpan(size), size);
+        
+        if (type != CaptureRecord::EndFrame)
+        {
+            replayRecord(type, record);
+            continue;
+        }
+        
+        ReplayFrame& frame = frames.back();
+        frame.recordedMs = record.read<double>();
+        frame.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        
+        if (paced && frames.size() == 1)
+        {
+            pacingStart = std::chrono::steady_clock::now();
+            firstRecordedMs = frame.recordedMs;
+        } else if (paced)
+        {
+            const std::chrono::duration<double, std::milli> recordedOffset(frame.recordedMs - firstRecordedMs);
+            std::this_thread::sleep_until(pacingStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(recordedOffset));
+        }
+        
+        // The next frame takes the slot of the frame MAX_FRAMES_IN_FLIGHT back, waiting for it counts as its time
+        frameStart = std::chrono::steady_clock::now();
+        currentSlot = (currentSlot + 1) % MAX_FRAMES_IN_FLIGHT;
+        retireSlot(slots[currentSlot]);
+        
+        frames.emplace_back();
+        frameIntervals.emplace_back();
+        slots[currentSlot].frame = frames.size() - 1;
+    }
+    
+    for (FrameSlot& slot : slots)
+    {
+        retireSlot(slot);
+    }
+    
+    // Whatever followed the last EndFrame never made it to a frame
+    frames.pop_back();
+    
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        frames[i].gpuMs = frameIntervals[i].durationMs();
+    }
+    
+    vkDeviceWaitIdle(device);
+    destroyObjects();
+}
+
+
+const CaptureHeader& CaptureReplayer::getHeader(void) const
+{
+    return header;
+}
+
+
+void CaptureReplayer::replayRecord(const CaptureRecord type, CaptureReader& reader)
+{
+    switch (type)
+    {
+        case CaptureRecord::CreateBuffer:
+            createBuffer(reader);
+            break;
+        case CaptureRecord::CreateImage:
+            createImage(reader);
+            break;
+        case CaptureRecord::CreateSwapchainImage:
+            createSwapchainImage(reader);
+            break;
+        case CaptureRecord::AllocateMemory:
+        {
+            const uint32_t id = reader.read<uint32_t>();
+            Memory& memory = memories[id];
+            reader.read(memory.size);
+            reader.read(memory.flags);
+            break;
+        }
+        case CaptureRecord::BindBufferMemory:
+        {
+            const VkBuffer buffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+            const uint32_t memoryId = reader.read<uint32_t>();
+            const VkDeviceSize offset = reader.read<VkDeviceSize>();
+            
+            VkMemoryRequirements requirements;
+            vkGetBufferMemoryRequirements(device, buffer, &requirements);
+            vkBindBufferMemory(device, buffer, allocateMemory(memoryId, requirements, offset), offset);
+            break;
+        }
+        case CaptureRecord::BindImageMemory:
+        {
+            const VkImage image = getHandle<VkImage>(reader.read<uint32_t>());
+            const uint32_t memoryId = reader.read<uint32_t>();
+            const VkDeviceSize offset = reader.read<VkDeviceSize>();
+            
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(device, image, &requirements);
+            vkBindImageMemory(device, image, allocateMemory(memoryId, requirements, offset), offset);
+            break;
+        }
+        case CaptureRecord::WriteMemory:
+            writeMemory(reader);
+            break;
+        case CaptureRecord::CreateImageView:
+            createImageView(reader);
+            break;
+        case CaptureRecord::CreateSampler:
+        {
+            const uint32_t id = reader.read<uint32_t>();
+            const VkSamplerCreateInfo createInfo = reader.read<VkSamplerCreateInfo>();
+            
+            VkSampler sampler;
+            if (vkCreateSampler(device, &createInfo, pAllocator, &sampler) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create replayed sampler!");
+            }
+            setHandle(id, sampler, VK_OBJECT_TYPE_SAMPLER);
+            break;
+        }
+        case CaptureRecord::CreateRenderPass:
+            createRenderPass(reader);
+            break;
+        case CaptureRecord::CreateFramebuffer:
+            createFramebuffer(reader);
+            break;
+        case CaptureRecord::CreateShaderModule:
+            createShaderModule(reader);
+            break;
+        case CaptureRecord::CreateDescriptorSetLayout:
+            createDescriptorSetLayout(reader);
+            break;
+        case CaptureRecord::CreatePipelineLayout:
+            createPipelineLayout(reader);
+            break;
+        case CaptureRecord::CreateGraphicsPipeline:
+            createGraphicsPipeline(reader);
+            break;
+        case CaptureRecord::CreateComputePipeline:
+            createComputePipeline(reader);
+            break;
+        case CaptureRecord::CreateDescriptorPool:
+            createDescriptorPool(reader);
+            break;
+        case CaptureRecord::AllocateDescriptorSets:
+            allocateDescriptorSets(reader);
+            break;
+        case CaptureRecord::UpdateDescriptorSets:
+            updateDescriptorSets(reader);
+            break;
+        case CaptureRecord::CreateQueryPool:
+        {
+            const uint32_t id = reader.read<uint32_t>();
+            const VkQueryPoolCreateInfo createInfo = reader.read<VkQueryPoolCreateInfo>();
+            
+            VkQueryPool queryPool;
+            if (vkCreateQueryPool(device, &createInfo, pAllocator, &queryPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create replayed query pool!");
+            }
+            setHandle(id, queryPool, VK_OBJECT_TYPE_QUERY_POOL);
+            break;
+        }
+        case CaptureRecord::CreateSemaphore:
+            createSemaphore(reader);
+            break;
+        case CaptureRecord::Submit:
+            submit(reader);
+            break;
+        case CaptureRecord::QueueWaitIdle:
+            queueWaitIdle(reader);
+            break;
+        case CaptureRecord::DestroyObject:
+            destroyObject(reader);
+            break;
+        default:
+            throw std::runtime_error("Capture contains an unknown record!");
+    }
+}
+
+
+void CaptureReplayer::createBuffer(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkBufferCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    reader.read(createInfo.flags);
+    reader.read(createInfo.size);
+    reader.read(createInfo.usage);
+    reader.read(createInfo.sharingMode);
+    applySharing(concurrentFamilies, createInfo.sharingMode, createInfo.queueFamilyIndexCount, createInfo.pQueueFamilyIndices);
+    
+    VkBuffer buffer;
+    if (vkCreateBuffer(device, &createInfo, pAllocator, &buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed buffer!");
+    }
+    setHandle(id, buffer, VK_OBJECT_TYPE_BUFFER);
+}
+
+
+void CaptureReplayer::createImage(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkImageCreateInfo createInfo = reader.read<VkImageCreateInfo>();
+    applySharing(concurrentFamilies, createInfo.sharingMode, createInfo.queueFamilyIndexCount, createInfo.pQueueFamilyIndices);
+    
+    VkImage image;
+    if (vkCreateImage(device, &createInfo, pAllocator, &image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed image!");
+    }
+    setHandle(id, image, VK_OBJECT_TYPE_IMAGE);
+}
+
+
+void CaptureReplayer::createSwapchainImage(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkImageCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    reader.read(createInfo.format);
+    const VkExtent2D extent = reader.read<VkExtent2D>();
+    createInfo.extent = {extent.width, extent.height, 1};
+    reader.read(createInfo.usage);
+    reader.read(createInfo.arrayLayers);
+    createInfo.mipLevels = 1;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    
+    VkImage image;
+    if (vkCreateImage(device, &createInfo, pAllocator, &image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed swap chain image!");
+    }
+    setHandle(id, image, VK_OBJECT_TYPE_IMAGE);
+    
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image, &requirements);
+    
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = findReplayMemoryType(memoryProperties, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, pAllocator, &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate replayed swap chain image memory!");
+    }
+    createdObjects.push_back({VK_OBJECT_TYPE_DEVICE_MEMORY, toKey(memory)});
+    swapchainImageMemories[id] = memory;
+    
+    vkBindImageMemory(device, image, memory, 0);
+}
+
+
+VkDeviceMemory CaptureReplayer::allocateMemory(const uint32_t memoryId, const VkMemoryRequirements& requirements, const VkDeviceSize offset)
+{
+    const auto it = memories.find(memoryId);
+    if (it == memories.end())
+    {
+        throw std::runtime_error("Capture binds memory it did not allocate!");
+    }
+    
+    Memory& memory = it->second;
+    if (memory.memory != VK_NULL_HANDLE)
+    {
+        return memory.memory;
+    }
+    
+    const uint32_t typeIndex = findReplayMemoryType(memoryProperties, requirements.memoryTypeBits, memory.flags);
+    const VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[typeIndex].propertyFlags;
+    
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = std::max(memory.size, offset + requirements.size);
+    allocInfo.memoryTypeIndex = typeIndex;
+    
+    if (vkAllocateMemory(device, &allocInfo, pAllocator, &memory.memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate replayed memory!");
+    }
+    setHandle(memoryId, memory.memory, VK_OBJECT_TYPE_DEVICE_MEMORY);
+    
+    memory.size = allocInfo.allocationSize;
+    memory.coherent = (typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    
+    // Host visible memory stays mapped for the writes of the capture, freeing it unmaps it
+    if (typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        void* mapped = nullptr;
+        vkMapMemory(device, memory.memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+        memory.mapped = static_cast<uint8_t*>(mapped);
+    }
+    
+    return memory.memory;
+}
+
+
+void CaptureReplayer::writeMemory(CaptureReader& reader)
+{
+    const uint32_t memoryId = reader.read<uint32_t>();
+    const VkDeviceSize offset = reader.read<VkDeviceSize>();
+    const uint32_t size = reader.read<uint32_t>();
+    const uint8_t* bytes = reader.readSpan(size);
+    
+    const auto it = memories.find(memoryId);
+    if (it == memories.end() || it->second.mapped == nullptr || offset + size > it->second.size)
+    {
+        throw std::runtime_error("Capture writes memory that is not host visible here!");
+    }
+    
+    Memory& memory = it->second;
+    std::memcpy(memory.mapped + offset, bytes, size);
+    
+    if (!memory.coherent)
+    {
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = memory.memory;
+        range.offset = 0;
+        range.size = VK_WHOLE_SIZE;
+        vkFlushMappedMemoryRanges(device, 1, &range);
+    }
+}
+
+
+void CaptureReplayer::createImageView(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkImageViewCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    createInfo.image = getHandle<VkImage>(reader.read<uint32_t>());
+    reader.read(createInfo.flags);
+    reader.read(createInfo.viewType);
+    reader.read(createInfo.format);
+    reader.read(createInfo.components);
+    reader.read(createInfo.subresourceRange);
+    
+    VkImageView imageView;
+    if (vkCreateImageView(device, &createInfo, pAllocator, &imageView) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed image view!");
+    }
+    setHandle(id, imageView, VK_OBJECT_TYPE_IMAGE_VIEW);
+}
+
+
+void CaptureReplayer::createRenderPass(CaptureReader& reader)
+{
+    struct SubpassArrays
+    {
+        std::vector<VkAttachmentReference> inputs;
+        std::vector<VkAttachmentReference> colors;
+        std::vector<VkAttachmentReference> resolves;
+        std::vector<VkAttachmentReference> depthStencil;
+        std::vector<uint32_t> preserves;
+    };
+    
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkRenderPassCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    reader.read(createInfo.flags);
+    
+    std::vector<VkAttachmentDescription> attachments = reader.readArray<VkAttachmentDescription>();
+    for (VkAttachmentDescription& attachment : attachments)
+    {
+        attachment.initialLayout = replayLayout(attachment.initialLayout);
+        attachment.finalLayout = replayLayout(attachment.finalLayout);
+    }
+    
+    const uint32_t subpassCount = reader.read<uint32_t>();
+    std::vector<SubpassArrays> arrays(subpassCount);
+    std::vector<VkSubpassDescription> subpasses(subpassCount);
+    for (uint32_t i = 0; i < subpassCount; i++)
+    {
+        VkSubpassDescription& subpass = subpasses[i];
+        reader.read(subpass.flags);
+        reader.read(subpass.pipelineBindPoint);
+        
+        arrays[i].inputs = reader.readArray<VkAttachmentReference>();
+        arrays[i].colors = reader.readArray<VkAttachmentReference>();
+        arrays[i].resolves = reader.readArray<VkAttachmentReference>();
+        arrays[i].depthStencil = reader.readArray<VkAttachmentReference>();
+        arrays[i].preserves = reader.readArray<uint32_t>();
+        
+        subpass.inputAttachmentCount = static_cast<uint32_t>(arrays[i].inputs.size());
+        subpass.pInputAttachments = arrays[i].inputs.data();
+        subpass.colorAttachmentCount = static_cast<uint32_t>(arrays[i].colors.size());
+        subpass.pColorAttachments = arrays[i].colors.data();
+        subpass.pResolveAttachments = arrays[i].resolves.empty() ? nullptr : arrays[i].resolves.data();
+        subpass.pDepthStencilAttachment = arrays[i].depthStencil.empty() ? nullptr : arrays[i].depthStencil.data();
+        subpass.preserveAttachmentCount = static_cast<uint32_t>(arrays[i].preserves.size());
+        subpass.pPreserveAttachments = arrays[i].preserves.data();
+    }
+    
+    const std::vector<VkSubpassDependency> dependencies = reader.readArray<VkSubpassDependency>();
+    
+    createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    createInfo.pAttachments = attachments.data();
+    createInfo.subpassCount = subpassCount;
+    createInfo.pSubpasses = subpasses.data();
+    createInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    createInfo.pDependencies = dependencies.data();
+    
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(device, &createInfo, pAllocator, &renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed render pass!");
+    }
+    setHandle(id, renderPass, VK_OBJECT_TYPE_RENDER_PASS);
+}
+
+
+void CaptureReplayer::createFramebuffer(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkFramebufferCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    reader.read(createInfo.flags);
+    createInfo.renderPass = getHandle<VkRenderPass>(reader.read<uint32_t>());
+    
+    std::vector<VkImageView> attachments(reader.read<uint32_t>());
+    for (VkImageView& attachment : attachments)
+    {
+        attachment = getHandle<VkImageView>(reader.read<uint32_t>());
+    }
+    createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    createInfo.pAttachments = attachments.data();
+    
+    reader.read(createInfo.width);
+    reader.read(createInfo.height);
+    reader.read(createInfo.layers);
+    
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(device, &createInfo, pAllocator, &framebuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed framebuffer!");
+    }
+    setHandle(id, framebuffer, VK_OBJECT_TYPE_FRAMEBUFFER);
+}
+
+
+void CaptureReplayer::createShaderModule(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    const std::vector<uint32_t> code = reader.readArray<uint32_t>();
+    
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
+    
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(device, &createInfo, pAllocator, &shaderModule) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed shader module!");
+    }
+    setHandle(id, shaderModule, VK_OBJECT_TYPE_SHADER_MODULE);
+}
+
+
+void CaptureReplayer::createDescriptorSetLayout(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkDescriptorSetLayoutCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    reader.read(createInfo.flags);
+    const std::vector<VkDescriptorSetLayoutBinding> bindings = reader.readArray<VkDescriptorSetLayoutBinding>();
+    createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    createInfo.pBindings = bindings.data();
+    
+    VkDescriptorSetLayout setLayout;
+    if (vkCreateDescriptorSetLayout(device, &createInfo, pAllocator, &setLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed descriptor set layout!");
+    }
+    setHandle(id, setLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT);
+}
+
+
+void CaptureReplayer::createPipelineLayout(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkPipelineLayoutCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    reader.read(createInfo.flags);
+    
+    std::vector<VkDescriptorSetLayout> setLayouts(reader.read<uint32_t>());
+    for (VkDescriptorSetLayout& setLayout : setLayouts)
+    {
+        setLayout = getHandle<VkDescriptorSetLayout>(reader.read<uint32_t>());
+    }
+    const std::vector<VkPushConstantRange> ranges = reader.readArray<VkPushConstantRange>();
+    
+    createInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    createInfo.pSetLayouts = setLayouts.data();
+    createInfo.pushConstantRangeCount = static_cast<uint32_t>(ranges.size());
+    createInfo.pPushConstantRanges = ranges.data();
+    
+    VkPipelineLayout pipelineLayout;
+    if (vkCreatePipelineLayout(device, &createInfo, pAllocator, &pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed pipeline layout!");
+    }
+    setHandle(id, pipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT);
+}
+
+
+struct ReplayShaderStage
+{
+    VkPipelineShaderStageCreateInfo info{};
+    std::string name;
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<uint8_t> data;
+    VkSpecializationInfo specialization{};
+};
+
+
+// stage must not move once read, info points into it
+template <typename GetModule>
+static void readShaderStage(CaptureReader& reader, ReplayShaderStage& stage, const GetModule& getModule)
+{
+    stage.info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    reader.read(stage.info.flags);
+    reader.read(stage.info.stage);
+    stage.info.module = getModule(reader.read<uint32_t>());
+    stage.name = reader.readString();
+    stage.info.pName = stage.name.c_str();
+    
+    stage.entries = reader.readArray<VkSpecializationMapEntry>();
+    stage.data = reader.readArray<uint8_t>();
+    if (!stage.entries.empty())
+    {
+        stage.specialization.mapEntryCount = static_cast<uint32_t>(stage.entries.size());
+        stage.specialization.pMapEntries = stage.entries.data();
+        stage.specialization.dataSize = stage.data.size();
+        stage.specialization.pData = stage.data.data();
+        stage.info.pSpecializationInfo = &stage.specialization;
+    }
+}
+
+
+// Reads a state struct written with a count of 0 or 1, returns whether it was there
+template <typename T>
+static bool readState(CaptureReader& reader, T& state)
+{
+    if (reader.read<uint32_t>() == 0)
+    {
+        return false;
+    }
+    
+    reader.read(state);
+    return true;
+}
+
+
+void CaptureReplayer::createGraphicsPipeline(CaptureReader& reader)
+{
+    const auto getModule = [this](const uint32_t moduleId) { return getHandle<VkShaderModule>(moduleId); };
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkGraphicsPipelineCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    reader.read(createInfo.flags);
+    
+    std::vector<ReplayShaderStage> stages(reader.read<uint32_t>());
+    std::vector<VkPipelineShaderStageCreateInfo> stageInfos;
+    for (ReplayShaderStage& stage : stages)
+    {
+        readShaderStage(reader, stage, getModule);
+        stageInfos.push_back(stage.info);
+    }
+    createInfo.stageCount = static_cast<uint32_t>(stageInfos.size());
+    createInfo.pStages = stageInfos.data();
+    
+    const std::vector<VkVertexInputBindingDescription> bindings = reader.readArray<VkVertexInputBindingDescription>();
+    const std::vector<VkVertexInputAttributeDescription> attributes = reader.readArray<VkVertexInputAttributeDescription>();
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+    vertexInput.pVertexBindingDescriptions = bindings.data();
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+    vertexInput.pVertexAttributeDescriptions = attributes.data();
+    createInfo.pVertexInputState = &vertexInput;
+    
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    createInfo.pInputAssemblyState = readState(reader, inputAssembly) ? &inputAssembly : nullptr;
+    VkPipelineTessellationStateCreateInfo tessellation{};
+    createInfo.pTessellationState = readState(reader, tessellation) ? &tessellation : nullptr;
+    
+    VkPipelineViewportStateCreateInfo viewport{};
+    viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    reader.read(viewport.viewportCount);
+    reader.read(viewport.scissorCount);
+    const std::vector<VkViewport> viewports = reader.readArray<VkViewport>();
+    const std::vector<VkRect2D> scissors = reader.readArray<VkRect2D>();
+    viewport.pViewports = viewports.empty() ? nullptr : viewports.data();
+    viewport.pScissors = scissors.empty() ? nullptr : scissors.data();
+    createInfo.pViewportState = &viewport;
+    
+    VkPipelineRasterizationStateCreateInfo rasterization{};
+    createInfo.pRasterizationState = readState(reader, rasterization) ? &rasterization : nullptr;
+    VkPipelineMultisampleStateCreateInfo multisample{};
+    createInfo.pMultisampleState = readState(reader, multisample) ? &multisample : nullptr;
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    createInfo.pDepthStencilState = readState(reader, depthStencil) ? &depthStencil : nullptr;
+    
+    VkPipelineColorBlendStateCreateInfo colorBlend{};
+    const bool hasColorBlend = readState(reader, colorBlend);
+    const std::vector<VkPipelineColorBlendAttachmentState> blendAttachments = reader.readArray<VkPipelineColorBlendAttachmentState>();
+    colorBlend.attachmentCount = static_cast<uint32_t>(blendAttachments.size());
+    colorBlend.pAttachments = blendAttachments.data();
+    createInfo.pColorBlendState = hasColorBlend ? &colorBlend : nullptr;
+    
+    const std::vector<VkDynamicState> dynamicStates = reader.readArray<VkDynamicState>();
+    VkPipelineDynamicStateCreateInfo dynamic{};
+    dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamic.pDynamicStates = dynamicStates.data();
+    createInfo.pDynamicState = &dynamic;
+    
+    createInfo.layout = getHandle<VkPipelineLayout>(reader.read<uint32_t>());
+    createInfo.renderPass = getHandle<VkRenderPass>(reader.read<uint32_t>());
+    reader.read(createInfo.subpass);
+    createInfo.basePipelineIndex = -1;
+    
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    reader.read(libraryInfo.flags);
+    std::vector<VkPipeline> libraries(reader.read<uint32_t>());
+    for (VkPipeline& library : libraries)
+    {
+        library = getHandle<VkPipeline>(reader.read<uint32_t>());
+    }
+    
+    VkPipelineLibraryCreateInfoKHR linkInfo{};
+    linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    linkInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+    linkInfo.pLibraries = libraries.data();
+    
+    void* linkChain = libraries.empty() ? nullptr : &linkInfo;
+    libraryInfo.pNext = linkChain;
+    createInfo.pNext = libraryInfo.flags != 0 ? &libraryInfo : linkChain;
+    
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &createInfo, pAllocator, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed graphics pipeline!");
+    }
+    setHandle(id, pipeline, VK_OBJECT_TYPE_PIPELINE);
+}
+
+
+void CaptureReplayer::createComputePipeline(CaptureReader& reader)
+{
+    const auto getModule = [this](const uint32_t moduleId) { return getHandle<VkShaderModule>(moduleId); };
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkComputePipelineCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    reader.read(createInfo.flags);
+    
+    ReplayShaderStage stage;
+    readShaderStage(reader, stage, getModule);
+    createInfo.stage = stage.info;
+    createInfo.layout = getHandle<VkPipelineLayout>(reader.read<uint32_t>());
+    createInfo.basePipelineIndex = -1;
+    
+    VkPipeline pipeline;
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &createInfo, pAllocator, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed compute pipeline!");
+    }
+    setHandle(id, pipeline, VK_OBJECT_TYPE_PIPELINE);
+}
+
+
+void CaptureReplayer::createDescriptorPool(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkDescriptorPoolCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    reader.read(createInfo.flags);
+    reader.read(createInfo.maxSets);
+    const std::vector<VkDescriptorPoolSize> poolSizes = reader.readArray<VkDescriptorPoolSize>();
+    createInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    createInfo.pPoolSizes = poolSizes.data();
+    
+    VkDescriptorPool descriptorPool;
+    if (vkCreateDescriptorPool(device, &createInfo, pAllocator, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed descriptor pool!");
+    }
+    setHandle(id, descriptorPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL);
+}
+
+
+void CaptureReplayer::allocateDescriptorSets(CaptureReader& reader)
+{
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = getHandle<VkDescriptorPool>(reader.read<uint32_t>());
+    
+    std::vector<VkDescriptorSetLayout> setLayouts(reader.read<uint32_t>());
+    for (VkDescriptorSetLayout& setLayout : setLayouts)
+    {
+        setLayout = getHandle<VkDescriptorSetLayout>(reader.read<uint32_t>());
+    }
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+    allocInfo.pSetLayouts = setLayouts.data();
+    
+    std::vector<VkDescriptorSet> sets(setLayouts.size());
+    if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate replayed descriptor sets!");
+    }
+    
+    // Freed with their pool
+    for (const VkDescriptorSet set : sets)
+    {
+        setHandle(reader.read<uint32_t>(), set, VK_OBJECT_TYPE_UNKNOWN);
+    }
+}
+
+
+void CaptureReplayer::updateDescriptorSets(CaptureReader& reader)
+{
+    const uint32_t writeCount = reader.read<uint32_t>();
+    
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<std::vector<VkDescriptorImageInfo>> imageInfos(writeCount);
+    std::vector<std::vector<VkDescriptorBufferInfo>> bufferInfos(writeCount);
+    for (uint32_t i = 0; i < writeCount; i++)
+    {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = getHandle<VkDescriptorSet>(reader.read<uint32_t>());
+        reader.read(write.dstBinding);
+        reader.read(write.dstArrayElement);
+        reader.read(write.descriptorType);
+        
+        imageInfos[i].resize(reader.read<uint32_t>());
+        for (VkDescriptorImageInfo& imageInfo : imageInfos[i])
+        {
+            imageInfo.sampler = getHandle<VkSampler>(reader.read<uint32_t>());
+            imageInfo.imageView = getHandle<VkImageView>(reader.read<uint32_t>());
+            imageInfo.imageLayout = replayLayout(reader.read<VkImageLayout>());
+        }
+        
+        bufferInfos[i].resize(reader.read<uint32_t>());
+        for (VkDescriptorBufferInfo& bufferInfo : bufferInfos[i])
+        {
+            bufferInfo.buffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+            reader.read(bufferInfo.offset);
+            reader.read(bufferInfo.range);
+        }
+        
+        // Texel buffer writes were captured without their views
+        if (imageInfos[i].empty() && bufferInfos[i].empty())
+        {
+            continue;
+        }
+        
+        write.descriptorCount = static_cast<uint32_t>(std::max(imageInfos[i].size(), bufferInfos[i].size()));
+        write.pImageInfo = imageInfos[i].empty() ? nullptr : imageInfos[i].data();
+        write.pBufferInfo = bufferInfos[i].empty() ? nullptr : bufferInfos[i].data();
+        writes.push_back(write);
+    }
+    
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+
+void CaptureReplayer::createSemaphore(CaptureReader& reader)
+{
+    const uint32_t id = reader.read<uint32_t>();
+    
+    VkSemaphoreTypeCreateInfoKHR typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    reader.read(typeInfo.initialValue);
+    
+    VkSemaphoreCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    createInfo.pNext = &typeInfo;
+    
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device, &createInfo, pAllocator, &semaphore) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create replayed timeline semaphore!");
+    }
+    setHandle(id, semaphore, VK_OBJECT_TYPE_SEMAPHORE);
+}
+
+
+SubmitScheduler& CaptureReplayer::getScheduler(const QueueRole role)
+{
+    // Present and transfer submissions of the capture run on the graphics queue
+    return role == QueueRole::Compute ? queue->getComputeScheduler() : queue->getGraphicsScheduler();
+}
+
+
+void CaptureReplayer::submit(CaptureReader& reader)
+{
+    struct ReplaySubmit
+    {
+        SubmitRequest request;
+        std::vector<CaptureReader> streams;
+    };
+    
+    const QueueRole role = reader.read<QueueRole>();
+    const bool compute = role == QueueRole::Compute;
+    
+    const auto readSemaphores = [&](SubmitRequest& request, const bool signal)
+    {
+        const uint32_t count = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const VkSemaphore semaphore = getHandle<VkSemaphore>(reader.read<uint32_t>());
+            const uint64_t value = reader.read<uint64_t>();
+            const uint64_t stageMask = reader.read<uint64_t>();
+            
+            if (signal)
+            {
+                request.addSignal(semaphore, stageMask, value);
+            } else
+            {
+                request.addWait(semaphore, stageMask, value);
+            }
+        }
+    };
+    
+    std::vector<ReplaySubmit> submits(reader.read<uint32_t>());
+    uint32_t commandBufferCount = 0;
+    for (ReplaySubmit& submit : submits)
+    {
+        readSemaphores(submit.request, false);
+        
+        const uint32_t streamCount = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < streamCount; i++)
+        {
+            const uint32_t size = reader.read<uint32_t>();
+            submit.streams.emplace_back(reader.readSpan(size), size);
+        }
+        commandBufferCount += streamCount;
+        
+        readSemaphores(submit.request, true);
+    }
+    
+    if (commandBufferCount > REPLAY_COMMAND_BUFFERS)
+    {
+        throw std::runtime_error("Capture submits more command buffers at once than REPLAY_COMMAND_BUFFERS!");
+    }
+    
+    FrameSlot& slot = slots[currentSlot];
+    if ((compute ? slot.computeUsed : slot.graphicsUsed) + commandBufferCount > REPLAY_COMMAND_BUFFERS)
+    {
+        retireSlot(slot);
+    }
+    
+    uint32_t& used = compute ? slot.computeUsed : slot.graphicsUsed;
+    CommandPool& commandPool = compute ? slot.computePool : slot.graphicsPool;
+    GpuTimer& timer = compute ? computeTimer : graphicsTimer;
+    SubmitScheduler& scheduler = getScheduler(role);
+    
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    
+    for (ReplaySubmit& submit : submits)
+    {
+        for (CaptureReader& stream : submit.streams)
+        {
+            const uint32_t timerSlot = currentSlot * REPLAY_COMMAND_BUFFERS + used;
+            const VkCommandBuffer commandBuffer = commandPool.getCommandBuffer(used++);
+            
+            if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to begin recording replayed command buffer!");
+            }
+            
+            timer.cmdBegin(commandBuffer, timerSlot);
+            recordCommandBuffer(commandBuffer, stream);
+            timer.cmdEnd(commandBuffer, timerSlot);
+            
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to record replayed command buffer!");
+            }
+            
+            submit.request.commandBuffers.push_back(commandBuffer);
+        }
+        
+        scheduler.enqueue(std::move(submit.request));
+    }
+    
+    (compute ? slot.computeValue : slot.graphicsValue) = scheduler.flush();
+}
+
+
+void CaptureReplayer::queueWaitIdle(CaptureReader& reader)
+{
+    const QueueRole role = reader.read<QueueRole>();
+    const VkQueue replayQueue = role == QueueRole::Compute ? queue->getComputeQueue() : queue->getGraphicsQueue();
+    
+    getScheduler(role).flush();
+    vkQueueWaitIdle(replayQueue);
+}
+
+
+// The capture only destroys objects once the frames that used them retired, which the replay retires at the same points
+void CaptureReplayer::destroyObject(CaptureReader& reader)
+{
+    const VkObjectType type = reader.read<VkObjectType>();
+    const uint32_t id = reader.read<uint32_t>();
+    const uint64_t key = getHandle<uint64_t>(id);
+    
+    // Memory nothing was bound to was never allocated
+    memories.erase(id);
+    if (key == 0)
+    {
+        return;
+    }
+    
+    const auto forget = [this](const VkObjectType objectType, const uint64_t objectKey)
+    {
+        const auto it = std::find(createdObjects.rbegin(), createdObjects.rend(), std::make_pair(objectType, objectKey));
+        if (it != createdObjects.rend())
+        {
+            createdObjects.erase(std::next(it).base());
+        }
+        destroyHandle(objectType, objectKey);
+    };
+    
+    forget(type, key);
+    handles[id] = 0;
+    
+    // Swap chain images are stand-ins with memory of their own
+    const auto memory = swapchainImageMemories.find(id);
+    if (memory != swapchainImageMemories.end())
+    {
+        forget(VK_OBJECT_TYPE_DEVICE_MEMORY, toKey(memory->second));
+        swapchainImageMemories.erase(memory);
+    }
+}
+
+
+void CaptureReplayer::retireSlot(FrameSlot& slot)
+{
+    queue->getGraphicsScheduler().waitFor(device, slot.graphicsValue);
+    queue->getComputeScheduler().waitFor(device, slot.computeValue);
+    
+    const uint32_t firstTimerSlot = static_cast<uint32_t>(&slot - slots) * REPLAY_COMMAND_BUFFERS;
+    GpuInterval& frame = frameIntervals[slot.frame];
+    
+    const auto addIntervals = [&](GpuTimer& timer, const uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            GpuInterval interval;
+            if (!timer.readInterval(device, firstTimerSlot + i, interval))
+            {
+                continue;
+            }
+            
+            const bool first = frame.endNs == 0.0;
+            frame.beginNs = first ? interval.beginNs : std::min(frame.beginNs, interval.beginNs);
+            frame.endNs = first ? interval.endNs : std::max(frame.endNs, interval.endNs);
+        }
+    };
+    
+    addIntervals(graphicsTimer, slot.graphicsUsed);
+    addIntervals(computeTimer, slot.computeUsed);
+    
+    slot.graphicsUsed = 0;
+    slot.computeUsed = 0;
+}
+
+
+void CaptureReplayer::recordCommandBuffer(const VkCommandBuffer commandBuffer, CaptureReader& stream)
+{
+    while (!stream.atEnd())
+    {
+        const CaptureCommand op = stream.read<CaptureCommand>();
+        const uint32_t size = stream.read<uint32_t>();
+        CaptureReader reader(stream.readSpan(size), size);
+        recordCommand(commandBuffer, op, reader);
+    }
+}
+
+
+void CaptureReplayer::recordCommand(const VkCommandBuffer commandBuffer, const CaptureCommand op, CaptureReader& reader)
+{
+    switch (op)
+    {
+        case CaptureCommand::BeginRenderPass:
+        {
+            VkRenderPassBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            beginInfo.renderPass = getHandle<VkRenderPass>(reader.read<uint32_t>());
+            beginInfo.framebuffer = getHandle<VkFramebuffer>(reader.read<uint32_t>());
+            reader.read(beginInfo.renderArea);
+            const std::vector<VkClearValue> clearValues = reader.readArray<VkClearValue>();
+            beginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+            beginInfo.pClearValues = clearValues.data();
+            
+            vkCmdBeginRenderPass(commandBuffer, &beginInfo, reader.read<VkSubpassContents>());
+            break;
+        }
+        case CaptureCommand::EndRenderPass:
+            vkCmdEndRenderPass(commandBuffer);
+            break;
+        case CaptureCommand::BindPipeline:
+        {
+            const VkPipelineBindPoint bindPoint = reader.read<VkPipelineBindPoint>();
+            vkCmdBindPipeline(commandBuffer, bindPoint, getHandle<VkPipeline>(reader.read<uint32_t>()));
+            break;
+        }
+        case CaptureCommand::BindDescriptorSets:
+        {
+            const VkPipelineBindPoint bindPoint = reader.read<VkPipelineBindPoint>();
+            const VkPipelineLayout layout = getHandle<VkPipelineLayout>(reader.read<uint32_t>());
+            const uint32_t firstSet = reader.read<uint32_t>();
+            
+            std::vector<VkDescriptorSet> sets(reader.read<uint32_t>());
+            for (VkDescriptorSet& set : sets)
+            {
+                set = getHandle<VkDescriptorSet>(reader.read<uint32_t>());
+            }
+            const std::vector<uint32_t> dynamicOffsets = reader.readArray<uint32_t>();
+            
+            vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, static_cast<uint32_t>(sets.size()), sets.data(), static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+            break;
+        }
+        case CaptureCommand::PushConstants:
+        {
+            const VkPipelineLayout layout = getHandle<VkPipelineLayout>(reader.read<uint32_t>());
+            const VkShaderStageFlags stageFlags = reader.read<VkShaderStageFlags>();
+            const uint32_t offset = reader.read<uint32_t>();
+            const std::vector<uint8_t> values = reader.readArray<uint8_t>();
+            
+            vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, static_cast<uint32_t>(values.size()), values.data());
+            break;
+        }
+        case CaptureCommand::SetViewport:
+        {
+            const uint32_t first = reader.read<uint32_t>();
+            const std::vector<VkViewport> viewports = reader.readArray<VkViewport>();
+            vkCmdSetViewport(commandBuffer, first, static_cast<uint32_t>(viewports.size()), viewports.data());
+            break;
+        }
+        case CaptureCommand::SetScissor:
+        {
+            const uint32_t first = reader.read<uint32_t>();
+            const std::vector<VkRect2D> scissors = reader.readArray<VkRect2D>();
+            vkCmdSetScissor(commandBuffer, first, static_cast<uint32_t>(scissors.size()), scissors.data());
+            break;
+        }
+        case CaptureCommand::BindVertexBuffers:
+        {
+            const uint32_t firstBinding = reader.read<uint32_t>();
+            
+            std::vector<VkBuffer> buffers(reader.read<uint32_t>());
+            for (VkBuffer& buffer : buffers)
+            {
+                buffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+            }
+            const std::vector<VkDeviceSize> offsets = reader.readArray<VkDeviceSize>();
+            
+            vkCmdBindVertexBuffers(commandBuffer, firstBinding, static_cast<uint32_t>(buffers.size()), buffers.data(), offsets.data());
+            break;
+        }
+        case CaptureCommand::BindIndexBuffer:
+        {
+            const VkBuffer buffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+            const VkDeviceSize offset = reader.read<VkDeviceSize>();
+            vkCmdBindIndexBuffer(commandBuffer, buffer, offset, reader.read<VkIndexType>());
+            break;
+        }
+        case CaptureCommand::Draw:
+        {
+            const uint32_t vertexCount = reader.read<uint32_t>();
+            const uint32_t instanceCount = reader.read<uint32_t>();
+            const uint32_t firstVertex = reader.read<uint32_t>();
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, reader.read<uint32_t>());
+            break;
+        }
+        case CaptureCommand::DrawIndexed:
+        {
+            const uint32_t indexCount = reader.read<uint32_t>();
+            const uint32_t instanceCount = reader.read<uint32_t>();
+            const uint32_t firstIndex = reader.read<uint32_t>();
+            const int32_t vertexOffset = reader.read<int32_t>();
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, reader.read<uint32_t>());
+            break;
+        }
+        case CaptureCommand::Dispatch:
+        {
+            const uint32_t groupCountX = reader.read<uint32_t>();
+            const uint32_t groupCountY = reader.read<uint32_t>();
+            vkCmdDispatch(commandBuffer, groupCountX, groupCountY, reader.read<uint32_t>());
+            break;
+        }
+        case CaptureCommand::PipelineBarrier:
+        {
+            const VkPipelineStageFlags srcStageMask = reader.read<VkPipelineStageFlags>();
+            const VkPipelineStageFlags dstStageMask = reader.read<VkPipelineStageFlags>();
+            const VkDependencyFlags dependencyFlags = reader.read<VkDependencyFlags>();
+            
+            std::vector<VkMemoryBarrier> memoryBarriers(reader.read<uint32_t>());
+            for (VkMemoryBarrier& barrier : memoryBarriers)
+            {
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                reader.read(barrier.srcAccessMask);
+                reader.read(barrier.dstAccessMask);
+            }
+            
+            std::vector<VkBufferMemoryBarrier> bufferBarriers(reader.read<uint32_t>());
+            for (VkBufferMemoryBarrier& barrier : bufferBarriers)
+            {
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                reader.read(barrier.srcAccessMask);
+                reader.read(barrier.dstAccessMask);
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.buffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+                reader.read(barrier.offset);
+                reader.read(barrier.size);
+            }
+            
+            std::vector<VkImageMemoryBarrier> imageBarriers(reader.read<uint32_t>());
+            for (VkImageMemoryBarrier& barrier : imageBarriers)
+            {
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                reader.read(barrier.srcAccessMask);
+                reader.read(barrier.dstAccessMask);
+                barrier.oldLayout = replayLayout(reader.read<VkImageLayout>());
+                barrier.newLayout = replayLayout(reader.read<VkImageLayout>());
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = getHandle<VkImage>(reader.read<uint32_t>());
+                reader.read(barrier.subresourceRange);
+            }
+            
+            vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, dependencyFlags, static_cast<uint32_t>(memoryBarriers.size()), memoryBarriers.data(), static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+            break;
+        }
+        case CaptureCommand::CopyBuffer:
+        {
+            const VkBuffer srcBuffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+            const VkBuffer dstBuffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+            const std::vector<VkBufferCopy> regions = reader.readArray<VkBufferCopy>();
+            vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+            break;
+        }
+        case CaptureCommand::CopyImage:
+        {
+            const VkImage srcImage = getHandle<VkImage>(reader.read<uint32_t>());
+            const VkImageLayout srcLayout = replayLayout(reader.read<VkImageLayout>());
+            const VkImage dstImage = getHandle<VkImage>(reader.read<uint32_t>());
+            const VkImageLayout dstLayout = replayLayout(reader.read<VkImageLayout>());
+            const std::vector<VkImageCopy> regions = reader.readArray<VkImageCopy>();
+            vkCmdCopyImage(commandBuffer, srcImage, srcLayout, dstImage, dstLayout, static_cast<uint32_t>(regions.size()), regions.data());
+            break;
+        }
+        case CaptureCommand::CopyImageToBuffer:
+        {
+            const VkImage srcImage = getHandle<VkImage>(reader.read<uint32_t>());
+            const VkImageLayout srcLayout = replayLayout(reader.read<VkImageLayout>());
+            const VkBuffer dstBuffer = getHandle<VkBuffer>(reader.read<uint32_t>());
+            const std::vector<VkBufferImageCopy> regions = reader.readArray<VkBufferImageCopy>();
+            vkCmdCopyImageToBuffer(commandBuffer, srcImage, srcLayout, dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+            break;
+        }
+        case CaptureCommand::WriteTimestamp:
+        {
+            const VkPipelineStageFlagBits stage = reader.read<VkPipelineStageFlagBits>();
+            const VkQueryPool queryPool = getHandle<VkQueryPool>(reader.read<uint32_t>());
+            vkCmdWriteTimestamp(commandBuffer, stage, queryPool, reader.read<uint32_t>());
+            break;
+        }
+        case CaptureCommand::ResetQueryPool:
+        {
+            const VkQueryPool queryPool = getHandle<VkQueryPool>(reader.read<uint32_t>());
+            const uint32_t firstQuery = reader.read<uint32_t>();
+            vkCmdResetQueryPool(commandBuffer, queryPool, firstQuery, reader.read<uint32_t>());
+            break;
+        }
+        default:
+            throw std::runtime_error("Capture contains an unknown command!");
+    }
+}
@@ -0,0 +1,1675 @@
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+
+void CaptureStream::writeBytes(const void* data, const size_t size)
+{
+    const uint8_t* bytesIn = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), bytesIn, bytesIn + size);
+}
+
+
+void CaptureStream::writeString(const char* text)
+{
+    const uint32_t length = text == nullptr ? 0 : static_cast<uint32_t>(std::strlen(text));
+    write(length);
+    writeBytes(text, length);
+}
+
+
+void CaptureStream::clear(void)
+{
+    bytes.clear();
+}
+
+
+const std::vector<uint8_t>& CaptureStream::getBytes(void) const
+{
+    return bytes;
+}
+
+
+CaptureReader::CaptureReader(const uint8_t* data, const size_t size)
+    : data(data), size(size)
+{
+}
+
+
+void CaptureReader::readBytes(void* data, const size_t size)
+{
+    std::memcpy(data, readSpan(size), size);
+}
+
+
+std::string CaptureReader::readString(void)
+{
+    const uint32_t length = read<uint32_t>();
+    const uint8_t* text = readSpan(length);
+    return std::string(reinterpret_cast<const char*>(text), length);
+}
+
+
+const uint8_t* CaptureReader::readSpan(const size_t size)
+{
+    if (size > this->size - offset)
+    {
+        throw std::runtime_error("Capture record is truncated!");
+    }
+    
+    const uint8_t* span = data + offset;
+    offset += size;
+    return span;
+}
+
+
+bool CaptureReader::atEnd(void) const
+{
+    return offset == size;
+}
+
+
+// Everything below runs with CaptureState::mutex held unless it says otherwise
+struct CaptureMapping
+{
+    const uint8_t* data;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    // Ranges of the mapping the host marked written since they were last captured, a new mapping counts as written
+    // whole
+    std::vector<std::pair<VkDeviceSize, VkDeviceSize>> written;
+    // Readback memory the host does not write
+    bool readback;
+};
+
+struct CaptureState
+{
+    std::mutex mutex;
+    std::atomic<bool> capturing{false};
+    std::ofstream file;
+    std::string path;
+    std::chrono::steady_clock::time_point start;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    
+    std::unordered_map<uint64_t, uint32_t> ids;
+    uint32_t nextId = 1;
+    std::unordered_set<uint64_t> timelines;
+    std::unordered_map<uint64_t, VkDeviceSize> allocationSizes;
+    std::unordered_map<uint64_t, VkMemoryPropertyFlags> allocationFlags;
+    std::unordered_map<uint64_t, CaptureMapping> mappings;
+    // Objects that go away with their parent without a destroy call of their own
+    std::unordered_map<uint64_t, std::vector<uint64_t>> swapchainImages;
+    std::unordered_map<uint64_t, std::vector<uint64_t>> poolSets;
+    std::unordered_map<uint64_t, QueueRole> queueRoles;
+    std::unordered_map<uint64_t, CaptureStream> commandStreams;
+    CaptureStream payload;
+    
+    uint64_t recordCount = 0;
+    uint64_t byteCount = 0;
+    uint64_t frameCount = 0;
+    
+    // Counted with or without a capture, for the performance HUD
+    std::atomic<uint32_t> drawCount{0};
+    std::atomic<uint32_t> dispatchCount{0};
+    std::atomic<uint32_t> pipelineBindCount{0};
+};
+
+static CaptureState state;
+
+
+template <typename T>
+static uint64_t handleKey(const T handle)
+{
+    // Non-dispatchable handles are pointers or 64-bit integers depending on the platform
+    uint64_t key = 0;
+    std::memcpy(&key, &handle, sizeof(T));
+    return key;
+}
+
+
+template <typename T>
+static uint32_t assignId(const T handle)
+{
+    const uint32_t id = state.nextId++;
+    state.ids[handleKey(handle)] = id;
+    return id;
+}
+
+
+// 0 for null handles and objects created before the capture was opened
+template <typename T>
+static uint32_t idOf(const T handle)
+{
+    const auto it = state.ids.find(handleKey(handle));
+    return it == state.ids.end() ? 0 : it->second;
+}
+
+
+template <typename T>
+static void writeIds(CaptureStream& stream, const T* handles, const uint32_t count)
+{
+    stream.write(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        stream.write(idOf(handles[i]));
+    }
+}
+
+
+static CaptureStream& beginPayload(void)
+{
+    state.payload.clear();
+    return state.payload;
+}
+
+
+static void commitRecord(const CaptureRecord type)
+{
+    const std::vector<uint8_t>& bytes = state.payload.getBytes();
+    const uint32_t header[2] = {static_cast<uint32_t>(type), static_cast<uint32_t>(bytes.size())};
+    
+    state.file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    state.file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    
+    state.recordCount++;
+    state.byteCount += sizeof(header) + bytes.size();
+}
+
+
+static void appendCommand(const VkCommandBuffer commandBuffer, const CaptureCommand op)
+{
+    const std::vector<uint8_t>& bytes = state.payload.getBytes();
+    CaptureStream& stream = state.commandStreams[handleKey(commandBuffer)];
+    
+    stream.write(static_cast<uint32_t>(op));
+    stream.write(static_cast<uint32_t>(bytes.size()));
+    stream.writeBytes(bytes.data(), bytes.size());
+}
+
+
+static const void* findInChain(const void* pNext, const VkStructureType sType)
+{
+    for (const VkBaseInStructure* base = static_cast<const VkBaseInStructure*>(pNext); base != nullptr; base = base->pNext)
+    {
+        if (base->sType == sType)
+        {
+            return base;
+        }
+    }
+    
+    return nullptr;
+}
+
+
+static void writeMemory(const uint64_t memoryKey, const CaptureMapping& mapping, const VkDeviceSize begin, const VkDeviceSize end)
+{
+    CaptureStream& payload = beginPayload();
+    payload.write(state.ids[memoryKey]);
+    payload.write(mapping.offset + begin);
+    payload.writeArray(mapping.data + begin, static_cast<uint32_t>(end - begin));
+    commitRecord(CaptureRecord::WriteMemory);
+}
+
+
+// Writes a WriteMemory record for every run of ranges marked written since the mapping was last captured
+static void captureMapping(const uint64_t memoryKey, CaptureMapping& mapping)
+{
+    if (mapping.readback || mapping.written.empty())
+    {
+        mapping.written.clear();
+        return;
+    }
+    
+    // Overlapping and adjacent ranges go out as one record
+    std::sort(mapping.written.begin(), mapping.written.end());
+    VkDeviceSize begin = mapping.written.front().first;
+    VkDeviceSize end = begin;
+    for (const auto& range : mapping.written)
+    {
+        if (range.first > end)
+        {
+            writeMemory(memoryKey, mapping, begin, end);
+            begin = range.first;
+        }
+        end = std::max(end, range.first + range.second);
+    }
+    writeMemory(memoryKey, mapping, begin, end);
+    
+    mapping.written.clear();
+}
+
+
+// Persistently mapped memory is picked up before every submit that may read it
+static void captureMappings(void)
+{
+    for (auto& mapping : state.mappings)
+    {
+        captureMapping(mapping.first, mapping.second);
+    }
+}
+
+
+// Writes a DestroyObject record and drops everything known about the handle, so a driver that hands the same value out
+// again gets a new id. Called before the object is destroyed, while no other object can have its value
+static void forgetObject(const VkObjectType type, const uint64_t key)
+{
+    const auto it = state.ids.find(key);
+    if (it == state.ids.end())
+    {
+        return;
+    }
+    
+    CaptureStream& payload = beginPayload();
+    payload.write(type);
+    payload.write(it->second);
+    commitRecord(CaptureRecord::DestroyObject);
+    
+    state.ids.erase(it);
+    state.timelines.erase(key);
+    state.allocationSizes.erase(key);
+    state.allocationFlags.erase(key);
+    state.mappings.erase(key);
+}
+
+
+// Takes the mutex itself
+template <typename T>
+static void destroyObject(const VkObjectType type, const T handle)
+{
+    if (handle == VK_NULL_HANDLE || !capture::isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    forgetObject(type, handleKey(handle));
+}
+
+
+static QueueRole roleOf(const VkQueue queue)
+{
+    const auto it = state.queueRoles.find(handleKey(queue));
+    return it == state.queueRoles.end() ? QueueRole::Graphics : it->second;
+}
+
+
+struct CapturedSemaphore
+{
+    uint32_t id;
+    uint64_t value;
+    uint64_t stageMask;
+};
+
+
+// Binary semaphores only order acquire and present, which are not replayed
+static void writeSemaphores(CaptureStream& stream, const std::vector<CapturedSemaphore>& semaphores)
+{
+    stream.write(static_cast<uint32_t>(semaphores.size()));
+    for (const CapturedSemaphore& semaphore : semaphores)
+    {
+        stream.write(semaphore.id);
+        stream.write(semaphore.value);
+        stream.write(semaphore.stageMask);
+    }
+}
+
+
+static void writeCommandBuffer(CaptureStream& stream, const VkCommandBuffer commandBuffer)
+{
+    const std::vector<uint8_t>& bytes = state.commandStreams[handleKey(commandBuffer)].getBytes();
+    stream.writeArray(bytes.data(), static_cast<uint32_t>(bytes.size()));
+}
+
+
+std::string capture::pathFromEnvironment(void)
+{
+    const char* value = std::getenv("VULKAN_COMMAND_CAPTURE");
+    return value == nullptr ? std::string() : std::string(value);
+}
+
+
+void capture::openCapture(const std::string& path, const VkPhysicalDevice physicalDevice)
+{
+    std::lock_guard<std::mutex> lock(state.mutex);
+    
+    state.file.open(path, std::ios::binary | std::ios::trunc);
+    if (!state.file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing!");
+    }
+    
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &state.memoryProperties);
+    
+    CaptureHeader header{};
+    std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    header.version = CAPTURE_VERSION;
+    header.apiVersion = properties.apiVersion;
+    header.driverVersion = properties.driverVersion;
+    std::memcpy(header.deviceName, properties.deviceName, sizeof(header.deviceName));
+    state.file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    state.path = path;
+    state.start = std::chrono::steady_clock::now();
+    state.byteCount = sizeof(header);
+    state.capturing.store(true);
+}
+
+
+void capture::closeCapture(std::ostream& os)
+{
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.capturing.store(false);
+    state.file.close();
+    
+    if (state.file.fail())
+    {
+        throw std::runtime_error("Failed to write " + state.path + "!");
+    }
+    
+    os << "[command capture] " << state.frameCount << " frames, " << state.recordCount << " records, " << state.byteCount / (1024.0 * 1024.0) << " MiB written to " << state.path << std::endl;
+    
+    state.ids.clear();
+    state.timelines.clear();
+    state.allocationSizes.clear();
+    state.allocationFlags.clear();
+    state.mappings.clear();
+    state.swapchainImages.clear();
+    state.poolSets.clear();
+    state.queueRoles.clear();
+    state.commandStreams.clear();
+}
+
+
+bool capture::isCapturing(void)
+{
+    return state.capturing.load(std::memory_order_relaxed);
+}
+
+
+void capture::registerQueue(const VkQueue queue, const QueueRole role)
+{
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.queueRoles.emplace(handleKey(queue), role);
+}
+
+
+void capture::registerSwapchainImages(const VkSwapchainKHR swapChain, const VkSwapchainCreateInfoKHR& createInfo, const std::vector<VkImage>& images)
+{
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    std::vector<uint64_t>& imageKeys = state.swapchainImages[handleKey(swapChain)];
+    for (const VkImage image : images)
+    {
+        imageKeys.push_back(handleKey(image));
+        CaptureStream& payload = beginPayload();
+        payload.write(assignId(image));
+        payload.write(createInfo.imageFormat);
+        payload.write(createInfo.imageExtent);
+        payload.write(createInfo.imageUsage);
+        payload.write(createInfo.imageArrayLayers);
+        commitRecord(CaptureRecord::CreateSwapchainImage);
+    }
+}
+
+
+void capture::endFrame(void)
+{
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - state.start).count();
+    
+    CaptureStream& payload = beginPayload();
+    payload.write(elapsedMs);
+    commitRecord(CaptureRecord::EndFrame);
+    
+    state.frameCount++;
+}
+
+
+CommandCounts capture::takeCommandCounts(void)
+{
+    CommandCounts counts;
+    counts.draws = state.drawCount.exchange(0, std::memory_order_relaxed);
+    counts.dispatches = state.dispatchCount.exchange(0, std::memory_order_relaxed);
+    counts.pipelineBinds = state.pipelineBindCount.exchange(0, std::memory_order_relaxed);
+    return counts;
+}
+
+
+VkResult capture::createBuffer(const VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer)
+{
+    const VkResult result = vkCreateBuffer(device, pCreateInfo, pAllocator, pBuffer);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pBuffer));
+    payload.write(pCreateInfo->flags);
+    payload.write(pCreateInfo->size);
+    payload.write(pCreateInfo->usage);
+    payload.write(pCreateInfo->sharingMode);
+    commitRecord(CaptureRecord::CreateBuffer);
+    
+    return result;
+}
+
+
+VkResult capture::createImage(const VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage)
+{
+    const VkResult result = vkCreateImage(device, pCreateInfo, pAllocator, pImage);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    VkImageCreateInfo createInfo = *pCreateInfo;
+    createInfo.pNext = nullptr;
+    createInfo.queueFamilyIndexCount = 0;
+    createInfo.pQueueFamilyIndices = nullptr;
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pImage));
+    payload.write(createInfo);
+    commitRecord(CaptureRecord::CreateImage);
+    
+    return result;
+}
+
+
+VkResult capture::allocateMemory(const VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory)
+{
+    const VkResult result = vkAllocateMemory(device, pAllocateInfo, pAllocator, pMemory);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    
+    // Memory type indices differ between devices, the replay picks a type with the same properties
+    const VkMemoryPropertyFlags flags = state.memoryProperties.memoryTypes[pAllocateInfo->memoryTypeIndex].propertyFlags;
+    state.allocationSizes[handleKey(*pMemory)] = pAllocateInfo->allocationSize;
+    state.allocationFlags[handleKey(*pMemory)] = flags;
+    
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pMemory));
+    payload.write(pAllocateInfo->allocationSize);
+    payload.write(flags);
+    commitRecord(CaptureRecord::AllocateMemory);
+    
+    return result;
+}
+
+
+VkResult capture::bindBufferMemory(const VkDevice device, const VkBuffer buffer, const VkDeviceMemory memory, const VkDeviceSize memoryOffset)
+{
+    const VkResult result = vkBindBufferMemory(device, buffer, memory, memoryOffset);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(buffer));
+    payload.write(idOf(memory));
+    payload.write(memoryOffset);
+    commitRecord(CaptureRecord::BindBufferMemory);
+    
+    return result;
+}
+
+
+VkResult capture::bindImageMemory(const VkDevice device, const VkImage image, const VkDeviceMemory memory, const VkDeviceSize memoryOffset)
+{
+    const VkResult result = vkBindImageMemory(device, image, memory, memoryOffset);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(image));
+    payload.write(idOf(memory));
+    payload.write(memoryOffset);
+    commitRecord(CaptureRecord::BindImageMemory);
+    
+    return result;
+}
+
+
+VkResult capture::mapMemory(const VkDevice device, const VkDeviceMemory memory, const VkDeviceSize offset, const VkDeviceSize size, const VkMemoryMapFlags flags, void** ppData)
+{
+    const VkResult result = vkMapMemory(device, memory, offset, size, flags, ppData);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    const uint64_t key = handleKey(memory);
+    if (state.ids.count(key) == 0)
+    {
+        return result;
+    }
+    
+    CaptureMapping mapping{};
+    mapping.data = static_cast<const uint8_t*>(*ppData);
+    mapping.offset = offset;
+    mapping.size = size == VK_WHOLE_SIZE ? state.allocationSizes[key] - offset : size;
+    mapping.readback = (state.allocationFlags[key] & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0;
+    mapping.written.push_back({0, mapping.size});
+    state.mappings[key] = std::move(mapping);
+    
+    return result;
+}
+
+
+void capture::unmapMemory(const VkDevice device, const VkDeviceMemory memory)
+{
+    if (isCapturing())
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        const auto it = state.mappings.find(handleKey(memory));
+        if (it != state.mappings.end())
+        {
+            captureMapping(it->first, it->second);
+            state.mappings.erase(it);
+        }
+    }
+    
+    vkUnmapMemory(device, memory);
+}
+
+
+void capture::markWritten(const VkDeviceMemory memory, const VkDeviceSize offset, const VkDeviceSize size)
+{
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    const auto it = state.mappings.find(handleKey(memory));
+    if (it == state.mappings.end())
+    {
+        return;
+    }
+    
+    // Clamped to the mapping, offsets are from the start of the allocation like those of vkFlushMappedMemoryRanges
+    CaptureMapping& mapping = it->second;
+    const VkDeviceSize begin = std::clamp(offset, mapping.offset, mapping.offset + mapping.size) - mapping.offset;
+    const VkDeviceSize end = size == VK_WHOLE_SIZE ? mapping.size : std::min(offset + size - mapping.offset, mapping.size);
+    if (end > begin)
+    {
+        mapping.written.push_back({begin, end - begin});
+    }
+}
+
+
+VkResult capture::createImageView(const VkDevice device, const VkImageViewCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImageView* pView)
+{
+    const VkResult result = vkCreateImageView(device, pCreateInfo, pAllocator, pView);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pView));
+    payload.write(idOf(pCreateInfo->image));
+    payload.write(pCreateInfo->flags);
+    payload.write(pCreateInfo->viewType);
+    payload.write(pCreateInfo->format);
+    payload.write(pCreateInfo->components);
+    payload.write(pCreateInfo->subresourceRange);
+    commitRecord(CaptureRecord::CreateImageView);
+    
+    return result;
+}
+
+
+VkResult capture::createSampler(const VkDevice device, const VkSamplerCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSampler* pSampler)
+{
+    const VkResult result = vkCreateSampler(device, pCreateInfo, pAllocator, pSampler);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    VkSamplerCreateInfo createInfo = *pCreateInfo;
+    createInfo.pNext = nullptr;
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pSampler));
+    payload.write(createInfo);
+    commitRecord(CaptureRecord::CreateSampler);
+    
+    return result;
+}
+
+
+VkResult capture::createRenderPass(const VkDevice device, const VkRenderPassCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkRenderPass* pRenderPass)
+{
+    const VkResult result = vkCreateRenderPass(device, pCreateInfo, pAllocator, pRenderPass);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pRenderPass));
+    payload.write(pCreateInfo->flags);
+    payload.writeArray(pCreateInfo->pAttachments, pCreateInfo->attachmentCount);
+    
+    payload.write(pCreateInfo->subpassCount);
+    for (uint32_t i = 0; i < pCreateInfo->subpassCount; i++)
+    {
+        const VkSubpassDescription& subpass = pCreateInfo->pSubpasses[i];
+        payload.write(subpass.flags);
+        payload.write(subpass.pipelineBindPoint);
+        payload.writeArray(subpass.pInputAttachments, subpass.inputAttachmentCount);
+        payload.writeArray(subpass.pColorAttachments, subpass.colorAttachmentCount);
+        payload.writeArray(subpass.pResolveAttachments, subpass.pResolveAttachments == nullptr ? 0 : subpass.colorAttachmentCount);
+        payload.writeArray(subpass.pDepthStencilAttachment, subpass.pDepthStencilAttachment == nullptr ? 0 : 1);
+        payload.writeArray(subpass.pPreserveAttachments, subpass.preserveAttachmentCount);
+    }
+    
+    payload.writeArray(pCreateInfo->pDependencies, pCreateInfo->dependencyCount);
+    commitRecord(CaptureRecord::CreateRenderPass);
+    
+    return result;
+}
+
+
+VkResult capture::createFramebuffer(const VkDevice device, const VkFramebufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFramebuffer* pFramebuffer)
+{
+    const VkResult result = vkCreateFramebuffer(device, pCreateInfo, pAllocator, pFramebuffer);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pFramebuffer));
+    payload.write(pCreateInfo->flags);
+    payload.write(idOf(pCreateInfo->renderPass));
+    writeIds(payload, pCreateInfo->pAttachments, pCreateInfo->attachmentCount);
+    payload.write(pCreateInfo->width);
+    payload.write(pCreateInfo->height);
+    payload.write(pCreateInfo->layers);
+    commitRecord(CaptureRecord::CreateFramebuffer);
+    
+    return result;
+}
+
+
+VkResult capture::createShaderModule(const VkDevice device, const VkShaderModuleCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkShaderModule* pShaderModule)
+{
+    const VkResult result = vkCreateShaderModule(device, pCreateInfo, pAllocator, pShaderModule);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pShaderModule));
+    payload.writeArray(pCreateInfo->pCode, static_cast<uint32_t>(pCreateInfo->codeSize / sizeof(uint32_t)));
+    commitRecord(CaptureRecord::CreateShaderModule);
+    
+    return result;
+}
+
+
+VkResult capture::createDescriptorSetLayout(const VkDevice device, const VkDescriptorSetLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pSetLayout)
+{
+    const VkResult result = vkCreateDescriptorSetLayout(device, pCreateInfo, pAllocator, pSetLayout);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    // Immutable samplers are not captured
+    std::vector<VkDescriptorSetLayoutBinding> bindings(pCreateInfo->pBindings, pCreateInfo->pBindings + pCreateInfo->bindingCount);
+    for (VkDescriptorSetLayoutBinding& binding : bindings)
+    {
+        binding.pImmutableSamplers = nullptr;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pSetLayout));
+    payload.write(pCreateInfo->flags);
+    payload.writeArray(bindings.data(), static_cast<uint32_t>(bindings.size()));
+    commitRecord(CaptureRecord::CreateDescriptorSetLayout);
+    
+    return result;
+}
+
+
+VkResult capture::createPipelineLayout(const VkDevice device, const VkPipelineLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineLayout* pPipelineLayout)
+{
+    const VkResult result = vkCreatePipelineLayout(device, pCreateInfo, pAllocator, pPipelineLayout);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pPipelineLayout));
+    payload.write(pCreateInfo->flags);
+    writeIds(payload, pCreateInfo->pSetLayouts, pCreateInfo->setLayoutCount);
+    payload.writeArray(pCreateInfo->pPushConstantRanges, pCreateInfo->pushConstantRangeCount);
+    commitRecord(CaptureRecord::CreatePipelineLayout);
+    
+    return result;
+}
+
+
+static void writeShaderStage(CaptureStream& stream, const VkPipelineShaderStageCreateInfo& stage)
+{
+    stream.write(stage.flags);
+    stream.write(stage.stage);
+    stream.write(idOf(stage.module));
+    stream.writeString(stage.pName);
+    
+    const VkSpecializationInfo* specialization = stage.pSpecializationInfo;
+    stream.writeArray(specialization == nullptr ? nullptr : specialization->pMapEntries, specialization == nullptr ? 0 : specialization->mapEntryCount);
+    stream.writeArray(specialization == nullptr ? nullptr : static_cast<const uint8_t*>(specialization->pData), specialization == nullptr ? 0 : static_cast<uint32_t>(specialization->dataSize));
+}
+
+
+// Optional state structs are written as a count of 0 or 1 followed by the struct with its pointers cleared
+template <typename T>
+static void writeState(CaptureStream& stream, const T* pState)
+{
+    if (pState == nullptr)
+    {
+        stream.write(0u);
+        return;
+    }
+    
+    T copy = *pState;
+    copy.pNext = nullptr;
+    stream.write(1u);
+    stream.write(copy);
+}
+
+
+static void writeGraphicsPipeline(CaptureStream& stream, const VkGraphicsPipelineCreateInfo& createInfo)
+{
+    stream.write(createInfo.flags);
+    stream.write(createInfo.stageCount);
+    for (uint32_t i = 0; i < createInfo.stageCount; i++)
+    {
+        writeShaderStage(stream, createInfo.pStages[i]);
+    }
+    
+    const VkPipelineVertexInputStateCreateInfo* vertexInput = createInfo.pVertexInputState;
+    stream.writeArray(vertexInput == nullptr ? nullptr : vertexInput->pVertexBindingDescriptions, vertexInput == nullptr ? 0 : vertexInput->vertexBindingDescriptionCount);
+    stream.writeArray(vertexInput == nullptr ? nullptr : vertexInput->pVertexAttributeDescriptions, vertexInput == nullptr ? 0 : vertexInput->vertexAttributeDescriptionCount);
+    
+    writeState(stream, createInfo.pInputAssemblyState);
+    writeState(stream, createInfo.pTessellationState);
+    
+    const VkPipelineViewportStateCreateInfo* viewport = createInfo.pViewportState;
+    stream.write(viewport == nullptr ? 0u : viewport->viewportCount);
+    stream.write(viewport == nullptr ? 0u : viewport->scissorCount);
+    stream.writeArray(viewport == nullptr ? nullptr : viewport->pViewports, viewport == nullptr || viewport->pViewports == nullptr ? 0 : viewport->viewportCount);
+    stream.writeArray(viewport == nullptr ? nullptr : viewport->pScissors, viewport == nullptr || viewport->pScissors == nullptr ? 0 : viewport->scissorCount);
+    
+    writeState(stream, createInfo.pRasterizationState);
+    
+    // Sample masks are not captured
+    VkPipelineMultisampleStateCreateInfo multisample{};
+    if (createInfo.pMultisampleState != nullptr)
+    {
+        multisample = *createInfo.pMultisampleState;
+        multisample.pSampleMask = nullptr;
+    }
+    writeState(stream, createInfo.pMultisampleState == nullptr ? nullptr : &multisample);
+    writeState(stream, createInfo.pDepthStencilState);
+    
+    const VkPipelineColorBlendStateCreateInfo* colorBlend = createInfo.pColorBlendState;
+    VkPipelineColorBlendStateCreateInfo colorBlendCopy{};
+    if (colorBlend != nullptr)
+    {
+        colorBlendCopy = *colorBlend;
+        colorBlendCopy.attachmentCount = 0;
+        colorBlendCopy.pAttachments = nullptr;
+    }
+    writeState(stream, colorBlend == nullptr ? nullptr : &colorBlendCopy);
+    stream.writeArray(colorBlend == nullptr ? nullptr : colorBlend->pAttachments, colorBlend == nullptr ? 0 : colorBlend->attachmentCount);
+    
+    const VkPipelineDynamicStateCreateInfo* dynamic = createInfo.pDynamicState;
+    stream.writeArray(dynamic == nullptr ? nullptr : dynamic->pDynamicStates, dynamic == nullptr ? 0 : dynamic->dynamicStateCount);
+    
+    stream.write(idOf(createInfo.layout));
+    stream.write(idOf(createInfo.renderPass));
+    stream.write(createInfo.subpass);
+    
+    // Library parts and the pipelines linked from them, the only extensions to the create info that are kept
+    const VkGraphicsPipelineLibraryCreateInfoEXT* libraryInfo = static_cast<const VkGraphicsPipelineLibraryCreateInfoEXT*>(findInChain(createInfo.pNext, VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT));
+    stream.write(libraryInfo == nullptr ? VkGraphicsPipelineLibraryFlagsEXT{0} : libraryInfo->flags);
+    const VkPipelineLibraryCreateInfoKHR* linkInfo = static_cast<const VkPipelineLibraryCreateInfoKHR*>(findInChain(createInfo.pNext, VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR));
+    writeIds(stream, linkInfo == nullptr ? nullptr : linkInfo->pLibraries, linkInfo == nullptr ? 0 : linkInfo->libraryCount);
+}
+
+
+VkResult capture::createGraphicsPipelines(const VkDevice device, const VkPipelineCache pipelineCache, const uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+    const VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (uint32_t i = 0; i < createInfoCount; i++)
+    {
+        CaptureStream& payload = beginPayload();
+        payload.write(assignId(pPipelines[i]));
+        writeGraphicsPipeline(payload, pCreateInfos[i]);
+        commitRecord(CaptureRecord::CreateGraphicsPipeline);
+    }
+    
+    return result;
+}
+
+
+VkResult capture::createComputePipelines(const VkDevice device, const VkPipelineCache pipelineCache, const uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+    const VkResult result = vkCreateComputePipelines(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (uint32_t i = 0; i < createInfoCount; i++)
+    {
+        CaptureStream& payload = beginPayload();
+        payload.write(assignId(pPipelines[i]));
+        payload.write(pCreateInfos[i].flags);
+        writeShaderStage(payload, pCreateInfos[i].stage);
+        payload.write(idOf(pCreateInfos[i].layout));
+        commitRecord(CaptureRecord::CreateComputePipeline);
+    }
+    
+    return result;
+}
+
+
+VkResult capture::createDescriptorPool(const VkDevice device, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorPool* pDescriptorPool)
+{
+    const VkResult result = vkCreateDescriptorPool(device, pCreateInfo, pAllocator, pDescriptorPool);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pDescriptorPool));
+    payload.write(pCreateInfo->flags);
+    payload.write(pCreateInfo->maxSets);
+    payload.writeArray(pCreateInfo->pPoolSizes, pCreateInfo->poolSizeCount);
+    commitRecord(CaptureRecord::CreateDescriptorPool);
+    
+    return result;
+}
+
+
+VkResult capture::allocateDescriptorSets(const VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets)
+{
+    const VkResult result = vkAllocateDescriptorSets(device, pAllocateInfo, pDescriptorSets);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(pAllocateInfo->descriptorPool));
+    writeIds(payload, pAllocateInfo->pSetLayouts, pAllocateInfo->descriptorSetCount);
+    std::vector<uint64_t>& setKeys = state.poolSets[handleKey(pAllocateInfo->descriptorPool)];
+    for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++)
+    {
+        payload.write(assignId(pDescriptorSets[i]));
+        setKeys.push_back(handleKey(pDescriptorSets[i]));
+    }
+    commitRecord(CaptureRecord::AllocateDescriptorSets);
+    
+    return result;
+}
+
+
+void capture::updateDescriptorSets(const VkDevice device, const uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, const uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies)
+{
+    vkUpdateDescriptorSets(device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(descriptorWriteCount);
+    for (uint32_t i = 0; i < descriptorWriteCount; i++)
+    {
+        const VkWriteDescriptorSet& write = pDescriptorWrites[i];
+        payload.write(idOf(write.dstSet));
+        payload.write(write.dstBinding);
+        payload.write(write.dstArrayElement);
+        payload.write(write.descriptorType);
+        
+        // Texel buffer views are not captured, their writes keep only the count
+        const uint32_t imageCount = write.pImageInfo == nullptr ? 0 : write.descriptorCount;
+        payload.write(imageCount);
+        for (uint32_t k = 0; k < imageCount; k++)
+        {
+            payload.write(idOf(write.pImageInfo[k].sampler));
+            payload.write(idOf(write.pImageInfo[k].imageView));
+            payload.write(write.pImageInfo[k].imageLayout);
+        }
+        
+        const uint32_t bufferCount = write.pBufferInfo == nullptr ? 0 : write.descriptorCount;
+        payload.write(bufferCount);
+        for (uint32_t k = 0; k < bufferCount; k++)
+        {
+            payload.write(idOf(write.pBufferInfo[k].buffer));
+            payload.write(write.pBufferInfo[k].offset);
+            payload.write(write.pBufferInfo[k].range);
+        }
+    }
+    commitRecord(CaptureRecord::UpdateDescriptorSets);
+}
+
+
+VkResult capture::createQueryPool(const VkDevice device, const VkQueryPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkQueryPool* pQueryPool)
+{
+    const VkResult result = vkCreateQueryPool(device, pCreateInfo, pAllocator, pQueryPool);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    VkQueryPoolCreateInfo createInfo = *pCreateInfo;
+    createInfo.pNext = nullptr;
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pQueryPool));
+    payload.write(createInfo);
+    commitRecord(CaptureRecord::CreateQueryPool);
+    
+    return result;
+}
+
+
+VkResult capture::createSemaphore(const VkDevice device, const VkSemaphoreCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSemaphore* pSemaphore)
+{
+    const VkResult result = vkCreateSemaphore(device, pCreateInfo, pAllocator, pSemaphore);
+    if (result != VK_SUCCESS || !isCapturing())
+    {
+        return result;
+    }
+    
+    const VkSemaphoreTypeCreateInfoKHR* typeInfo = static_cast<const VkSemaphoreTypeCreateInfoKHR*>(findInChain(pCreateInfo->pNext, VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR));
+    if (typeInfo == nullptr || typeInfo->semaphoreType != VK_SEMAPHORE_TYPE_TIMELINE_KHR)
+    {
+        return result;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.timelines.insert(handleKey(*pSemaphore));
+    
+    CaptureStream& payload = beginPayload();
+    payload.write(assignId(*pSemaphore));
+    payload.write(typeInfo->initialValue);
+    commitRecord(CaptureRecord::CreateSemaphore);
+    
+    return result;
+}
+
+
+void capture::destroyBuffer(const VkDevice device, const VkBuffer buffer, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_BUFFER, buffer);
+    vkDestroyBuffer(device, buffer, pAllocator);
+}
+
+
+void capture::destroyImage(const VkDevice device, const VkImage image, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_IMAGE, image);
+    vkDestroyImage(device, image, pAllocator);
+}
+
+
+void capture::freeMemory(const VkDevice device, const VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_DEVICE_MEMORY, memory);
+    vkFreeMemory(device, memory, pAllocator);
+}
+
+
+void capture::destroyImageView(const VkDevice device, const VkImageView imageView, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_IMAGE_VIEW, imageView);
+    vkDestroyImageView(device, imageView, pAllocator);
+}
+
+
+void capture::destroySampler(const VkDevice device, const VkSampler sampler, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_SAMPLER, sampler);
+    vkDestroySampler(device, sampler, pAllocator);
+}
+
+
+void capture::destroyRenderPass(const VkDevice device, const VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_RENDER_PASS, renderPass);
+    vkDestroyRenderPass(device, renderPass, pAllocator);
+}
+
+
+void capture::destroyFramebuffer(const VkDevice device, const VkFramebuffer framebuffer, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_FRAMEBUFFER, framebuffer);
+    vkDestroyFramebuffer(device, framebuffer, pAllocator);
+}
+
+
+void capture::destroyShaderModule(const VkDevice device, const VkShaderModule shaderModule, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_SHADER_MODULE, shaderModule);
+    vkDestroyShaderModule(device, shaderModule, pAllocator);
+}
+
+
+void capture::destroyDescriptorSetLayout(const VkDevice device, const VkDescriptorSetLayout setLayout, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, setLayout);
+    vkDestroyDescriptorSetLayout(device, setLayout, pAllocator);
+}
+
+
+void capture::destroyPipelineLayout(const VkDevice device, const VkPipelineLayout pipelineLayout, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipelineLayout);
+    vkDestroyPipelineLayout(device, pipelineLayout, pAllocator);
+}
+
+
+void capture::destroyPipeline(const VkDevice device, const VkPipeline pipeline, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_PIPELINE, pipeline);
+    vkDestroyPipeline(device, pipeline, pAllocator);
+}
+
+
+void capture::destroyDescriptorPool(const VkDevice device, const VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator)
+{
+    if (descriptorPool != VK_NULL_HANDLE && isCapturing())
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        // The sets are freed by the replay along with their pool
+        const auto it = state.poolSets.find(handleKey(descriptorPool));
+        if (it != state.poolSets.end())
+        {
+            for (const uint64_t set : it->second)
+            {
+                state.ids.erase(set);
+            }
+            state.poolSets.erase(it);
+        }
+        forgetObject(VK_OBJECT_TYPE_DESCRIPTOR_POOL, handleKey(descriptorPool));
+    }
+    
+    vkDestroyDescriptorPool(device, descriptorPool, pAllocator);
+}
+
+
+void capture::destroyQueryPool(const VkDevice device, const VkQueryPool queryPool, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_QUERY_POOL, queryPool);
+    vkDestroyQueryPool(device, queryPool, pAllocator);
+}
+
+
+void capture::destroySemaphore(const VkDevice device, const VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator)
+{
+    destroyObject(VK_OBJECT_TYPE_SEMAPHORE, semaphore);
+    vkDestroySemaphore(device, semaphore, pAllocator);
+}
+
+
+void capture::destroySwapchain(const VkDevice device, const VkSwapchainKHR swapChain, const VkAllocationCallbacks* pAllocator)
+{
+    if (swapChain != VK_NULL_HANDLE && isCapturing())
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        const auto it = state.swapchainImages.find(handleKey(swapChain));
+        if (it != state.swapchainImages.end())
+        {
+            // The replay's stand-ins are destroyed one by one
+            for (const uint64_t image : it->second)
+            {
+                forgetObject(VK_OBJECT_TYPE_IMAGE, image);
+            }
+            state.swapchainImages.erase(it);
+        }
+    }
+    
+    vkDestroySwapchainKHR(device, swapChain, pAllocator);
+}
+
+
+VkResult capture::beginCommandBuffer(const VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* pBeginInfo)
+{
+    if (isCapturing())
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.commandStreams[handleKey(commandBuffer)].clear();
+    }
+    
+    return vkBeginCommandBuffer(commandBuffer, pBeginInfo);
+}
+
+
+void capture::cmdBeginRenderPass(const VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo* pRenderPassBegin, const VkSubpassContents contents)
+{
+    vkCmdBeginRenderPass(commandBuffer, pRenderPassBegin, contents);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(pRenderPassBegin->renderPass));
+    payload.write(idOf(pRenderPassBegin->framebuffer));
+    payload.write(pRenderPassBegin->renderArea);
+    payload.writeArray(pRenderPassBegin->pClearValues, pRenderPassBegin->clearValueCount);
+    payload.write(contents);
+    appendCommand(commandBuffer, CaptureCommand::BeginRenderPass);
+}
+
+
+void capture::cmdEndRenderPass(const VkCommandBuffer commandBuffer)
+{
+    vkCmdEndRenderPass(commandBuffer);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    beginPayload();
+    appendCommand(commandBuffer, CaptureCommand::EndRenderPass);
+}
+
+
+void capture::cmdBindPipeline(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint pipelineBindPoint, const VkPipeline pipeline)
+{
+    vkCmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
+    state.pipelineBindCount.fetch_add(1, std::memory_order_relaxed);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(pipelineBindPoint);
+    payload.write(idOf(pipeline));
+    appendCommand(commandBuffer, CaptureCommand::BindPipeline);
+}
+
+
+void capture::cmdBindDescriptorSets(const VkCommandBuffer commandBuffer, const VkPipelineBindPoint pipelineBindPoint, const VkPipelineLayout layout, const uint32_t firstSet, const uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, const uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets)
+{
+    vkCmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(pipelineBindPoint);
+    payload.write(idOf(layout));
+    payload.write(firstSet);
+    writeIds(payload, pDescriptorSets, descriptorSetCount);
+    payload.writeArray(pDynamicOffsets, dynamicOffsetCount);
+    appendCommand(commandBuffer, CaptureCommand::BindDescriptorSets);
+}
+
+
+void capture::cmdPushConstants(const VkCommandBuffer commandBuffer, const VkPipelineLayout layout, const VkShaderStageFlags stageFlags, const uint32_t offset, const uint32_t size, const void* pValues)
+{
+    vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, pValues);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(layout));
+    payload.write(stageFlags);
+    payload.write(offset);
+    payload.writeArray(static_cast<const uint8_t*>(pValues), size);
+    appendCommand(commandBuffer, CaptureCommand::PushConstants);
+}
+
+
+void capture::cmdSetViewport(const VkCommandBuffer commandBuffer, const uint32_t firstViewport, const uint32_t viewportCount, const VkViewport* pViewports)
+{
+    vkCmdSetViewport(commandBuffer, firstViewport, viewportCount, pViewports);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(firstViewport);
+    payload.writeArray(pViewports, viewportCount);
+    appendCommand(commandBuffer, CaptureCommand::SetViewport);
+}
+
+
+void capture::cmdSetScissor(const VkCommandBuffer commandBuffer, const uint32_t firstScissor, const uint32_t scissorCount, const VkRect2D* pScissors)
+{
+    vkCmdSetScissor(commandBuffer, firstScissor, scissorCount, pScissors);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(firstScissor);
+    payload.writeArray(pScissors, scissorCount);
+    appendCommand(commandBuffer, CaptureCommand::SetScissor);
+}
+
+
+void capture::cmdBindVertexBuffers(const VkCommandBuffer commandBuffer, const uint32_t firstBinding, const uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets)
+{
+    vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(firstBinding);
+    writeIds(payload, pBuffers, bindingCount);
+    payload.writeArray(pOffsets, bindingCount);
+    appendCommand(commandBuffer, CaptureCommand::BindVertexBuffers);
+}
+
+
+void capture::cmdBindIndexBuffer(const VkCommandBuffer commandBuffer, const VkBuffer buffer, const VkDeviceSize offset, const VkIndexType indexType)
+{
+    vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(buffer));
+    payload.write(offset);
+    payload.write(indexType);
+    appendCommand(commandBuffer, CaptureCommand::BindIndexBuffer);
+}
+
+
+void capture::cmdDraw(const VkCommandBuffer commandBuffer, const uint32_t vertexCount, const uint32_t instanceCount, const uint32_t firstVertex, const uint32_t firstInstance)
+{
+    vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    state.drawCount.fetch_add(1, std::memory_order_relaxed);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(vertexCount);
+    payload.write(instanceCount);
+    payload.write(firstVertex);
+    payload.write(firstInstance);
+    appendCommand(commandBuffer, CaptureCommand::Draw);
+}
+
+
+void capture::cmdDrawIndexed(const VkCommandBuffer commandBuffer, const uint32_t indexCount, const uint32_t instanceCount, const uint32_t firstIndex, const int32_t vertexOffset, const uint32_t firstInstance)
+{
+    vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    state.drawCount.fetch_add(1, std::memory_order_relaxed);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(indexCount);
+    payload.write(instanceCount);
+    payload.write(firstIndex);
+    payload.write(vertexOffset);
+    payload.write(firstInstance);
+    appendCommand(commandBuffer, CaptureCommand::DrawIndexed);
+}
+
+
+void capture::cmdDispatch(const VkCommandBuffer commandBuffer, const uint32_t groupCountX, const uint32_t groupCountY, const uint32_t groupCountZ)
+{
+    vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+    state.dispatchCount.fetch_add(1, std::memory_order_relaxed);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(groupCountX);
+    payload.write(groupCountY);
+    payload.write(groupCountZ);
+    appendCommand(commandBuffer, CaptureCommand::Dispatch);
+}
+
+
+void capture::cmdPipelineBarrier(const VkCommandBuffer commandBuffer, const VkPipelineStageFlags srcStageMask, const VkPipelineStageFlags dstStageMask, const VkDependencyFlags dependencyFlags, const uint32_t memoryBarrierCount, const VkMemoryBarrier* pMemoryBarriers, const uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers, const uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers)
+{
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(srcStageMask);
+    payload.write(dstStageMask);
+    payload.write(dependencyFlags);
+    
+    payload.write(memoryBarrierCount);
+    for (uint32_t i = 0; i < memoryBarrierCount; i++)
+    {
+        payload.write(pMemoryBarriers[i].srcAccessMask);
+        payload.write(pMemoryBarriers[i].dstAccessMask);
+    }
+    
+    payload.write(bufferMemoryBarrierCount);
+    for (uint32_t i = 0; i < bufferMemoryBarrierCount; i++)
+    {
+        const VkBufferMemoryBarrier& barrier = pBufferMemoryBarriers[i];
+        payload.write(barrier.srcAccessMask);
+        payload.write(barrier.dstAccessMask);
+        payload.write(idOf(barrier.buffer));
+        payload.write(barrier.offset);
+        payload.write(barrier.size);
+    }
+    
+    // Queue family indices are dropped, the replay does not transfer ownership
+    payload.write(imageMemoryBarrierCount);
+    for (uint32_t i = 0; i < imageMemoryBarrierCount; i++)
+    {
+        const VkImageMemoryBarrier& barrier = pImageMemoryBarriers[i];
+        payload.write(barrier.srcAccessMask);
+        payload.write(barrier.dstAccessMask);
+        payload.write(barrier.oldLayout);
+        payload.write(barrier.newLayout);
+        payload.write(idOf(barrier.image));
+        payload.write(barrier.subresourceRange);
+    }
+    appendCommand(commandBuffer, CaptureCommand::PipelineBarrier);
+}
+
+
+void capture::cmdCopyBuffer(const VkCommandBuffer commandBuffer, const VkBuffer srcBuffer, const VkBuffer dstBuffer, const uint32_t regionCount, const VkBufferCopy* pRegions)
+{
+    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(srcBuffer));
+    payload.write(idOf(dstBuffer));
+    payload.writeArray(pRegions, regionCount);
+    appendCommand(commandBuffer, CaptureCommand::CopyBuffer);
+}
+
+
+void capture::cmdCopyImage(const VkCommandBuffer commandBuffer, const VkImage srcImage, const VkImageLayout srcImageLayout, const VkImage dstImage, const VkImageLayout dstImageLayout, const uint32_t regionCount, const VkImageCopy* pRegions)
+{
+    vkCmdCopyImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(srcImage));
+    payload.write(srcImageLayout);
+    payload.write(idOf(dstImage));
+    payload.write(dstImageLayout);
+    payload.writeArray(pRegions, regionCount);
+    appendCommand(commandBuffer, CaptureCommand::CopyImage);
+}
+
+
+void capture::cmdCopyImageToBuffer(const VkCommandBuffer commandBuffer, const VkImage srcImage, const VkImageLayout srcImageLayout, const VkBuffer dstBuffer, const uint32_t regionCount, const VkBufferImageCopy* pRegions)
+{
+    vkCmdCopyImageToBuffer(commandBuffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(srcImage));
+    payload.write(srcImageLayout);
+    payload.write(idOf(dstBuffer));
+    payload.writeArray(pRegions, regionCount);
+    appendCommand(commandBuffer, CaptureCommand::CopyImageToBuffer);
+}
+
+
+void capture::cmdWriteTimestamp(const VkCommandBuffer commandBuffer, const VkPipelineStageFlagBits pipelineStage, const VkQueryPool queryPool, const uint32_t query)
+{
+    vkCmdWriteTimestamp(commandBuffer, pipelineStage, queryPool, query);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(pipelineStage);
+    payload.write(idOf(queryPool));
+    payload.write(query);
+    appendCommand(commandBuffer, CaptureCommand::WriteTimestamp);
+}
+
+
+void capture::cmdResetQueryPool(const VkCommandBuffer commandBuffer, const VkQueryPool queryPool, const uint32_t firstQuery, const uint32_t queryCount)
+{
+    vkCmdResetQueryPool(commandBuffer, queryPool, firstQuery, queryCount);
+    if (!isCapturing())
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CaptureStream& payload = beginPayload();
+    payload.write(idOf(queryPool));
+    payload.write(firstQuery);
+    payload.write(queryCount);
+    appendCommand(commandBuffer, CaptureCommand::ResetQueryPool);
+}
+
+
+VkResult capture::queueSubmit(const VkQueue queue, const uint32_t submitCount, const VkSubmitInfo* pSubmits, const VkFence fence)
+{
+    if (isCapturing())
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        captureMappings();
+        
+        CaptureStream& payload = beginPayload();
+        payload.write(roleOf(queue));
+        payload.write(submitCount);
+        for (uint32_t i = 0; i < submitCount; i++)
+        {
+            const VkSubmitInfo& submit = pSubmits[i];
+            const VkTimelineSemaphoreSubmitInfoKHR* timelineInfo = static_cast<const VkTimelineSemaphoreSubmitInfoKHR*>(findInChain(submit.pNext, VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR));
+            
+            std::vector<CapturedSemaphore> waits;
+            for (uint32_t k = 0; k < submit.waitSemaphoreCount; k++)
+            {
+                if (state.timelines.count(handleKey(submit.pWaitSemaphores[k])) != 0)
+                {
+                    const uint64_t value = timelineInfo != nullptr && k < timelineInfo->waitSemaphoreValueCount ? timelineInfo->pWaitSemaphoreValues[k] : 0;
+                    waits.push_back({idOf(submit.pWaitSemaphores[k]), value, submit.pWaitDstStageMask[k]});
+                }
+            }
+            writeSemaphores(payload, waits);
+            
+            payload.write(submit.commandBufferCount);
+            for (uint32_t k = 0; k < submit.commandBufferCount; k++)
+            {
+                writeCommandBuffer(payload, submit.pCommandBuffers[k]);
+            }
+            
+            std::vector<CapturedSemaphore> signals;
+            for (uint32_t k = 0; k < submit.signalSemaphoreCount; k++)
+            {
+                if (state.timelines.count(handleKey(submit.pSignalSemaphores[k])) != 0)
+                {
+                    const uint64_t value = timelineInfo != nullptr && k < timelineInfo->signalSemaphoreValueCount ? timelineInfo->pSignalSemaphoreValues[k] : 0;
+                    signals.push_back({idOf(submit.pSignalSemaphores[k]), value, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT});
+                }
+            }
+            writeSemaphores(payload, signals);
+        }
+        commitRecord(CaptureRecord::Submit);
+    }
+    
+    return vkQueueSubmit(queue, submitCount, pSubmits, fence);
+}
+
+
+static void collectSemaphores(std::vector<CapturedSemaphore>& semaphores, const VkSemaphoreSubmitInfoKHR* pInfos, const uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (state.timelines.count(handleKey(pInfos[i].semaphore)) != 0)
+        {
+            semaphores.push_back({idOf(pInfos[i].semaphore), pInfos[i].value, pInfos[i].stageMask});
+        }
+    }
+}
+
+
+VkResult capture::queueSubmit2(const PFN_vkQueueSubmit2KHR pfnQueueSubmit2, const VkQueue queue, const uint32_t submitCount, const VkSubmitInfo2KHR* pSubmits, const VkFence fence)
+{
+    if (isCapturing())
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        captureMappings();
+        
+        CaptureStream& payload = beginPayload();
+        payload.write(roleOf(queue));
+        payload.write(submitCount);
+        for (uint32_t i = 0; i < submitCount; i++)
+        {
+            const VkSubmitInfo2KHR& submit = pSubmits[i];
+            
+            std::vector<CapturedSemaphore> waits;
+            collectSemaphores(waits, submit.pWaitSemaphoreInfos, submit.waitSemaphoreInfoCount);
+            writeSemaphores(payload, waits);
+            
+            payload.write(submit.commandBufferInfoCount);
+            for (uint32_t k = 0; k < submit.commandBufferInfoCount; k++)
+            {
+                writeCommandBuffer(payload, submit.pCommandBufferInfos[k].commandBuffer);
+            }
+            
+            std::vector<CapturedSemaphore> signals;
+            collectSemaphores(signals, submit.pSignalSemaphoreInfos, submit.signalSemaphoreInfoCount);
+            writeSemaphores(payload, signals);
+        }
+        commitRecord(CaptureRecord::Submit);
+    }
+    
+    return pfnQueueSubmit2(queue, submitCount, pSubmits, fence);
+}
+
+
+VkResult capture::queueWaitIdle(const VkQueue queue)
+{
+    if (isCapturing())
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        CaptureStream& payload = beginPayload();
+        payload.write(roleOf(queue));
+        commitRecord(CaptureRecord::QueueWaitIdle);
+    }
+    
+    return vkQueueWaitIdle(queue);
+}
@@ -0,0 +1,93 @@
+#include "CommandPool.hpp"
+#include "CommandCapture.hpp"
+
+
+void CommandPool::setupCommandPool(const VkDevice device, const uint32_t queueFamilyIndex, const VkAllocationCallbacks* pAllocator)
+{
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    if (vkCreateCommandPool(device, &poolInfo, pAllocator, &commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create command pool!");
+    }
+}
+
+
+void CommandPool::setupCommandBuffers(const VkDevice device, const uint32_t count)
+{
+    commandBuffers.resize(count);
+    
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = count;
+    
+    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate command buffers!");
+    }
+}
+
+
+void CommandPool::destroyCommandPool(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    if (commandPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(device, commandPool, pAllocator);
+    }
+}
+
+
+VkCommandBuffer CommandPool::beginSingleTimeCommands(const VkDevice device)
+{
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool;
+    allocInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate command buffers!");
+    }
+    
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    capture::beginCommandBuffer(commandBuffer, &beginInfo);
+    
+    return commandBuffer;
+}
+
+
+void CommandPool::endSingleTimeCommands(const VkDevice device, const VkQueue queue, VkCommandBuffer commandBuffer)
+{
+    vkEndCommandBuffer(commandBuffer);
+    
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    
+    capture::queueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+    capture::queueWaitIdle(queue);
+    
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+}
+
+
+const VkCommandPool CommandPool::getCommandPool(void) const
+{
+    return commandPool;
+}
+
+
+const VkCommandBuffer CommandPool::getCommandBuffer(const uint32_t idx) const
+{
+    return commandBuffers[idx];
+}
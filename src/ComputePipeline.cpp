@@ -0,0 +1,67 @@
+#include "ComputePipeline.hpp"
+#include "CommandCapture.hpp"
+
+
+void ComputePipeline::setShaderVariant(const ShaderVariant& variant)
+{
+    this->variant = variant;
+}
+
+
+void ComputePipeline::populateShaderStageCreateInfo(VkPipelineShaderStageCreateInfo& shaderStageInfo, VkSpecializationInfo& specializationInfo, const VkShaderModule shaderModule)
+{
+    variant.populateSpecializationInfo(specializationInfo);
+    
+    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageInfo.module = shaderModule;
+    shaderStageInfo.pName = "main";
+    shaderStageInfo.pSpecializationInfo = variant.empty() ? nullptr : &specializationInfo;
+}
+
+
+void ComputePipeline::setupComputePipeline(const VkDevice device, const ByteView shaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache, const VkAllocationCallbacks* pAllocator)
+{
+    VkShaderModule compShaderModule = Pipeline::createShaderModule(device, shaderCode);
+    
+    VkPipelineShaderStageCreateInfo compShaderStageInfo{};
+    VkSpecializationInfo specializationInfo{};
+    populateShaderStageCreateInfo(compShaderStageInfo, specializationInfo, compShaderModule);
+    
+    computePipelineLayout = layoutCache.getPipelineLayout(VK_PIPELINE_BIND_POINT_COMPUTE, spirv::reflectShader(shaderCode));
+    
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = compShaderStageInfo;
+    pipelineInfo.layout = computePipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex = -1; // Optional
+    
+    if (capture::createComputePipelines(device, pipelineCache, 1, &pipelineInfo, pAllocator, &computePipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create compute pipeline!");
+    }
+    
+    capture::destroyShaderModule(device, compShaderModule, nullptr);
+}
+
+
+void ComputePipeline::destroyComputePipeline(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    if (computePipeline != VK_NULL_HANDLE)
+    {
+        capture::destroyPipeline(device, computePipeline, pAllocator);
+    }
+}
+
+
+const VkPipeline ComputePipeline::getPipeline(void) const
+{
+    return computePipeline;
+}
+
+
+const VkPipelineLayout ComputePipeline::getPipelineLayout(void) const
+{
+    return computePipelineLayout;
+}
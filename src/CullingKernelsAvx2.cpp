@@ -0,0 +1,57 @@
+#include "FrustumCuller.hpp"
+
+#if defined(SIMD_X86)
+
+#include <immintrin.h>
+
+// Built for AVX2 only, like TransformKernelsAvx2.cpp, and called once the CPU check passed
+#if defined(__clang__)
+    #pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+    #pragma GCC push_options
+    #pragma GCC target("avx2")
+#endif
+
+
+// All eight boxes of a node per plane. Multiply and add stay separate to match the other kernels
+uint32_t cullBoxesAvx2(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask)
+{
+    __m256 box[6];
+    for (int i = 0; i < 6; i++)
+    {
+        box[i] = _mm256_loadu_ps(bounds[i]);
+    }
+    
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 outside = zero;
+    __m256 intersects = zero;
+    
+    for (const auto& plane : frustum.planes)
+    {
+        const __m256 a = _mm256_set1_ps(plane[0]);
+        const __m256 b = _mm256_set1_ps(plane[1]);
+        const __m256 c = _mm256_set1_ps(plane[2]);
+        const __m256 d = _mm256_set1_ps(plane[3]);
+        
+        const __m256 px = box[plane[0] >= 0.0f ? 3 : 0], nx = box[plane[0] >= 0.0f ? 0 : 3];
+        const __m256 py = box[plane[1] >= 0.0f ? 4 : 1], ny = box[plane[1] >= 0.0f ? 1 : 4];
+        const __m256 pz = box[plane[2] >= 0.0f ? 5 : 2], nz = box[plane[2] >= 0.0f ? 2 : 5];
+        
+        const __m256 positive = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, px), _mm256_mul_ps(b, py)), _mm256_mul_ps(c, pz)), d);
+        const __m256 negative = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, nx), _mm256_mul_ps(b, ny)), _mm256_mul_ps(c, nz)), d);
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(positive, zero, _CMP_LT_OQ));
+        intersects = _mm256_or_ps(intersects, _mm256_cmp_ps(negative, zero, _CMP_LT_OQ));
+    }
+    
+    const uint32_t visibleMask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFFu;
+    insideMask = visibleMask & ~static_cast<uint32_t>(_mm256_movemask_ps(intersects));
+    return visibleMask;
+}
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#else
+    #pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,303 @@
+#include "DebugLog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+
+namespace
+{
+    const char* severityName(const VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+    {
+        switch (severity)
+        {
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT: return "VERBOSE";
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT: return "INFO";
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: return "WARNING";
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: return "ERROR";
+            default: return "UNKNOWN";
+        }
+    }
+    
+    
+    const char* typeName(const VkDebugUtilsMessageTypeFlagsEXT type)
+    {
+        if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) return "performance";
+        if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) return "validation";
+        
+        return "general";
+    }
+    
+    
+    void copyTruncated(char* dst, const char* src, const size_t size)
+    {
+        if (src == nullptr)
+        {
+            dst[0] = '\0';
+            return;
+        }
+        
+        std::strncpy(dst, src, size - 1);
+        dst[size - 1] = '\0';
+    }
+}
+
+
+void DebugLog::setupLog(std::ostream& os)
+{
+    this->os = &os;
+    
+    slots = std::make_unique<Slot[]>(RING_SIZE);
+    for (size_t i = 0; i < RING_SIZE; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    
+    running.store(true);
+    writer = std::thread(&DebugLog::writerLoop, this);
+}
+
+
+void DebugLog::destroyLog(void)
+{
+    if (!writer.joinable())
+    {
+        return;
+    }
+    
+    running.store(false);
+    wake.notify_one();
+    writer.join();
+}
+
+
+void DebugLog::push(const VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData)
+{
+    received.fetch_add(1, std::memory_order_relaxed);
+    
+    // Performance messages always reach the writer so they are counted even when not printed
+    const bool isPerformance = (type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) != 0;
+    if (isPerformance)
+    {
+        performance.fetch_add(1, std::memory_order_relaxed);
+    } else if (!(severity & severityFilter.load(std::memory_order_relaxed)) || !(type & typeFilter.load(std::memory_order_relaxed)))
+    {
+        filtered.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    // Bounded multi-producer ring, each slot's sequence says whose turn it is
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots[pos % RING_SIZE];
+        const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        
+        if (difference == 0)
+        {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        } else if (difference < 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else
+        {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    
+    slot->severity = severity;
+    slot->type = type;
+    slot->messageId = pCallbackData->messageIdNumber;
+    copyTruncated(slot->idName, pCallbackData->pMessageIdName, ID_NAME_SIZE);
+    copyTruncated(slot->message, pCallbackData->pMessage, MESSAGE_SIZE);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    
+    wake.notify_one();
+}
+
+
+void DebugLog::setSeverityFilter(const VkDebugUtilsMessageSeverityFlagsEXT severities)
+{
+    severityFilter.store(severities, std::memory_order_relaxed);
+}
+
+
+VkDebugUtilsMessageSeverityFlagsEXT DebugLog::getSeverityFilter(void) const
+{
+    return severityFilter.load(std::memory_order_relaxed);
+}
+
+
+void DebugLog::setTypeFilter(const VkDebugUtilsMessageTypeFlagsEXT types)
+{
+    typeFilter.store(types, std::memory_order_relaxed);
+}
+
+
+void DebugLog::setRateLimit(const uint32_t messagesPerSecond)
+{
+    rateLimit.store(messagesPerSecond, std::memory_order_relaxed);
+}
+
+
+void DebugLog::writerLoop(void)
+{
+    while (running.load())
+    {
+        if (!drain())
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(50));
+        }
+    }
+    
+    drain();
+    
+    std::lock_guard<std::mutex> lock(idMutex);
+    for (auto& entry : messageIds)
+    {
+        flushSuppressed(entry.second);
+    }
+    os->flush();
+}
+
+
+bool DebugLog::drain(void)
+{
+    bool any = false;
+    
+    while (true)
+    {
+        Slot& slot = slots[dequeuePos % RING_SIZE];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1)
+        {
+            break;
+        }
+        
+        write(slot);
+        slot.sequence.store(dequeuePos + RING_SIZE, std::memory_order_release);
+        dequeuePos++;
+        any = true;
+    }
+    
+    if (any)
+    {
+        os->flush();
+    }
+    
+    return any;
+}
+
+
+void DebugLog::write(const Slot& slot)
+{
+    // Messages without an id number are told apart by their id name
+    const int32_t key = slot.messageId != 0 ? slot.messageId : static_cast<int32_t>(std::hash<std::string>{}(slot.idName));
+    const auto now = std::chrono::steady_clock::now();
+    
+    {
+        std::lock_guard<std::mutex> lock(idMutex);
+        
+        MessageIdState& state = messageIds[key];
+        if (state.name.empty())
+        {
+            state.name = slot.idName[0] != '\0' ? slot.idName : "unnamed";
+            state.windowStart = now;
+        }
+        
+        if (slot.type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)
+        {
+            state.performanceCount++;
+        }
+        
+        if (now - state.windowStart >= std::chrono::seconds(1))
+        {
+            flushSuppressed(state);
+            state.windowStart = now;
+            state.windowCount = 0;
+        }
+        
+        // The filters may have changed since the message was pushed
+        if (!(slot.severity & severityFilter.load(std::memory_order_relaxed)) || !(slot.type & typeFilter.load(std::memory_order_relaxed)))
+        {
+            filtered.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        
+        const uint32_t limit = rateLimit.load(std::memory_order_relaxed);
+        if (limit > 0 && ++state.windowCount > limit)
+        {
+            state.suppressed++;
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    
+    *os << "Validation layer [" << severityName(slot.severity) << "][" << typeName(slot.type) << "]: " << slot.message << '\n';
+    written.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void DebugLog::flushSuppressed(MessageIdState& state)
+{
+    if (state.suppressed > 0)
+    {
+        *os << "Validation layer: suppressed " << state.suppressed << " repeats of " << state.name << '\n';
+        state.suppressed = 0;
+    }
+}
+
+
+DebugLogStats DebugLog::getStats(void) const
+{
+    DebugLogStats stats;
+    stats.received = received.load(std::memory_order_relaxed);
+    stats.filtered = filtered.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.suppressed = suppressed.load(std::memory_order_relaxed);
+    stats.written = written.load(std::memory_order_relaxed);
+    stats.performance = performance.load(std::memory_order_relaxed);
+    
+    return stats;
+}
+
+
+void DebugLog::reportPerformance(std::ostream& os) const
+{
+    const DebugLogStats stats = getStats();
+    if (stats.received == 0)
+    {
+        return;
+    }
+    
+    os << "[validation] messages: " << stats.received
+       << " | written: " << stats.written
+       << " | filtered: " << stats.filtered
+       << " | suppressed: " << stats.suppressed
+       << " | dropped: " << stats.dropped
+       << " | performance: " << stats.performance << '\n';
+    
+    std::vector<std::pair<std::string, uint64_t>> counts;
+    {
+        std::lock_guard<std::mutex> lock(idMutex);
+        for (const auto& entry : messageIds)
+        {
+            if (entry.second.performanceCount > 0)
+            {
+                counts.emplace_back(entry.second.name, entry.second.performanceCount);
+            }
+        }
+    }
+    
+    std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    for (const auto& count : counts)
+    {
+        os << "[validation] performance " << count.first << ": " << count.second << '\n';
+    }
+}
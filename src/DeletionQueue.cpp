@@ -0,0 +1,146 @@
+#include "DeletionQueue.hpp"
+#include "CommandCapture.hpp"
+
+#include <utility>
+
+
+void DeletionQueue::push(const TimelineSemaphore& timeline, const uint64_t value, Deleter deleter)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    timelineEntries.push_back({&timeline, value, std::move(deleter)});
+}
+
+
+void DeletionQueue::pushFrame(const uint32_t frame, Deleter deleter)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    frameEntries[frame].push_back(std::move(deleter));
+}
+
+
+void DeletionQueue::deferSwapchain(const uint32_t frame, const VkSwapchainKHR swapChain, const VkAllocationCallbacks* pAllocator)
+{
+    pushFrame(frame, [swapChain, pAllocator](const VkDevice device) { capture::destroySwapchain(device, swapChain, pAllocator); });
+}
+
+
+void DeletionQueue::deferImage(const uint32_t frame, const VkImage image, const VkAllocationCallbacks* pAllocator)
+{
+    pushFrame(frame, [image, pAllocator](const VkDevice device) { capture::destroyImage(device, image, pAllocator); });
+}
+
+
+void DeletionQueue::deferImageView(const uint32_t frame, const VkImageView imageView, const VkAllocationCallbacks* pAllocator)
+{
+    pushFrame(frame, [imageView, pAllocator](const VkDevice device) { capture::destroyImageView(device, imageView, pAllocator); });
+}
+
+
+void DeletionQueue::deferFramebuffer(const uint32_t frame, const VkFramebuffer framebuffer, const VkAllocationCallbacks* pAllocator)
+{
+    pushFrame(frame, [framebuffer, pAllocator](const VkDevice device) { capture::destroyFramebuffer(device, framebuffer, pAllocator); });
+}
+
+
+void DeletionQueue::deferMemory(const uint32_t frame, const VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator)
+{
+    pushFrame(frame, [memory, pAllocator](const VkDevice device) { capture::freeMemory(device, memory, pAllocator); });
+}
+
+
+void DeletionQueue::deferDescriptorPool(const uint32_t frame, const VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator)
+{
+    pushFrame(frame, [descriptorPool, pAllocator](const VkDevice device) { capture::destroyDescriptorPool(device, descriptorPool, pAllocator); });
+}
+
+
+void DeletionQueue::deferSemaphore(const uint32_t frame, const VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator)
+{
+    pushFrame(frame, [semaphore, pAllocator](const VkDevice device) { capture::destroySemaphore(device, semaphore, pAllocator); });
+}
+
+
+void DeletionQueue::collect(const VkDevice device, const uint32_t frame)
+{
+    std::vector<Deleter> ready;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(frameEntries[frame]);
+        
+        // Query each timeline once per collect, entries keep their push order otherwise
+        std::vector<std::pair<const TimelineSemaphore*, uint64_t>> reached;
+        
+        size_t kept = 0;
+        for (size_t i = 0; i < timelineEntries.size(); i++)
+        {
+            TimelineEntry& entry = timelineEntries[i];
+            
+            auto it = reached.begin();
+            while (it != reached.end() && it->first != entry.timeline)
+            {
+                it++;
+            }
+            
+            if (it == reached.end())
+            {
+                reached.emplace_back(entry.timeline, entry.timeline->getValue(device));
+                it = reached.end() - 1;
+            }
+            
+            if (entry.value <= it->second)
+            {
+                ready.push_back(std::move(entry.deleter));
+            } else
+            {
+                if (kept != i)
+                {
+                    timelineEntries[kept] = std::move(entry);
+                }
+                kept++;
+            }
+        }
+        timelineEntries.resize(kept);
+    }
+    
+    // Deleters run outside the lock so producers are never blocked on the driver
+    for (auto& deleter : ready)
+    {
+        deleter(device);
+    }
+}
+
+
+void DeletionQueue::flush(const VkDevice device)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    for (auto& entry : timelineEntries)
+    {
+        entry.deleter(device);
+    }
+    timelineEntries.clear();
+    
+    for (auto& entries : frameEntries)
+    {
+        for (auto& deleter : entries)
+        {
+            deleter(device);
+        }
+        entries.clear();
+    }
+}
+
+
+size_t DeletionQueue::getPendingCount(void) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    size_t count = timelineEntries.size();
+    for (const auto& entries : frameEntries)
+    {
+        count += entries.size();
+    }
+    
+    return count;
+}
@@ -0,0 +1,71 @@
+#include "DescriptorBinder.hpp"
+#include "CommandCapture.hpp"
+
+
+void DescriptorBinder::reset(void)
+{
+    for (auto& sets : boundSets)
+    {
+        sets.clear();
+    }
+}
+
+
+void DescriptorBinder::cmdBindSets(const VkCommandBuffer commandBuffer, const PipelineLayoutCache& layoutCache, const VkPipelineBindPoint bindPoint, const VkPipelineLayout pipelineLayout, const uint32_t firstSet, const std::vector<VkDescriptorSet>& sets)
+{
+    std::vector<BoundSet>& bound = boundSets[bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0];
+    const uint32_t endSet = firstSet + static_cast<uint32_t>(sets.size());
+    
+    bool upToDate = endSet <= bound.size();
+    for (uint32_t set = firstSet; upToDate && set < endSet; set++)
+    {
+        const BoundSet& current = bound[set];
+        upToDate = current.set == sets[set - firstSet] && layoutCache.isCompatible(current.pipelineLayout, pipelineLayout, set);
+    }
+    
+    if (upToDate)
+    {
+        skippedCount += sets.size();
+        return;
+    }
+    
+    capture::cmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, firstSet, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+    boundCount += sets.size();
+    
+    // Binding through an incompatible layout disturbs the other sets, they have to be bound again before use
+    for (uint32_t set = 0; set < bound.size(); set++)
+    {
+        if (bound[set].set != VK_NULL_HANDLE && (set < firstSet || set >= endSet) && !layoutCache.isCompatible(bound[set].pipelineLayout, pipelineLayout, set))
+        {
+            bound[set] = {};
+        }
+    }
+    
+    if (bound.size() < endSet)
+    {
+        bound.resize(endSet);
+    }
+    for (uint32_t set = firstSet; set < endSet; set++)
+    {
+        bound[set] = {sets[set - firstSet], pipelineLayout};
+    }
+}
+
+
+const uint64_t DescriptorBinder::getBoundCount(void) const
+{
+    return boundCount;
+}
+
+
+const uint64_t DescriptorBinder::getSkippedCount(void) const
+{
+    return skippedCount;
+}
+
+
+void DescriptorBinder::resetStats(void)
+{
+    boundCount = 0;
+    skippedCount = 0;
+}
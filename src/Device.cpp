@@ -2,18 +2,85 @@
 #include "ValLayers.hpp"
 #include "SwapChain.hpp"
 
+#include <algorithm>
 #include <map>
 #include <set>
-#include <string>
 
 
 const stringVector Device::deviceExtensions =
 {
-    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME
 };
 
+// Enabled when the device exposes them and their dependencies, callers query getCapabilities
+const std::vector<OptionalDeviceExtension> Device::optionalDeviceExtensions =
+{
+    {VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, {}},
+    {VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, {}},
+    {VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME, {}},
+    {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, {
+        {VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME, VK_API_VERSION_1_2},
+        {VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME, VK_API_VERSION_1_2},
+        {VK_KHR_MULTIVIEW_EXTENSION_NAME, VK_API_VERSION_1_1},
+        {VK_KHR_MAINTENANCE_2_EXTENSION_NAME, VK_API_VERSION_1_1}
+    }},
+    // VK_KHR_pipeline_library is not part of any core version
+    {VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, {
+        {VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, UINT32_MAX}
+    }}
+};
+
+
+namespace
+{
+    // Feature structs of the extensions above, only the enabled ones are chained
+    struct DeviceFeatureChain
+    {
+        VkPhysicalDeviceFeatures2KHR features2{};
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphore{};
+        VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2{};
+        VkPhysicalDevicePipelineCreationCacheControlFeaturesEXT pipelineCreationCacheControl{};
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRendering{};
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibrary{};
+        
+        void link(const DeviceCapabilities& capabilities)
+        {
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+            timelineSemaphore.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+            synchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+            pipelineCreationCacheControl.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_CREATION_CACHE_CONTROL_FEATURES_EXT;
+            dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+            graphicsPipelineLibrary.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+            
+            void** ppNext = &features2.pNext;
+            auto append = [&ppNext](auto& features)
+            {
+                *ppNext = &features;
+                ppNext = &features.pNext;
+            };
+            
+            if (capabilities.hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) append(timelineSemaphore);
+            if (capabilities.hasExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) append(synchronization2);
+            if (capabilities.hasExtension(VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME)) append(pipelineCreationCacheControl);
+            if (capabilities.hasExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) append(dynamicRendering);
+            if (capabilities.hasExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) append(graphicsPipelineLibrary);
+        }
+        
+        // Each of these features is mandatory for its extension, used when the query is unavailable
+        void assumeSupported(void)
+        {
+            timelineSemaphore.timelineSemaphore = VK_TRUE;
+            synchronization2.synchronization2 = VK_TRUE;
+            pipelineCreationCacheControl.pipelineCreationCacheControl = VK_TRUE;
+            dynamicRendering.dynamicRendering = VK_TRUE;
+            graphicsPipelineLibrary.graphicsPipelineLibrary = VK_TRUE;
+        }
+    };
+}
+
 
-int Device::rateDeviceSuitability(const VkPhysicalDevice device, const VkSurfaceKHR surface)
+int Device::rateDeviceSuitability(const VkPhysicalDevice device, const std::vector<VkSurfaceKHR>& surfaces)
 {
     VkPhysicalDeviceProperties deviceProperties;
     vkGetPhysicalDeviceProperties(device, &deviceProperties);
@@ -22,7 +89,7 @@ int Device::rateDeviceSuitability(const VkPhysicalDevice device, const VkSurface
     vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
     
     
-    if (!isDeviceSuitable(device, surface))
+    if (!isDeviceSuitable(device, surfaces))
     {
         return 0;
     }
@@ -46,28 +113,40 @@ int Device::rateDeviceSuitability(const VkPhysicalDevice device, const VkSurface
 }
 
 
-bool Device::isDeviceSuitable(const VkPhysicalDevice device, const VkSurfaceKHR surface)
+bool Device::isDeviceSuitable(const VkPhysicalDevice device, const std::vector<VkSurfaceKHR>& surfaces)
 {
-    QueueFamilyIndices indices = Queue::findQueueFamilies(device, surface);
-    SwapChainSupportDetails swapChainSupport = SwapChain::querySwapChainSupport(device, surface);
+    QueueFamilyIndices indices = Queue::findQueueFamilies(device, surfaces);
     
     bool isSuitable = true;
     isSuitable &= indices.isComplete();
     isSuitable &= checkDeviceExtensionSupport(device);
-    isSuitable &= !swapChainSupport.surfaceFormats.empty();
-    isSuitable &= !swapChainSupport.presentModes.empty();
+    
+    for (const VkSurfaceKHR surface : surfaces)
+    {
+        SwapChainSupportDetails swapChainSupport = SwapChain::querySwapChainSupport(device, surface);
+        isSuitable &= !swapChainSupport.surfaceFormats.empty();
+        isSuitable &= !swapChainSupport.presentModes.empty();
+    }
     
     return isSuitable;
 }
 
 
-bool Device::checkDeviceExtensionSupport(const VkPhysicalDevice device)
+std::vector<VkExtensionProperties> Device::getAvailableExtensions(const VkPhysicalDevice device)
 {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
     std::vector<VkExtensionProperties> availableExtensions(extensionCount);
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
     
+    return availableExtensions;
+}
+
+
+bool Device::checkDeviceExtensionSupport(const VkPhysicalDevice device)
+{
+    std::vector<VkExtensionProperties> availableExtensions = getAvailableExtensions(device);
+    
     std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
     for (const auto& extension : availableExtensions)
@@ -79,17 +158,12 @@ bool Device::checkDeviceExtensionSupport(const VkPhysicalDevice device)
 }
 
 
-void Device::populateDeviceCreateInfo(VkDeviceCreateInfo& createInfo, const std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos, const VkPhysicalDeviceFeatures& deviceFeatures, stringVector& extensions)
+void Device::populateDeviceCreateInfo(VkDeviceCreateInfo& createInfo, const std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos, const VkPhysicalDeviceFeatures* pDeviceFeatures, const stringVector& extensions)
 {
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
-    createInfo.pEnabledFeatures = &deviceFeatures;
-    
-    if (MOLTEN_VK)
-    {
-        extensions.emplace_back("VK_KHR_portability_subset");
-    }
+    createInfo.pEnabledFeatures = pDeviceFeatures;
     
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
@@ -105,7 +179,7 @@ void Device::populateDeviceCreateInfo(VkDeviceCreateInfo& createInfo, const std:
 }
 
 
-void Device::pickPhysicalDevice(const VkInstance instance, const VkSurfaceKHR surface)
+void Device::pickPhysicalDevice(const VkInstance instance, const std::vector<VkSurfaceKHR>& surfaces)
 {
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
@@ -120,14 +194,14 @@ void Device::pickPhysicalDevice(const VkInstance instance, const VkSurfaceKHR su
 
     for (const auto& device : devices)
     {
-        int score = rateDeviceSuitability(device, surface);
+        int score = rateDeviceSuitability(device, surfaces);
         candidates.insert(std::make_pair(score, device));
     }
 
     if (candidates.rbegin()->first > 0)
     {
         physicalDevice = candidates.rbegin()->second;
-        qIndices = Queue::findQueueFamilies(physicalDevice, surface);
+        qIndices = Queue::findQueueFamilies(physicalDevice, surfaces);
     } else
     {
         throw std::runtime_error("Failed to find a suitable GPU!");
@@ -135,15 +209,125 @@ void Device::pickPhysicalDevice(const VkInstance instance, const VkSurfaceKHR su
 }
 
 
-void Device::createLogicalDevice(const VkAllocationCallbacks* pAllocator)
+stringVector Device::negotiateExtensions(const InstanceCapabilities& instanceCapabilities)
+{
+    std::set<std::string> available;
+    for (const auto& extension : getAvailableExtensions(physicalDevice))
+    {
+        available.insert(extension.extensionName);
+    }
+    
+    stringVector extensions{deviceExtensions};
+    std::set<std::string> enabled(extensions.begin(), extensions.end());
+    
+    // Must be enabled whenever the device exposes it
+    if (available.count(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME) > 0)
+    {
+        extensions.emplace_back(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME);
+        capabilities.portabilitySubset = true;
+    }
+    
+    // Every optional extension depends on VK_KHR_get_physical_device_properties2 at instance level
+    for (const auto& optional : optionalDeviceExtensions)
+    {
+        if (!instanceCapabilities.physicalDeviceProperties2 || available.count(optional.name) == 0)
+        {
+            continue;
+        }
+        
+        bool satisfied = true;
+        for (const auto& dependency : optional.dependencies)
+        {
+            satisfied &= capabilities.apiVersion >= dependency.second || available.count(dependency.first) > 0;
+        }
+        
+        if (!satisfied)
+        {
+            continue;
+        }
+        
+        for (const auto& dependency : optional.dependencies)
+        {
+            if (capabilities.apiVersion < dependency.second && enabled.insert(dependency.first).second)
+            {
+                extensions.emplace_back(dependency.first);
+            }
+        }
+        
+        extensions.emplace_back(optional.name);
+        enabled.insert(optional.name);
+    }
+    
+    capabilities.extensions = std::set<std::string>(extensions.begin(), extensions.end());
+    
+    return extensions;
+}
+
+
+void Device::createLogicalDevice(const VkInstance instance, const InstanceCapabilities& instanceCapabilities, const VkAllocationCallbacks* pAllocator)
 {
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     Queue::populateDeviceQueueCreateInfo(queueCreateInfos, qIndices);
     
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    capabilities.apiVersion = std::min(instanceCapabilities.apiVersion, deviceProperties.apiVersion);
+    
+    const stringVector extensions = negotiateExtensions(instanceCapabilities);
+    
+    DeviceFeatureChain featureChain;
+    featureChain.link(capabilities);
+    
+    if (instanceCapabilities.physicalDeviceProperties2)
+    {
+        const char* queryName = instanceCapabilities.apiVersion >= VK_API_VERSION_1_1 ? "vkGetPhysicalDeviceFeatures2" : "vkGetPhysicalDeviceFeatures2KHR";
+        auto getPhysicalDeviceFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2KHR) vkGetInstanceProcAddr(instance, queryName);
+        getPhysicalDeviceFeatures2(physicalDevice, &featureChain.features2);
+    } else
+    {
+        vkGetPhysicalDeviceFeatures(physicalDevice, &featureChain.features2.features);
+        featureChain.assumeSupported();
+    }
+    
+    // Nothing requires these yet, they are enabled whenever supported so later code can rely on them
+    const VkPhysicalDeviceFeatures supportedFeatures = featureChain.features2.features;
+    featureChain.features2.features = {};
+    featureChain.features2.features.samplerAnisotropy = supportedFeatures.samplerAnisotropy;
+    featureChain.features2.features.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    featureChain.features2.features.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    
+    capabilities.features = featureChain.features2.features;
+    capabilities.timelineSemaphore = capabilities.hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) && featureChain.timelineSemaphore.timelineSemaphore;
+    capabilities.synchronization2 = capabilities.hasExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) && featureChain.synchronization2.synchronization2;
+    capabilities.memoryBudget = capabilities.hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (capabilities.memoryBudget)
+    {
+        // Optional extensions are only enabled with properties2, so the query exists
+        const char* queryName = instanceCapabilities.apiVersion >= VK_API_VERSION_1_1 ? "vkGetPhysicalDeviceMemoryProperties2" : "vkGetPhysicalDeviceMemoryProperties2KHR";
+        getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR) vkGetInstanceProcAddr(instance, queryName);
+        capabilities.memoryBudget = getMemoryProperties2 != nullptr;
+    }
+    capabilities.pipelineCreationCacheControl = capabilities.hasExtension(VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME) && featureChain.pipelineCreationCacheControl.pipelineCreationCacheControl;
+    capabilities.dynamicRendering = capabilities.hasExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) && featureChain.dynamicRendering.dynamicRendering;
+    capabilities.graphicsPipelineLibrary = capabilities.hasExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) && featureChain.graphicsPipelineLibrary.graphicsPipelineLibrary;
+    
+    if (!capabilities.timelineSemaphore)
+    {
+        throw std::runtime_error("Timeline semaphores are not supported!");
+    }
+    
     VkDeviceCreateInfo createInfo{};
-    VkPhysicalDeviceFeatures deviceFeatures{};
-    stringVector extensions{deviceExtensions};
-    populateDeviceCreateInfo(createInfo, queueCreateInfos, deviceFeatures, extensions);
+    
+    // VkPhysicalDeviceFeatures2 replaces pEnabledFeatures, but only exists with properties2
+    if (instanceCapabilities.physicalDeviceProperties2)
+    {
+        populateDeviceCreateInfo(createInfo, queueCreateInfos, nullptr, extensions);
+        createInfo.pNext = &featureChain.features2;
+    } else
+    {
+        populateDeviceCreateInfo(createInfo, queueCreateInfos, &featureChain.features2.features, extensions);
+        createInfo.pNext = featureChain.features2.pNext;
+    }
     
     if (vkCreateDevice(physicalDevice, &createInfo, pAllocator, &logicalDevice) != VK_SUCCESS)
     {
@@ -152,13 +336,13 @@ void Device::createLogicalDevice(const VkAllocationCallbacks* pAllocator)
 }
 
 
-void Device::setupDevices(const VkInstance instance, const VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator)
+void Device::setupDevices(const VkInstance instance, const InstanceCapabilities& instanceCapabilities, const std::vector<VkSurfaceKHR>& surfaces, const VkAllocationCallbacks* pAllocator)
 {
-    pickPhysicalDevice(instance, surface);
+    pickPhysicalDevice(instance, surfaces);
     
     if (physicalDevice != VK_NULL_HANDLE)
     {
-        createLogicalDevice(pAllocator);
+        createLogicalDevice(instance, instanceCapabilities, pAllocator);
     }
 }
 
@@ -189,3 +373,46 @@ const QueueFamilyIndices Device::getQIndices(void) const
     return qIndices;
 }
 
+
+const DeviceCapabilities& Device::getCapabilities(void) const
+{
+    return capabilities;
+}
+
+
+const MemoryUsage Device::queryMemoryUsage(void) const
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    
+    VkPhysicalDeviceMemoryProperties2KHR memoryProperties{};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+    if (capabilities.memoryBudget)
+    {
+        memoryProperties.pNext = &budgetProperties;
+        getMemoryProperties2(physicalDevice, &memoryProperties);
+    } else
+    {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties.memoryProperties);
+    }
+    
+    MemoryUsage memoryUsage;
+    for (uint32_t i = 0; i < memoryProperties.memoryProperties.memoryHeapCount; i++)
+    {
+        if ((memoryProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0)
+        {
+            continue;
+        }
+        
+        if (capabilities.memoryBudget)
+        {
+            memoryUsage.usage += budgetProperties.heapUsage[i];
+            memoryUsage.budget += budgetProperties.heapBudget[i];
+        } else
+        {
+            memoryUsage.budget += memoryProperties.memoryProperties.memoryHeaps[i].size;
+        }
+    }
+    
+    return memoryUsage;
+}
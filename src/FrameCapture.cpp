@@ -0,0 +1,453 @@
+#include "FrameCapture.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+
+CaptureConfig FrameCapture::configFromEnvironment(void)
+{
+    CaptureConfig config;
+    
+    const char* value = std::getenv("VULKAN_CAPTURE");
+    if (value == nullptr)
+    {
+        return config;
+    }
+    
+    const std::string setting(value);
+    const size_t separator = setting.find(':');
+    const std::string format = setting.substr(0, separator);
+    
+    if (separator == std::string::npos || separator + 1 == setting.size())
+    {
+        std::cerr << "VULKAN_CAPTURE needs <format>:<output>, capture is off" << std::endl;
+        return config;
+    }
+    
+    if (format == "raw") config.format = CaptureFormat::Raw;
+    else if (format == "ppm") config.format = CaptureFormat::Ppm;
+    else if (format == "y4m") config.format = CaptureFormat::Y4m;
+    else
+    {
+        std::cerr << "Unknown VULKAN_CAPTURE format \"" << format << "\", capture is off" << std::endl;
+        return config;
+    }
+    
+    config.output = setting.substr(separator + 1);
+    return config;
+}
+
+
+void FrameCapture::setupCapture(const VkPhysicalDevice physicalDevice, const VkDevice device, const SwapChainConfig& swapChainConfig, const CaptureConfig& config, HostAllocator* hostAllocator)
+{
+    if (config.format == CaptureFormat::None)
+    {
+        return;
+    }
+    
+    if (!(swapChainConfig.imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+    {
+        throw std::runtime_error("Swap chain images do not support capture!");
+    }
+    
+    switch (swapChainConfig.surfaceFormat.format)
+    {
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            swapRedBlue = true;
+            break;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            swapRedBlue = false;
+            break;
+        default:
+            throw std::runtime_error("Unsupported swap chain format for capture!");
+    }
+    
+    this->config = config;
+    extent = swapChainConfig.extent;
+    perFrameFiles = config.format != CaptureFormat::Y4m && config.output.find("%u") != std::string::npos;
+    
+    // Cached memory keeps CPU reads of the mapping fast; Buffer::invalidate covers it not being coherent
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    
+    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        if ((memProperties.memoryTypes[i].propertyFlags & cached) == cached)
+        {
+            properties = cached;
+            break;
+        }
+    }
+    
+    slots = std::make_unique<Slot[]>(config.ringSize);
+    for (uint32_t i = 0; i < config.ringSize; i++)
+    {
+        slots[i].buffer.setupBuffer(physicalDevice, device, getFrameSize(), VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties, {}, hostAllocator);
+        slots[i].data = static_cast<const uint8_t*>(slots[i].buffer.map(device));
+    }
+    
+    if (!perFrameFiles)
+    {
+        openStream();
+    }
+    
+    stopping = false;
+    startTime = std::chrono::steady_clock::now();
+    
+    for (uint32_t i = 0; i < config.workerCount; i++)
+    {
+        workers.emplace_back(&FrameCapture::workerLoop, this);
+    }
+}
+
+
+void FrameCapture::destroyCapture(const VkDevice device, HostAllocator* hostAllocator)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    
+    poll(device, std::numeric_limits<uint64_t>::max());
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobCondition.notify_all();
+    
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+    
+    closeStream();
+    
+    for (uint32_t i = 0; i < config.ringSize; i++)
+    {
+        slots[i].buffer.destroyBuffer(device, hostAllocator);
+    }
+    slots.reset();
+    
+    config.format = CaptureFormat::None;
+}
+
+
+bool FrameCapture::isEnabled(void) const
+{
+    return config.format != CaptureFormat::None;
+}
+
+
+const size_t FrameCapture::getFrameSize(void) const
+{
+    return static_cast<size_t>(extent.width) * extent.height * 4;
+}
+
+
+void FrameCapture::openStream(void)
+{
+    streamIsPipe = config.output[0] == '|';
+    stream = streamIsPipe ? popen(config.output.c_str() + 1, "w") : std::fopen(config.output.c_str(), "wb");
+    
+    if (stream == nullptr)
+    {
+        throw std::runtime_error("Failed to open capture output " + config.output + "!");
+    }
+    
+    if (config.format == CaptureFormat::Y4m)
+    {
+        std::fprintf(stream, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", extent.width, extent.height, config.frameRate);
+    }
+}
+
+
+void FrameCapture::closeStream(void)
+{
+    if (stream == nullptr)
+    {
+        return;
+    }
+    
+    if (streamIsPipe)
+    {
+        pclose(stream);
+    } else
+    {
+        std::fclose(stream);
+    }
+    
+    stream = nullptr;
+}
+
+
+void FrameCapture::cmdCapture(const VkCommandBuffer commandBuffer, const VkImage image, const VkExtent2D imageExtent)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    
+    if (imageExtent.width != extent.width || imageExtent.height != extent.height)
+    {
+        droppedFrames++;
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        hasRecordedSlot = false;
+        for (uint32_t i = 0; i < config.ringSize; i++)
+        {
+            if (slots[i].state == SlotState::Free)
+            {
+                slots[i].state = SlotState::Recorded;
+                slots[i].frameNumber = nextFrameNumber++;
+                recordedSlot = i;
+                hasRecordedSlot = true;
+                break;
+            }
+        }
+    }
+    
+    if (!hasRecordedSlot)
+    {
+        droppedFrames++;
+        return;
+    }
+    
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = image;
+    toTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toTransfer.subresourceRange.levelCount = 1;
+    toTransfer.subresourceRange.layerCount = 1;
+    
+    capture::cmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+    
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {extent.width, extent.height, 1};
+    
+    const VkBuffer buffer = slots[recordedSlot].buffer.getBuffer();
+    capture::cmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+    
+    VkImageMemoryBarrier toPresent = toTransfer;
+    toPresent.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toPresent.dstAccessMask = 0;
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    
+    // The host reads the copy once the timeline passes this frame
+    VkBufferMemoryBarrier toHost{};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = buffer;
+    toHost.size = VK_WHOLE_SIZE;
+    
+    capture::cmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &toHost, 1, &toPresent);
+}
+
+
+void FrameCapture::commitFrame(const uint64_t timelineValue)
+{
+    if (!hasRecordedSlot)
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    slots[recordedSlot].state = SlotState::InFlight;
+    slots[recordedSlot].timelineValue = timelineValue;
+    hasRecordedSlot = false;
+    capturedFrames++;
+}
+
+
+void FrameCapture::poll(const VkDevice device, const uint64_t completedValue)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    
+    std::vector<uint32_t> completed;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        for (uint32_t i = 0; i < config.ringSize; i++)
+        {
+            if (slots[i].state == SlotState::InFlight && slots[i].timelineValue <= completedValue)
+            {
+                slots[i].buffer.invalidate(device);
+                slots[i].state = SlotState::Encoding;
+                completed.push_back(i);
+            }
+        }
+        
+        // Jobs are taken in frame order, so the frame a writer waits for is always being encoded
+        std::sort(completed.begin(), completed.end(), [this](const uint32_t a, const uint32_t b) { return slots[a].frameNumber < slots[b].frameNumber; });
+        jobs.insert(jobs.end(), completed.begin(), completed.end());
+    }
+    
+    if (!completed.empty())
+    {
+        jobCondition.notify_all();
+    }
+}
+
+
+void FrameCapture::workerLoop(void)
+{
+    std::vector<uint8_t> scratch;
+    
+    while (true)
+    {
+        uint32_t index;
+        
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+            
+            if (jobs.empty())
+            {
+                return;
+            }
+            
+            index = jobs.front();
+            jobs.pop_front();
+        }
+        
+        encode(slots[index], scratch);
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        slots[index].state = SlotState::Free;
+    }
+}
+
+
+void FrameCapture::encode(const Slot& slot, std::vector<uint8_t>& scratch)
+{
+    const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+    const uint8_t* src = slot.data;
+    const uint32_t r = swapRedBlue ? 2 : 0;
+    const uint32_t b = swapRedBlue ? 0 : 2;
+    
+    if (config.format == CaptureFormat::Raw)
+    {
+        write(slot.frameNumber, src, getFrameSize());
+        return;
+    }
+    
+    const std::string header = config.format == CaptureFormat::Ppm
+        ? "P6\n" + std::to_string(extent.width) + " " + std::to_string(extent.height) + "\n255\n"
+        : "FRAME\n";
+    
+    scratch.resize(header.size() + pixelCount * 3);
+    std::copy(header.begin(), header.end(), scratch.begin());
+    uint8_t* dst = scratch.data() + header.size();
+    
+    if (config.format == CaptureFormat::Ppm)
+    {
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            dst[3 * i + 0] = src[4 * i + r];
+            dst[3 * i + 1] = src[4 * i + 1];
+            dst[3 * i + 2] = src[4 * i + b];
+        }
+    } else
+    {
+        // BT.601 limited range, full resolution planes (4:4:4)
+        uint8_t* yPlane = dst;
+        uint8_t* uPlane = dst + pixelCount;
+        uint8_t* vPlane = dst + 2 * pixelCount;
+        
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            const int32_t red = src[4 * i + r];
+            const int32_t green = src[4 * i + 1];
+            const int32_t blue = src[4 * i + b];
+            
+            yPlane[i] = static_cast<uint8_t>(16 + ((66 * red + 129 * green + 25 * blue + 128) >> 8));
+            uPlane[i] = static_cast<uint8_t>(128 + ((-38 * red - 74 * green + 112 * blue + 128) >> 8));
+            vPlane[i] = static_cast<uint8_t>(128 + ((112 * red - 94 * green - 18 * blue + 128) >> 8));
+        }
+    }
+    
+    write(slot.frameNumber, scratch.data(), scratch.size());
+}
+
+
+void FrameCapture::write(const uint64_t frameNumber, const uint8_t* data, const size_t size)
+{
+    size_t written = 0;
+    
+    if (perFrameFiles)
+    {
+        std::string path = config.output;
+        std::ostringstream number;
+        number << std::setw(6) << std::setfill('0') << frameNumber;
+        path.replace(path.find("%u"), 2, number.str());
+        
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (file != nullptr)
+        {
+            written = std::fwrite(data, 1, size, file);
+            std::fclose(file);
+        }
+    } else
+    {
+        // Streams take frames strictly in order
+        std::unique_lock<std::mutex> lock(writeMutex);
+        writeCondition.wait(lock, [this, frameNumber] { return nextWriteFrame == frameNumber; });
+        
+        written = std::fwrite(data, 1, size, stream);
+        nextWriteFrame++;
+        
+        lock.unlock();
+        writeCondition.notify_all();
+    }
+    
+    bytesWritten += written;
+    if (written == size)
+    {
+        writtenFrames++;
+    }
+}
+
+
+void FrameCapture::report(std::ostream& os) const
+{
+    if (capturedFrames == 0 && droppedFrames == 0)
+    {
+        return;
+    }
+    
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    
+    os << std::fixed << std::setprecision(1)
+       << "[capture] " << capturedFrames << " captured, " << writtenFrames << " written, " << droppedFrames << " dropped"
+       << " | " << (seconds > 0.0 ? bytesWritten / (1024.0 * 1024.0) / seconds : 0.0) << " MB/s" << std::endl;
+}
@@ -0,0 +1,253 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+
+
+// CPU time of the whole process, so worker threads a frame keeps busy count towards it
+static double processCpuSeconds(void)
+{
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+
+static FramePacer* pacerOf(GLFWwindow* window)
+{
+    return static_cast<FramePacer*>(glfwGetWindowUserPointer(window));
+}
+
+
+static void keyCallback(GLFWwindow* window, int key, int, int action, int mods)
+{
+    pacerOf(window)->handleKey({key, action, mods});
+}
+
+
+static void mouseButtonCallback(GLFWwindow* window, int, int, int)
+{
+    pacerOf(window)->markDirty(DirtyFlag::Input);
+}
+
+
+static void cursorPosCallback(GLFWwindow* window, double, double)
+{
+    pacerOf(window)->markDirty(DirtyFlag::Input);
+}
+
+
+static void scrollCallback(GLFWwindow* window, double, double)
+{
+    pacerOf(window)->markDirty(DirtyFlag::Input);
+}
+
+
+static void framebufferSizeCallback(GLFWwindow* window, int, int)
+{
+    pacerOf(window)->markResized();
+}
+
+
+// The window system lost the contents, after an expose or a resize
+static void windowRefreshCallback(GLFWwindow* window)
+{
+    pacerOf(window)->markDirty(DirtyFlag::Resize);
+}
+
+
+PacingMode FramePacer::modeFromEnvironment(const PacingMode defaultMode)
+{
+    const char* value = std::getenv("VULKAN_FRAME_PACING");
+    if (value == nullptr)
+    {
+        return defaultMode;
+    }
+    
+    const std::string mode(value);
+    if (mode == "continuous") return PacingMode::Continuous;
+    if (mode == "on-demand") return PacingMode::OnDemand;
+    
+    std::cerr << "Unknown VULKAN_FRAME_PACING value \"" << mode << "\", using the default" << std::endl;
+    return defaultMode;
+}
+
+
+void FramePacer::setupPacer(const PacingMode mode, const std::vector<GLFWwindow*>& windows, const uint32_t settleFrames, std::function<void(const KeyEvent&)> keyHandler)
+{
+    this->mode = mode;
+    this->settleFrames = settleFrames;
+    this->keyHandler = std::move(keyHandler);
+    settleFramesLeft = settleFrames;
+    capInterval = 1.0 / PACER_MAX_FPS;
+    
+    for (GLFWwindow* window : windows)
+    {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetKeyCallback(window, keyCallback);
+        glfwSetMouseButtonCallback(window, mouseButtonCallback);
+        glfwSetCursorPosCallback(window, cursorPosCallback);
+        glfwSetScrollCallback(window, scrollCallback);
+        glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+        glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+    }
+    
+    // The first frame is always due
+    dirtyMask.store(static_cast<uint32_t>(DirtyFlag::Scene));
+    lastAccountWall = std::chrono::steady_clock::now();
+    lastAccountCpu = processCpuSeconds();
+    lastFrameStart = lastAccountWall - std::chrono::seconds(1);
+}
+
+
+void FramePacer::accountTime(void)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const double cpu = processCpuSeconds();
+    
+    StateStats& stateStats = stats[static_cast<uint32_t>(state)];
+    stateStats.wallSeconds += std::chrono::duration<double>(now - lastAccountWall).count();
+    stateStats.cpuSeconds += cpu - lastAccountCpu;
+    
+    lastAccountWall = now;
+    lastAccountCpu = cpu;
+}
+
+
+bool FramePacer::waitForFrame(void)
+{
+    accountTime();
+    
+    if (mode == PacingMode::Continuous || animating.load())
+    {
+        state = PacerState::Active;
+        glfwPollEvents();
+        stats[static_cast<uint32_t>(state)].wakeups++;
+        
+        dirtyMask.store(0);
+        settleFramesLeft = settleFrames;
+        return beginFrame();
+    }
+    
+    if (dirtyMask.load() == 0 && settleFramesLeft == 0)
+    {
+        state = PacerState::Idle;
+        glfwWaitEventsTimeout(PACER_IDLE_TIMEOUT);
+        stats[static_cast<uint32_t>(state)].wakeups++;
+        
+        if (dirtyMask.load() == 0)
+        {
+            return false;
+        }
+    }
+    
+    // Changes arriving before the cap interval has passed are coalesced into one frame
+    state = PacerState::Capped;
+    const double sinceLastFrame = std::chrono::duration<double>(std::chrono::steady_clock::now() - lastFrameStart).count();
+    if (sinceLastFrame < capInterval)
+    {
+        glfwWaitEventsTimeout(capInterval - sinceLastFrame);
+        stats[static_cast<uint32_t>(state)].wakeups++;
+        return false;
+    }
+    
+    glfwPollEvents();
+    stats[static_cast<uint32_t>(state)].wakeups++;
+    
+    if (dirtyMask.exchange(0) != 0)
+    {
+        settleFramesLeft = settleFrames;
+    } else
+    {
+        settleFramesLeft--;
+    }
+    
+    return beginFrame();
+}
+
+
+bool FramePacer::beginFrame(void)
+{
+    lastFrameStart = std::chrono::steady_clock::now();
+    frameStartCpu = processCpuSeconds();
+    stats[static_cast<uint32_t>(state)].frames++;
+    return true;
+}
+
+
+void FramePacer::endFrame(void)
+{
+    // Smoothed so one slow frame does not drop the cap on its own
+    const double cpu = processCpuSeconds() - frameStartCpu;
+    frameCpuSeconds = frameCpuSeconds == 0.0 ? cpu : 0.9 * frameCpuSeconds + 0.1 * cpu;
+    capInterval = std::clamp(frameCpuSeconds / PACER_CPU_BUDGET, 1.0 / PACER_MAX_FPS, 1.0 / PACER_MIN_FPS);
+}
+
+
+void FramePacer::markDirty(const DirtyFlag flag)
+{
+    // A loop that already has changes to draw wakes on its own, bursts of input post a single event
+    if (dirtyMask.fetch_or(static_cast<uint32_t>(flag)) == 0)
+    {
+        glfwPostEmptyEvent();
+    }
+}
+
+
+void FramePacer::markResized(void)
+{
+    resized.store(true);
+    markDirty(DirtyFlag::Resize);
+}
+
+
+bool FramePacer::takeResized(void)
+{
+    return resized.exchange(false);
+}
+
+
+void FramePacer::handleKey(const KeyEvent& event)
+{
+    if (keyHandler)
+    {
+        keyHandler(event);
+    }
+    
+    markDirty(DirtyFlag::Input);
+}
+
+
+void FramePacer::setAnimating(const bool animating)
+{
+    this->animating.store(animating);
+    markDirty(DirtyFlag::Scene);
+}
+
+
+bool FramePacer::isAnimating(void) const
+{
+    return animating.load();
+}
+
+
+void FramePacer::report(std::ostream& os) const
+{
+    static const char* const names[] = {"idle", "capped", "active"};
+    
+    os << std::fixed << std::setprecision(1);
+    for (uint32_t i = 0; i < static_cast<uint32_t>(PacerState::Count); i++)
+    {
+        const StateStats& stateStats = stats[i];
+        if (stateStats.wallSeconds == 0.0)
+        {
+            continue;
+        }
+        
+        os << "[pacer] " << names[i] << ": " << stateStats.wallSeconds << " s, " << 100.0 * stateStats.cpuSeconds / stateStats.wallSeconds << "% cpu, "
+           << stateStats.wakeups / stateStats.wallSeconds << " wakeups/s, " << stateStats.frames / stateStats.wallSeconds << " frames/s" << std::endl;
+    }
+}
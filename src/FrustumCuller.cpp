@@ -0,0 +1,705 @@
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(SIMD_X86)
+    #include <emmintrin.h>
+#elif defined(SIMD_NEON)
+    #include <arm_neon.h>
+#endif
+
+
+static void normalizePlane(float plane[4])
+{
+    const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+    for (int i = 0; i < 4; i++)
+    {
+        plane[i] /= length;
+    }
+}
+
+
+Frustum Frustum::fromViewProjection(const float matrix[16])
+{
+    // Rows of the matrix combined as in Gribb and Hartmann, near is z >= 0 for Vulkan clip space
+    auto row = [matrix](const int r, const int c)
+    {
+        return matrix[c * 4 + r];
+    };
+    
+    Frustum frustum;
+    for (int c = 0; c < 4; c++)
+    {
+        frustum.planes[0][c] = row(3, c) + row(0, c);
+        frustum.planes[1][c] = row(3, c) - row(0, c);
+        frustum.planes[2][c] = row(3, c) + row(1, c);
+        frustum.planes[3][c] = row(3, c) - row(1, c);
+        frustum.planes[4][c] = row(2, c);
+        frustum.planes[5][c] = row(3, c) - row(2, c);
+    }
+    
+    for (auto& plane : frustum.planes)
+    {
+        normalizePlane(plane);
+    }
+    
+    return frustum;
+}
+
+
+Frustum Frustum::fromPerspective(const float eye[3], const float forward[3], const float up[3], const float fovY, const float aspect, const float nearPlane, const float farPlane)
+{
+    const float right[3] = {forward[1] * up[2] - forward[2] * up[1], forward[2] * up[0] - forward[0] * up[2], forward[0] * up[1] - forward[1] * up[0]};
+    const float tanY = std::tan(fovY * 0.5f);
+    const float tanX = tanY * aspect;
+    
+    // Side planes pass through the eye with normals tilted inwards from the right and up axes
+    Frustum frustum;
+    for (int i = 0; i < 3; i++)
+    {
+        frustum.planes[0][i] = right[i] + forward[i] * tanX;
+        frustum.planes[1][i] = -right[i] + forward[i] * tanX;
+        frustum.planes[2][i] = up[i] + forward[i] * tanY;
+        frustum.planes[3][i] = -up[i] + forward[i] * tanY;
+        frustum.planes[4][i] = forward[i];
+        frustum.planes[5][i] = -forward[i];
+    }
+    
+    for (int p = 0; p < 6; p++)
+    {
+        float* plane = frustum.planes[p];
+        plane[3] = 0.0f;
+        normalizePlane(plane);
+        plane[3] = -(plane[0] * eye[0] + plane[1] * eye[1] + plane[2] * eye[2]);
+    }
+    frustum.planes[4][3] -= nearPlane;
+    frustum.planes[5][3] += farPlane;
+    
+    return frustum;
+}
+
+
+// The corner furthest along the plane normal decides outside, the nearest one inside. Every kernel
+// evaluates a x + b y + c z + d in the same order, so they agree with the brute force reference
+uint32_t cullBoxesScalar(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask)
+{
+    uint32_t visibleMask = 0;
+    insideMask = 0;
+    
+    for (uint32_t box = 0; box < CULL_NODE_WIDTH; box++)
+    {
+        bool outside = false;
+        bool intersects = false;
+        
+        for (const auto& plane : frustum.planes)
+        {
+            const float px = bounds[plane[0] >= 0.0f ? 3 : 0][box];
+            const float py = bounds[plane[1] >= 0.0f ? 4 : 1][box];
+            const float pz = bounds[plane[2] >= 0.0f ? 5 : 2][box];
+            const float nx = bounds[plane[0] >= 0.0f ? 0 : 3][box];
+            const float ny = bounds[plane[1] >= 0.0f ? 1 : 4][box];
+            const float nz = bounds[plane[2] >= 0.0f ? 2 : 5][box];
+            
+            outside |= plane[0] * px + plane[1] * py + plane[2] * pz + plane[3] < 0.0f;
+            intersects |= plane[0] * nx + plane[1] * ny + plane[2] * nz + plane[3] < 0.0f;
+        }
+        
+        if (!outside)
+        {
+            visibleMask |= 1u << box;
+            insideMask |= intersects ? 0u : 1u << box;
+        }
+    }
+    
+    return visibleMask;
+}
+
+
+#if defined(SIMD_X86)
+uint32_t cullBoxesSse(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask)
+{
+    uint32_t outsideMask = 0;
+    uint32_t intersectMask = 0;
+    const __m128 zero = _mm_setzero_ps();
+    
+    for (uint32_t half = 0; half < CULL_NODE_WIDTH; half += 4)
+    {
+        __m128 box[6];
+        for (int i = 0; i < 6; i++)
+        {
+            box[i] = _mm_loadu_ps(bounds[i] + half);
+        }
+        
+        __m128 outside = zero;
+        __m128 intersects = zero;
+        for (const auto& plane : frustum.planes)
+        {
+            const __m128 a = _mm_set1_ps(plane[0]);
+            const __m128 b = _mm_set1_ps(plane[1]);
+            const __m128 c = _mm_set1_ps(plane[2]);
+            const __m128 d = _mm_set1_ps(plane[3]);
+            
+            const __m128 px = box[plane[0] >= 0.0f ? 3 : 0], nx = box[plane[0] >= 0.0f ? 0 : 3];
+            const __m128 py = box[plane[1] >= 0.0f ? 4 : 1], ny = box[plane[1] >= 0.0f ? 1 : 4];
+            const __m128 pz = box[plane[2] >= 0.0f ? 5 : 2], nz = box[plane[2] >= 0.0f ? 2 : 5];
+            
+            const __m128 positive = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, px), _mm_mul_ps(b, py)), _mm_mul_ps(c, pz)), d);
+            const __m128 negative = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, nx), _mm_mul_ps(b, ny)), _mm_mul_ps(c, nz)), d);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(positive, zero));
+            intersects = _mm_or_ps(intersects, _mm_cmplt_ps(negative, zero));
+        }
+        
+        outsideMask |= static_cast<uint32_t>(_mm_movemask_ps(outside)) << half;
+        intersectMask |= static_cast<uint32_t>(_mm_movemask_ps(intersects)) << half;
+    }
+    
+    const uint32_t visibleMask = ~outsideMask & ((1u << CULL_NODE_WIDTH) - 1);
+    insideMask = visibleMask & ~intersectMask;
+    return visibleMask;
+}
+#endif
+
+
+#if defined(SIMD_NEON)
+static uint32_t movemask(const uint32x4_t mask)
+{
+    static const uint32_t bitValues[4] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(mask, vld1q_u32(bitValues)));
+}
+
+
+uint32_t cullBoxesNeon(const float* const bounds[6], const Frustum& frustum, uint32_t& insideMask)
+{
+    uint32_t outsideMask = 0;
+    uint32_t intersectMask = 0;
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    
+    for (uint32_t half = 0; half < CULL_NODE_WIDTH; half += 4)
+    {
+        float32x4_t box[6];
+        for (int i = 0; i < 6; i++)
+        {
+            box[i] = vld1q_f32(bounds[i] + half);
+        }
+        
+        uint32x4_t outside = vdupq_n_u32(0);
+        uint32x4_t intersects = vdupq_n_u32(0);
+        for (const auto& plane : frustum.planes)
+        {
+            const float32x4_t px = box[plane[0] >= 0.0f ? 3 : 0], nx = box[plane[0] >= 0.0f ? 0 : 3];
+            const float32x4_t py = box[plane[1] >= 0.0f ? 4 : 1], ny = box[plane[1] >= 0.0f ? 1 : 4];
+            const float32x4_t pz = box[plane[2] >= 0.0f ? 5 : 2], nz = box[plane[2] >= 0.0f ? 2 : 5];
+            const float32x4_t d = vdupq_n_f32(plane[3]);
+            
+            // Separate multiply and add, a fused one would round differently from the reference
+            const float32x4_t positive = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(px, plane[0]), vmulq_n_f32(py, plane[1])), vmulq_n_f32(pz, plane[2])), d);
+            const float32x4_t negative = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(nx, plane[0]), vmulq_n_f32(ny, plane[1])), vmulq_n_f32(nz, plane[2])), d);
+            outside = vorrq_u32(outside, vcltq_f32(positive, zero));
+            intersects = vorrq_u32(intersects, vcltq_f32(negative, zero));
+        }
+        
+        outsideMask |= movemask(outside) << half;
+        intersectMask |= movemask(intersects) << half;
+    }
+    
+    const uint32_t visibleMask = ~outsideMask & ((1u << CULL_NODE_WIDTH) - 1);
+    insideMask = visibleMask & ~intersectMask;
+    return visibleMask;
+}
+#endif
+
+
+void FrustumCuller::setupCuller(const uint32_t workerCount)
+{
+    stopping = false;
+    
+    // Read before any worker exists, so a cull started before a worker first takes the lock is still its business
+    uint64_t startGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        startGeneration = generation;
+    }
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&FrustumCuller::workerLoop, this, startGeneration);
+    }
+}
+
+
+void FrustumCuller::destroyCuller(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+    
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+}
+
+
+void FrustumCuller::setKernel(const SimdKernel kernel)
+{
+    if (!simd::isKernelSupported(kernel))
+    {
+        throw std::runtime_error("Culling kernel " + simd::getKernelName(kernel) + " is not supported on this CPU!");
+    }
+    
+    this->kernel = kernel;
+    cullBoxes = nullptr;
+}
+
+
+SimdKernel FrustumCuller::getKernel(void) const
+{
+    return kernel;
+}
+
+
+uint32_t FrustumCuller::buildNode(const std::vector<Bounds>& bounds, const uint32_t begin, const uint32_t end, const uint32_t parent)
+{
+    // Median splits on the longest centroid axis, repeated on the largest group until the node is full
+    std::vector<std::pair<uint32_t, uint32_t>> groups = {{begin, end}};
+    while (groups.size() < CULL_NODE_WIDTH)
+    {
+        auto largest = std::max_element(groups.begin(), groups.end(), [](const auto& a, const auto& b) { return a.second - a.first < b.second - b.first; });
+        if (largest->second - largest->first <= CULL_NODE_WIDTH)
+        {
+            break;
+        }
+        
+        float low[3], high[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            low[axis] = std::numeric_limits<float>::max();
+            high[axis] = std::numeric_limits<float>::lowest();
+        }
+        for (uint32_t i = largest->first; i < largest->second; i++)
+        {
+            const Bounds& box = bounds[order[i]];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const float centroid = box.min[axis] + box.max[axis];
+                low[axis] = std::min(low[axis], centroid);
+                high[axis] = std::max(high[axis], centroid);
+            }
+        }
+        
+        int axis = 0;
+        for (int i = 1; i < 3; i++)
+        {
+            if (high[i] - low[i] > high[axis] - low[axis])
+            {
+                axis = i;
+            }
+        }
+        
+        const uint32_t first = largest->first;
+        const uint32_t last = largest->second;
+        const uint32_t middle = first + (last - first) / 2;
+        std::nth_element(order.begin() + first, order.begin() + middle, order.begin() + last, [&bounds, axis](const uint32_t a, const uint32_t b)
+        {
+            return bounds[a].min[axis] + bounds[a].max[axis] < bounds[b].min[axis] + bounds[b].max[axis];
+        });
+        
+        largest->second = middle;
+        groups.insert(largest + 1, {middle, last});
+    }
+    
+    // Children get higher indices than their parent, so a reverse sweep refits bottom-up
+    const uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    nodes[index].childCount = static_cast<uint32_t>(groups.size());
+    nodes[index].parent = parent;
+    nodes[index].first = begin;
+    nodes[index].end = end;
+    
+    for (uint32_t slot = 0; slot < groups.size(); slot++)
+    {
+        const uint32_t first = groups[slot].first;
+        const uint32_t count = groups[slot].second - first;
+        
+        if (count <= CULL_NODE_WIDTH)
+        {
+            nodes[index].child[slot] = first;
+            nodes[index].count[slot] = count;
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                objectNodes[order[i]] = index;
+            }
+        } else
+        {
+            const uint32_t child = buildNode(bounds, first, first + count, index);
+            nodes[index].child[slot] = child;
+            nodes[index].count[slot] = 0;
+        }
+    }
+    
+    return index;
+}
+
+
+void FrustumCuller::build(const std::vector<Bounds>& bounds)
+{
+    const uint32_t objectCount = static_cast<uint32_t>(bounds.size());
+    
+    nodes.clear();
+    order.resize(objectCount);
+    leafSlots.resize(objectCount);
+    objectNodes.resize(objectCount);
+    for (uint32_t i = 0; i < objectCount; i++)
+    {
+        order[i] = i;
+    }
+    
+    if (objectCount > 0)
+    {
+        nodes.reserve(objectCount / (CULL_NODE_WIDTH / 2) + 1);
+        buildNode(bounds, 0, objectCount, NO_NODE);
+    }
+    
+    for (int i = 0; i < 6; i++)
+    {
+        objectBounds[i].assign(objectCount + CULL_NODE_WIDTH, 0.0f);
+    }
+    for (uint32_t slot = 0; slot < objectCount; slot++)
+    {
+        const Bounds& box = bounds[order[slot]];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            objectBounds[axis][slot] = box.min[axis];
+            objectBounds[3 + axis][slot] = box.max[axis];
+        }
+        leafSlots[order[slot]] = slot;
+    }
+    
+    dirtyNodes.assign(nodes.size(), 1);
+    dirty = true;
+    refit();
+}
+
+
+void FrustumCuller::setBounds(const uint32_t object, const Bounds& bounds)
+{
+    const uint32_t slot = leafSlots[object];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        objectBounds[axis][slot] = bounds.min[axis];
+        objectBounds[3 + axis][slot] = bounds.max[axis];
+    }
+    
+    markDirty(objectNodes[object]);
+}
+
+
+void FrustumCuller::markDirty(uint32_t node)
+{
+    // Stops at the first ancestor that is already marked, everything above it is too
+    while (node != NO_NODE && !dirtyNodes[node])
+    {
+        dirtyNodes[node] = 1;
+        node = nodes[node].parent;
+    }
+    dirty = true;
+}
+
+
+void FrustumCuller::refitNode(const uint32_t index)
+{
+    CullNode& node = nodes[index];
+    
+    for (uint32_t slot = 0; slot < CULL_NODE_WIDTH; slot++)
+    {
+        float box[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        
+        if (slot < node.childCount)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                box[axis] = std::numeric_limits<float>::max();
+                box[3 + axis] = std::numeric_limits<float>::lowest();
+            }
+            
+            // Leaves cover their objects, inner children the slots of their node
+            const bool leaf = node.count[slot] > 0;
+            const uint32_t first = leaf ? node.child[slot] : 0;
+            const uint32_t end = leaf ? first + node.count[slot] : nodes[node.child[slot]].childCount;
+            
+            for (uint32_t i = first; i < end; i++)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    const float low = leaf ? objectBounds[axis][i] : nodes[node.child[slot]].bounds[axis][i];
+                    const float high = leaf ? objectBounds[3 + axis][i] : nodes[node.child[slot]].bounds[3 + axis][i];
+                    box[axis] = std::min(box[axis], low);
+                    box[3 + axis] = std::max(box[3 + axis], high);
+                }
+            }
+        }
+        
+        for (int i = 0; i < 6; i++)
+        {
+            node.bounds[i][slot] = box[i];
+        }
+    }
+}
+
+
+void FrustumCuller::refit(void)
+{
+    if (!dirty)
+    {
+        return;
+    }
+    
+    for (uint32_t node = static_cast<uint32_t>(nodes.size()); node-- > 0;)
+    {
+        if (dirtyNodes[node])
+        {
+            refitNode(node);
+            dirtyNodes[node] = 0;
+        }
+    }
+    dirty = false;
+}
+
+
+void FrustumCuller::emitRange(const uint32_t first, const uint32_t end, std::vector<uint32_t>& output) const
+{
+    output.insert(output.end(), order.begin() + first, order.begin() + end);
+}
+
+
+void FrustumCuller::visitNode(const uint32_t index, std::vector<uint32_t>& next, std::vector<uint32_t>& output) const
+{
+    const CullNode& node = nodes[index];
+    const float* const childBounds[6] = {node.bounds[0], node.bounds[1], node.bounds[2], node.bounds[3], node.bounds[4], node.bounds[5]};
+    
+    uint32_t insideMask;
+    uint32_t visibleMask = cullBoxes(childBounds, frustum, insideMask) & ((1u << node.childCount) - 1);
+    
+    while (visibleMask != 0)
+    {
+        const uint32_t slot = static_cast<uint32_t>(__builtin_ctz(visibleMask));
+        visibleMask &= visibleMask - 1;
+        
+        const uint32_t child = node.child[slot];
+        const uint32_t count = node.count[slot];
+        
+        if (insideMask & (1u << slot))
+        {
+            // Whole subtree inside, no further tests
+            if (count > 0)
+            {
+                emitRange(child, child + count, output);
+            } else
+            {
+                emitRange(nodes[child].first, nodes[child].end, output);
+            }
+        } else if (count > 0)
+        {
+            // Leaf straddling a plane, its objects are tested in one go
+            const float* const leafBounds[6] = {&objectBounds[0][child], &objectBounds[1][child], &objectBounds[2][child], &objectBounds[3][child], &objectBounds[4][child], &objectBounds[5][child]};
+            uint32_t leafInside;
+            uint32_t leafVisible = cullBoxes(leafBounds, frustum, leafInside) & ((1u << count) - 1);
+            
+            while (leafVisible != 0)
+            {
+                const uint32_t i = static_cast<uint32_t>(__builtin_ctz(leafVisible));
+                leafVisible &= leafVisible - 1;
+                output.push_back(order[child + i]);
+            }
+        } else
+        {
+            next.push_back(child);
+        }
+    }
+}
+
+
+void FrustumCuller::traverse(CullTask& task) const
+{
+    task.stack.clear();
+    task.stack.push_back(task.node);
+    
+    while (!task.stack.empty())
+    {
+        const uint32_t node = task.stack.back();
+        task.stack.pop_back();
+        visitNode(node, task.stack, task.visible);
+    }
+}
+
+
+void FrustumCuller::runTasks(void)
+{
+    uint32_t task;
+    while ((task = nextTask.fetch_add(1)) < tasks.size())
+    {
+        traverse(tasks[task]);
+    }
+}
+
+
+void FrustumCuller::workerLoop(const uint64_t startGeneration)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t seenGeneration = startGeneration;
+    
+    while (true)
+    {
+        startCondition.wait(lock, [this, &seenGeneration] { return stopping || generation != seenGeneration; });
+        if (stopping)
+        {
+            return;
+        }
+        seenGeneration = generation;
+        
+        lock.unlock();
+        runTasks();
+        lock.lock();
+        
+        if (--activeWorkers == 0)
+        {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+
+const std::vector<uint32_t>& FrustumCuller::cull(const Frustum& frustum)
+{
+    refit();
+    
+    this->frustum = frustum;
+    visible.clear();
+    frontierVisible.clear();
+    
+    if (nodes.empty())
+    {
+        return visible;
+    }
+    
+    if (cullBoxes == nullptr)
+    {
+        switch (kernel)
+        {
+#if defined(SIMD_X86)
+            case SimdKernel::Sse:
+                cullBoxes = cullBoxesSse;
+                break;
+            case SimdKernel::Avx2:
+                cullBoxes = cullBoxesAvx2;
+                break;
+#endif
+#if defined(SIMD_NEON)
+            case SimdKernel::Neon:
+                cullBoxes = cullBoxesNeon;
+                break;
+#endif
+            default:
+                cullBoxes = cullBoxesScalar;
+                break;
+        }
+    }
+    
+    // Breadth-first from the root until every thread has a few subtrees to take. Without workers
+    // the root is the only task
+    const size_t targetTasks = (workers.size() + 1) * CULL_TASKS_PER_THREAD;
+    std::vector<uint32_t> frontier = {0};
+    std::vector<uint32_t> next;
+    while (!workers.empty() && !frontier.empty() && frontier.size() < targetTasks)
+    {
+        next.clear();
+        for (const uint32_t node : frontier)
+        {
+            visitNode(node, next, frontierVisible);
+        }
+        frontier.swap(next);
+    }
+    
+    tasks.resize(frontier.size());
+    for (size_t i = 0; i < frontier.size(); i++)
+    {
+        tasks[i].node = frontier[i];
+        tasks[i].visible.clear();
+    }
+    
+    nextTask = 0;
+    if (!workers.empty() && tasks.size() > 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            generation++;
+            activeWorkers = static_cast<uint32_t>(workers.size());
+        }
+        startCondition.notify_all();
+        
+        runTasks();
+        
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+    } else
+    {
+        runTasks();
+    }
+    
+    // Joined in task order, so the list is the same whatever thread took which subtree
+    size_t visibleCount = frontierVisible.size();
+    for (const auto& task : tasks)
+    {
+        visibleCount += task.visible.size();
+    }
+    
+    visible.reserve(visibleCount);
+    visible.insert(visible.end(), frontierVisible.begin(), frontierVisible.end());
+    for (const auto& task : tasks)
+    {
+        visible.insert(visible.end(), task.visible.begin(), task.visible.end());
+    }
+    
+    return visible;
+}
+
+
+uint32_t FrustumCuller::getObjectCount(void) const
+{
+    return static_cast<uint32_t>(order.size());
+}
+
+
+uint32_t FrustumCuller::getNodeCount(void) const
+{
+    return static_cast<uint32_t>(nodes.size());
+}
+
+
+void FrustumCuller::cullBruteForce(const std::vector<Bounds>& bounds, const Frustum& frustum, std::vector<uint32_t>& visible)
+{
+    visible.clear();
+    
+    for (uint32_t object = 0; object < bounds.size(); object++)
+    {
+        const Bounds& box = bounds[object];
+        bool outside = false;
+        
+        for (const auto& plane : frustum.planes)
+        {
+            const float px = plane[0] >= 0.0f ? box.max[0] : box.min[0];
+            const float py = plane[1] >= 0.0f ? box.max[1] : box.min[1];
+            const float pz = plane[2] >= 0.0f ? box.max[2] : box.min[2];
+            outside |= plane[0] * px + plane[1] * py + plane[2] * pz + plane[3] < 0.0f;
+        }
+        
+        if (!outside)
+        {
+            visible.push_back(object);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include "GpuTimer.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+
+double GpuInterval::durationMs(void) const
+{
+    return (endNs - beginNs) * 1e-6;
+}
+
+
+void GpuTimer::setupTimer(const VkPhysicalDevice physicalDevice, const VkDevice device, const uint32_t queueFamilyIndex, const uint32_t slotCount, const uint32_t sectionCount, const VkAllocationCallbacks* pAllocator)
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    
+    const uint32_t validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+    if (validBits == 0)
+    {
+        return;
+    }
+    
+    timestampPeriod = deviceProperties.limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? ~0ULL : ((1ULL << validBits) - 1);
+    this->sectionCount = sectionCount;
+    slotWritten.assign(slotCount, false);
+    
+    VkQueryPoolCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    createInfo.queryCount = (sectionCount + 1) * slotCount;
+    
+    if (capture::createQueryPool(device, &createInfo, pAllocator, &queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create timestamp query pool!");
+    }
+}
+
+
+void GpuTimer::destroyTimer(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    if (queryPool != VK_NULL_HANDLE)
+    {
+        capture::destroyQueryPool(device, queryPool, pAllocator);
+    }
+}
+
+
+void GpuTimer::cmdBegin(const VkCommandBuffer commandBuffer, const uint32_t slot)
+{
+    if (!isSupported()) return;
+    
+    capture::cmdResetQueryPool(commandBuffer, queryPool, (sectionCount + 1) * slot, sectionCount + 1);
+    capture::cmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, (sectionCount + 1) * slot);
+}
+
+
+void GpuTimer::cmdSplit(const VkCommandBuffer commandBuffer, const uint32_t slot, const uint32_t section)
+{
+    if (!isSupported()) return;
+    
+    capture::cmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, (sectionCount + 1) * slot + section + 1);
+}
+
+
+void GpuTimer::cmdEnd(const VkCommandBuffer commandBuffer, const uint32_t slot)
+{
+    if (!isSupported()) return;
+    
+    capture::cmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, (sectionCount + 1) * slot + sectionCount);
+    slotWritten[slot] = true;
+}
+
+
+bool GpuTimer::readInterval(const VkDevice device, const uint32_t slot, GpuInterval& interval)
+{
+    std::vector<GpuInterval> sections;
+    if (!readSections(device, slot, sections))
+    {
+        return false;
+    }
+    
+    interval.beginNs = sections.front().beginNs;
+    interval.endNs = sections.back().endNs;
+    
+    return true;
+}
+
+
+bool GpuTimer::readSections(const VkDevice device, const uint32_t slot, std::vector<GpuInterval>& sections)
+{
+    if (!isSupported() || !slotWritten[slot])
+    {
+        return false;
+    }
+    
+    std::vector<uint64_t> timestamps(sectionCount + 1);
+    if (vkGetQueryPoolResults(device, queryPool, (sectionCount + 1) * slot, sectionCount + 1, timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        return false;
+    }
+    
+    sections.resize(sectionCount);
+    for (uint32_t i = 0; i < sectionCount; i++)
+    {
+        sections[i].beginNs = static_cast<double>(timestamps[i] & timestampMask) * timestampPeriod;
+        sections[i].endNs = static_cast<double>(timestamps[i + 1] & timestampMask) * timestampPeriod;
+    }
+    
+    return true;
+}
+
+
+bool GpuTimer::isSupported(void) const
+{
+    return queryPool != VK_NULL_HANDLE;
+}
+
+
+void OverlapStats::addFrame(const GpuInterval& compute, const GpuInterval& graphics, const double cpuFrameMs)
+{
+    // Timestamps from different queues share a timebase on common drivers, but the spec
+    // does not guarantee it, so the overlap is an estimate
+    const double overlapNs = std::min(compute.endNs, graphics.endNs) - std::max(compute.beginNs, graphics.beginNs);
+    
+    frameCount++;
+    computeMs += compute.durationMs();
+    graphicsMs += graphics.durationMs();
+    overlapMs += std::max(overlapNs, 0.0) * 1e-6;
+    this->cpuFrameMs += cpuFrameMs;
+}
+
+
+void OverlapStats::report(std::ostream& os, const bool asyncCompute) const
+{
+    if (frameCount == 0) return;
+    
+    const double n = static_cast<double>(frameCount);
+    const double hidden = computeMs > 0.0 ? 100.0 * overlapMs / computeMs : 0.0;
+    
+    os << std::fixed << std::setprecision(3)
+       << "[timing] async compute: " << (asyncCompute ? "on" : "off")
+       << " | frames: " << frameCount
+       << " | compute: " << computeMs / n << " ms"
+       << " | graphics: " << graphicsMs / n << " ms"
+       << " | overlap: " << overlapMs / n << " ms (" << std::setprecision(1) << hidden << "% of compute hidden)"
+       << std::setprecision(3) << " | cpu frame: " << cpuFrameMs / n << " ms" << '\n';
+}
+
+
+void OverlapStats::reset(void)
+{
+    *this = OverlapStats{};
+}
+
+
+uint32_t OverlapStats::getFrameCount(void) const
+{
+    return frameCount;
+}
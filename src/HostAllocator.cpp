@@ -0,0 +1,435 @@
+#include "HostAllocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+
+namespace
+{
+    // Stored right before every pointer handed to the driver, frees carry no size otherwise
+    struct alignas(16) AllocationHeader
+    {
+        void* base;
+        size_t size;
+        uint32_t scope;
+        uint32_t fromArena;
+    };
+    
+    constexpr size_t HEADER_SIZE = sizeof(AllocationHeader);
+    
+    
+    uintptr_t alignUp(const uintptr_t value, const size_t alignment)
+    {
+        return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    }
+    
+    
+    AllocationHeader* getHeader(void* pMemory)
+    {
+        return reinterpret_cast<AllocationHeader*>(static_cast<char*>(pMemory) - HEADER_SIZE);
+    }
+    
+    
+    void updatePeak(std::atomic<int64_t>& peak, const int64_t value)
+    {
+        int64_t current = peak.load(std::memory_order_relaxed);
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+    
+    
+    const char* scopeName(const uint32_t scope)
+    {
+        static const char* names[] = {"COMMAND", "OBJECT", "CACHE", "DEVICE", "INSTANCE"};
+        return scope < 5 ? names[scope] : "UNKNOWN";
+    }
+    
+    
+    const char* objectTypeName(const VkObjectType objectType)
+    {
+        switch (objectType)
+        {
+            case VK_OBJECT_TYPE_INSTANCE: return "instance";
+            case VK_OBJECT_TYPE_DEVICE: return "device";
+            case VK_OBJECT_TYPE_SURFACE_KHR: return "surface";
+            case VK_OBJECT_TYPE_SWAPCHAIN_KHR: return "swapchain";
+            case VK_OBJECT_TYPE_IMAGE_VIEW: return "image view";
+            case VK_OBJECT_TYPE_FRAMEBUFFER: return "framebuffer";
+            case VK_OBJECT_TYPE_RENDER_PASS: return "render pass";
+            case VK_OBJECT_TYPE_PIPELINE: return "pipeline";
+            case VK_OBJECT_TYPE_PIPELINE_LAYOUT: return "pipeline layout";
+            case VK_OBJECT_TYPE_SHADER_MODULE: return "shader module";
+            case VK_OBJECT_TYPE_COMMAND_POOL: return "command pool";
+            case VK_OBJECT_TYPE_SEMAPHORE: return "semaphore";
+            case VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT: return "debug messenger";
+            default: return "other";
+        }
+    }
+    
+    
+    void printBytes(std::ostream& os, const double bytes)
+    {
+        if (bytes >= 1024.0 * 1024.0)
+        {
+            os << bytes / (1024.0 * 1024.0) << " MiB";
+        } else if (bytes >= 1024.0)
+        {
+            os << bytes / 1024.0 << " KiB";
+        } else
+        {
+            os << bytes << " B";
+        }
+    }
+}
+
+
+HostAllocatorMode HostAllocator::modeFromEnvironment(const HostAllocatorMode defaultMode)
+{
+    const char* value = std::getenv("VULKAN_HOST_ALLOCATOR");
+    if (value == nullptr)
+    {
+        return defaultMode;
+    }
+    
+    const std::string mode(value);
+    if (mode == "driver") return HostAllocatorMode::Driver;
+    if (mode == "tracking") return HostAllocatorMode::Tracking;
+    if (mode == "arena") return HostAllocatorMode::Arena;
+    
+    std::cerr << "Unknown VULKAN_HOST_ALLOCATOR value \"" << mode << "\", using the default" << std::endl;
+    return defaultMode;
+}
+
+
+void HostAllocator::setupAllocator(const HostAllocatorMode mode, const size_t arenaBlockSize)
+{
+    this->mode = mode;
+    this->arenaBlockSize = arenaBlockSize;
+    
+    if (mode == HostAllocatorMode::Arena)
+    {
+        arenaBlocks.push_back({std::make_unique<char[]>(arenaBlockSize), arenaBlockSize});
+    }
+}
+
+
+void HostAllocator::destroyAllocator(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        slots.clear();
+    }
+    arenaBlocks.clear();
+}
+
+
+HostAllocator::TypeSlot& HostAllocator::getSlot(const VkObjectType objectType)
+{
+    std::lock_guard<std::mutex> lock(slotMutex);
+    for (auto& slot : slots)
+    {
+        if (slot->objectType == objectType)
+        {
+            return *slot;
+        }
+    }
+    
+    slots.push_back(std::make_unique<TypeSlot>());
+    TypeSlot& slot = *slots.back();
+    slot.owner = this;
+    slot.objectType = objectType;
+    slot.callbacks.pUserData = &slot;
+    slot.callbacks.pfnAllocation = allocationCallback;
+    slot.callbacks.pfnReallocation = reallocationCallback;
+    slot.callbacks.pfnFree = freeCallback;
+    slot.callbacks.pfnInternalAllocation = internalAllocationCallback;
+    slot.callbacks.pfnInternalFree = internalFreeCallback;
+    
+    return slot;
+}
+
+
+const VkAllocationCallbacks* HostAllocator::getCallbacks(const VkObjectType objectType)
+{
+    if (mode == HostAllocatorMode::Driver)
+    {
+        return nullptr;
+    }
+    
+    return &getSlot(objectType).callbacks;
+}
+
+
+const VkAllocationCallbacks* HostAllocator::callbacksFor(HostAllocator* hostAllocator, const VkObjectType objectType)
+{
+    return hostAllocator == nullptr ? nullptr : hostAllocator->getCallbacks(objectType);
+}
+
+
+void* HostAllocator::allocateFromArena(const size_t size, const size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    
+    const size_t worstCase = size + alignment + HEADER_SIZE;
+    while (true)
+    {
+        if (arenaBlock == arenaBlocks.size())
+        {
+            const size_t blockSize = std::max(arenaBlockSize, worstCase);
+            arenaBlocks.push_back({std::make_unique<char[]>(blockSize), blockSize});
+        }
+        
+        const ArenaBlock& block = arenaBlocks[arenaBlock];
+        const uintptr_t blockStart = reinterpret_cast<uintptr_t>(block.data.get());
+        const uintptr_t user = alignUp(blockStart + arenaOffset + HEADER_SIZE, alignment);
+        
+        if (user + size <= blockStart + block.size)
+        {
+            arenaOffset = user + size - blockStart;
+            arenaFrameBytes += size;
+            arenaLiveAllocations.fetch_add(1, std::memory_order_relaxed);
+            
+            return reinterpret_cast<void*>(user);
+        }
+        
+        arenaBlock++;
+        arenaOffset = 0;
+    }
+}
+
+
+void* HostAllocator::allocate(TypeSlot& slot, const size_t size, const size_t alignment, const VkSystemAllocationScope scope)
+{
+    const size_t effectiveAlignment = std::max(alignment, alignof(AllocationHeader));
+    
+    void* base = nullptr;
+    void* pMemory = nullptr;
+    
+    // COMMAND-scope memory never outlives the Vulkan call that allocated it
+    if (mode == HostAllocatorMode::Arena && scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND)
+    {
+        pMemory = allocateFromArena(size, effectiveAlignment);
+    } else
+    {
+        base = std::malloc(size + effectiveAlignment + HEADER_SIZE);
+        if (base == nullptr)
+        {
+            return nullptr;
+        }
+        
+        pMemory = reinterpret_cast<void*>(alignUp(reinterpret_cast<uintptr_t>(base) + HEADER_SIZE, effectiveAlignment));
+    }
+    
+    AllocationHeader* header = getHeader(pMemory);
+    header->base = base;
+    header->size = size;
+    header->scope = static_cast<uint32_t>(scope);
+    header->fromArena = base == nullptr ? 1 : 0;
+    
+    ScopeCounters& counters = slot.scopes[scope];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.totalBytes.fetch_add(size, std::memory_order_relaxed);
+    updatePeak(counters.peakBytes, counters.liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size));
+    
+    if (header->fromArena)
+    {
+        counters.arenaAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    return pMemory;
+}
+
+
+void HostAllocator::release(TypeSlot& slot, void* pMemory)
+{
+    if (pMemory == nullptr)
+    {
+        return;
+    }
+    
+    const AllocationHeader* header = getHeader(pMemory);
+    
+    ScopeCounters& counters = slot.scopes[header->scope];
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.liveBytes.fetch_sub(static_cast<int64_t>(header->size), std::memory_order_relaxed);
+    
+    if (header->fromArena)
+    {
+        arenaLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+    } else
+    {
+        std::free(header->base);
+    }
+}
+
+
+void HostAllocator::resetArena(void)
+{
+    if (mode != HostAllocatorMode::Arena)
+    {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    
+    if (arenaLiveAllocations.load(std::memory_order_relaxed) > 0)
+    {
+        arenaSkippedResets++;
+        return;
+    }
+    
+    // A frame that spilled into several blocks gets one block big enough for all of them
+    if (arenaBlocks.size() > 1)
+    {
+        size_t totalSize = 0;
+        for (const auto& block : arenaBlocks)
+        {
+            totalSize += block.size;
+        }
+        
+        arenaBlocks.clear();
+        arenaBlocks.push_back({std::make_unique<char[]>(totalSize), totalSize});
+    }
+    
+    arenaPeakBytes = std::max(arenaPeakBytes, arenaFrameBytes);
+    arenaFrameBytes = 0;
+    arenaBlock = 0;
+    arenaOffset = 0;
+    arenaResets++;
+}
+
+
+void HostAllocator::report(std::ostream& os) const
+{
+    if (mode == HostAllocatorMode::Driver)
+    {
+        return;
+    }
+    
+    os << std::fixed << std::setprecision(1);
+    
+    if (mode == HostAllocatorMode::Arena)
+    {
+        std::lock_guard<std::mutex> lock(arenaMutex);
+        
+        size_t arenaSize = 0;
+        for (const auto& block : arenaBlocks)
+        {
+            arenaSize += block.size;
+        }
+        
+        os << "[host-alloc] arena: ";
+        printBytes(os, static_cast<double>(arenaSize));
+        os << " in " << arenaBlocks.size() << " block(s) | peak ";
+        printBytes(os, static_cast<double>(std::max(arenaPeakBytes, arenaFrameBytes)));
+        os << "/frame | resets: " << arenaResets << " (skipped " << arenaSkippedResets << ")" << '\n';
+    }
+    
+    std::lock_guard<std::mutex> lock(slotMutex);
+    for (const auto& slot : slots)
+    {
+        for (uint32_t scope = 0; scope < SCOPE_COUNT; scope++)
+        {
+            const ScopeCounters& counters = slot->scopes[scope];
+            const uint64_t allocations = counters.allocations.load(std::memory_order_relaxed);
+            if (allocations == 0)
+            {
+                continue;
+            }
+            
+            os << "[host-alloc] " << std::left << std::setw(16) << objectTypeName(slot->objectType) << std::setw(9) << scopeName(scope) << std::right
+               << "allocs: " << allocations
+               << " | reallocs: " << counters.reallocations.load(std::memory_order_relaxed)
+               << " | frees: " << counters.frees.load(std::memory_order_relaxed)
+               << " | arena: " << counters.arenaAllocations.load(std::memory_order_relaxed)
+               << " | live: ";
+            printBytes(os, static_cast<double>(counters.liveBytes.load(std::memory_order_relaxed)));
+            os << " | peak: ";
+            printBytes(os, static_cast<double>(counters.peakBytes.load(std::memory_order_relaxed)));
+            os << " | total: ";
+            printBytes(os, static_cast<double>(counters.totalBytes.load(std::memory_order_relaxed)));
+            os << '\n';
+        }
+    }
+    
+    for (uint32_t scope = 0; scope < SCOPE_COUNT; scope++)
+    {
+        if (internalAllocations[scope].load(std::memory_order_relaxed) > 0)
+        {
+            os << "[host-alloc] driver internal " << scopeName(scope) << " allocs: " << internalAllocations[scope].load(std::memory_order_relaxed) << " | live: ";
+            printBytes(os, static_cast<double>(internalLiveBytes[scope].load(std::memory_order_relaxed)));
+            os << '\n';
+        }
+    }
+}
+
+
+HostAllocatorMode HostAllocator::getMode(void) const
+{
+    return mode;
+}
+
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::allocationCallback(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    TypeSlot& slot = *static_cast<TypeSlot*>(pUserData);
+    return slot.owner->allocate(slot, size, alignment, scope);
+}
+
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::reallocationCallback(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    TypeSlot& slot = *static_cast<TypeSlot*>(pUserData);
+    
+    if (pOriginal == nullptr)
+    {
+        return slot.owner->allocate(slot, size, alignment, scope);
+    }
+    
+    if (size == 0)
+    {
+        slot.owner->release(slot, pOriginal);
+        return nullptr;
+    }
+    
+    // On failure the original allocation must stay valid
+    void* pMemory = slot.owner->allocate(slot, size, alignment, scope);
+    if (pMemory == nullptr)
+    {
+        return nullptr;
+    }
+    
+    std::memcpy(pMemory, pOriginal, std::min(size, getHeader(pOriginal)->size));
+    slot.owner->release(slot, pOriginal);
+    slot.scopes[scope].reallocations.fetch_add(1, std::memory_order_relaxed);
+    
+    return pMemory;
+}
+
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::freeCallback(void* pUserData, void* pMemory)
+{
+    TypeSlot& slot = *static_cast<TypeSlot*>(pUserData);
+    slot.owner->release(slot, pMemory);
+}
+
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocationCallback(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+    HostAllocator* owner = static_cast<TypeSlot*>(pUserData)->owner;
+    owner->internalAllocations[scope].fetch_add(1, std::memory_order_relaxed);
+    owner->internalLiveBytes[scope].fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+}
+
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFreeCallback(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+    HostAllocator* owner = static_cast<TypeSlot*>(pUserData)->owner;
+    owner->internalLiveBytes[scope].fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+}
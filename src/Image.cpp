@@ -0,0 +1,194 @@
+#include "Image.hpp"
+#include "Buffer.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+
+
+void Image::populateImageCreateInfo(VkImageCreateInfo& createInfo, const uint32_t mipLevels, const VkImageUsageFlags usage, const std::vector<uint32_t>& queueFamilies)
+{
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    createInfo.format = format;
+    createInfo.extent = {extent.width, extent.height, 1};
+    createInfo.mipLevels = mipLevels;
+    createInfo.arrayLayers = 1;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    createInfo.usage = usage;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    
+    if (queueFamilies.size() > 1)
+    {
+        createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+        createInfo.pQueueFamilyIndices = queueFamilies.data();
+    } else
+    {
+        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+}
+
+
+VkImageView Image::createView(const VkDevice device, const uint32_t baseMipLevel, const uint32_t levelCount, const VkAllocationCallbacks* pAllocator)
+{
+    VkImageViewCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    createInfo.image = image;
+    createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    createInfo.format = format;
+    createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    createInfo.subresourceRange.baseMipLevel = baseMipLevel;
+    createInfo.subresourceRange.levelCount = levelCount;
+    createInfo.subresourceRange.baseArrayLayer = 0;
+    createInfo.subresourceRange.layerCount = 1;
+    
+    VkImageView imageView;
+    if (capture::createImageView(device, &createInfo, pAllocator, &imageView) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create image view!");
+    }
+    
+    return imageView;
+}
+
+
+void Image::setupImage(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkExtent2D extent, const VkFormat format, const uint32_t mipLevels, const VkImageUsageFlags usage, const std::vector<uint32_t>& queueFamilies, HostAllocator* hostAllocator)
+{
+    this->extent = extent;
+    this->format = format;
+    
+    std::vector<uint32_t> uniqueFamilies;
+    for (uint32_t family : queueFamilies)
+    {
+        if (std::find(uniqueFamilies.begin(), uniqueFamilies.end(), family) == uniqueFamilies.end())
+        {
+            uniqueFamilies.push_back(family);
+        }
+    }
+    
+    VkImageCreateInfo createInfo{};
+    populateImageCreateInfo(createInfo, mipLevels, usage, uniqueFamilies);
+    
+    if (capture::createImage(device, &createInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE), &image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create image!");
+    }
+    
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, image, &memRequirements);
+    
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = Buffer::findMemoryType(physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    
+    if (capture::allocateMemory(device, &allocInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DEVICE_MEMORY), &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate image memory!");
+    }
+    
+    capture::bindImageMemory(device, image, memory, 0);
+    
+    view = createView(device, 0, mipLevels, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE_VIEW));
+    mipViews.resize(mipLevels);
+    for (uint32_t i = 0; i < mipLevels; i++)
+    {
+        mipViews[i] = mipLevels == 1 ? view : createView(device, i, 1, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE_VIEW));
+    }
+}
+
+
+void Image::destroyImage(const VkDevice device, HostAllocator* hostAllocator)
+{
+    for (const VkImageView mipView : mipViews)
+    {
+        if (mipView != view)
+        {
+            capture::destroyImageView(device, mipView, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE_VIEW));
+        }
+    }
+    mipViews.clear();
+    
+    if (view != VK_NULL_HANDLE)
+    {
+        capture::destroyImageView(device, view, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE_VIEW));
+    }
+    
+    if (image != VK_NULL_HANDLE)
+    {
+        capture::destroyImage(device, image, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE));
+    }
+    
+    if (memory != VK_NULL_HANDLE)
+    {
+        capture::freeMemory(device, memory, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+}
+
+
+void Image::deferDestroy(DeletionQueue& deletionQueue, const uint32_t frame, HostAllocator* hostAllocator)
+{
+    for (const VkImageView mipView : mipViews)
+    {
+        if (mipView != view)
+        {
+            deletionQueue.deferImageView(frame, mipView, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE_VIEW));
+        }
+    }
+    mipViews.clear();
+    
+    if (view != VK_NULL_HANDLE)
+    {
+        deletionQueue.deferImageView(frame, view, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE_VIEW));
+        view = VK_NULL_HANDLE;
+    }
+    
+    if (image != VK_NULL_HANDLE)
+    {
+        deletionQueue.deferImage(frame, image, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_IMAGE));
+        image = VK_NULL_HANDLE;
+    }
+    
+    if (memory != VK_NULL_HANDLE)
+    {
+        deletionQueue.deferMemory(frame, memory, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DEVICE_MEMORY));
+        memory = VK_NULL_HANDLE;
+    }
+}
+
+
+const VkImage Image::getImage(void) const
+{
+    return image;
+}
+
+
+const VkImageView Image::getView(void) const
+{
+    return view;
+}
+
+
+const VkImageView Image::getMipView(const uint32_t mipLevel) const
+{
+    return mipViews[mipLevel];
+}
+
+
+const VkExtent2D Image::getExtent(const uint32_t mipLevel) const
+{
+    return {std::max(extent.width >> mipLevel, 1u), std::max(extent.height >> mipLevel, 1u)};
+}
+
+
+const VkFormat Image::getFormat(void) const
+{
+    return format;
+}
+
+
+const uint32_t Image::getMipLevels(void) const
+{
+    return static_cast<uint32_t>(mipViews.size());
+}
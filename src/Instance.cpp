@@ -1,6 +1,9 @@
 #include "Instance.hpp"
 #include "ValLayers.hpp"
 
+#include <algorithm>
+#include <string>
+
 
 stringVector Instance::getRequiredInstanceExtensions(void)
 {
@@ -14,18 +17,66 @@ stringVector Instance::getRequiredInstanceExtensions(void)
     {
         extensions.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
+
+    return extensions;
+}
+
+
+InstanceCapabilities Instance::negotiateCapabilities(stringVector& extensions)
+{
+    InstanceCapabilities capabilities;
     
-    if (MOLTEN_VK)
+    // vkEnumerateInstanceVersion does not exist on a 1.0 loader
+    auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion) vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+    if (enumerateInstanceVersion != nullptr)
+    {
+        enumerateInstanceVersion(&capabilities.apiVersion);
+    }
+    capabilities.apiVersion = std::min(capabilities.apiVersion, MAX_API_VERSION);
+    
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+    
+    std::set<std::string> available;
+    for (const auto& extension : availableExtensions)
+    {
+        available.insert(extension.extensionName);
+    }
+    
+    for (const char* extension : extensions)
+    {
+        if (available.count(extension) == 0)
+        {
+            throw std::runtime_error(std::string("Required instance extension ") + extension + " is not available!");
+        }
+    }
+    
+    // Portability drivers such as MoltenVK are only enumerated when this is enabled
+    if (available.count(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME) > 0)
     {
         extensions.emplace_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
-        extensions.emplace_back("VK_KHR_get_physical_device_properties2");
+        capabilities.portabilityEnumeration = true;
     }
-
-    return extensions;
+    
+    // Core since 1.1, needed for the device feature chain queries
+    if (capabilities.apiVersion >= VK_API_VERSION_1_1)
+    {
+        capabilities.physicalDeviceProperties2 = true;
+    } else if (available.count(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) > 0)
+    {
+        extensions.emplace_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        capabilities.physicalDeviceProperties2 = true;
+    }
+    
+    capabilities.extensions = std::set<std::string>(extensions.begin(), extensions.end());
+    
+    return capabilities;
 }
 
 
-void Instance::populateInstanceCreateInfo(VkInstanceCreateInfo& createInfo, VkApplicationInfo& appInfo, VkDebugUtilsMessengerCreateInfoEXT& debugCreateInfo, stringVector& extensions)
+void Instance::populateInstanceCreateInfo(VkInstanceCreateInfo& createInfo, VkApplicationInfo& appInfo, VkDebugUtilsMessengerCreateInfoEXT& debugCreateInfo, stringVector& extensions, const InstanceCapabilities& capabilities)
 {
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
@@ -33,7 +84,7 @@ void Instance::populateInstanceCreateInfo(VkInstanceCreateInfo& createInfo, VkAp
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
     
-    if (MOLTEN_VK)
+    if (capabilities.portabilityEnumeration)
     {
         createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
     }
@@ -53,12 +104,12 @@ void Instance::populateInstanceCreateInfo(VkInstanceCreateInfo& createInfo, VkAp
 }
 
 
-void Instance::populateApplicationInfo(VkApplicationInfo& appInfo)
+void Instance::populateApplicationInfo(VkApplicationInfo& appInfo, const uint32_t apiVersion)
 {
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName = "Hello Triangle";
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = apiVersion;
 }
@@ -0,0 +1,445 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+// Chunks per thread a parallel for starts from, before adaptive splitting takes over
+static constexpr uint32_t CHUNKS_PER_THREAD = 8;
+
+// The system and index of the calling thread, set for the thread that called setupJobSystem and for its workers
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local uint32_t currentIndex = 0;
+
+
+static uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+
+bool JobCounter::isDone(void) const
+{
+    return pending.load(std::memory_order_acquire) == 0;
+}
+
+
+void JobCounter::fail(std::exception_ptr error)
+{
+    if (!failed.exchange(true))
+    {
+        failure = error;
+    }
+}
+
+
+JobSystemConfig JobSystem::configFromEnvironment(const uint32_t defaultWorkers)
+{
+    JobSystemConfig config;
+    config.workerCount = defaultWorkers;
+    
+    const char* workers = std::getenv("VULKAN_JOB_WORKERS");
+    if (workers != nullptr)
+    {
+        char* end = nullptr;
+        const long count = std::strtol(workers, &end, 10);
+        if (end != workers && *end == '\0' && count >= 0)
+        {
+            config.workerCount = static_cast<uint32_t>(count);
+        } else
+        {
+            std::cerr << "Unknown VULKAN_JOB_WORKERS value \"" << workers << "\", using the default" << std::endl;
+        }
+    }
+    
+    const char* affinity = std::getenv("VULKAN_JOB_AFFINITY");
+    if (affinity != nullptr)
+    {
+        const std::string setting(affinity);
+        if (setting == "on") config.pinThreads = true;
+        else if (setting == "off") config.pinThreads = false;
+        else std::cerr << "Unknown VULKAN_JOB_AFFINITY value \"" << setting << "\", using the default" << std::endl;
+    }
+    
+    return config;
+}
+
+
+uint32_t JobSystem::getCoreWorkerCount(void)
+{
+    return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+}
+
+
+void JobSystem::setupJobSystem(const JobSystemConfig& config)
+{
+    this->config = config;
+    threadCount = config.workerCount + 1;
+    threadStates = std::make_unique<ThreadState[]>(threadCount);
+    
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        threadStates[i].pool = std::make_unique<Job[]>(JOB_POOL_SIZE);
+        threadStates[i].stealSeed = 0x9e3779b9u * (i + 1);
+    }
+    
+    // A system set up from a thread of another one, as a tool running its own task graph would, hands the
+    // thread back on destroy
+    previousSystem = currentSystem;
+    previousIndex = currentIndex;
+    currentSystem = this;
+    currentIndex = 0;
+    pinThread(0);
+    
+    running.store(true);
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+
+void JobSystem::destroyJobSystem(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running.store(false);
+    }
+    wakeCondition.notify_all();
+    
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+    
+    if (currentSystem == this)
+    {
+        currentSystem = previousSystem;
+        currentIndex = previousIndex;
+    }
+    
+    threadStates.reset();
+    threadCount = 0;
+    queuedCount.store(0);
+}
+
+
+uint32_t JobSystem::getThreadIndex(void) const
+{
+    if (currentSystem != this)
+    {
+        throw std::runtime_error("Jobs can only be submitted and waited for on the threads of their job system!");
+    }
+    
+    return currentIndex;
+}
+
+
+Job& JobSystem::allocateJob(void)
+{
+    const uint32_t index = getThreadIndex();
+    ThreadState& state = threadStates[index];
+    
+    // The pool is a ring. Slots still in use, queued or running further up this thread's stack, are skipped;
+    // with every slot taken this thread is far ahead of the others and helps out until one is handed back
+    while (true)
+    {
+        for (uint32_t i = 0; i < JOB_POOL_SIZE; i++)
+        {
+            Job& job = state.pool[state.nextJob++ & (JOB_POOL_SIZE - 1)];
+            if (!job.inUse.load(std::memory_order_acquire))
+            {
+                job.inUse.store(true, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        
+        Job* other = findJob(index);
+        if (other != nullptr)
+        {
+            runJob(*other);
+        } else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+void JobSystem::pushJob(Job& job)
+{
+    if (job.counter != nullptr)
+    {
+        job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    ThreadState& state = threadStates[currentIndex];
+    if (!state.deque.push(&job))
+    {
+        state.runInline.fetch_add(1, std::memory_order_relaxed);
+        runJob(job);
+        return;
+    }
+    
+    // Pairs with the check a worker makes under sleepMutex before it sleeps, so a new job is never missed
+    queuedCount.fetch_add(1);
+    if (sleepingCount.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+
+Job* JobSystem::findJob(const uint32_t index)
+{
+    ThreadState& state = threadStates[index];
+    
+    Job* job = nullptr;
+    if (state.deque.pop(job))
+    {
+        queuedCount.fetch_sub(1);
+        return job;
+    }
+    
+    // Victims are tried from a random start so thieves spread over the other threads
+    const uint32_t start = nextRandom(state.stealSeed);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        const uint32_t victim = (start + i) % threadCount;
+        if (victim != index && threadStates[victim].deque.steal(job))
+        {
+            queuedCount.fetch_sub(1);
+            state.stolen.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    
+    return nullptr;
+}
+
+
+void JobSystem::runJob(Job& job)
+{
+    JobCounter* counter = job.counter;
+    
+    std::exception_ptr error;
+    try
+    {
+        job.function(job);
+    } catch (...)
+    {
+        error = std::current_exception();
+    }
+    
+    threadStates[currentIndex].executed.fetch_add(1, std::memory_order_relaxed);
+    job.inUse.store(false, std::memory_order_release);
+    
+    // With nobody waiting on a counter the exception goes to whoever ran the job
+    if (counter == nullptr)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        return;
+    }
+    
+    if (error)
+    {
+        counter->fail(error);
+    }
+    
+    // Last, the waiter may release the counter as soon as it reaches zero
+    counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+
+bool JobSystem::runPendingJob(void)
+{
+    Job* job = findJob(getThreadIndex());
+    if (job == nullptr)
+    {
+        return false;
+    }
+    
+    runJob(*job);
+    return true;
+}
+
+
+void JobSystem::wait(JobCounter& counter)
+{
+    const uint32_t index = getThreadIndex();
+    
+    while (!counter.isDone())
+    {
+        Job* job = findJob(index);
+        if (job != nullptr)
+        {
+            runJob(*job);
+        } else
+        {
+            std::this_thread::yield();
+        }
+    }
+    
+    if (counter.failed.load())
+    {
+        std::rethrow_exception(counter.failure);
+    }
+}
+
+
+void JobSystem::runParallelFor(const uint32_t begin, const uint32_t end, const uint32_t minChunk, const RangeFunction& range)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    
+    const uint32_t count = end - begin;
+    const uint32_t grain = std::max({minChunk, count / (threadCount * CHUNKS_PER_THREAD), 1u});
+    if (threadCount == 1 || count <= grain)
+    {
+        range.call(range.context, begin, end);
+        return;
+    }
+    
+    // The calling thread takes the whole range as if it were a job of the batch, so an exception it throws is
+    // held until the halves it handed out have finished with the counter
+    JobCounter counter;
+    counter.pending.store(1);
+    try
+    {
+        runRange(begin, end, grain, range, counter);
+    } catch (...)
+    {
+        counter.fail(std::current_exception());
+    }
+    counter.pending.fetch_sub(1, std::memory_order_acq_rel);
+    
+    wait(counter);
+}
+
+
+void JobSystem::runRange(uint32_t begin, uint32_t end, const uint32_t grain, const RangeFunction& range, JobCounter& counter)
+{
+    while (begin < end)
+    {
+        // Lazy splitting: half of what is left goes out only while fewer jobs are queued than there are other
+        // threads to take them, otherwise the range runs on here a grain at a time and checks again
+        if (end - begin > grain && queuedCount.load(std::memory_order_relaxed) < static_cast<int32_t>(threadCount - 1))
+        {
+            const uint32_t middle = begin + (end - begin) / 2;
+            submit([this, middle, end, grain, &range, &counter]
+            {
+                runRange(middle, end, grain, range, counter);
+            }, &counter);
+            end = middle;
+            continue;
+        }
+        
+        const uint32_t chunkEnd = begin + std::min(grain, end - begin);
+        range.call(range.context, begin, chunkEnd);
+        begin = chunkEnd;
+    }
+}
+
+
+void JobSystem::pinThread(const uint32_t index) const
+{
+    if (!config.pinThreads)
+    {
+        return;
+    }
+
+#ifdef __linux__
+    const uint32_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cores, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    {
+        std::cerr << "[jobs] could not pin thread " << index << " to core " << index % cores << std::endl;
+    }
+#endif
+}
+
+
+void JobSystem::workerLoop(const uint32_t index)
+{
+    currentSystem = this;
+    currentIndex = index;
+    pinThread(index);
+    
+    ThreadState& state = threadStates[index];
+    uint32_t idleSpins = 0;
+    
+    while (running.load(std::memory_order_relaxed))
+    {
+        Job* job = findJob(index);
+        if (job != nullptr)
+        {
+            runJob(*job);
+            idleSpins = 0;
+            continue;
+        }
+        
+        if (++idleSpins < JOB_IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingCount.fetch_add(1);
+        state.sleeps.fetch_add(1, std::memory_order_relaxed);
+        wakeCondition.wait(lock, [this] { return queuedCount.load() > 0 || !running.load(); });
+        sleepingCount.fetch_sub(1);
+        idleSpins = 0;
+    }
+}
+
+
+const uint32_t JobSystem::getWorkerCount(void) const
+{
+    return threadCount > 0 ? threadCount - 1 : 0;
+}
+
+
+JobStats JobSystem::getStats(void) const
+{
+    JobStats stats;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        const ThreadState& state = threadStates[i];
+        stats.executed += state.executed.load(std::memory_order_relaxed);
+        stats.stolen += state.stolen.load(std::memory_order_relaxed);
+        stats.runInline += state.runInline.load(std::memory_order_relaxed);
+        stats.sleeps += state.sleeps.load(std::memory_order_relaxed);
+    }
+    
+    return stats;
+}
+
+
+void JobSystem::report(std::ostream& os) const
+{
+    const JobStats stats = getStats();
+    os << "[jobs] " << threadCount << " threads" << (config.pinThreads ? " pinned" : "") << ": " << stats.executed << " jobs, "
+       << stats.stolen << " stolen, " << stats.runInline << " run inline, " << stats.sleeps << " sleeps" << std::endl;
+}
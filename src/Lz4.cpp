@@ -0,0 +1,218 @@
+#include "Lz4.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+
+static constexpr size_t MIN_MATCH = 4;
+// The last match has to start this far from the end and leave LAST_LITERALS bytes after it
+static constexpr size_t MATCH_FIND_LIMIT = 12;
+static constexpr size_t LAST_LITERALS = 5;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr uint32_t HASH_BITS = 12;
+
+
+static uint32_t read32(const char* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+
+static uint32_t hashSequence(const uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+
+// Token nibbles stop at 15, the rest follows as a run of 255 bytes and a remainder
+static void writeLength(std::vector<char>& output, size_t length)
+{
+    while (length >= 255)
+    {
+        output.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+
+static void writeSequence(std::vector<char>& output, const char* literals, const size_t literalCount, const size_t offset, const size_t matchLength)
+{
+    const size_t matchCode = matchLength - MIN_MATCH;
+    const uint8_t token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4 | (matchCode < 15 ? matchCode : 15));
+    output.push_back(static_cast<char>(token));
+    if (literalCount >= 15)
+    {
+        writeLength(output, literalCount - 15);
+    }
+    output.insert(output.end(), literals, literals + literalCount);
+    
+    output.push_back(static_cast<char>(offset & 0xff));
+    output.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15)
+    {
+        writeLength(output, matchCode - 15);
+    }
+}
+
+
+std::vector<char> lz4::compress(const ByteView input)
+{
+    const char* source = input.data;
+    const size_t size = input.size;
+    
+    std::vector<char> output;
+    output.reserve(size + size / 255 + 16);
+    
+    size_t anchor = 0;
+    if (size > MATCH_FIND_LIMIT)
+    {
+        std::vector<int64_t> table(size_t(1) << HASH_BITS, -1);
+        const size_t findLimit = size - MATCH_FIND_LIMIT;
+        const size_t matchLimit = size - LAST_LITERALS;
+        
+        size_t position = 0;
+        // Steps grow through incompressible data so it costs little more than a copy
+        uint32_t misses = 0;
+        while (position < findLimit)
+        {
+            const uint32_t sequence = read32(source + position);
+            const uint32_t hash = hashSequence(sequence);
+            const int64_t candidate = table[hash];
+            table[hash] = static_cast<int64_t>(position);
+            
+            if (candidate < 0 || position - static_cast<size_t>(candidate) > MAX_OFFSET || read32(source + candidate) != sequence)
+            {
+                position += 1 + (misses++ >> 6);
+                continue;
+            }
+            
+            size_t match = static_cast<size_t>(candidate);
+            size_t length = MIN_MATCH;
+            while (position + length < matchLimit && source[match + length] == source[position + length])
+            {
+                length++;
+            }
+            // Runs ending in the same bytes often started earlier than the hash hit
+            while (position > anchor && match > 0 && source[position - 1] == source[match - 1])
+            {
+                position--;
+                match--;
+                length++;
+            }
+            
+            writeSequence(output, source + anchor, position - anchor, position - match, length);
+            position += length;
+            anchor = position;
+            misses = 0;
+            
+            if (position - 2 < findLimit)
+            {
+                table[hashSequence(read32(source + position - 2))] = static_cast<int64_t>(position - 2);
+            }
+        }
+    }
+    
+    // Closing sequence, literals only
+    const size_t literalCount = size - anchor;
+    output.push_back(static_cast<char>((literalCount < 15 ? literalCount : 15) << 4));
+    if (literalCount >= 15)
+    {
+        writeLength(output, literalCount - 15);
+    }
+    output.insert(output.end(), source + anchor, source + size);
+    
+    return output;
+}
+
+
+void lz4::decompress(const ByteView input, char* output, const size_t outputSize)
+{
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(input.data);
+    const size_t size = input.size;
+    size_t in = 0;
+    size_t out = 0;
+    
+    const auto readLength = [&](size_t length)
+    {
+        uint8_t byte;
+        do
+        {
+            if (in >= size)
+            {
+                throw std::runtime_error("Truncated LZ4 block!");
+            }
+            byte = source[in++];
+            length += byte;
+        } while (byte == 255);
+        return length;
+    };
+    
+    while (true)
+    {
+        if (in >= size)
+        {
+            throw std::runtime_error("Truncated LZ4 block!");
+        }
+        const uint8_t token = source[in++];
+        
+        size_t literalCount = token >> 4;
+        if (literalCount == 15)
+        {
+            literalCount = readLength(literalCount);
+        }
+        if (literalCount > size - in || literalCount > outputSize - out)
+        {
+            throw std::runtime_error("Corrupt LZ4 block!");
+        }
+        std::memcpy(output + out, source + in, literalCount);
+        in += literalCount;
+        out += literalCount;
+        
+        if (in == size)
+        {
+            break;
+        }
+        
+        if (size - in < 2)
+        {
+            throw std::runtime_error("Truncated LZ4 block!");
+        }
+        const size_t offset = source[in] | source[in + 1] << 8;
+        in += 2;
+        
+        size_t matchLength = token & 15;
+        if (matchLength == 15)
+        {
+            matchLength = readLength(matchLength);
+        }
+        matchLength += MIN_MATCH;
+        
+        if (offset == 0 || offset > out || matchLength > outputSize - out)
+        {
+            throw std::runtime_error("Corrupt LZ4 block!");
+        }
+        
+        // Offsets shorter than the match repeat a pattern, those need the byte order
+        const char* match = output + out - offset;
+        if (offset >= matchLength)
+        {
+            std::memcpy(output + out, match, matchLength);
+        } else
+        {
+            for (size_t i = 0; i < matchLength; i++)
+            {
+                output[out + i] = match[i];
+            }
+        }
+        out += matchLength;
+    }
+    
+    if (out != outputSize)
+    {
+        throw std::runtime_error("LZ4 block does not match its size!");
+    }
+}
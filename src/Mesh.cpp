@@ -0,0 +1,199 @@
+#include "Mesh.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+
+static constexpr char MESH_MAGIC[4] = {'V', 'M', 'S', 'H'};
+static constexpr uint32_t MESH_VERSION = 2;
+
+struct MeshFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexLayout;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    uint32_t meshletVertexCount;
+    uint32_t meshletTriangleCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    VertexDequantization dequantization;
+};
+
+
+template <typename T>
+static void writeArray(std::ofstream& file, const std::vector<T>& data)
+{
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+}
+
+
+template <typename T>
+static void readArray(std::ifstream& file, std::vector<T>& data, const uint32_t count)
+{
+    data.resize(count);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+}
+
+
+void mesh::saveMesh(const std::string& path, const MeshData& mesh)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + " for writing!");
+    }
+    
+    MeshFileHeader header{};
+    std::memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+    header.version = MESH_VERSION;
+    header.vertexLayout = static_cast<uint32_t>(mesh.vertexLayout);
+    header.vertexCount = static_cast<uint32_t>(mesh.vertexLayout == VertexLayout::Quantized ? mesh.quantizedVertices.size() : mesh.vertices.size());
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+    header.meshletVertexCount = static_cast<uint32_t>(mesh.meshletVertices.size());
+    header.meshletTriangleCount = static_cast<uint32_t>(mesh.meshletTriangles.size());
+    std::memcpy(header.boundsMin, mesh.boundsMin, sizeof(header.boundsMin));
+    std::memcpy(header.boundsMax, mesh.boundsMax, sizeof(header.boundsMax));
+    header.dequantization = mesh.dequantization;
+    
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (mesh.vertexLayout == VertexLayout::Quantized)
+    {
+        writeArray(file, mesh.quantizedVertices);
+    } else
+    {
+        writeArray(file, mesh.vertices);
+    }
+    writeArray(file, mesh.indices);
+    writeArray(file, mesh.lods);
+    writeArray(file, mesh.meshlets);
+    writeArray(file, mesh.meshletVertices);
+    writeArray(file, mesh.meshletTriangles);
+    
+    if (!file.good())
+    {
+        throw std::runtime_error("Failed to write " + path + "!");
+    }
+}
+
+
+MeshData mesh::loadMesh(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    
+    MeshFileHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file.good() || std::memcmp(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC)) != 0 || header.version != MESH_VERSION)
+    {
+        throw std::runtime_error(path + " is not a version " + std::to_string(MESH_VERSION) + " mesh file!");
+    }
+    
+    MeshData mesh;
+    mesh.vertexLayout = static_cast<VertexLayout>(header.vertexLayout);
+    if (mesh.vertexLayout == VertexLayout::Quantized)
+    {
+        readArray(file, mesh.quantizedVertices, header.vertexCount);
+    } else if (mesh.vertexLayout == VertexLayout::Float)
+    {
+        readArray(file, mesh.vertices, header.vertexCount);
+    } else
+    {
+        throw std::runtime_error(path + " has an unknown vertex layout!");
+    }
+    readArray(file, mesh.indices, header.indexCount);
+    readArray(file, mesh.lods, header.lodCount);
+    readArray(file, mesh.meshlets, header.meshletCount);
+    readArray(file, mesh.meshletVertices, header.meshletVertexCount);
+    readArray(file, mesh.meshletTriangles, header.meshletTriangleCount);
+    std::memcpy(mesh.boundsMin, header.boundsMin, sizeof(header.boundsMin));
+    std::memcpy(mesh.boundsMax, header.boundsMax, sizeof(header.boundsMax));
+    mesh.dequantization = header.dequantization;
+    
+    if (!file.good())
+    {
+        throw std::runtime_error(path + " is truncated!");
+    }
+    
+    return mesh;
+}
+
+
+MeshData mesh::createSphere(const uint32_t rings, const uint32_t segments)
+{
+    constexpr float PI = 3.14159265358979f;
+    
+    MeshData mesh;
+    mesh.vertices.reserve((rings + 1) * (segments + 1));
+    
+    // The seam column is duplicated so UVs wrap, poles keep one vertex per segment
+    for (uint32_t r = 0; r <= rings; r++)
+    {
+        const float v = static_cast<float>(r) / static_cast<float>(rings);
+        const float theta = v * PI;
+        
+        for (uint32_t s = 0; s <= segments; s++)
+        {
+            const float u = static_cast<float>(s) / static_cast<float>(segments);
+            const float phi = u * 2.0f * PI;
+            
+            MeshVertex vertex{};
+            vertex.normal[0] = std::sin(theta) * std::cos(phi);
+            vertex.normal[1] = std::cos(theta);
+            vertex.normal[2] = std::sin(theta) * std::sin(phi);
+            for (int k = 0; k < 3; k++)
+            {
+                vertex.position[k] = vertex.normal[k];
+            }
+            
+            // Direction of increasing u
+            vertex.tangent[0] = -std::sin(phi);
+            vertex.tangent[1] = 0.0f;
+            vertex.tangent[2] = std::cos(phi);
+            vertex.tangent[3] = 1.0f;
+            
+            vertex.uv[0] = u;
+            vertex.uv[1] = v;
+            
+            vertex.color[0] = u;
+            vertex.color[1] = v;
+            vertex.color[2] = 1.0f - u;
+            vertex.color[3] = 1.0f;
+            
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    
+    mesh.indices.reserve(rings * segments * 6);
+    for (uint32_t r = 0; r < rings; r++)
+    {
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            const uint32_t a = r * (segments + 1) + s;
+            const uint32_t b = a + segments + 1;
+            mesh.indices.insert(mesh.indices.end(), {a, a + 1, b, b, a + 1, b + 1});
+        }
+    }
+    
+    MeshLod lod{};
+    lod.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    mesh.lods.push_back(lod);
+    
+    for (int k = 0; k < 3; k++)
+    {
+        mesh.boundsMin[k] = -1.0f;
+        mesh.boundsMax[k] = 1.0f;
+    }
+    
+    return mesh;
+}
@@ -0,0 +1,949 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+
+static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+// Forsyth's published tuning, for a simulated LRU cache of 32 entries
+static constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+static constexpr float CACHE_DECAY_POWER = 1.5f;
+static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+// Meshlets whose normals spread wider than this never pass the cone test, so they get no cone
+static constexpr float MIN_CONE_SPREAD = 0.1f;
+
+
+static void subtract(const float a[3], const float b[3], float result[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        result[i] = a[i] - b[i];
+    }
+}
+
+
+static float dot(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+
+// Unnormalized, its length is twice the triangle area
+static void triangleNormal(const float p0[3], const float p1[3], const float p2[3], float normal[3])
+{
+    float e1[3];
+    float e2[3];
+    subtract(p1, p0, e1);
+    subtract(p2, p0, e2);
+    
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+
+static bool normalize(float v[3])
+{
+    const float length = std::sqrt(dot(v, v));
+    if (length <= 0.0f)
+    {
+        return false;
+    }
+    
+    for (int i = 0; i < 3; i++)
+    {
+        v[i] /= length;
+    }
+    
+    return true;
+}
+
+
+VertexCacheStats mesh::analyzeVertexCache(const std::vector<uint32_t>& indices, const uint32_t vertexCount, const uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty())
+    {
+        return stats;
+    }
+    
+    // A vertex is still cached while fewer than cacheSize misses happened after its own
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t time = cacheSize + 1;
+    uint32_t referencedCount = 0;
+    
+    for (const uint32_t index : indices)
+    {
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            stats.misses++;
+        }
+        
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            referencedCount++;
+        }
+    }
+    
+    stats.acmr = static_cast<float>(stats.misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(stats.misses) / static_cast<float>(referencedCount);
+    
+    return stats;
+}
+
+
+static float forsythVertexScore(const int cachePosition, const uint32_t remainingTriangles)
+{
+    if (remainingTriangles == 0)
+    {
+        return -1.0f;
+    }
+    
+    float score = 0.0f;
+    if (cachePosition >= 0 && cachePosition < 3)
+    {
+        // The last triangle's vertices score lower so the next one does not just reuse the same edge
+        score = LAST_TRIANGLE_SCORE;
+    } else if (cachePosition >= 3)
+    {
+        const float scale = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+        score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, CACHE_DECAY_POWER);
+    }
+    
+    // Vertices with few triangles left are finished first so they leave the working set
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+}
+
+
+void mesh::optimizeVertexCache(std::vector<uint32_t>& indices, const uint32_t vertexCount)
+{
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0)
+    {
+        return;
+    }
+    
+    // Triangles of each vertex that are not emitted yet, the live ones first in each list
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (const uint32_t index : indices)
+    {
+        remaining[index]++;
+    }
+    
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < indices.size(); i++)
+    {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+    
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        vertexScores[v] = forsythVertexScore(-1, remaining[v]);
+    }
+    
+    std::vector<float> triangleScores(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    }
+    
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t cache[FORSYTH_CACHE_SIZE];
+    uint32_t cacheCount = 0;
+    
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    
+    uint32_t best = 0;
+    uint32_t restartCursor = 0;
+    
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        if (best == INVALID_INDEX)
+        {
+            // Dead end, nothing in the cache has triangles left: continue with the next one in input order
+            while (emitted[restartCursor])
+            {
+                restartCursor++;
+            }
+            best = restartCursor;
+        }
+        
+        const uint32_t* triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best] = true;
+        
+        for (int k = 0; k < 3; k++)
+        {
+            const uint32_t v = triangle[k];
+            uint32_t* list = &adjacency[offsets[v]];
+            
+            const uint32_t* found = std::find(list, list + remaining[v], best);
+            std::swap(list[found - list], list[remaining[v] - 1]);
+            remaining[v]--;
+        }
+        
+        // Emitted vertices move to the front of the LRU cache, whatever falls past its end is evicted
+        uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+        uint32_t newCount = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            if (std::find(newCache, newCache + newCount, triangle[k]) == newCache + newCount)
+            {
+                newCache[newCount++] = triangle[k];
+            }
+        }
+        
+        for (uint32_t i = 0; i < cacheCount; i++)
+        {
+            if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+            {
+                newCache[newCount++] = cache[i];
+            }
+        }
+        
+        for (uint32_t i = 0; i < newCount; i++)
+        {
+            const uint32_t v = newCache[i];
+            const int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            const float score = forsythVertexScore(position, remaining[v]);
+            const float delta = score - vertexScores[v];
+            
+            vertexScores[v] = score;
+            for (uint32_t j = 0; j < remaining[v]; j++)
+            {
+                triangleScores[adjacency[offsets[v] + j]] += delta;
+            }
+        }
+        
+        cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+        
+        // Only triangles touching the cache changed score, the best of them goes next
+        best = INVALID_INDEX;
+        float bestScore = -std::numeric_limits<float>::max();
+        for (uint32_t i = 0; i < cacheCount; i++)
+        {
+            const uint32_t v = cache[i];
+            for (uint32_t j = 0; j < remaining[v]; j++)
+            {
+                const uint32_t t = adjacency[offsets[v] + j];
+                if (triangleScores[t] > bestScore)
+                {
+                    best = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+        }
+    }
+    
+    indices.swap(output);
+}
+
+
+void mesh::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, const float threshold)
+{
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    if (triangleCount == 0)
+    {
+        return;
+    }
+    
+    // A triangle missing the cache on all three vertices starts a cluster, so reordering whole clusters keeps
+    // the cache behaviour of optimizeVertexCache within each one
+    std::vector<uint32_t> clusterStarts;
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = DEFAULT_CACHE_SIZE + 1;
+    
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        uint32_t misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            const uint32_t v = indices[t * 3 + k];
+            if (time - timestamps[v] > DEFAULT_CACHE_SIZE)
+            {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        
+        if (t == 0 || misses == 3)
+        {
+            clusterStarts.push_back(t);
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+    
+    const uint32_t clusterCount = static_cast<uint32_t>(clusterStarts.size() - 1);
+    std::vector<float> centroids(clusterCount * 3, 0.0f);
+    std::vector<float> normals(clusterCount * 3, 0.0f);
+    std::vector<float> areas(clusterCount, 0.0f);
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    
+    // Area-weighted centroid and average normal of every cluster
+    for (uint32_t c = 0; c < clusterCount; c++)
+    {
+        for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+        {
+            const float* p0 = vertices[indices[t * 3]].position;
+            const float* p1 = vertices[indices[t * 3 + 1]].position;
+            const float* p2 = vertices[indices[t * 3 + 2]].position;
+            
+            float normal[3];
+            triangleNormal(p0, p1, p2, normal);
+            const float area = std::sqrt(dot(normal, normal));
+            
+            for (int i = 0; i < 3; i++)
+            {
+                centroids[c * 3 + i] += area * (p0[i] + p1[i] + p2[i]) / 3.0f;
+                normals[c * 3 + i] += normal[i];
+            }
+            areas[c] += area;
+        }
+        
+        for (int i = 0; i < 3; i++)
+        {
+            meshCentroid[i] += centroids[c * 3 + i];
+        }
+        meshArea += areas[c];
+    }
+    
+    for (int i = 0; i < 3; i++)
+    {
+        meshCentroid[i] /= std::max(meshArea, std::numeric_limits<float>::min());
+    }
+    
+    // Clusters facing away from the centre are drawn first, they occlude the inner ones from most viewpoints
+    std::vector<float> sortKeys(clusterCount, 0.0f);
+    for (uint32_t c = 0; c < clusterCount; c++)
+    {
+        float* centroid = &centroids[c * 3];
+        float* normal = &normals[c * 3];
+        if (areas[c] <= 0.0f || !normalize(normal))
+        {
+            continue;
+        }
+        
+        for (int i = 0; i < 3; i++)
+        {
+            centroid[i] = centroid[i] / areas[c] - meshCentroid[i];
+        }
+        sortKeys[c] = dot(centroid, normal);
+    }
+    
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; c++)
+    {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](const uint32_t a, const uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+    
+    std::vector<uint32_t> reordered;
+    reordered.reserve(indices.size());
+    for (const uint32_t c : order)
+    {
+        reordered.insert(reordered.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+    
+    const float before = analyzeVertexCache(indices, vertexCount).acmr;
+    const float after = analyzeVertexCache(reordered, vertexCount).acmr;
+    if (after <= before * threshold)
+    {
+        indices.swap(reordered);
+    }
+}
+
+
+void mesh::generateTangents(const std::vector<uint32_t>& indices, std::vector<MeshVertex>& vertices)
+{
+    // Lengyel's method: accumulate the directions of increasing u and v over the triangles of each vertex
+    std::vector<float> uDirections(vertices.size() * 3, 0.0f);
+    std::vector<float> vDirections(vertices.size() * 3, 0.0f);
+    
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const MeshVertex& v0 = vertices[indices[i]];
+        const MeshVertex& v1 = vertices[indices[i + 1]];
+        const MeshVertex& v2 = vertices[indices[i + 2]];
+        
+        float e1[3];
+        float e2[3];
+        subtract(v1.position, v0.position, e1);
+        subtract(v2.position, v0.position, e2);
+        
+        const float du1 = v1.uv[0] - v0.uv[0];
+        const float dv1 = v1.uv[1] - v0.uv[1];
+        const float du2 = v2.uv[0] - v0.uv[0];
+        const float dv2 = v2.uv[1] - v0.uv[1];
+        const float determinant = du1 * dv2 - du2 * dv1;
+        if (std::fabs(determinant) <= std::numeric_limits<float>::epsilon())
+        {
+            continue;
+        }
+        
+        for (int k = 0; k < 3; k++)
+        {
+            const float uDirection = (e1[k] * dv2 - e2[k] * dv1) / determinant;
+            const float vDirection = (e2[k] * du1 - e1[k] * du2) / determinant;
+            for (int c = 0; c < 3; c++)
+            {
+                uDirections[indices[i + c] * 3 + k] += uDirection;
+                vDirections[indices[i + c] * 3 + k] += vDirection;
+            }
+        }
+    }
+    
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        MeshVertex& vertex = vertices[v];
+        const float* n = vertex.normal;
+        const float* u = &uDirections[v * 3];
+        
+        // Gram-Schmidt against the normal
+        float tangent[3];
+        const float projection = dot(n, u);
+        for (int k = 0; k < 3; k++)
+        {
+            tangent[k] = u[k] - n[k] * projection;
+        }
+        
+        if (!normalize(tangent))
+        {
+            const float axis[3] = {std::fabs(n[0]) < 0.9f ? 1.0f : 0.0f, std::fabs(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f};
+            const float along = dot(n, axis);
+            for (int k = 0; k < 3; k++)
+            {
+                tangent[k] = axis[k] - n[k] * along;
+            }
+            normalize(tangent);
+        }
+        
+        const float bitangent[3] = {n[1] * tangent[2] - n[2] * tangent[1], n[2] * tangent[0] - n[0] * tangent[2], n[0] * tangent[1] - n[1] * tangent[0]};
+        std::copy(tangent, tangent + 3, vertex.tangent);
+        vertex.tangent[3] = dot(bitangent, &vDirections[v * 3]) < 0.0f ? -1.0f : 1.0f;
+    }
+}
+
+
+void mesh::optimizeVertexFetch(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+    std::vector<MeshVertex> reordered;
+    reordered.reserve(vertices.size());
+    
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == INVALID_INDEX)
+        {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    
+    vertices.swap(reordered);
+}
+
+
+// Sum of squared distances to a set of area-weighted planes, as a symmetric 4x4 matrix
+struct Quadric
+{
+    double xx = 0.0, xy = 0.0, xz = 0.0, xw = 0.0;
+    double yy = 0.0, yz = 0.0, yw = 0.0;
+    double zz = 0.0, zw = 0.0;
+    double ww = 0.0;
+    double weight = 0.0;
+};
+
+
+static void addPlane(Quadric& q, const double a, const double b, const double c, const double d, const double weight)
+{
+    q.xx += weight * a * a;
+    q.xy += weight * a * b;
+    q.xz += weight * a * c;
+    q.xw += weight * a * d;
+    q.yy += weight * b * b;
+    q.yz += weight * b * c;
+    q.yw += weight * b * d;
+    q.zz += weight * c * c;
+    q.zw += weight * c * d;
+    q.ww += weight * d * d;
+    q.weight += weight;
+}
+
+
+static void addQuadric(Quadric& q, const Quadric& other)
+{
+    q.xx += other.xx;
+    q.xy += other.xy;
+    q.xz += other.xz;
+    q.xw += other.xw;
+    q.yy += other.yy;
+    q.yz += other.yz;
+    q.yw += other.yw;
+    q.zz += other.zz;
+    q.zw += other.zw;
+    q.ww += other.ww;
+    q.weight += other.weight;
+}
+
+
+// Mean squared distance of p to the planes
+static double evaluateQuadric(const Quadric& q, const float p[3])
+{
+    const double x = p[0];
+    const double y = p[1];
+    const double z = p[2];
+    
+    const double error = x * x * q.xx + y * y * q.yy + z * z * q.zz + q.ww
+                       + 2.0 * (x * y * q.xy + x * z * q.xz + y * z * q.yz + x * q.xw + y * q.yw + z * q.zw);
+    
+    return q.weight > 0.0 ? std::max(error, 0.0) / q.weight : 0.0;
+}
+
+
+struct PositionHash
+{
+    size_t operator()(const std::array<uint32_t, 3>& key) const
+    {
+        return (key[0] * 73856093u) ^ (key[1] * 19349663u) ^ (key[2] * 83492791u);
+    }
+};
+
+
+struct EdgeCollapse
+{
+    uint32_t from;
+    uint32_t to;
+    double cost;
+};
+
+
+// Vertices sharing a position with another one (attribute seams) or on an open edge must not move
+static std::vector<bool> findLockedVertices(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices)
+{
+    std::unordered_map<std::array<uint32_t, 3>, uint32_t, PositionHash> positionIds;
+    std::vector<uint32_t> vertexPositions(vertices.size());
+    std::vector<uint32_t> positionUses;
+    
+    for (uint32_t v = 0; v < vertices.size(); v++)
+    {
+        std::array<uint32_t, 3> key;
+        std::memcpy(key.data(), vertices[v].position, sizeof(key));
+        
+        const auto inserted = positionIds.emplace(key, static_cast<uint32_t>(positionUses.size()));
+        if (inserted.second)
+        {
+            positionUses.push_back(0);
+        }
+        vertexPositions[v] = inserted.first->second;
+        positionUses[vertexPositions[v]]++;
+    }
+    
+    std::unordered_set<uint64_t> edges;
+    edges.reserve(indices.size());
+    auto edgeKey = [](const uint32_t a, const uint32_t b) { return (static_cast<uint64_t>(a) << 32) | b; };
+    
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            edges.insert(edgeKey(vertexPositions[indices[i + k]], vertexPositions[indices[i + (k + 1) % 3]]));
+        }
+    }
+    
+    std::vector<bool> lockedPositions(positionUses.size(), false);
+    for (uint32_t p = 0; p < positionUses.size(); p++)
+    {
+        lockedPositions[p] = positionUses[p] > 1;
+    }
+    
+    // An edge without its opposite half is on the border of the surface
+    for (const uint64_t edge : edges)
+    {
+        const uint32_t a = static_cast<uint32_t>(edge >> 32);
+        const uint32_t b = static_cast<uint32_t>(edge);
+        if (edges.count(edgeKey(b, a)) == 0)
+        {
+            lockedPositions[a] = true;
+            lockedPositions[b] = true;
+        }
+    }
+    
+    std::vector<bool> locked(vertices.size());
+    for (uint32_t v = 0; v < vertices.size(); v++)
+    {
+        locked[v] = lockedPositions[vertexPositions[v]];
+    }
+    
+    return locked;
+}
+
+
+std::vector<uint32_t> mesh::simplify(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, const size_t targetIndexCount, const float targetError, float& resultError)
+{
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    std::vector<uint32_t> current = indices;
+    resultError = 0.0f;
+    
+    float boundsMin[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float boundsMax[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    for (const uint32_t index : indices)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            boundsMin[i] = std::min(boundsMin[i], vertices[index].position[i]);
+            boundsMax[i] = std::max(boundsMax[i], vertices[index].position[i]);
+        }
+    }
+    
+    const float extent = std::max({boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2]});
+    if (current.size() <= targetIndexCount || extent <= 0.0f)
+    {
+        return current;
+    }
+    
+    const double maxCost = static_cast<double>(targetError) * targetError * extent * extent;
+    const std::vector<bool> locked = findLockedVertices(indices, vertices);
+    
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const float* p0 = vertices[indices[i]].position;
+        
+        float normal[3];
+        triangleNormal(p0, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position, normal);
+        const float area = 0.5f * std::sqrt(dot(normal, normal));
+        if (!normalize(normal))
+        {
+            continue;
+        }
+        
+        for (int k = 0; k < 3; k++)
+        {
+            addPlane(quadrics[indices[i + k]], normal[0], normal[1], normal[2], -dot(normal, p0), area);
+        }
+    }
+    
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<EdgeCollapse> collapses;
+    double worstCost = 0.0;
+    
+    // Independent collapses in order of cost each pass, until nothing cheap enough is left
+    while (current.size() > targetIndexCount)
+    {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const uint32_t index : current)
+        {
+            offsets[index + 1]++;
+        }
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            offsets[v + 1] += offsets[v];
+        }
+        
+        adjacency.resize(current.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (uint32_t i = 0; i < current.size(); i++)
+        {
+            adjacency[fill[current[i]]++] = i / 3;
+        }
+        
+        // Collapsing onto the other endpoint keeps the vertex attributes exact
+        collapses.clear();
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                const uint32_t a = current[i + k];
+                const uint32_t b = current[i + (k + 1) % 3];
+                for (const auto& edge : {std::make_pair(a, b), std::make_pair(b, a)})
+                {
+                    if (locked[edge.first])
+                    {
+                        continue;
+                    }
+                    
+                    Quadric q = quadrics[edge.first];
+                    addQuadric(q, quadrics[edge.second]);
+                    
+                    const double cost = evaluateQuadric(q, vertices[edge.second].position);
+                    if (cost <= maxCost)
+                    {
+                        collapses.push_back({edge.first, edge.second, cost});
+                    }
+                }
+            }
+        }
+        
+        std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.cost < b.cost; });
+        
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), false);
+        
+        size_t triangleCount = current.size() / 3;
+        size_t collapseCount = 0;
+        
+        for (const auto& collapse : collapses)
+        {
+            if (triangleCount * 3 <= targetIndexCount)
+            {
+                break;
+            }
+            
+            if (touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+            
+            // Reject collapses that flip a triangle around the moving vertex
+            size_t removedTriangles = 0;
+            bool flips = false;
+            for (uint32_t j = offsets[collapse.from]; j < offsets[collapse.from + 1] && !flips; j++)
+            {
+                const uint32_t* triangle = &current[adjacency[j] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    removedTriangles++;
+                    continue;
+                }
+                
+                const float* before[3];
+                const float* after[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    before[k] = vertices[triangle[k]].position;
+                    after[k] = triangle[k] == collapse.from ? vertices[collapse.to].position : before[k];
+                }
+                
+                float oldNormal[3];
+                float newNormal[3];
+                triangleNormal(before[0], before[1], before[2], oldNormal);
+                triangleNormal(after[0], after[1], after[2], newNormal);
+                flips = dot(oldNormal, newNormal) <= 0.0f;
+            }
+            
+            if (flips)
+            {
+                continue;
+            }
+            
+            // The whole one-ring is frozen for the rest of the pass, so the flip tests above stay valid
+            for (uint32_t j = offsets[collapse.from]; j < offsets[collapse.from + 1]; j++)
+            {
+                const uint32_t* triangle = &current[adjacency[j] * 3];
+                touched[triangle[0]] = true;
+                touched[triangle[1]] = true;
+                touched[triangle[2]] = true;
+            }
+            
+            remap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            worstCost = std::max(worstCost, collapse.cost);
+            triangleCount -= removedTriangles;
+            collapseCount++;
+        }
+        
+        if (collapseCount == 0)
+        {
+            break;
+        }
+        
+        size_t write = 0;
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            const uint32_t a = remap[current[i]];
+            const uint32_t b = remap[current[i + 1]];
+            const uint32_t c = remap[current[i + 2]];
+            if (a != b && b != c && a != c)
+            {
+                current[write++] = a;
+                current[write++] = b;
+                current[write++] = c;
+            }
+        }
+        current.resize(write);
+    }
+    
+    resultError = static_cast<float>(std::sqrt(worstCost)) / extent;
+    
+    return current;
+}
+
+
+static void computeMeshletBounds(Meshlet& meshlet, const MeshData& mesh)
+{
+    const uint32_t* meshletVertices = &mesh.meshletVertices[meshlet.vertexOffset];
+    const uint8_t* triangles = &mesh.meshletTriangles[meshlet.triangleOffset];
+    
+    float boundsMin[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float boundsMax[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            boundsMin[k] = std::min(boundsMin[k], mesh.vertices[meshletVertices[i]].position[k]);
+            boundsMax[k] = std::max(boundsMax[k], mesh.vertices[meshletVertices[i]].position[k]);
+        }
+    }
+    
+    for (int k = 0; k < 3; k++)
+    {
+        meshlet.center[k] = 0.5f * (boundsMin[k] + boundsMax[k]);
+    }
+    
+    meshlet.radius = 0.0f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        float offset[3];
+        subtract(mesh.vertices[meshletVertices[i]].position, meshlet.center, offset);
+        meshlet.radius = std::max(meshlet.radius, std::sqrt(dot(offset, offset)));
+    }
+    
+    std::vector<float> normals;
+    std::vector<const float*> corners;
+    normals.reserve(meshlet.triangleCount * 3);
+    corners.reserve(meshlet.triangleCount);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+    {
+        const float* p0 = mesh.vertices[meshletVertices[triangles[t * 3]]].position;
+        float normal[3];
+        triangleNormal(p0, mesh.vertices[meshletVertices[triangles[t * 3 + 1]]].position, mesh.vertices[meshletVertices[triangles[t * 3 + 2]]].position, normal);
+        if (!normalize(normal))
+        {
+            continue;
+        }
+        
+        normals.insert(normals.end(), normal, normal + 3);
+        corners.push_back(p0);
+        for (int k = 0; k < 3; k++)
+        {
+            axis[k] += normal[k];
+        }
+    }
+    
+    // Cutoff 1 can never be reached, the meshlet is always drawn
+    std::fill(meshlet.coneApex, meshlet.coneApex + 3, 0.0f);
+    std::fill(meshlet.coneAxis, meshlet.coneAxis + 3, 0.0f);
+    meshlet.coneCutoff = 1.0f;
+    
+    if (!normalize(axis))
+    {
+        return;
+    }
+    
+    float minDot = 1.0f;
+    for (size_t i = 0; i < normals.size(); i += 3)
+    {
+        minDot = std::min(minDot, dot(axis, &normals[i]));
+    }
+    
+    if (minDot <= MIN_CONE_SPREAD)
+    {
+        return;
+    }
+    
+    // Apex far enough back along the axis that every triangle plane lies in front of it
+    float maxDistance = 0.0f;
+    for (size_t i = 0; i < corners.size(); i++)
+    {
+        float offset[3];
+        subtract(meshlet.center, corners[i], offset);
+        maxDistance = std::max(maxDistance, dot(offset, &normals[i * 3]) / dot(axis, &normals[i * 3]));
+    }
+    
+    for (int k = 0; k < 3; k++)
+    {
+        meshlet.coneAxis[k] = axis[k];
+        meshlet.coneApex[k] = meshlet.center[k] - axis[k] * maxDistance;
+    }
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+
+void mesh::buildMeshlets(const std::vector<uint32_t>& indices, const uint32_t indexOffset, const uint32_t indexCount, MeshData& mesh)
+{
+    constexpr uint8_t NOT_IN_MESHLET = 0xff;
+    std::vector<uint8_t> localIndices(mesh.vertices.size(), NOT_IN_MESHLET);
+    
+    Meshlet meshlet{};
+    meshlet.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+    meshlet.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+    
+    auto finishMeshlet = [&mesh, &meshlet, &localIndices]()
+    {
+        if (meshlet.triangleCount == 0)
+        {
+            return;
+        }
+        
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            localIndices[mesh.meshletVertices[meshlet.vertexOffset + i]] = NOT_IN_MESHLET;
+        }
+        
+        computeMeshletBounds(meshlet, mesh);
+        mesh.meshlets.push_back(meshlet);
+        
+        meshlet = Meshlet{};
+        meshlet.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+    };
+    
+    for (uint32_t i = indexOffset; i < indexOffset + indexCount; i += 3)
+    {
+        const uint32_t a = indices[i];
+        const uint32_t b = indices[i + 1];
+        const uint32_t c = indices[i + 2];
+        
+        const uint32_t newVertices = (localIndices[a] == NOT_IN_MESHLET ? 1 : 0) + (localIndices[b] == NOT_IN_MESHLET && b != a ? 1 : 0)
+                                   + (localIndices[c] == NOT_IN_MESHLET && c != a && c != b ? 1 : 0);
+        if (meshlet.vertexCount + newVertices > MESHLET_MAX_VERTICES || meshlet.triangleCount == MESHLET_MAX_TRIANGLES)
+        {
+            finishMeshlet();
+        }
+        
+        for (const uint32_t v : {a, b, c})
+        {
+            if (localIndices[v] == NOT_IN_MESHLET)
+            {
+                localIndices[v] = static_cast<uint8_t>(meshlet.vertexCount++);
+                mesh.meshletVertices.push_back(v);
+            }
+            mesh.meshletTriangles.push_back(localIndices[v]);
+        }
+        meshlet.triangleCount++;
+    }
+    
+    finishMeshlet();
+}
@@ -0,0 +1,190 @@
+#include "MeshRenderer.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+// FEATURE_* and MAX_LIGHTS in shaders/mesh.frag
+static constexpr uint32_t FEATURE_BUMP_MAPPING = 1;
+static constexpr uint32_t FEATURE_VERTEX_COLORS = 2;
+static constexpr uint32_t MAX_LIGHTS = 8;
+
+
+// Constant ids of shaders/mesh.frag
+static ShaderVariant fragmentVariantOf(const MeshShaderFeatures& features)
+{
+    ShaderVariant variant;
+    variant.set(1, features.runtimeBranches);
+    if (!features.runtimeBranches)
+    {
+        variant.set(2, features.lightCount).set(3, features.bumpMapping).set(4, features.vertexColors);
+    }
+    
+    return variant;
+}
+
+
+void MeshRenderer::uploadBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkQueue graphicsQueue, Buffer& buffer, const void* data, const VkDeviceSize size, const VkBufferUsageFlags usage, HostAllocator* hostAllocator)
+{
+    Buffer stagingBuffer;
+    stagingBuffer.setupBuffer(physicalDevice, device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}, hostAllocator);
+    std::memcpy(stagingBuffer.map(device), data, static_cast<size_t>(size));
+    stagingBuffer.unmap(device);
+    
+    buffer.setupBuffer(physicalDevice, device, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {}, hostAllocator);
+    
+    VkCommandBuffer commandBuffer = commandPool.beginSingleTimeCommands(device);
+    VkBufferCopy copyRegion{};
+    copyRegion.size = size;
+    capture::cmdCopyBuffer(commandBuffer, stagingBuffer.getBuffer(), buffer.getBuffer(), 1, &copyRegion);
+    commandPool.endSingleTimeCommands(device, graphicsQueue, commandBuffer);
+    
+    stagingBuffer.destroyBuffer(device, hostAllocator);
+}
+
+
+void MeshRenderer::setShaderFeatures(const MeshShaderFeatures& features)
+{
+    this->features = features;
+    if (pipeline.getPipeline() != VK_NULL_HANDLE)
+    {
+        pipeline.selectVariant(vertexVariant, fragmentVariantOf(features));
+    }
+}
+
+
+void MeshRenderer::setPipelineLibrary(const bool enabled, JobSystem* jobSystem)
+{
+    pipeline.setPipelineLibrary(enabled, jobSystem);
+}
+
+
+void MeshRenderer::setupMeshRenderer(const VkPhysicalDevice physicalDevice, const VkDevice device, const uint32_t graphicsFamily, const VkQueue graphicsQueue, const VkRenderPass renderPass, const MeshData& mesh, const VertexLayout layout, const ByteView vertShaderCode, const ByteView fragShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache, HostAllocator* hostAllocator)
+{
+    if (layout == VertexLayout::None || (layout == VertexLayout::Float && mesh.vertexLayout != VertexLayout::Float))
+    {
+        throw std::runtime_error("Mesh cannot be drawn with the requested vertex layout!");
+    }
+    
+    commandPool.setupCommandPool(device, graphicsFamily, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    std::vector<QuantizedVertex> quantizedVertices;
+    const void* vertexData = mesh.vertices.data();
+    VkDeviceSize vertexDataSize = mesh.vertices.size() * sizeof(MeshVertex);
+    dequantization = mesh.dequantization;
+    
+    if (layout == VertexLayout::Quantized)
+    {
+        if (mesh.vertexLayout == VertexLayout::Float)
+        {
+            dequantization = vertex::quantizeVertices(mesh.vertices, quantizedVertices);
+            vertexData = quantizedVertices.data();
+            vertexDataSize = quantizedVertices.size() * sizeof(QuantizedVertex);
+        } else
+        {
+            vertexData = mesh.quantizedVertices.data();
+            vertexDataSize = mesh.quantizedVertices.size() * sizeof(QuantizedVertex);
+        }
+    }
+    
+    // Only the most detailed level is drawn
+    const MeshLod lod = mesh.lods.empty() ? MeshLod{0, static_cast<uint32_t>(mesh.indices.size()), 0, 0, 0.0f} : mesh.lods[0];
+    indexCount = lod.indexCount;
+    
+    uploadBuffer(physicalDevice, device, graphicsQueue, vertexBuffer, vertexData, vertexDataSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostAllocator);
+    uploadBuffer(physicalDevice, device, graphicsQueue, indexBuffer, mesh.indices.data() + lod.indexOffset, indexCount * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, hostAllocator);
+    
+    std::memcpy(boundsMin, mesh.boundsMin, sizeof(boundsMin));
+    std::memcpy(boundsMax, mesh.boundsMax, sizeof(boundsMax));
+    
+    // Constant id of shaders/mesh.vert
+    vertexVariant = ShaderVariant().set(0, layout == VertexLayout::Quantized);
+    
+    pipeline.setVertexLayout(layout);
+    pipeline.setShaderVariant(VK_SHADER_STAGE_VERTEX_BIT, vertexVariant);
+    pipeline.setShaderVariant(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentVariantOf(features));
+    pipeline.setupGraphicsPipeline(device, renderPass, vertShaderCode, fragShaderCode, layoutCache, pipelineCache, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    
+    // Switching features later then only links, the runtime branching variant is a single part of its own
+    MeshShaderFeatures combination;
+    combination.runtimeBranches = true;
+    pipeline.precompileStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentVariantOf(combination));
+    combination.runtimeBranches = false;
+    for (uint32_t lightCount = 1; lightCount <= MAX_LIGHTS; lightCount++)
+    {
+        for (uint32_t flags = 0; flags < 4; flags++)
+        {
+            combination.lightCount = lightCount;
+            combination.bumpMapping = (flags & FEATURE_BUMP_MAPPING) != 0;
+            combination.vertexColors = (flags & FEATURE_VERTEX_COLORS) != 0;
+            pipeline.precompileStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentVariantOf(combination));
+        }
+    }
+}
+
+
+void MeshRenderer::destroyMeshRenderer(const VkDevice device, HostAllocator* hostAllocator)
+{
+    pipeline.destroyGraphicsPipeline(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    indexBuffer.destroyBuffer(device, hostAllocator);
+    vertexBuffer.destroyBuffer(device, hostAllocator);
+    commandPool.destroyCommandPool(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_COMMAND_POOL));
+}
+
+
+void MeshRenderer::cmdDraw(const VkCommandBuffer commandBuffer, const VkExtent2D extent, const uint32_t instanceCount) const
+{
+    const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(std::max(instanceCount, 1u)))));
+    const uint32_t rows = (std::max(instanceCount, 1u) + columns - 1) / columns;
+    const float size[2] = {boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1]};
+    const float spacing = 1.25f * std::max(size[0], size[1]);
+    
+    // Orthographic fit of the grid with square pixels, every vertex lands at depth 0.5
+    const float gridMin[2] = {boundsMin[0], boundsMin[1]};
+    const float gridMax[2] = {boundsMax[0] + spacing * static_cast<float>(columns - 1), boundsMax[1] + spacing * static_cast<float>(rows - 1)};
+    const float pixelsPerUnit = std::min(static_cast<float>(extent.width) / (gridMax[0] - gridMin[0]), static_cast<float>(extent.height) / (gridMax[1] - gridMin[1]));
+    const float scaleX = 2.0f * pixelsPerUnit / static_cast<float>(extent.width);
+    const float scaleY = 2.0f * pixelsPerUnit / static_cast<float>(extent.height);
+    
+    MeshPushConstants constants{};
+    constants.viewProjection[0] = scaleX;
+    constants.viewProjection[5] = scaleY;
+    constants.viewProjection[12] = -scaleX * 0.5f * (gridMin[0] + gridMax[0]);
+    constants.viewProjection[13] = -scaleY * 0.5f * (gridMin[1] + gridMax[1]);
+    constants.viewProjection[14] = 0.5f;
+    constants.viewProjection[15] = 1.0f;
+    constants.dequantization = dequantization;
+    constants.instanceGrid[0] = static_cast<float>(columns);
+    constants.instanceGrid[1] = spacing;
+    constants.lightCount = features.lightCount;
+    constants.featureFlags = (features.bumpMapping ? FEATURE_BUMP_MAPPING : 0) | (features.vertexColors ? FEATURE_VERTEX_COLORS : 0);
+    
+    const VkBuffer vertexBuffers[] = {vertexBuffer.getBuffer()};
+    const VkDeviceSize offsets[] = {0};
+    
+    capture::cmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipeline());
+    capture::cmdPushConstants(commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+    capture::cmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    capture::cmdBindIndexBuffer(commandBuffer, indexBuffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    capture::cmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 0);
+}
+
+
+void MeshRenderer::updatePipelines(DeletionQueue& deletionQueue, const uint32_t frame)
+{
+    pipeline.updatePipelines(deletionQueue, frame);
+}
+
+
+const VkDeviceSize MeshRenderer::getVertexBufferSize(void) const
+{
+    return vertexBuffer.getSize();
+}
+
+
+void MeshRenderer::report(std::ostream& os) const
+{
+    pipeline.report(os, "mesh");
+}
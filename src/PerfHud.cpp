@@ -0,0 +1,442 @@
+#include "PerfHud.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+
+// Layout in pixels from the top left of every view. Glyphs are 5x7 atlas texels drawn GLYPH_SCALE times
+// their size, which keeps each pixel inside one texel
+static constexpr float GLYPH_SCALE = 2.0f;
+static constexpr float GLYPH_ADVANCE = 6.0f * GLYPH_SCALE;
+static constexpr float LINE_HEIGHT = 9.0f * GLYPH_SCALE;
+static constexpr uint32_t TEXT_COLUMNS = 32;
+static constexpr float MARGIN = 8.0f;
+static constexpr float PADDING = 6.0f;
+static constexpr float PANEL_WIDTH = TEXT_COLUMNS * GLYPH_ADVANCE;
+static constexpr float GRAPH_HEIGHT = 64.0f;
+static constexpr float SPLIT_BAR_HEIGHT = 6.0f;
+// Frame time at the top of the graph and the full length of the split bars, two frames at 60 Hz
+static constexpr double GRAPH_MAX_MS = 1000.0 / 30.0;
+static constexpr double TARGET_FRAME_MS = 1000.0 / 60.0;
+
+static constexpr uint32_t ATLAS_COLUMNS = 16;
+static constexpr uint32_t GLYPH_WIDTH = 5;
+static constexpr uint32_t GLYPH_HEIGHT = 7;
+
+static constexpr uint32_t PANEL_COLOR = 0x101014c0;
+static constexpr uint32_t TEXT_COLOR = 0xf0f0f0ff;
+static constexpr uint32_t GOOD_COLOR = 0x40d060ff;
+static constexpr uint32_t SLOW_COLOR = 0xe0c040ff;
+static constexpr uint32_t MISSED_COLOR = 0xe04040ff;
+static constexpr uint32_t TARGET_LINE_COLOR = 0xffffff60;
+static constexpr uint32_t CPU_COLOR = 0x5090f0ff;
+static constexpr uint32_t GRAPHICS_COLOR = 0x40d060ff;
+static constexpr uint32_t COMPUTE_COLOR = 0xd070e0ff;
+static constexpr uint32_t POST_COLOR = 0xe0a040ff;
+
+
+bool PerfHud::enabledFromEnvironment(const bool defaultEnabled)
+{
+    const char* value = std::getenv("VULKAN_HUD");
+    if (value == nullptr)
+    {
+        return defaultEnabled;
+    }
+    
+    const std::string setting(value);
+    if (setting == "on") return true;
+    if (setting == "off") return false;
+    
+    std::cerr << "Unknown VULKAN_HUD value \"" << setting << "\", using the default" << std::endl;
+    return defaultEnabled;
+}
+
+
+const char* PerfHud::getPresentModeName(const VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "fifo relaxed";
+        default:
+            return "other";
+    }
+}
+
+
+void PerfHud::setupHud(const VkPhysicalDevice physicalDevice, const VkDevice device, const uint32_t graphicsFamily, const VkFormat outputFormat, const ByteView vertShaderCode, const ByteView fragShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache, HostAllocator* hostAllocator)
+{
+    createRenderPass(device, outputFormat, hostAllocator);
+    
+    pipeline.setVertexLayout(VertexLayout::Overlay);
+    pipeline.setupGraphicsPipeline(device, renderPass, vertShaderCode, fragShaderCode, layoutCache, pipelineCache, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    
+    // Host coherent, so the quads written through the mapping need no flush before the draw reads them
+    const VkDeviceSize slotSize = static_cast<VkDeviceSize>(HUD_MAX_QUADS) * 6 * sizeof(OverlayVertex);
+    vertexRing.setupBuffer(physicalDevice, device, slotSize * MAX_FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}, hostAllocator);
+    vertices = static_cast<OverlayVertex*>(vertexRing.map(device));
+    
+    timer.setupTimer(physicalDevice, device, graphicsFamily, MAX_FRAMES_IN_FLIGHT, 2);
+}
+
+
+void PerfHud::destroyHud(const VkDevice device, HostAllocator* hostAllocator)
+{
+    timer.destroyTimer(device);
+    vertexRing.destroyBuffer(device, hostAllocator);
+    vertices = nullptr;
+    pipeline.destroyGraphicsPipeline(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    
+    if (renderPass != VK_NULL_HANDLE)
+    {
+        capture::destroyRenderPass(device, renderPass, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_RENDER_PASS));
+        renderPass = VK_NULL_HANDLE;
+    }
+}
+
+
+void PerfHud::createRenderPass(const VkDevice device, const VkFormat outputFormat, HostAllocator* hostAllocator)
+{
+    // Draws over what the composite copied and hands the image back for presentation
+    VkAttachmentDescription colorAttachment{};
+    colorAttachment.format = outputFormat;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    
+    VkAttachmentReference colorAttachmentRef{};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    
+    // The composite's barrier made its copy available up to the color attachment stage, this makes it visible
+    // to the load and blending. Frame capture reads the image after the color attachment writes
+    VkSubpassDependency dependencies[2]{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstAccessMask = 0;
+    
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 2;
+    renderPassInfo.pDependencies = dependencies;
+    
+    if (capture::createRenderPass(device, &renderPassInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_RENDER_PASS), &renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD render pass!");
+    }
+}
+
+
+void PerfHud::addFrame(const PerfMetrics& metrics)
+{
+    const double hudCpuMs = this->metrics.hudCpuMs;
+    const double hudGpuMs = this->metrics.hudGpuMs;
+    this->metrics = metrics;
+    this->metrics.hudCpuMs = hudCpuMs;
+    this->metrics.hudGpuMs = hudGpuMs;
+    
+    frameHistory[historyHead] = static_cast<float>(metrics.frameMs);
+    historyHead = (historyHead + 1) % HUD_GRAPH_FRAMES;
+    historyCount = std::min(historyCount + 1, HUD_GRAPH_FRAMES);
+    
+    frameCount++;
+    frameMsTotal += metrics.frameMs;
+    frameMsMax = std::max(frameMsMax, metrics.frameMs);
+    cpuMsTotal += metrics.cpuMs;
+}
+
+
+void PerfHud::readTimings(const VkDevice device, const uint32_t slot)
+{
+    std::vector<GpuInterval> sections;
+    if (!timer.readSections(device, slot, sections))
+    {
+        return;
+    }
+    
+    metrics.hudGpuMs = sections[1].durationMs();
+    hudGpuFrames++;
+    hudGpuMsTotal += metrics.hudGpuMs;
+    hudGpuMsMax = std::max(hudGpuMsMax, metrics.hudGpuMs);
+}
+
+
+void PerfHud::buildFrame(const uint32_t slot)
+{
+    const auto start = std::chrono::steady_clock::now();
+    vertexCounts[slot] = 0;
+    
+    const float left = MARGIN + PADDING;
+    const float top = MARGIN + PADDING;
+    const float right = left + PANEL_WIDTH;
+    const float bottom = top + GRAPH_HEIGHT + 2.0f * SPLIT_BAR_HEIGHT + 6.0f * LINE_HEIGHT + 2.0f * PADDING;
+    pushRect(slot, MARGIN, MARGIN, right + PADDING, bottom + PADDING, PANEL_COLOR);
+    
+    // Frame time graph, newest frame on the right
+    const float barWidth = PANEL_WIDTH / HUD_GRAPH_FRAMES;
+    const float graphBottom = top + GRAPH_HEIGHT;
+    for (uint32_t i = 0; i < historyCount; i++)
+    {
+        const double frameMs = frameHistory[(historyHead + HUD_GRAPH_FRAMES - historyCount + i) % HUD_GRAPH_FRAMES];
+        const float height = static_cast<float>(std::min(frameMs / GRAPH_MAX_MS, 1.0)) * GRAPH_HEIGHT;
+        const uint32_t color = frameMs <= TARGET_FRAME_MS * 1.05 ? GOOD_COLOR : frameMs <= GRAPH_MAX_MS ? SLOW_COLOR : MISSED_COLOR;
+        const float x = right - (historyCount - i) * barWidth;
+        pushRect(slot, x, graphBottom - std::max(height, 1.0f), x + barWidth, graphBottom, color);
+    }
+    const float targetY = graphBottom - static_cast<float>(TARGET_FRAME_MS / GRAPH_MAX_MS) * GRAPH_HEIGHT;
+    pushRect(slot, left, targetY, right, targetY + 1.0f, TARGET_LINE_COLOR);
+    
+    // CPU over the GPU work split by queue, both against the same scale as the graph
+    const auto barLength = [](const double ms)
+    {
+        return static_cast<float>(std::min(ms / GRAPH_MAX_MS, 1.0)) * PANEL_WIDTH;
+    };
+    float y = graphBottom + PADDING;
+    pushRect(slot, left, y, left + barLength(metrics.cpuMs), y + SPLIT_BAR_HEIGHT, CPU_COLOR);
+    y += SPLIT_BAR_HEIGHT;
+    
+    float x = left;
+    const double gpuMs[] = {metrics.gpuGraphicsMs, metrics.gpuComputeMs, metrics.gpuPostMs};
+    const uint32_t gpuColors[] = {GRAPHICS_COLOR, COMPUTE_COLOR, POST_COLOR};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const float length = std::min(barLength(gpuMs[i]), right - x);
+        pushRect(slot, x, y, x + length, y + SPLIT_BAR_HEIGHT, gpuColors[i]);
+        x += length;
+    }
+    y += SPLIT_BAR_HEIGHT + PADDING;
+    
+    char line[TEXT_COLUMNS + 1];
+    const double fps = metrics.frameMs > 0.0 ? 1000.0 / metrics.frameMs : 0.0;
+    std::snprintf(line, sizeof(line), "frame %.2f ms %.0f fps", metrics.frameMs, fps);
+    pushText(slot, left, y, line, TEXT_COLOR);
+    y += LINE_HEIGHT;
+    
+    std::snprintf(line, sizeof(line), "cpu %.2f ms", metrics.cpuMs);
+    pushText(slot, left, y, line, CPU_COLOR);
+    y += LINE_HEIGHT;
+    
+    // Each GPU time in the color of its part of the bar
+    float column = left;
+    pushText(slot, column, y, "gpu", TEXT_COLOR);
+    column += 4 * GLYPH_ADVANCE;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const int length = std::snprintf(line, sizeof(line), "%.2f", gpuMs[i]);
+        pushText(slot, column, y, line, gpuColors[i]);
+        column += (std::min(length, static_cast<int>(TEXT_COLUMNS)) + 1) * GLYPH_ADVANCE;
+    }
+    pushText(slot, column, y, "ms", TEXT_COLOR);
+    y += LINE_HEIGHT;
+    
+    std::snprintf(line, sizeof(line), "%u draws %u disp %u pipes", metrics.draws, metrics.dispatches, metrics.pipelineBinds);
+    pushText(slot, left, y, line, TEXT_COLOR);
+    y += LINE_HEIGHT;
+    
+    const double mb = 1024.0 * 1024.0;
+    std::snprintf(line, sizeof(line), "mem %.0f / %.0f mb", metrics.memoryUsage / mb, metrics.memoryBudget / mb);
+    pushText(slot, left, y, line, TEXT_COLOR);
+    y += LINE_HEIGHT;
+    
+    std::snprintf(line, sizeof(line), "%s hud %.3f ms", getPresentModeName(metrics.presentMode), metrics.hudCpuMs + metrics.hudGpuMs);
+    pushText(slot, left, y, line, TEXT_COLOR);
+    
+    metrics.hudCpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    hudCpuFrames++;
+    hudCpuMsTotal += metrics.hudCpuMs;
+    hudCpuMsMax = std::max(hudCpuMsMax, metrics.hudCpuMs);
+}
+
+
+void PerfHud::cmdBegin(const VkCommandBuffer commandBuffer, const uint32_t slot)
+{
+    timer.cmdBegin(commandBuffer, slot);
+}
+
+
+void PerfHud::cmdDraw(const VkCommandBuffer commandBuffer, const uint32_t slot, const std::vector<HudTarget>& targets)
+{
+    // Everything before belongs to the first section
+    timer.cmdSplit(commandBuffer, slot, 0);
+    
+    const VkBuffer vertexBuffers[] = {vertexRing.getBuffer()};
+    const VkDeviceSize offsets[] = {static_cast<VkDeviceSize>(slot) * HUD_MAX_QUADS * 6 * sizeof(OverlayVertex)};
+    vertexRing.markWritten(offsets[0], vertexCounts[slot] * sizeof(OverlayVertex));
+    
+    for (const HudTarget& target : targets)
+    {
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = target.framebuffer;
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = target.extent;
+        
+        capture::cmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        capture::cmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipeline());
+        
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(target.extent.width);
+        viewport.height = static_cast<float>(target.extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        capture::cmdSetViewport(commandBuffer, 0, 1, &viewport);
+        
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = target.extent;
+        capture::cmdSetScissor(commandBuffer, 0, 1, &scissor);
+        
+        HudPushConstants constants;
+        constants.scale[0] = 2.0f / viewport.width;
+        constants.scale[1] = 2.0f / viewport.height;
+        constants.offset[0] = -1.0f;
+        constants.offset[1] = -1.0f;
+        
+        capture::cmdPushConstants(commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+        capture::cmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+        capture::cmdDraw(commandBuffer, vertexCounts[slot], 1, 0, 0);
+        capture::cmdEndRenderPass(commandBuffer);
+    }
+    
+    timer.cmdEnd(commandBuffer, slot);
+}
+
+
+void PerfHud::pushQuad(const uint32_t slot, const float x0, const float y0, const float x1, const float y1, const float u0, const float v0, const float u1, const float v1, const uint32_t color)
+{
+    uint32_t& count = vertexCounts[slot];
+    if (vertices == nullptr || count + 6 > HUD_MAX_QUADS * 6)
+    {
+        return;
+    }
+    
+    // Clockwise on screen like every other pipeline, two triangles sharing the top left and bottom right
+    const float corners[6][4] = {
+        {x0, y0, u0, v0}, {x1, y0, u1, v0}, {x1, y1, u1, v1},
+        {x0, y0, u0, v0}, {x1, y1, u1, v1}, {x0, y1, u0, v1}
+    };
+    
+    // Write-combined memory: every byte is written once, in order, and never read back
+    OverlayVertex* vertex = vertices + static_cast<size_t>(slot) * HUD_MAX_QUADS * 6 + count;
+    for (const auto& corner : corners)
+    {
+        vertex->position[0] = corner[0];
+        vertex->position[1] = corner[1];
+        vertex->uv[0] = corner[2];
+        vertex->uv[1] = corner[3];
+        vertex->color[0] = static_cast<uint8_t>(color >> 24);
+        vertex->color[1] = static_cast<uint8_t>(color >> 16);
+        vertex->color[2] = static_cast<uint8_t>(color >> 8);
+        vertex->color[3] = static_cast<uint8_t>(color);
+        vertex++;
+    }
+    count += 6;
+}
+
+
+void PerfHud::pushRect(const uint32_t slot, const float x0, const float y0, const float x1, const float y1, const uint32_t color)
+{
+    if (x1 > x0 && y1 > y0)
+    {
+        pushQuad(slot, x0, y0, x1, y1, -1.0f, -1.0f, -1.0f, -1.0f, color);
+    }
+}
+
+
+void PerfHud::pushText(const uint32_t slot, const float x, const float y, const char* text, const uint32_t color)
+{
+    float left = x;
+    for (const char* c = text; *c != '\0'; c++, left += GLYPH_ADVANCE)
+    {
+        char glyph = *c >= 'a' && *c <= 'z' ? static_cast<char>(*c - 'a' + 'A') : *c;
+        if (glyph == ' ')
+        {
+            continue;
+        }
+        if (glyph < ' ' || glyph > '_')
+        {
+            glyph = '?';
+        }
+        
+        const uint32_t index = static_cast<uint32_t>(glyph - ' ');
+        const float u = static_cast<float>((index % ATLAS_COLUMNS) * GLYPH_WIDTH);
+        const float v = static_cast<float>((index / ATLAS_COLUMNS) * GLYPH_HEIGHT);
+        pushQuad(slot, left, y, left + GLYPH_WIDTH * GLYPH_SCALE, y + GLYPH_HEIGHT * GLYPH_SCALE, u, v, u + GLYPH_WIDTH, v + GLYPH_HEIGHT, color);
+    }
+}
+
+
+const VkRenderPass PerfHud::getRenderPass(void) const
+{
+    return renderPass;
+}
+
+
+const PerfMetrics& PerfHud::getMetrics(void) const
+{
+    return metrics;
+}
+
+
+void PerfHud::report(std::ostream& os) const
+{
+    if (frameCount == 0)
+    {
+        return;
+    }
+    
+    const double mb = 1024.0 * 1024.0;
+    os << std::fixed << std::setprecision(2);
+    os << "[hud] " << frameCount << " frames: " << frameMsTotal / frameCount << " ms avg, " << frameMsMax << " ms max, cpu " << cpuMsTotal / frameCount << " ms avg"
+       << " | last: gpu " << metrics.gpuGraphicsMs << " graphics, " << metrics.gpuComputeMs << " compute, " << metrics.gpuPostMs << " post ms, "
+       << metrics.draws << " draws, " << metrics.dispatches << " dispatches, " << metrics.pipelineBinds << " pipeline binds, "
+       << metrics.memoryUsage / mb << " of " << metrics.memoryBudget / mb << " MB, " << getPresentModeName(metrics.presentMode) << std::endl;
+    
+    if (hudCpuFrames > 0)
+    {
+        os << std::setprecision(3) << "[hud] overlay: cpu " << hudCpuMsTotal / hudCpuFrames << " ms avg, " << hudCpuMsMax << " ms max";
+        if (hudGpuFrames > 0)
+        {
+            os << " | gpu " << hudGpuMsTotal / hudGpuFrames << " ms avg, " << hudGpuMsMax << " ms max";
+        }
+        os << std::endl;
+    }
+}
@@ -1,16 +1,46 @@
 #include "Pipeline.hpp"
-#include "Utils.hpp"
+#include "CommandCapture.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
 
-VkShaderModule Pipeline::createShaderModule(const VkDevice device, const std::vector<char>& code)
+
+// Fixed-function state shared by every variant, filled in once per pipeline or part created
+struct Pipeline::PipelineState
+{
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    VkVertexInputBindingDescription bindingDescription{};
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    VkPipelineViewportStateCreateInfo viewportState{};
+    std::vector<VkDynamicState> dynamicStates;
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+};
+
+struct Pipeline::ShaderStage
+{
+    VkPipelineShaderStageCreateInfo info{};
+    VkSpecializationInfo specializationInfo{};
+};
+
+
+VkShaderModule Pipeline::createShaderModule(const VkDevice device, const ByteView code)
 {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    createInfo.codeSize = code.size;
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data);
     
     VkShaderModule shaderModule;
-    if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    if (capture::createShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create shader module!");
     }
@@ -19,13 +49,61 @@ VkShaderModule Pipeline::createShaderModule(const VkDevice device, const std::ve
 }
 
 
-void Pipeline::populateVertexCreateInfo(VkPipelineVertexInputStateCreateInfo& vertexInputInfo)
+bool Pipeline::libraryFromEnvironment(const bool defaultEnabled)
+{
+    const char* value = std::getenv("VULKAN_PIPELINE_LIBRARY");
+    if (value == nullptr)
+    {
+        return defaultEnabled;
+    }
+    
+    const std::string setting(value);
+    if (setting == "on") return true;
+    if (setting == "off") return false;
+    
+    std::cerr << "Unknown VULKAN_PIPELINE_LIBRARY value \"" << setting << "\", using the default" << std::endl;
+    return defaultEnabled;
+}
+
+
+void Pipeline::setVertexLayout(const VertexLayout layout)
+{
+    vertexLayout = layout;
+}
+
+
+void Pipeline::setShaderVariant(const VkShaderStageFlagBits stage, const ShaderVariant& variant)
+{
+    if (stage == VK_SHADER_STAGE_VERTEX_BIT)
+    {
+        vertexVariant = variant;
+    } else if (stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+    {
+        fragmentVariant = variant;
+    } else
+    {
+        throw std::runtime_error("Graphics pipelines only have vertex and fragment shaders!");
+    }
+}
+
+
+void Pipeline::setPipelineLibrary(const bool enabled, JobSystem* jobSystem)
+{
+    useLibrary = enabled;
+    this->jobSystem = jobSystem;
+}
+
+
+void Pipeline::populateVertexCreateInfo(VkPipelineVertexInputStateCreateInfo& vertexInputInfo, VkVertexInputBindingDescription& bindingDescription, std::vector<VkVertexInputAttributeDescription>& attributeDescriptions)
 {
+    vertex::populateVertexInputDescriptions(vertexLayout, bindingDescription, attributeDescriptions);
+    const bool hasVertexInput = vertexLayout != VertexLayout::None;
+    
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 0;
-    vertexInputInfo.pVertexBindingDescriptions = nullptr;
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputInfo.pVertexAttributeDescriptions = nullptr;
+    vertexInputInfo.vertexBindingDescriptionCount = hasVertexInput ? 1 : 0;
+    vertexInputInfo.pVertexBindingDescriptions = hasVertexInput ? &bindingDescription : nullptr;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 }
 
 
@@ -109,106 +187,427 @@ void Pipeline::populateColorBlendCreateInfo(VkPipelineColorBlendAttachmentState&
 }
 
 
-void Pipeline::populatePipelineLayoutCreateInfo(VkPipelineLayoutCreateInfo& pipelineLayoutInfo)
+void Pipeline::populateState(PipelineState& state)
 {
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0; // Optional
-    pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+    populateVertexCreateInfo(state.vertexInputInfo, state.bindingDescription, state.attributeDescriptions);
+    populateAssemblyCreateInfo(state.inputAssembly);
+    populateViewportCreateInfo(state.viewportState);
+    populateDynamicCreateInfo(state.dynamicStates, state.dynamicState);
+    populateRasterizationCreateInfo(state.rasterizer);
+    populateMultisampleCreateInfo(state.multisampling);
+    populateColorBlendCreateInfo(state.colorBlendAttachment, state.colorBlending);
 }
 
 
-void Pipeline::setupGraphicsPipeline(const VkDevice device, const VkRenderPass renderPass, const VkAllocationCallbacksPair pAllocators)
+void Pipeline::populateShaderStage(ShaderStage& shaderStage, const VkShaderStageFlagBits stage, const ShaderVariant& variant)
 {
-    auto vertShaderCode = utils::readFile("shaders/vert.spv");
-    auto fragShaderCode = utils::readFile("shaders/frag.spv");
+    shaderStage.info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStage.info.stage = stage;
+    shaderStage.info.module = stage == VK_SHADER_STAGE_VERTEX_BIT ? vertShaderModule : fragShaderModule;
+    shaderStage.info.pName = "main";
     
-    VkShaderModule vertShaderModule = createShaderModule(device, vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(device, fragShaderCode);
+    variant.populateSpecializationInfo(shaderStage.specializationInfo);
+    shaderStage.info.pSpecializationInfo = variant.empty() ? nullptr : &shaderStage.specializationInfo;
+}
+
+
+VkPipeline Pipeline::createMonolithicPipeline(const ShaderVariant& vertexVariant, const ShaderVariant& fragmentVariant)
+{
+    ShaderStage vertStage, fragStage;
+    populateShaderStage(vertStage, VK_SHADER_STAGE_VERTEX_BIT, vertexVariant);
+    populateShaderStage(fragStage, VK_SHADER_STAGE_FRAGMENT_BIT, fragmentVariant);
+    VkPipelineShaderStageCreateInfo shaderStages[] = {vertStage.info, fragStage.info};
     
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
+    PipelineState state;
+    populateState(state);
     
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &state.vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+    pipelineInfo.pViewportState = &state.viewportState;
+    pipelineInfo.pRasterizationState = &state.rasterizer;
+    pipelineInfo.pMultisampleState = &state.multisampling;
+    pipelineInfo.pDepthStencilState = nullptr; // Optional
+    pipelineInfo.pColorBlendState = &state.colorBlending;
+    pipelineInfo.pDynamicState = &state.dynamicState;
+    pipelineInfo.layout = graphicsPipelineLayout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex = -1; // Optional
     
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+    VkPipeline pipeline;
+    if (capture::createGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, pAllocator, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create graphics pipeline!");
+    }
     
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    populateVertexCreateInfo(vertexInputInfo);
+    return pipeline;
+}
+
+
+// Each part only reads the state that belongs to it, the variant is only used by the two shader parts
+VkPipeline Pipeline::createLibraryPart(const VkGraphicsPipelineLibraryFlagsEXT part, const ShaderVariant& variant)
+{
+    PipelineState state;
+    populateState(state);
     
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    populateAssemblyCreateInfo(inputAssembly);
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    libraryInfo.flags = part;
     
-    VkPipelineViewportStateCreateInfo viewportState{};
-    populateViewportCreateInfo(viewportState);
-
-    std::vector<VkDynamicState> dynamicStates;
-    VkPipelineDynamicStateCreateInfo dynamicState{};
-    populateDynamicCreateInfo(dynamicStates, dynamicState);
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &libraryInfo;
+    // Keeps what the optimizing link needs to compile the parts again as a whole
+    pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    pipelineInfo.pDynamicState = &state.dynamicState;
+    pipelineInfo.basePipelineIndex = -1;
     
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    populateRasterizationCreateInfo(rasterizer);
-
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    populateMultisampleCreateInfo(multisampling);
+    ShaderStage shaderStage;
+    switch (part)
+    {
+        case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+            pipelineInfo.pVertexInputState = &state.vertexInputInfo;
+            pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+            populateShaderStage(shaderStage, VK_SHADER_STAGE_VERTEX_BIT, variant);
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &shaderStage.info;
+            pipelineInfo.pViewportState = &state.viewportState;
+            pipelineInfo.pRasterizationState = &state.rasterizer;
+            pipelineInfo.layout = graphicsPipelineLayout;
+            pipelineInfo.renderPass = renderPass;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+            populateShaderStage(shaderStage, VK_SHADER_STAGE_FRAGMENT_BIT, variant);
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &shaderStage.info;
+            pipelineInfo.pMultisampleState = &state.multisampling;
+            pipelineInfo.layout = graphicsPipelineLayout;
+            pipelineInfo.renderPass = renderPass;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+            pipelineInfo.pMultisampleState = &state.multisampling;
+            pipelineInfo.pColorBlendState = &state.colorBlending;
+            pipelineInfo.renderPass = renderPass;
+            break;
+        default:
+            throw std::runtime_error("Graphics pipeline library parts are created one at a time!");
+    }
     
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    populateColorBlendCreateInfo(colorBlendAttachment, colorBlending);
+    VkPipeline pipeline;
+    if (capture::createGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, pAllocator, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create graphics pipeline library part!");
+    }
     
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    populatePipelineLayoutCreateInfo(pipelineLayoutInfo);
+    return pipeline;
+}
+
 
-    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, pAllocators.second, &graphicsPipelineLayout) != VK_SUCCESS)
+VkPipeline Pipeline::getStagePart(const VkShaderStageFlagBits stage, const ShaderVariant& variant)
+{
+    if (stage != VK_SHADER_STAGE_VERTEX_BIT && stage != VK_SHADER_STAGE_FRAGMENT_BIT)
     {
-        throw std::runtime_error("Failed to create pipeline layout!");
+        throw std::runtime_error("Graphics pipelines only have vertex and fragment shaders!");
     }
     
+    auto& parts = stage == VK_SHADER_STAGE_VERTEX_BIT ? preRasterizationParts : fragmentShaderParts;
+    const auto findPart = [&parts, &variant]
+    {
+        return std::find_if(parts.begin(), parts.end(), [&variant](const auto& part) { return part.first == variant; });
+    };
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = findPart();
+        if (it != parts.end())
+        {
+            return it->second;
+        }
+    }
+    
+    // Compiled outside the lock so parts of different variants build side by side
+    const VkPipeline part = createLibraryPart(stage == VK_SHADER_STAGE_VERTEX_BIT ? VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT : VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, variant);
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = findPart();
+    if (it != parts.end())
+    {
+        // Another thread built the same part meanwhile
+        capture::destroyPipeline(device, part, pAllocator);
+        return it->second;
+    }
+    
+    parts.emplace_back(variant, part);
+    return part;
+}
+
+
+VkPipeline Pipeline::linkParts(const VkPipeline vertexPart, const VkPipeline fragmentPart, const bool optimize)
+{
+    const VkPipeline libraries[] = {vertexInputPart, vertexPart, fragmentPart, fragmentOutputPart};
+    
+    VkPipelineLibraryCreateInfoKHR linkInfo{};
+    linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    linkInfo.libraryCount = 4;
+    linkInfo.pLibraries = libraries;
+    
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr; // Optional
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.pNext = &linkInfo;
+    // Without the bit the driver only stitches the compiled parts together
+    pipelineInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
     pipelineInfo.layout = graphicsPipelineLayout;
-    pipelineInfo.renderPass = renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-    pipelineInfo.basePipelineIndex = -1; // Optional
+    pipelineInfo.basePipelineIndex = -1;
     
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, pAllocators.first, &graphicsPipeline) != VK_SUCCESS)
+    VkPipeline pipeline;
+    if (capture::createGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, pAllocator, &pipeline) != VK_SUCCESS)
     {
-        throw std::runtime_error("Failed to create graphics pipeline!");
+        throw std::runtime_error("Failed to link graphics pipeline!");
+    }
+    
+    return pipeline;
+}
+
+
+void Pipeline::submitOptimizedLink(Variant& variant, const VkPipeline vertexPart, const VkPipeline fragmentPart)
+{
+    // Without workers the job would only run once somebody waits, which is at destroy
+    if (jobSystem == nullptr || jobSystem->getWorkerCount() == 0)
+    {
+        return;
+    }
+    
+    Variant* target = &variant;
+    jobSystem->submit([this, target, vertexPart, fragmentPart]
+    {
+        VkPipeline optimized;
+        try
+        {
+            optimized = linkParts(vertexPart, fragmentPart, true);
+        } catch (const std::exception& e)
+        {
+            std::cerr << "[pipeline] " << e.what() << " Keeping the fast-linked pipeline" << std::endl;
+            return;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        target->optimized = optimized;
+    }, &compileJobs);
+}
+
+
+void Pipeline::setupGraphicsPipeline(const VkDevice device, const VkRenderPass renderPass, const ByteView vertShaderCode, const ByteView fragShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache, const VkAllocationCallbacks* pAllocator)
+{
+    this->device = device;
+    this->renderPass = renderPass;
+    this->pipelineCache = pipelineCache;
+    this->pAllocator = pAllocator;
+    
+    const ShaderReflection reflection = spirv::mergeStages({spirv::reflectShader(vertShaderCode), spirv::reflectShader(fragShaderCode)});
+    
+    // Kept for the variants built later on
+    vertShaderModule = createShaderModule(device, vertShaderCode);
+    fragShaderModule = createShaderModule(device, fragShaderCode);
+    
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    VkVertexInputBindingDescription bindingDescription{};
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    populateVertexCreateInfo(vertexInputInfo, bindingDescription, attributeDescriptions);
+    spirv::checkVertexInputs(reflection, attributeDescriptions);
+    
+    graphicsPipelineLayout = layoutCache.getPipelineLayout(VK_PIPELINE_BIND_POINT_GRAPHICS, reflection);
+    
+    if (useLibrary)
+    {
+        vertexInputPart = createLibraryPart(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, ShaderVariant());
+        fragmentOutputPart = createLibraryPart(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, ShaderVariant());
     }
     
-    vkDestroyShaderModule(device, fragShaderModule, nullptr);
-    vkDestroyShaderModule(device, vertShaderModule, nullptr);
+    selectVariant(vertexVariant, fragmentVariant);
 }
 
 
-void Pipeline::destroyGraphicsPipeline(const VkDevice device, const VkAllocationCallbacksPair pAllocators)
+void Pipeline::destroyGraphicsPipeline(const VkDevice device, const VkAllocationCallbacks* pAllocator)
 {
-    if (graphicsPipeline != VK_NULL_HANDLE)
+    if (jobSystem != nullptr && !compileJobs.isDone())
+    {
+        jobSystem->wait(compileJobs);
+    }
+    
+    for (const Variant& variant : variants)
+    {
+        capture::destroyPipeline(device, variant.pipeline, pAllocator);
+        if (variant.optimized != VK_NULL_HANDLE)
+        {
+            capture::destroyPipeline(device, variant.optimized, pAllocator);
+        }
+    }
+    variants.clear();
+    current = nullptr;
+    
+    for (auto* parts : {&preRasterizationParts, &fragmentShaderParts})
+    {
+        for (const auto& part : *parts)
+        {
+            capture::destroyPipeline(device, part.second, pAllocator);
+        }
+        parts->clear();
+    }
+    
+    for (VkPipeline* part : {&vertexInputPart, &fragmentOutputPart})
+    {
+        if (*part != VK_NULL_HANDLE)
+        {
+            capture::destroyPipeline(device, *part, pAllocator);
+            *part = VK_NULL_HANDLE;
+        }
+    }
+    
+    if (fragShaderModule != VK_NULL_HANDLE)
     {
-        vkDestroyPipeline(device, graphicsPipeline, pAllocators.first);
+        capture::destroyShaderModule(device, fragShaderModule, nullptr);
+        capture::destroyShaderModule(device, vertShaderModule, nullptr);
+        fragShaderModule = VK_NULL_HANDLE;
+        vertShaderModule = VK_NULL_HANDLE;
     }
     
-    if (graphicsPipelineLayout != VK_NULL_HANDLE)
+    stats = {};
+}
+
+
+void Pipeline::selectVariant(const ShaderVariant& vertexVariant, const ShaderVariant& fragmentVariant)
+{
+    for (Variant& variant : variants)
     {
-        vkDestroyPipelineLayout(device, graphicsPipelineLayout, pAllocators.second);
+        if (variant.vertex == vertexVariant && variant.fragment == fragmentVariant)
+        {
+            current = &variant;
+            return;
+        }
     }
+    
+    const auto start = std::chrono::steady_clock::now();
+    VkPipeline vertexPart = VK_NULL_HANDLE;
+    VkPipeline fragmentPart = VK_NULL_HANDLE;
+    VkPipeline pipeline;
+    if (useLibrary)
+    {
+        vertexPart = getStagePart(VK_SHADER_STAGE_VERTEX_BIT, vertexVariant);
+        fragmentPart = getStagePart(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentVariant);
+        pipeline = linkParts(vertexPart, fragmentPart, false);
+        stats.linkedCount++;
+    } else
+    {
+        pipeline = createMonolithicPipeline(vertexVariant, fragmentVariant);
+        stats.monolithicCount++;
+    }
+    stats.worstBuildMs = std::max(stats.worstBuildMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    
+    Variant& variant = variants.emplace_back();
+    variant.vertex = vertexVariant;
+    variant.fragment = fragmentVariant;
+    variant.pipeline = pipeline;
+    current = &variant;
+    
+    if (useLibrary)
+    {
+        submitOptimizedLink(variant, vertexPart, fragmentPart);
+    }
+}
+
+
+void Pipeline::precompileStage(const VkShaderStageFlagBits stage, const ShaderVariant& variant)
+{
+    if (!useLibrary)
+    {
+        return;
+    }
+    
+    if (jobSystem == nullptr)
+    {
+        getStagePart(stage, variant);
+        return;
+    }
+    
+    // A part that fails here is tried again by the first variant that needs it
+    jobSystem->submit([this, stage, variant]
+    {
+        try
+        {
+            getStagePart(stage, variant);
+        } catch (const std::exception& e)
+        {
+            std::cerr << "[pipeline] " << e.what() << std::endl;
+        }
+    }, &compileJobs);
+}
+
+
+void Pipeline::updatePipelines(DeletionQueue& deletionQueue, const uint32_t frame)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Variant& variant : variants)
+    {
+        if (variant.optimized == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+        
+        // Frames still in flight may draw with the fast-linked pipeline
+        const VkPipeline linked = variant.pipeline;
+        const VkAllocationCallbacks* callbacks = pAllocator;
+        deletionQueue.pushFrame(frame, [linked, callbacks](const VkDevice device)
+        {
+            capture::destroyPipeline(device, linked, callbacks);
+        });
+        
+        variant.pipeline = variant.optimized;
+        variant.optimized = VK_NULL_HANDLE;
+        stats.optimizedCount++;
+    }
+}
+
+
+const PipelineStats Pipeline::getStats(void) const
+{
+    return stats;
+}
+
+
+void Pipeline::report(std::ostream& os, const char* label) const
+{
+    os << std::fixed << std::setprecision(2) << "[pipeline] " << label << ": " << variants.size() << " variants, ";
+    if (useLibrary)
+    {
+        os << stats.linkedCount << " fast-linked, " << stats.optimizedCount << " optimized";
+    } else
+    {
+        os << stats.monolithicCount << " monolithic";
+    }
+    os << ", worst build " << stats.worstBuildMs << " ms" << std::endl;
+}
+
+
+const VkPipeline Pipeline::getPipeline(void) const
+{
+    return current == nullptr ? VK_NULL_HANDLE : current->pipeline;
+}
+
+
+const VkPipelineLayout Pipeline::getPipelineLayout(void) const
+{
+    return graphicsPipelineLayout;
+}
+
+
+const VertexLayout Pipeline::getVertexLayout(void) const
+{
+    return vertexLayout;
 }
@@ -0,0 +1,96 @@
+#include "PipelineCache.hpp"
+
+#include <cstring>
+#include <fstream>
+
+
+void PipelineCache::loadCacheFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    
+    if (!file.is_open())
+    {
+        return;
+    }
+    
+    size_t fileSize = (size_t) file.tellg();
+    initialData.resize(fileSize);
+    
+    file.seekg(0);
+    file.read(initialData.data(), fileSize);
+}
+
+
+void PipelineCache::saveCacheFile(const VkDevice device, const std::string& path) const
+{
+    if (pipelineCache == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    
+    size_t dataSize = 0;
+    vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr);
+    std::vector<char> data(dataSize);
+    if (dataSize == 0 || vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+    {
+        return;
+    }
+    
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), dataSize);
+}
+
+
+bool PipelineCache::isCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+{
+    // Data from another driver or device is rejected here rather than trusted to the driver
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    
+    std::memcpy(&header, data.data(), sizeof(header));
+    
+    return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+
+void PipelineCache::setupCache(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    
+    const bool compatible = isCompatible(initialData, deviceProperties);
+    
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = compatible ? initialData.size() : 0;
+    createInfo.pInitialData = compatible ? initialData.data() : nullptr;
+    
+    if (vkCreatePipelineCache(device, &createInfo, pAllocator, &pipelineCache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create pipeline cache!");
+    }
+    
+    initialData.clear();
+    initialData.shrink_to_fit();
+}
+
+
+void PipelineCache::destroyCache(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    if (pipelineCache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(device, pipelineCache, pAllocator);
+    }
+}
+
+
+const VkPipelineCache PipelineCache::getCache(void) const
+{
+    return pipelineCache;
+}
@@ -0,0 +1,200 @@
+#include "PipelineLayoutCache.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+
+
+static VkShaderStageFlags bindPointStages(const VkPipelineBindPoint bindPoint)
+{
+    return bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_ALL_GRAPHICS;
+}
+
+
+void PipelineLayoutCache::setupLayoutCache(const VkDevice device, HostAllocator* hostAllocator)
+{
+    this->device = device;
+    this->hostAllocator = hostAllocator;
+}
+
+
+void PipelineLayoutCache::destroyLayoutCache(void)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    for (const auto& entry : pipelineLayouts)
+    {
+        capture::destroyPipelineLayout(device, entry.second, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    }
+    for (const auto& entry : setLayouts)
+    {
+        capture::destroyDescriptorSetLayout(device, entry.second, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    }
+    
+    pipelineLayouts.clear();
+    setLayouts.clear();
+    layoutInfos.clear();
+}
+
+
+const VkDescriptorSetLayout PipelineLayoutCache::getSetLayout(const VkPipelineBindPoint bindPoint, const std::vector<ReflectedBinding>& bindings)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return getSetLayoutLocked(bindPoint, bindings);
+}
+
+
+const VkDescriptorSetLayout PipelineLayoutCache::getSetLayoutLocked(const VkPipelineBindPoint bindPoint, const std::vector<ReflectedBinding>& bindings)
+{
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    for (const ReflectedBinding& binding : bindings)
+    {
+        layoutBindings.push_back({binding.binding, binding.descriptorType, binding.descriptorCount, bindPointStages(bindPoint), nullptr});
+    }
+    std::sort(layoutBindings.begin(), layoutBindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+    {
+        return a.binding < b.binding;
+    });
+    
+    std::vector<uint64_t> key = {static_cast<uint64_t>(bindPoint)};
+    for (const VkDescriptorSetLayoutBinding& binding : layoutBindings)
+    {
+        key.insert(key.end(), {binding.binding, static_cast<uint64_t>(binding.descriptorType), binding.descriptorCount});
+    }
+    
+    const auto cached = setLayouts.find(key);
+    if (cached != setLayouts.end())
+    {
+        return cached->second;
+    }
+    
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+    layoutInfo.pBindings = layoutBindings.data();
+    
+    VkDescriptorSetLayout setLayout;
+    if (capture::createDescriptorSetLayout(device, &layoutInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &setLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create descriptor set layout!");
+    }
+    
+    setLayouts.emplace(key, setLayout);
+    return setLayout;
+}
+
+
+const VkPipelineLayout PipelineLayoutCache::getPipelineLayout(const VkPipelineBindPoint bindPoint, const ShaderReflection& reflection)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    const uint32_t setCount = reflection.bindings.empty() ? 0 : reflection.bindings.back().set + 1;
+    LayoutInfo info;
+    for (uint32_t set = 0; set < setCount; set++)
+    {
+        std::vector<ReflectedBinding> bindings;
+        std::copy_if(reflection.bindings.begin(), reflection.bindings.end(), std::back_inserter(bindings), [set](const ReflectedBinding& binding)
+        {
+            return binding.set == set;
+        });
+        info.setLayouts.push_back(getSetLayoutLocked(bindPoint, bindings));
+    }
+    info.pushConstantRanges = reflection.pushConstantRanges;
+    
+    // Set layouts are canonical already, so their handles identify them
+    std::vector<uint64_t> key;
+    for (const VkDescriptorSetLayout setLayout : info.setLayouts)
+    {
+        key.push_back(reinterpret_cast<uint64_t>(setLayout));
+    }
+    for (const VkPushConstantRange& range : info.pushConstantRanges)
+    {
+        key.insert(key.end(), {UINT64_MAX, range.stageFlags, range.offset, range.size});
+    }
+    
+    const auto cached = pipelineLayouts.find(key);
+    if (cached != pipelineLayouts.end())
+    {
+        return cached->second;
+    }
+    
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(info.setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = info.setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(info.pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = info.pushConstantRanges.data();
+    
+    VkPipelineLayout pipelineLayout;
+    if (capture::createPipelineLayout(device, &pipelineLayoutInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create pipeline layout!");
+    }
+    
+    pipelineLayouts.emplace(key, pipelineLayout);
+    layoutInfos.emplace(pipelineLayout, std::move(info));
+    return pipelineLayout;
+}
+
+
+const VkDescriptorSetLayout PipelineLayoutCache::getPipelineSetLayout(const VkPipelineLayout pipelineLayout, const uint32_t set) const
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    const auto info = layoutInfos.find(pipelineLayout);
+    if (info == layoutInfos.end() || set >= info->second.setLayouts.size())
+    {
+        throw std::runtime_error("Pipeline layout has no set " + std::to_string(set) + "!");
+    }
+    return info->second.setLayouts[set];
+}
+
+
+const bool PipelineLayoutCache::isCompatible(const VkPipelineLayout a, const VkPipelineLayout b, const uint32_t set) const
+{
+    if (a == b)
+    {
+        return true;
+    }
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    const auto infoA = layoutInfos.find(a);
+    const auto infoB = layoutInfos.find(b);
+    if (infoA == layoutInfos.end() || infoB == layoutInfos.end())
+    {
+        return false;
+    }
+    
+    const LayoutInfo& first = infoA->second;
+    const LayoutInfo& second = infoB->second;
+    if (set >= first.setLayouts.size() || set >= second.setLayouts.size() || first.pushConstantRanges.size() != second.pushConstantRanges.size())
+    {
+        return false;
+    }
+    
+    for (size_t i = 0; i < first.pushConstantRanges.size(); i++)
+    {
+        const VkPushConstantRange& rangeA = first.pushConstantRanges[i];
+        const VkPushConstantRange& rangeB = second.pushConstantRanges[i];
+        if (rangeA.stageFlags != rangeB.stageFlags || rangeA.offset != rangeB.offset || rangeA.size != rangeB.size)
+        {
+            return false;
+        }
+    }
+    
+    return std::equal(first.setLayouts.begin(), first.setLayouts.begin() + set + 1, second.setLayouts.begin());
+}
+
+
+const uint32_t PipelineLayoutCache::getSetLayoutCount(void) const
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return static_cast<uint32_t>(setLayouts.size());
+}
+
+
+const uint32_t PipelineLayoutCache::getPipelineLayoutCount(void) const
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return static_cast<uint32_t>(pipelineLayouts.size());
+}
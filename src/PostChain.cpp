@@ -0,0 +1,560 @@
+#include "PostChain.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+
+// Makes the writes of one pass visible to the next, the bloom levels depend on each other one by one
+static void cmdComputeBarrier(const VkCommandBuffer commandBuffer)
+{
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    capture::cmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+
+static VkImageMemoryBarrier imageBarrier(const Image& image, const VkImageLayout oldLayout, const VkImageLayout newLayout, const VkAccessFlags srcAccessMask, const VkAccessFlags dstAccessMask)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.getImage();
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = image.getMipLevels();
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+
+void PostStats::addFrame(const PostTimings& timings, const GpuInterval& graphics)
+{
+    // Same timebase caveat as OverlapStats
+    const double overlapNs = std::min(timings.chain.endNs, graphics.endNs) - std::max(timings.chain.beginNs, graphics.beginNs);
+    
+    frameCount++;
+    for (uint32_t i = 0; i < POST_EFFECT_COUNT; i++)
+    {
+        effectMs[i] += timings.effectMs[i];
+    }
+    chainMs += timings.chain.durationMs();
+    overlapMs += std::max(overlapNs, 0.0) * 1e-6;
+}
+
+
+void PostStats::report(std::ostream& os, const bool overlapped) const
+{
+    if (frameCount == 0) return;
+    
+    const double n = static_cast<double>(frameCount);
+    const double hidden = chainMs > 0.0 ? 100.0 * overlapMs / chainMs : 0.0;
+    
+    os << std::fixed << std::setprecision(3)
+       << "[post] overlap: " << (overlapped ? "on" : "off")
+       << " | frames: " << frameCount;
+    for (uint32_t i = 0; i < POST_EFFECT_COUNT; i++)
+    {
+        os << " | " << PostChain::getEffectName(static_cast<PostEffect>(i)) << ": " << effectMs[i] / n << " ms";
+    }
+    os << " | chain: " << chainMs / n << " ms"
+       << " | overlap: " << overlapMs / n << " ms (" << std::setprecision(1) << hidden << "% of chain hidden)" << '\n';
+}
+
+
+void PostStats::reset(void)
+{
+    *this = PostStats{};
+}
+
+
+uint32_t PostStats::getFrameCount(void) const
+{
+    return frameCount;
+}
+
+
+const char* PostChain::getEffectName(const PostEffect effect)
+{
+    switch (effect)
+    {
+        case PostEffect::BloomDownsample: return "bloom down";
+        case PostEffect::BloomUpsample: return "bloom up";
+        case PostEffect::Tonemap: return "tonemap";
+        case PostEffect::Fxaa: return "fxaa";
+    }
+    return "unknown";
+}
+
+
+void PostChain::createTargets(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const VkRenderPass renderPass, const std::vector<VkExtent2D>& extents, HostAllocator* hostAllocator)
+{
+    // Written by the compute queue and read by the graphics queue without ownership transfers
+    const std::vector<uint32_t> families = {indices.graphicsFamily.value(), indices.computeFamily.value()};
+    
+    viewCount = static_cast<uint32_t>(extents.size());
+    targets = std::make_unique<Target[]>(viewCount * MAX_FRAMES_IN_FLIGHT);
+    
+    for (uint32_t i = 0; i < viewCount * MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        Target& target = targets[i];
+        const VkExtent2D extent = extents[i / MAX_FRAMES_IN_FLIGHT];
+        
+        const VkExtent2D bloomExtent = {std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u)};
+        target.bloomLevels = 1;
+        while (target.bloomLevels < POST_BLOOM_LEVELS && (std::min(bloomExtent.width, bloomExtent.height) >> target.bloomLevels) > 0)
+        {
+            target.bloomLevels++;
+        }
+        
+        target.scene.setupImage(physicalDevice, device, extent, POST_HDR_FORMAT, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, families, hostAllocator);
+        target.bloom.setupImage(physicalDevice, device, bloomExtent, POST_HDR_FORMAT, target.bloomLevels, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, families, hostAllocator);
+        target.tonemapped.setupImage(physicalDevice, device, extent, VK_FORMAT_R8G8B8A8_UNORM, 1, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, families, hostAllocator);
+        target.output.setupImage(physicalDevice, device, extent, VK_FORMAT_R8G8B8A8_UNORM, 1, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, families, hostAllocator);
+        
+        const VkImageView attachment = target.scene.getView();
+        
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &attachment;
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+        
+        if (capture::createFramebuffer(device, &framebufferInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_FRAMEBUFFER), &target.framebuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create post framebuffer!");
+        }
+    }
+}
+
+
+void PostChain::createSampler(const VkDevice device, HostAllocator* hostAllocator)
+{
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    
+    if (capture::createSampler(device, &samplerInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_SAMPLER), &sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post sampler!");
+    }
+}
+
+
+void PostChain::writeDescriptorSet(const VkDevice device, const VkDescriptorSet set, const std::vector<VkDescriptorImageInfo>& sampledImages, const VkImageView storageView)
+{
+    VkDescriptorImageInfo storageImage{};
+    storageImage.imageView = storageView;
+    storageImage.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    
+    // Sampled images first, the storage image takes the binding after them
+    std::vector<VkWriteDescriptorSet> writes(sampledImages.size() + 1, VkWriteDescriptorSet{});
+    for (uint32_t i = 0; i < writes.size(); i++)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        if (i < sampledImages.size())
+        {
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[i].pImageInfo = &sampledImages[i];
+        } else
+        {
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[i].pImageInfo = &storageImage;
+        }
+    }
+    
+    capture::updateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+
+void PostChain::createDescriptorSets(const VkDevice device, PipelineLayoutCache& layoutCache, HostAllocator* hostAllocator)
+{
+    VkDescriptorSetLayout setLayouts[POST_EFFECT_COUNT];
+    for (uint32_t i = 0; i < POST_EFFECT_COUNT; i++)
+    {
+        setLayouts[i] = layoutCache.getPipelineSetLayout(pipelines[i].getPipelineLayout(), 0);
+    }
+    
+    // A downsample set per bloom level, an upsample set per level but the smallest, tonemap and FXAA
+    uint32_t setCount = 0;
+    uint32_t sampledCount = 0;
+    uint32_t storageCount = 0;
+    for (uint32_t i = 0; i < viewCount * MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        const uint32_t levels = targets[i].bloomLevels;
+        setCount += 2 * levels + 1;
+        sampledCount += 2 * levels + 2;
+        storageCount += 2 * levels + 1;
+    }
+    
+    VkDescriptorPoolSize poolSizes[2]{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = sampledCount;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = storageCount;
+    
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    poolInfo.maxSets = setCount;
+    
+    if (capture::createDescriptorPool(device, &poolInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DESCRIPTOR_POOL), &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post descriptor pool!");
+    }
+    
+    for (uint32_t i = 0; i < viewCount * MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        Target& target = targets[i];
+        const uint32_t levels = target.bloomLevels;
+        
+        std::vector<VkDescriptorSetLayout> layouts(levels, setLayouts[static_cast<uint32_t>(PostEffect::BloomDownsample)]);
+        layouts.insert(layouts.end(), levels - 1, setLayouts[static_cast<uint32_t>(PostEffect::BloomUpsample)]);
+        layouts.push_back(setLayouts[static_cast<uint32_t>(PostEffect::Tonemap)]);
+        layouts.push_back(setLayouts[static_cast<uint32_t>(PostEffect::Fxaa)]);
+        std::vector<VkDescriptorSet> sets(layouts.size());
+        
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+        allocInfo.pSetLayouts = layouts.data();
+        
+        if (capture::allocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate post descriptor sets!");
+        }
+        
+        target.downsampleSets.assign(sets.begin(), sets.begin() + levels);
+        target.upsampleSets.assign(sets.begin() + levels, sets.begin() + 2 * levels - 1);
+        target.tonemapSet = sets[2 * levels - 1];
+        target.fxaaSet = sets[2 * levels];
+        
+        // The scene is left in SHADER_READ_ONLY_OPTIMAL by the render pass, the chain keeps its images in GENERAL
+        const VkDescriptorImageInfo scene = {sampler, target.scene.getView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            const VkDescriptorImageInfo source = level == 0 ? scene : VkDescriptorImageInfo{sampler, target.bloom.getMipView(level - 1), VK_IMAGE_LAYOUT_GENERAL};
+            writeDescriptorSet(device, target.downsampleSets[level], {source}, target.bloom.getMipView(level));
+        }
+        
+        // Each level adds the one below it, so the smallest level has no set
+        for (uint32_t level = 0; level + 1 < levels; level++)
+        {
+            const VkDescriptorImageInfo source = {sampler, target.bloom.getMipView(level + 1), VK_IMAGE_LAYOUT_GENERAL};
+            writeDescriptorSet(device, target.upsampleSets[level], {source}, target.bloom.getMipView(level));
+        }
+        
+        const VkDescriptorImageInfo bloom = {sampler, target.bloom.getMipView(0), VK_IMAGE_LAYOUT_GENERAL};
+        writeDescriptorSet(device, target.tonemapSet, {scene, bloom}, target.tonemapped.getView());
+        
+        const VkDescriptorImageInfo tonemapped = {sampler, target.tonemapped.getView(), VK_IMAGE_LAYOUT_GENERAL};
+        writeDescriptorSet(device, target.fxaaSet, {tonemapped}, target.output.getView());
+    }
+}
+
+
+void PostChain::setupPostChain(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const VkRenderPass renderPass, const std::vector<VkExtent2D>& extents, const VkFormat outputFormat, const std::array<ByteView, POST_EFFECT_COUNT>& shaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache, HostAllocator* hostAllocator)
+{
+    const bool bgraOutput = outputFormat == VK_FORMAT_B8G8R8A8_UNORM || outputFormat == VK_FORMAT_B8G8R8A8_SRGB;
+    const bool rgbaOutput = outputFormat == VK_FORMAT_R8G8B8A8_UNORM || outputFormat == VK_FORMAT_R8G8B8A8_SRGB;
+    if (!bgraOutput && !rgbaOutput)
+    {
+        throw std::runtime_error("Post chain needs an 8-bit RGBA or BGRA swap chain!");
+    }
+    
+    commandPool.setupCommandPool(device, indices.computeFamily.value(), HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_COMMAND_POOL));
+    commandPool.setupCommandBuffers(device, MAX_FRAMES_IN_FLIGHT);
+    
+    createTargets(physicalDevice, device, indices, renderPass, extents, hostAllocator);
+    createSampler(device, hostAllocator);
+    
+    // BGRA_OUTPUT in fxaa.comp swizzles the result, so the copy into the swap chain keeps the bytes as they are
+    pipelines[static_cast<uint32_t>(PostEffect::Fxaa)].setShaderVariant(ShaderVariant().set(0, bgraOutput));
+    for (uint32_t i = 0; i < POST_EFFECT_COUNT; i++)
+    {
+        pipelines[i].setupComputePipeline(device, shaderCode[i], layoutCache, pipelineCache, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    }
+    
+    createDescriptorSets(device, layoutCache, hostAllocator);
+    timer.setupTimer(physicalDevice, device, indices.computeFamily.value(), MAX_FRAMES_IN_FLIGHT, POST_EFFECT_COUNT, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_QUERY_POOL));
+}
+
+
+void PostChain::destroyTargets(const VkDevice device, HostAllocator* hostAllocator)
+{
+    if (descriptorPool != VK_NULL_HANDLE)
+    {
+        capture::destroyDescriptorPool(device, descriptorPool, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+        descriptorPool = VK_NULL_HANDLE;
+    }
+    
+    for (uint32_t i = 0; targets && i < viewCount * MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        Target& target = targets[i];
+        if (target.framebuffer != VK_NULL_HANDLE)
+        {
+            capture::destroyFramebuffer(device, target.framebuffer, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_FRAMEBUFFER));
+        }
+        target.output.destroyImage(device, hostAllocator);
+        target.tonemapped.destroyImage(device, hostAllocator);
+        target.bloom.destroyImage(device, hostAllocator);
+        target.scene.destroyImage(device, hostAllocator);
+    }
+    targets.reset();
+}
+
+
+void PostChain::destroyPostChain(const VkDevice device, HostAllocator* hostAllocator)
+{
+    timer.destroyTimer(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_QUERY_POOL));
+    
+    for (auto& pipeline : pipelines)
+    {
+        pipeline.destroyComputePipeline(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    }
+    
+    destroyTargets(device, hostAllocator);
+    
+    if (sampler != VK_NULL_HANDLE)
+    {
+        capture::destroySampler(device, sampler, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_SAMPLER));
+    }
+    
+    commandPool.destroyCommandPool(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_COMMAND_POOL));
+}
+
+
+void PostChain::retireTargets(DeletionQueue& deletionQueue, const uint32_t frame, HostAllocator* hostAllocator)
+{
+    if (descriptorPool != VK_NULL_HANDLE)
+    {
+        deletionQueue.deferDescriptorPool(frame, descriptorPool, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+        descriptorPool = VK_NULL_HANDLE;
+    }
+    
+    for (uint32_t i = 0; targets && i < viewCount * MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        Target& target = targets[i];
+        if (target.framebuffer != VK_NULL_HANDLE)
+        {
+            deletionQueue.deferFramebuffer(frame, target.framebuffer, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_FRAMEBUFFER));
+        }
+        target.output.deferDestroy(deletionQueue, frame, hostAllocator);
+        target.tonemapped.deferDestroy(deletionQueue, frame, hostAllocator);
+        target.bloom.deferDestroy(deletionQueue, frame, hostAllocator);
+        target.scene.deferDestroy(deletionQueue, frame, hostAllocator);
+    }
+    targets.reset();
+}
+
+
+void PostChain::resizeTargets(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const VkRenderPass renderPass, const std::vector<VkExtent2D>& extents, PipelineLayoutCache& layoutCache, DeletionQueue& deletionQueue, const uint32_t frame, HostAllocator* hostAllocator)
+{
+    retireTargets(deletionQueue, frame, hostAllocator);
+    createTargets(physicalDevice, device, indices, renderPass, extents, hostAllocator);
+    createDescriptorSets(device, layoutCache, hostAllocator);
+}
+
+
+void PostChain::cmdDispatch(const VkCommandBuffer commandBuffer, const PostEffect effect, const VkDescriptorSet set, const VkExtent2D extent, const PostPushConstants& constants)
+{
+    const ComputePipeline& pipeline = pipelines[static_cast<uint32_t>(effect)];
+    
+    capture::cmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getPipeline());
+    capture::cmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getPipelineLayout(), 0, 1, &set, 0, nullptr);
+    capture::cmdPushConstants(commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    capture::cmdDispatch(commandBuffer, (extent.width + POST_TILE_SIZE - 1) / POST_TILE_SIZE, (extent.height + POST_TILE_SIZE - 1) / POST_TILE_SIZE, 1);
+}
+
+
+void PostChain::recordCommandBuffer(const VkCommandBuffer commandBuffer, const uint64_t frame)
+{
+    const uint32_t slot = static_cast<uint32_t>(frame % MAX_FRAMES_IN_FLIGHT);
+    
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    
+    if (capture::beginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin recording post command buffer!");
+    }
+    
+    timer.cmdBegin(commandBuffer, slot);
+    
+    // Every pass rewrites its image completely, so the old contents are discarded. The copy out of the output
+    // of this slot two frames ago must be done first, which only a barrier ensures when the queues are shared
+    std::vector<VkImageMemoryBarrier> barriers;
+    uint32_t maxLevels = 0;
+    for (uint32_t view = 0; view < viewCount; view++)
+    {
+        const Target& target = targets[getTargetIndex(view, frame)];
+        barriers.push_back(imageBarrier(target.bloom, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+        barriers.push_back(imageBarrier(target.tonemapped, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+        barriers.push_back(imageBarrier(target.output, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT));
+        maxLevels = std::max(maxLevels, target.bloomLevels);
+    }
+    capture::cmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+    
+    // Passes of all views are interleaved so one barrier per level covers every view
+    for (uint32_t level = 0; level < maxLevels; level++)
+    {
+        for (uint32_t view = 0; view < viewCount; view++)
+        {
+            const Target& target = targets[getTargetIndex(view, frame)];
+            if (level >= target.bloomLevels) continue;
+            
+            const VkExtent2D source = level == 0 ? target.scene.getExtent() : target.bloom.getExtent(level - 1);
+            const PostPushConstants constants{{1.0f / source.width, 1.0f / source.height}, level == 0 ? POST_BLOOM_THRESHOLD : 0.0f, 0.0f};
+            cmdDispatch(commandBuffer, PostEffect::BloomDownsample, target.downsampleSets[level], target.bloom.getExtent(level), constants);
+        }
+        cmdComputeBarrier(commandBuffer);
+    }
+    timer.cmdSplit(commandBuffer, slot, static_cast<uint32_t>(PostEffect::BloomDownsample));
+    
+    for (uint32_t level = maxLevels - 1; level-- > 0;)
+    {
+        for (uint32_t view = 0; view < viewCount; view++)
+        {
+            const Target& target = targets[getTargetIndex(view, frame)];
+            if (level + 1 >= target.bloomLevels) continue;
+            
+            const VkExtent2D destination = target.bloom.getExtent(level);
+            const PostPushConstants constants{{1.0f / destination.width, 1.0f / destination.height}, 0.0f, 0.0f};
+            cmdDispatch(commandBuffer, PostEffect::BloomUpsample, target.upsampleSets[level], destination, constants);
+        }
+        cmdComputeBarrier(commandBuffer);
+    }
+    timer.cmdSplit(commandBuffer, slot, static_cast<uint32_t>(PostEffect::BloomUpsample));
+    
+    for (uint32_t view = 0; view < viewCount; view++)
+    {
+        const Target& target = targets[getTargetIndex(view, frame)];
+        const VkExtent2D extent = target.scene.getExtent();
+        const PostPushConstants constants{{1.0f / extent.width, 1.0f / extent.height}, 0.0f, POST_BLOOM_STRENGTH};
+        cmdDispatch(commandBuffer, PostEffect::Tonemap, target.tonemapSet, extent, constants);
+    }
+    cmdComputeBarrier(commandBuffer);
+    timer.cmdSplit(commandBuffer, slot, static_cast<uint32_t>(PostEffect::Tonemap));
+    
+    for (uint32_t view = 0; view < viewCount; view++)
+    {
+        const Target& target = targets[getTargetIndex(view, frame)];
+        const VkExtent2D extent = target.tonemapped.getExtent();
+        const PostPushConstants constants{{1.0f / extent.width, 1.0f / extent.height}, 0.0f, 0.0f};
+        cmdDispatch(commandBuffer, PostEffect::Fxaa, target.fxaaSet, extent, constants);
+    }
+    
+    timer.cmdEnd(commandBuffer, slot);
+    
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record post command buffer!");
+    }
+}
+
+
+const VkCommandBuffer PostChain::recordFrame(const uint64_t frame)
+{
+    const VkCommandBuffer commandBuffer = commandPool.getCommandBuffer(static_cast<uint32_t>(frame % MAX_FRAMES_IN_FLIGHT));
+    vkResetCommandBuffer(commandBuffer, 0);
+    recordCommandBuffer(commandBuffer, frame);
+    return commandBuffer;
+}
+
+
+void PostChain::cmdComposite(const VkCommandBuffer commandBuffer, const uint32_t view, const uint64_t frame, const VkImage image) const
+{
+    const Target& target = targets[getTargetIndex(view, frame)];
+    
+    // The chain only needs the memory barrier when it ran on this queue, otherwise the timeline wait orders it.
+    // TRANSFER is the stage the acquire semaphore is waited on, so the layout change happens after the acquire
+    VkMemoryBarrier chainDone{};
+    chainDone.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    chainDone.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    chainDone.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = 0;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = image;
+    toTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toTransfer.subresourceRange.levelCount = 1;
+    toTransfer.subresourceRange.layerCount = 1;
+    capture::cmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &chainDone, 0, nullptr, 1, &toTransfer);
+    
+    // Both formats are 32 bits per texel, FXAA already wrote the channels in swap chain order
+    const VkExtent2D extent = target.output.getExtent();
+    VkImageCopy region{};
+    region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.srcSubresource.layerCount = 1;
+    region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.dstSubresource.layerCount = 1;
+    region.extent = {extent.width, extent.height, 1};
+    capture::cmdCopyImage(commandBuffer, target.output.getImage(), VK_IMAGE_LAYOUT_GENERAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    
+    // Ends in COLOR_ATTACHMENT_OUTPUT like a render pass would, which is where FrameCapture picks the image up
+    VkImageMemoryBarrier toPresent = toTransfer;
+    toPresent.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toPresent.dstAccessMask = 0;
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    capture::cmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &toPresent);
+}
+
+
+bool PostChain::readTimings(const VkDevice device, const uint32_t slot, PostTimings& timings)
+{
+    std::vector<GpuInterval> sections;
+    if (!timer.readSections(device, slot, sections))
+    {
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < POST_EFFECT_COUNT; i++)
+    {
+        timings.effectMs[i] = sections[i].durationMs();
+    }
+    timings.chain.beginNs = sections.front().beginNs;
+    timings.chain.endNs = sections.back().endNs;
+    
+    return true;
+}
+
+
+const VkFramebuffer PostChain::getFramebuffer(const uint32_t view, const uint64_t frame) const
+{
+    return targets[getTargetIndex(view, frame)].framebuffer;
+}
+
+
+const uint32_t PostChain::getTargetIndex(const uint32_t view, const uint64_t frame) const
+{
+    return view * MAX_FRAMES_IN_FLIGHT + static_cast<uint32_t>(frame % MAX_FRAMES_IN_FLIGHT);
+}
@@ -1,15 +1,53 @@
 #include "Queue.hpp"
+#include "CommandCapture.hpp"
 
-#include <set>
 
 
 bool QueueFamilyIndices::isComplete(void)
 {
-    return graphicsFamily.has_value() && presentFamily.has_value();
+    return graphicsFamily.has_value() && presentFamily.has_value() && computeFamily.has_value();
 }
 
 
-QueueFamilyIndices Queue::findQueueFamilies(const VkPhysicalDevice device, const VkSurfaceKHR surface)
+bool QueueFamilyIndices::hasAsyncCompute(void) const
+{
+    return computeFamily.has_value() && computeFamily != graphicsFamily;
+}
+
+
+bool QueueFamilyIndices::hasDedicatedTransfer(void) const
+{
+    return transferFamily.has_value() && transferFamily != graphicsFamily && transferFamily != computeFamily;
+}
+
+
+bool QueueFamilyIndices::isUnified(void) const
+{
+    return graphicsFamily.has_value() && graphicsFamily == presentFamily;
+}
+
+
+const QueueSlot QueueFamilyIndices::getSlot(const QueueRole role) const
+{
+    return slots[static_cast<uint32_t>(role)];
+}
+
+
+void Queue::assignSlot(QueueFamilyIndices& indices, const QueueRole role, const uint32_t family, const uint32_t queueCount, const float priority)
+{
+    std::vector<float>& priorities = indices.queuePriorities[family];
+    
+    // Share the family's last queue once its queueCount is used up
+    if (priorities.size() < queueCount)
+    {
+        priorities.push_back(priority);
+    }
+    
+    indices.slots[static_cast<uint32_t>(role)] = {family, static_cast<uint32_t>(priorities.size()) - 1};
+}
+
+
+QueueFamilyIndices Queue::findQueueFamilies(const VkPhysicalDevice device, const std::vector<VkSurfaceKHR>& surfaces)
 {
     QueueFamilyIndices indices;
     
@@ -18,52 +56,201 @@ QueueFamilyIndices Queue::findQueueFamilies(const VkPhysicalDevice device, const
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
     
-    uint32_t idx = 0;
-    for (const auto& queueFamily : queueFamilies)
+    std::optional<uint32_t> firstPresentFamily;
+    
+    for (uint32_t idx = 0; idx < queueFamilyCount; idx++)
     {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        const VkQueueFlags flags = queueFamilies[idx].queueFlags;
+        
+        VkBool32 presentSupport = !surfaces.empty();
+        for (const VkSurfaceKHR surface : surfaces)
+        {
+            VkBool32 surfaceSupport = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, idx, surface, &surfaceSupport);
+            presentSupport &= surfaceSupport;
+        }
+        
+        if (presentSupport && !firstPresentFamily.has_value())
+        {
+            firstPresentFamily = idx;
+        }
+        
+        // A family that both draws and presents wins over the first graphics family
+        if ((flags & VK_QUEUE_GRAPHICS_BIT) && (!indices.graphicsFamily.has_value() || (presentSupport && !indices.isUnified())))
         {
             indices.graphicsFamily = idx;
+            indices.presentFamily = presentSupport ? std::optional<uint32_t>(idx) : std::nullopt;
         }
         
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, idx, surface, &presentSupport);
+        // A compute family without graphics support is scheduled independently of the graphics queue
+        bool dedicatedCompute = (flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT);
         
-        if (presentSupport)
+        if (ASYNC_COMPUTE && dedicatedCompute && !indices.computeFamily.has_value())
         {
-            indices.presentFamily = idx;
+            indices.computeFamily = idx;
         }
         
-        if (indices.isComplete())
+        // Transfer-only families are usually backed by copy engines
+        bool dedicatedTransfer = (flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+        
+        if (dedicatedTransfer && !indices.transferFamily.has_value())
         {
-            break;
+            indices.transferFamily = idx;
         }
-
-        idx++;
     }
     
+    if (!indices.presentFamily.has_value())
+    {
+        indices.presentFamily = firstPresentFamily;
+    }
+    
+    if (!indices.graphicsFamily.has_value() || !indices.presentFamily.has_value())
+    {
+        return indices;
+    }
+    
+    // Fall back to the graphics family, compute work is then serialized with rendering
+    if (!indices.computeFamily.has_value() && (queueFamilies[indices.graphicsFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT))
+    {
+        indices.computeFamily = indices.graphicsFamily;
+    }
+    
+    // Graphics and compute families implicitly support transfers
+    if (!indices.transferFamily.has_value())
+    {
+        indices.transferFamily = indices.computeFamily.has_value() ? indices.computeFamily : indices.graphicsFamily;
+    }
+    
+    // Roles sharing a family get their own queue while queueCount allows, rendering at the highest priority
+    const uint32_t graphicsFamily = indices.graphicsFamily.value();
+    assignSlot(indices, QueueRole::Graphics, graphicsFamily, queueFamilies[graphicsFamily].queueCount, 1.0f);
+    
+    const uint32_t presentFamily = indices.presentFamily.value();
+    if (presentFamily == graphicsFamily)
+    {
+        indices.slots[static_cast<uint32_t>(QueueRole::Present)] = indices.getSlot(QueueRole::Graphics);
+    } else
+    {
+        assignSlot(indices, QueueRole::Present, presentFamily, queueFamilies[presentFamily].queueCount, 1.0f);
+    }
+    
+    if (indices.computeFamily.has_value())
+    {
+        const uint32_t computeFamily = indices.computeFamily.value();
+        assignSlot(indices, QueueRole::Compute, computeFamily, queueFamilies[computeFamily].queueCount, computeFamily == graphicsFamily ? 0.75f : 1.0f);
+    }
+    
+    const uint32_t transferFamily = indices.transferFamily.value();
+    assignSlot(indices, QueueRole::Transfer, transferFamily, queueFamilies[transferFamily].queueCount, indices.hasDedicatedTransfer() ? 1.0f : 0.5f);
+    
     return indices;
 }
 
+
 void Queue::populateDeviceQueueCreateInfo(std::vector<VkDeviceQueueCreateInfo>& createInfos, const QueueFamilyIndices& indices)
 {
-    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
-    
-    float queuePriority = 1.0f;
-    for (uint32_t queueFamily : uniqueQueueFamilies)
+    // The priorities are read through pointers by vkCreateDevice, so indices must outlive that call
+    for (const auto& [queueFamily, priorities] : indices.queuePriorities)
     {
         VkDeviceQueueCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         createInfo.queueFamilyIndex = queueFamily;
-        createInfo.queueCount = 1;
-        createInfo.pQueuePriorities = &queuePriority;
+        createInfo.queueCount = static_cast<uint32_t>(priorities.size());
+        createInfo.pQueuePriorities = priorities.data();
         createInfos.push_back(createInfo);
     }
 }
 
 
-void Queue::setupQueues(const VkDevice logicalDevice, const QueueFamilyIndices& indices)
+void Queue::setupQueues(const VkDevice logicalDevice, const QueueFamilyIndices& indices, const bool synchronization2, const VkAllocationCallbacks* pAllocator)
+{
+    for (uint32_t role = 0; role < static_cast<uint32_t>(QueueRole::Count); role++)
+    {
+        vkGetDeviceQueue(logicalDevice, indices.slots[role].family, indices.slots[role].index, &queues[role]);
+        capture::registerQueue(queues[role], static_cast<QueueRole>(role));
+    }
+    
+    graphicsScheduler.setupScheduler(logicalDevice, getGraphicsQueue(), synchronization2, pAllocator);
+    
+    if (!sharedScheduler())
+    {
+        computeScheduler.setupScheduler(logicalDevice, getComputeQueue(), synchronization2, pAllocator);
+    }
+}
+
+
+void Queue::destroyQueues(const VkDevice logicalDevice, const VkAllocationCallbacks* pAllocator)
+{
+    computeScheduler.destroyScheduler(logicalDevice, pAllocator);
+    graphicsScheduler.destroyScheduler(logicalDevice, pAllocator);
+}
+
+
+bool Queue::sharedScheduler(void) const
+{
+    return getComputeQueue() == getGraphicsQueue();
+}
+
+
+void Queue::flush(void)
+{
+    if (!sharedScheduler())
+    {
+        computeScheduler.flush();
+    }
+    
+    graphicsScheduler.flush();
+}
+
+
+void Queue::endFrame(void)
+{
+    if (!sharedScheduler())
+    {
+        computeScheduler.endFrame();
+    }
+    
+    graphicsScheduler.endFrame();
+}
+
+
+const VkQueue Queue::getQueue(const QueueRole role) const
+{
+    return queues[static_cast<uint32_t>(role)];
+}
+
+
+const VkQueue Queue::getGraphicsQueue(void) const
+{
+    return getQueue(QueueRole::Graphics);
+}
+
+
+const VkQueue Queue::getPresentQueue(void) const
+{
+    return getQueue(QueueRole::Present);
+}
+
+
+const VkQueue Queue::getComputeQueue(void) const
+{
+    return getQueue(QueueRole::Compute);
+}
+
+
+const VkQueue Queue::getTransferQueue(void) const
+{
+    return getQueue(QueueRole::Transfer);
+}
+
+
+SubmitScheduler& Queue::getGraphicsScheduler(void)
+{
+    return graphicsScheduler;
+}
+
+
+SubmitScheduler& Queue::getComputeScheduler(void)
 {
-    vkGetDeviceQueue(logicalDevice, indices.graphicsFamily.value(), 0, &graphicsQueue);
-    vkGetDeviceQueue(logicalDevice, indices.presentFamily.value(), 0, &presentQueue);
+    return sharedScheduler() ? graphicsScheduler : computeScheduler;
 }
@@ -0,0 +1,583 @@
+#include "ShaderReflection.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+
+static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+// The subset of the SPIR-V grammar reflection needs
+enum SpirvOp : uint32_t
+{
+    OpEntryPoint = 15,
+    OpTypeBool = 20,
+    OpTypeInt = 21,
+    OpTypeFloat = 22,
+    OpTypeVector = 23,
+    OpTypeMatrix = 24,
+    OpTypeImage = 25,
+    OpTypeSampler = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct = 30,
+    OpTypePointer = 32,
+    OpConstant = 43,
+    OpVariable = 59,
+    OpDecorate = 71,
+    OpMemberDecorate = 72
+};
+
+enum SpirvDecoration : uint32_t
+{
+    DecorationBlock = 2,
+    DecorationBufferBlock = 3,
+    DecorationArrayStride = 6,
+    DecorationMatrixStride = 7,
+    DecorationBuiltIn = 11,
+    DecorationLocation = 30,
+    DecorationBinding = 33,
+    DecorationDescriptorSet = 34,
+    DecorationOffset = 35
+};
+
+enum SpirvStorageClass : uint32_t
+{
+    StorageClassUniformConstant = 0,
+    StorageClassInput = 1,
+    StorageClassUniform = 2,
+    StorageClassPushConstant = 9,
+    StorageClassStorageBuffer = 12
+};
+
+enum SpirvDim : uint32_t
+{
+    DimBuffer = 5,
+    DimSubpassData = 6
+};
+
+struct SpirvType
+{
+    uint32_t op = 0;
+    // Operands after the result id: component type, counts, storage class and so on
+    std::vector<uint32_t> operands;
+};
+
+struct SpirvMember
+{
+    uint32_t offset = 0;
+    uint32_t matrixStride = 0;
+    bool builtIn = false;
+};
+
+struct SpirvId
+{
+    SpirvType type;
+    uint32_t constant = 0;
+    uint32_t set = 0;
+    uint32_t binding = 0;
+    uint32_t location = 0;
+    uint32_t arrayStride = 0;
+    bool hasBinding = false;
+    bool hasLocation = false;
+    bool block = false;
+    bool bufferBlock = false;
+    bool builtIn = false;
+    std::vector<SpirvMember> members;
+};
+
+struct SpirvVariable
+{
+    uint32_t id;
+    uint32_t pointerType;
+    uint32_t storageClass;
+};
+
+class SpirvModule
+{
+public:
+    std::vector<SpirvId> ids;
+    std::vector<SpirvVariable> variables;
+    VkShaderStageFlags stage = 0;
+    
+    const SpirvId& get(const uint32_t id) const
+    {
+        if (id >= ids.size())
+        {
+            throw std::runtime_error("SPIR-V id out of range!");
+        }
+        return ids[id];
+    }
+    
+    SpirvMember& member(const uint32_t id, const uint32_t index)
+    {
+        SpirvId& target = ids.at(id);
+        if (target.members.size() <= index)
+        {
+            target.members.resize(index + 1);
+        }
+        return target.members[index];
+    }
+    
+    uint32_t sizeOf(const uint32_t typeId, const uint32_t matrixStride) const;
+};
+
+
+uint32_t SpirvModule::sizeOf(const uint32_t typeId, const uint32_t matrixStride) const
+{
+    const SpirvId& id = get(typeId);
+    const std::vector<uint32_t>& operands = id.type.operands;
+    
+    switch (id.type.op)
+    {
+        case OpTypeBool:
+            return 4;
+        case OpTypeInt:
+        case OpTypeFloat:
+            return operands.at(0) / 8;
+        case OpTypeVector:
+            return operands.at(1) * sizeOf(operands.at(0), 0);
+        case OpTypeMatrix:
+            return operands.at(1) * (matrixStride > 0 ? matrixStride : sizeOf(operands.at(0), 0));
+        case OpTypeArray:
+            return get(operands.at(1)).constant * (id.arrayStride > 0 ? id.arrayStride : sizeOf(operands.at(0), matrixStride));
+        case OpTypeStruct:
+        {
+            uint32_t size = 0;
+            for (uint32_t i = 0; i < operands.size(); i++)
+            {
+                const SpirvMember memberInfo = i < id.members.size() ? id.members[i] : SpirvMember{};
+                size = std::max(size, memberInfo.offset + sizeOf(operands[i], memberInfo.matrixStride));
+            }
+            return size;
+        }
+        default:
+            throw std::runtime_error("SPIR-V type without a size in a push constant block!");
+    }
+}
+
+
+static VkShaderStageFlags stageFromExecutionModel(const uint32_t model)
+{
+    switch (model)
+    {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default: throw std::runtime_error("Unsupported SPIR-V execution model!");
+    }
+}
+
+
+// Operands every instruction of the op has, so parseModule can index them without checking each one
+static uint32_t minOperandCount(const uint32_t op)
+{
+    switch (op)
+    {
+        case OpTypeBool:
+        case OpTypeSampler:
+        case OpTypeStruct:
+            return 1;
+        case OpTypeFloat:
+        case OpTypeSampledImage:
+        case OpTypeRuntimeArray:
+        case OpDecorate:
+            return 2;
+        case OpEntryPoint:
+        case OpTypeInt:
+        case OpTypeVector:
+        case OpTypeMatrix:
+        case OpTypeArray:
+        case OpTypePointer:
+        case OpConstant:
+        case OpVariable:
+        case OpMemberDecorate:
+            return 3;
+        case OpTypeImage:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+
+static SpirvModule parseModule(const ByteView code)
+{
+    if (code.size % 4 != 0 || code.size < 20)
+    {
+        throw std::runtime_error("Shader code is not SPIR-V!");
+    }
+    
+    std::vector<uint32_t> words(code.size / 4);
+    std::memcpy(words.data(), code.data, code.size);
+    if (words[0] != SPIRV_MAGIC)
+    {
+        throw std::runtime_error("Shader code is not SPIR-V!");
+    }
+    
+    SpirvModule module;
+    module.ids.resize(words[3]);
+    
+    for (size_t position = 5; position < words.size();)
+    {
+        const uint32_t op = words[position] & 0xffff;
+        const uint32_t count = words[position] >> 16;
+        if (count == 0 || position + count > words.size())
+        {
+            throw std::runtime_error("Truncated SPIR-V instruction!");
+        }
+        const uint32_t* operands = &words[position + 1];
+        const uint32_t operandCount = count - 1;
+        position += count;
+        if (operandCount < minOperandCount(op))
+        {
+            throw std::runtime_error("Malformed SPIR-V instruction!");
+        }
+        
+        switch (op)
+        {
+            case OpEntryPoint:
+                if (module.stage != 0)
+                {
+                    throw std::runtime_error("SPIR-V modules with several entry points are not supported!");
+                }
+                module.stage = stageFromExecutionModel(operands[0]);
+                break;
+            case OpTypeBool:
+            case OpTypeInt:
+            case OpTypeFloat:
+            case OpTypeVector:
+            case OpTypeMatrix:
+            case OpTypeImage:
+            case OpTypeSampler:
+            case OpTypeSampledImage:
+            case OpTypeArray:
+            case OpTypeRuntimeArray:
+            case OpTypeStruct:
+            case OpTypePointer:
+            {
+                SpirvId& id = module.ids.at(operands[0]);
+                id.type.op = op;
+                id.type.operands.assign(operands + 1, operands + operandCount);
+                break;
+            }
+            case OpConstant:
+                // Only 32-bit integers size arrays
+                module.ids.at(operands[1]).constant = operandCount > 2 ? operands[2] : 0;
+                break;
+            case OpVariable:
+                module.variables.push_back({operands[1], operands[0], operands[2]});
+                break;
+            case OpDecorate:
+            {
+                SpirvId& id = module.ids.at(operands[0]);
+                const uint32_t value = operandCount > 2 ? operands[2] : 0;
+                switch (operands[1])
+                {
+                    case DecorationBlock: id.block = true; break;
+                    case DecorationBufferBlock: id.bufferBlock = true; break;
+                    case DecorationArrayStride: id.arrayStride = value; break;
+                    case DecorationBuiltIn: id.builtIn = true; break;
+                    case DecorationLocation: id.location = value; id.hasLocation = true; break;
+                    case DecorationBinding: id.binding = value; id.hasBinding = true; break;
+                    case DecorationDescriptorSet: id.set = value; break;
+                    default: break;
+                }
+                break;
+            }
+            case OpMemberDecorate:
+            {
+                SpirvMember& memberInfo = module.member(operands[0], operands[1]);
+                const uint32_t value = operandCount > 3 ? operands[3] : 0;
+                switch (operands[2])
+                {
+                    case DecorationOffset: memberInfo.offset = value; break;
+                    case DecorationMatrixStride: memberInfo.matrixStride = value; break;
+                    case DecorationBuiltIn: memberInfo.builtIn = true; break;
+                    default: break;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    
+    if (module.stage == 0)
+    {
+        throw std::runtime_error("SPIR-V module without an entry point!");
+    }
+    
+    return module;
+}
+
+
+// Arrays of descriptors become the descriptor count
+static uint32_t unwrapArrays(const SpirvModule& module, uint32_t& typeId)
+{
+    uint32_t count = 1;
+    while (true)
+    {
+        const SpirvType& type = module.get(typeId).type;
+        if (type.op == OpTypeArray)
+        {
+            count *= module.get(type.operands.at(1)).constant;
+            typeId = type.operands.at(0);
+        } else if (type.op == OpTypeRuntimeArray)
+        {
+            throw std::runtime_error("Unsized descriptor arrays are not supported!");
+        } else
+        {
+            return count;
+        }
+    }
+}
+
+
+static VkDescriptorType descriptorTypeOf(const SpirvModule& module, const uint32_t typeId, const uint32_t storageClass)
+{
+    const SpirvId& id = module.get(typeId);
+    
+    if (storageClass == StorageClassStorageBuffer || (storageClass == StorageClassUniform && id.bufferBlock))
+    {
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    if (storageClass == StorageClassUniform)
+    {
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+    
+    switch (id.type.op)
+    {
+        case OpTypeSampler:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case OpTypeSampledImage:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case OpTypeImage:
+        {
+            // Operands: sampled type, dim, depth, arrayed, multisampled, sampled (1 with a sampler, 2 storage)
+            const uint32_t dim = id.type.operands.at(1);
+            const bool storage = id.type.operands.at(5) == 2;
+            if (dim == DimBuffer)
+            {
+                return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            if (dim == DimSubpassData)
+            {
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        default:
+            throw std::runtime_error("Unsupported SPIR-V descriptor type!");
+    }
+}
+
+
+static ReflectedInput reflectInput(const SpirvModule& module, const uint32_t location, const uint32_t typeId)
+{
+    const SpirvType* type = &module.get(typeId).type;
+    uint32_t componentCount = 1;
+    if (type->op == OpTypeVector)
+    {
+        componentCount = type->operands.at(1);
+        type = &module.get(type->operands.at(0)).type;
+    }
+    
+    NumericType numericType = NumericType::Float;
+    if (type->op == OpTypeInt)
+    {
+        numericType = type->operands.at(1) != 0 ? NumericType::Sint : NumericType::Uint;
+    } else if (type->op != OpTypeFloat)
+    {
+        throw std::runtime_error("Vertex inputs must be scalars or vectors!");
+    }
+    
+    return {location, componentCount, numericType};
+}
+
+
+ShaderReflection spirv::reflectShader(const ByteView code)
+{
+    const SpirvModule module = parseModule(code);
+    
+    ShaderReflection reflection;
+    reflection.stageFlags = module.stage;
+    
+    for (const SpirvVariable& variable : module.variables)
+    {
+        const SpirvId& id = module.get(variable.id);
+        const SpirvType& pointer = module.get(variable.pointerType).type;
+        if (pointer.op != OpTypePointer)
+        {
+            throw std::runtime_error("SPIR-V variable without a pointer type!");
+        }
+        uint32_t typeId = pointer.operands.at(1);
+        
+        switch (variable.storageClass)
+        {
+            case StorageClassUniformConstant:
+            case StorageClassUniform:
+            case StorageClassStorageBuffer:
+            {
+                if (!id.hasBinding)
+                {
+                    break;
+                }
+                const uint32_t count = unwrapArrays(module, typeId);
+                reflection.bindings.push_back({id.set, id.binding, descriptorTypeOf(module, typeId, variable.storageClass), count, module.stage});
+                break;
+            }
+            case StorageClassPushConstant:
+            {
+                const SpirvId& block = module.get(typeId);
+                uint32_t offset = UINT32_MAX;
+                for (const SpirvMember& memberInfo : block.members)
+                {
+                    offset = std::min(offset, memberInfo.offset);
+                }
+                offset = block.members.empty() ? 0 : offset;
+                reflection.pushConstantRanges.push_back({module.stage, offset, module.sizeOf(typeId, 0) - offset});
+                break;
+            }
+            case StorageClassInput:
+            {
+                const bool builtInBlock = !module.get(typeId).members.empty() && module.get(typeId).members[0].builtIn;
+                if (module.stage == VK_SHADER_STAGE_VERTEX_BIT && !id.builtIn && !builtInBlock && id.hasLocation)
+                {
+                    reflection.vertexInputs.push_back(reflectInput(module, id.location, typeId));
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b)
+    {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const ReflectedInput& a, const ReflectedInput& b)
+    {
+        return a.location < b.location;
+    });
+    
+    return reflection;
+}
+
+
+ShaderReflection spirv::mergeStages(const std::vector<ShaderReflection>& stages)
+{
+    ShaderReflection merged;
+    
+    for (const ShaderReflection& stage : stages)
+    {
+        merged.stageFlags |= stage.stageFlags;
+        
+        for (const ReflectedBinding& binding : stage.bindings)
+        {
+            const auto existing = std::find_if(merged.bindings.begin(), merged.bindings.end(), [&binding](const ReflectedBinding& other)
+            {
+                return other.set == binding.set && other.binding == binding.binding;
+            });
+            
+            if (existing == merged.bindings.end())
+            {
+                merged.bindings.push_back(binding);
+            } else if (existing->descriptorType != binding.descriptorType || existing->descriptorCount != binding.descriptorCount)
+            {
+                throw std::runtime_error("Shader stages disagree on set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + "!");
+            } else
+            {
+                existing->stageFlags |= binding.stageFlags;
+            }
+        }
+        
+        // One range for all stages, so a single vkCmdPushConstants with the combined flags covers every byte
+        for (const VkPushConstantRange& range : stage.pushConstantRanges)
+        {
+            if (merged.pushConstantRanges.empty())
+            {
+                merged.pushConstantRanges.push_back(range);
+                continue;
+            }
+            
+            VkPushConstantRange& combined = merged.pushConstantRanges[0];
+            const uint32_t end = std::max(combined.offset + combined.size, range.offset + range.size);
+            combined.offset = std::min(combined.offset, range.offset);
+            combined.size = end - combined.offset;
+            combined.stageFlags |= range.stageFlags;
+        }
+        
+        if (!stage.vertexInputs.empty())
+        {
+            merged.vertexInputs = stage.vertexInputs;
+        }
+    }
+    
+    std::sort(merged.bindings.begin(), merged.bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b)
+    {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    
+    return merged;
+}
+
+
+static NumericType numericTypeOf(const VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8_UINT:
+        case VK_FORMAT_R8G8_UINT:
+        case VK_FORMAT_R8G8B8A8_UINT:
+        case VK_FORMAT_R16_UINT:
+        case VK_FORMAT_R16G16_UINT:
+        case VK_FORMAT_R16G16B16A16_UINT:
+        case VK_FORMAT_R32_UINT:
+        case VK_FORMAT_R32G32_UINT:
+        case VK_FORMAT_R32G32B32_UINT:
+        case VK_FORMAT_R32G32B32A32_UINT:
+            return NumericType::Uint;
+        case VK_FORMAT_R8_SINT:
+        case VK_FORMAT_R8G8_SINT:
+        case VK_FORMAT_R8G8B8A8_SINT:
+        case VK_FORMAT_R16_SINT:
+        case VK_FORMAT_R16G16_SINT:
+        case VK_FORMAT_R16G16B16A16_SINT:
+        case VK_FORMAT_R32_SINT:
+        case VK_FORMAT_R32G32_SINT:
+        case VK_FORMAT_R32G32B32_SINT:
+        case VK_FORMAT_R32G32B32A32_SINT:
+            return NumericType::Sint;
+        default:
+            // Float, normalized and scaled formats
+            return NumericType::Float;
+    }
+}
+
+
+void spirv::checkVertexInputs(const ShaderReflection& reflection, const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions)
+{
+    for (const ReflectedInput& input : reflection.vertexInputs)
+    {
+        const auto attribute = std::find_if(attributeDescriptions.begin(), attributeDescriptions.end(), [&input](const VkVertexInputAttributeDescription& description)
+        {
+            return description.location == input.location;
+        });
+        
+        if (attribute == attributeDescriptions.end())
+        {
+            throw std::runtime_error("Vertex input location " + std::to_string(input.location) + " has no attribute!");
+        }
+        if (numericTypeOf(attribute->format) != input.numericType)
+        {
+            throw std::runtime_error("Vertex input location " + std::to_string(input.location) + " does not match its attribute format!");
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "ShaderVariant.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+ShaderVariant& ShaderVariant::setWord(const uint32_t constantId, const uint32_t word)
+{
+    const auto entry = std::lower_bound(entries.begin(), entries.end(), constantId, [](const VkSpecializationMapEntry& entry, const uint32_t id)
+    {
+        return entry.constantID < id;
+    });
+    const size_t index = static_cast<size_t>(entry - entries.begin());
+    
+    if (entry != entries.end() && entry->constantID == constantId)
+    {
+        data[index] = word;
+        return *this;
+    }
+    
+    entries.insert(entry, {constantId, 0, sizeof(uint32_t)});
+    data.insert(data.begin() + static_cast<std::ptrdiff_t>(index), word);
+    for (size_t i = index; i < entries.size(); i++)
+    {
+        entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+    }
+    
+    return *this;
+}
+
+
+ShaderVariant& ShaderVariant::set(const uint32_t constantId, const bool value)
+{
+    return setWord(constantId, value ? VK_TRUE : VK_FALSE);
+}
+
+
+ShaderVariant& ShaderVariant::set(const uint32_t constantId, const int32_t value)
+{
+    return setWord(constantId, static_cast<uint32_t>(value));
+}
+
+
+ShaderVariant& ShaderVariant::set(const uint32_t constantId, const uint32_t value)
+{
+    return setWord(constantId, value);
+}
+
+
+ShaderVariant& ShaderVariant::set(const uint32_t constantId, const float value)
+{
+    uint32_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    return setWord(constantId, word);
+}
+
+
+const bool ShaderVariant::empty(void) const
+{
+    return entries.empty();
+}
+
+
+const size_t ShaderVariant::getHash(void) const
+{
+    // FNV-1a over the id and value words
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        for (const uint32_t word : {entries[i].constantID, data[i]})
+        {
+            hash ^= word;
+            hash *= 1099511628211ull;
+        }
+    }
+    
+    return static_cast<size_t>(hash);
+}
+
+
+bool ShaderVariant::operator==(const ShaderVariant& other) const
+{
+    if (data != other.data || entries.size() != other.entries.size())
+    {
+        return false;
+    }
+    
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].constantID != other.entries[i].constantID)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+bool ShaderVariant::operator!=(const ShaderVariant& other) const
+{
+    return !(*this == other);
+}
+
+
+void ShaderVariant::populateSpecializationInfo(VkSpecializationInfo& specializationInfo) const
+{
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+    specializationInfo.pMapEntries = entries.data();
+    specializationInfo.dataSize = data.size() * sizeof(uint32_t);
+    specializationInfo.pData = data.data();
+}
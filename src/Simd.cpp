@@ -0,0 +1,58 @@
+#include "Simd.hpp"
+
+
+SimdKernel simd::detectKernel(void)
+{
+#if defined(SIMD_X86)
+    if (isKernelSupported(SimdKernel::Avx2))
+    {
+        return SimdKernel::Avx2;
+    }
+    return SimdKernel::Sse;
+#elif defined(SIMD_NEON)
+    return SimdKernel::Neon;
+#else
+    return SimdKernel::Scalar;
+#endif
+}
+
+
+bool simd::isKernelSupported(const SimdKernel kernel)
+{
+    switch (kernel)
+    {
+        case SimdKernel::Scalar:
+            return true;
+#if defined(SIMD_X86)
+        case SimdKernel::Sse:
+            return true;
+        case SimdKernel::Avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#if defined(SIMD_NEON)
+        case SimdKernel::Neon:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+
+const std::string simd::getKernelName(const SimdKernel kernel)
+{
+    switch (kernel)
+    {
+        case SimdKernel::Scalar:
+            return "scalar";
+        case SimdKernel::Sse:
+            return "sse";
+        case SimdKernel::Avx2:
+            return "avx2";
+        case SimdKernel::Neon:
+            return "neon";
+    }
+    
+    return "unknown";
+}
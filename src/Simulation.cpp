@@ -0,0 +1,215 @@
+#include "Simulation.hpp"
+#include "CommandCapture.hpp"
+
+#include <random>
+#include <cstring>
+
+
+void Simulation::createParticleBuffers(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const Queue& queue, HostAllocator* hostAllocator)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> velocity(-0.25f, 0.25f);
+    
+    std::vector<Particle> particles(PARTICLE_COUNT);
+    for (auto& particle : particles)
+    {
+        particle.position[0] = position(rng);
+        particle.position[1] = position(rng);
+        particle.velocity[0] = velocity(rng);
+        particle.velocity[1] = velocity(rng);
+    }
+    
+    const VkDeviceSize bufferSize = sizeof(Particle) * PARTICLE_COUNT;
+    
+    Buffer stagingBuffer;
+    stagingBuffer.setupBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}, hostAllocator);
+    std::memcpy(stagingBuffer.map(device), particles.data(), static_cast<size_t>(bufferSize));
+    stagingBuffer.unmap(device);
+    
+    // Written by the compute queue and read by the graphics queue without ownership transfers
+    const std::vector<uint32_t> families = {indices.graphicsFamily.value(), indices.computeFamily.value()};
+    
+    VkCommandBuffer commandBuffer = commandPool.beginSingleTimeCommands(device);
+    for (auto& particleBuffer : particleBuffers)
+    {
+        particleBuffer.setupBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, families, hostAllocator);
+        
+        VkBufferCopy copyRegion{};
+        copyRegion.size = bufferSize;
+        capture::cmdCopyBuffer(commandBuffer, stagingBuffer.getBuffer(), particleBuffer.getBuffer(), 1, &copyRegion);
+    }
+    commandPool.endSingleTimeCommands(device, queue.getComputeQueue(), commandBuffer);
+    
+    stagingBuffer.destroyBuffer(device, hostAllocator);
+}
+
+
+void Simulation::createDescriptorSetLayouts(PipelineLayoutCache& layoutCache)
+{
+    computeSetLayout = layoutCache.getPipelineSetLayout(computePipeline.getPipelineLayout(), 0);
+    
+    // Set 0 of shaders/shader.vert, the same layout the graphics pipeline reflects
+    const ReflectedBinding particleBinding{0, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT};
+    renderSetLayout = layoutCache.getSetLayout(VK_PIPELINE_BIND_POINT_GRAPHICS, {particleBinding});
+}
+
+
+void Simulation::createDescriptorSets(const VkDevice device, HostAllocator* hostAllocator)
+{
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 6;
+    
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 4;
+    
+    if (capture::createDescriptorPool(device, &poolInfo, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DESCRIPTOR_POOL), &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create simulation descriptor pool!");
+    }
+    
+    const VkDescriptorSetLayout layouts[4] = {computeSetLayout, computeSetLayout, renderSetLayout, renderSetLayout};
+    VkDescriptorSet sets[4];
+    
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 4;
+    allocInfo.pSetLayouts = layouts;
+    
+    if (capture::allocateDescriptorSets(device, &allocInfo, sets) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate simulation descriptor sets!");
+    }
+    
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        computeSets[i] = sets[i];
+        renderSets[i] = sets[2 + i];
+        
+        VkDescriptorBufferInfo bufferInfos[2]{};
+        bufferInfos[0].buffer = particleBuffers[i].getBuffer();
+        bufferInfos[0].range = VK_WHOLE_SIZE;
+        bufferInfos[1].buffer = particleBuffers[1 - i].getBuffer();
+        bufferInfos[1].range = VK_WHOLE_SIZE;
+        
+        VkWriteDescriptorSet writes[2]{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = computeSets[i];
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 2;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[0].pBufferInfo = bufferInfos;
+        
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = renderSets[i];
+        writes[1].dstBinding = 0;
+        writes[1].descriptorCount = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[1].pBufferInfo = &bufferInfos[0];
+        
+        capture::updateDescriptorSets(device, 2, writes, 0, nullptr);
+    }
+}
+
+
+void Simulation::setupSimulation(const VkPhysicalDevice physicalDevice, const VkDevice device, const QueueFamilyIndices& indices, const Queue& queue, const ByteView compShaderCode, PipelineLayoutCache& layoutCache, const VkPipelineCache pipelineCache, HostAllocator* hostAllocator)
+{
+    commandPool.setupCommandPool(device, indices.computeFamily.value(), HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_COMMAND_POOL));
+    commandPool.setupCommandBuffers(device, MAX_FRAMES_IN_FLIGHT);
+    
+    createParticleBuffers(physicalDevice, device, indices, queue, hostAllocator);
+    
+    // local_size_x_id 0 in shader.comp
+    computePipeline.setShaderVariant(ShaderVariant().set(0, PARTICLE_WORKGROUP_SIZE));
+    computePipeline.setupComputePipeline(device, compShaderCode, layoutCache, pipelineCache, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    
+    createDescriptorSetLayouts(layoutCache);
+    createDescriptorSets(device, hostAllocator);
+    timer.setupTimer(physicalDevice, device, indices.computeFamily.value(), MAX_FRAMES_IN_FLIGHT, 1, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_QUERY_POOL));
+}
+
+
+void Simulation::destroySimulation(const VkDevice device, HostAllocator* hostAllocator)
+{
+    timer.destroyTimer(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_QUERY_POOL));
+    computePipeline.destroyComputePipeline(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_PIPELINE));
+    
+    if (descriptorPool != VK_NULL_HANDLE)
+    {
+        capture::destroyDescriptorPool(device, descriptorPool, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    }
+    
+    for (auto& particleBuffer : particleBuffers)
+    {
+        particleBuffer.destroyBuffer(device, hostAllocator);
+    }
+    
+    commandPool.destroyCommandPool(device, HostAllocator::callbacksFor(hostAllocator, VK_OBJECT_TYPE_COMMAND_POOL));
+}
+
+
+void Simulation::recordCommandBuffer(const VkCommandBuffer commandBuffer, const uint64_t frame, const float deltaTime)
+{
+    const uint32_t slot = static_cast<uint32_t>(frame % MAX_FRAMES_IN_FLIGHT);
+    
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    
+    if (capture::beginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin recording compute command buffer!");
+    }
+    
+    timer.cmdBegin(commandBuffer, slot);
+    
+    // The previous dispatch on this queue wrote the buffer this one reads
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    capture::cmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    
+    const VkDescriptorSet computeSet = computeSets[frame % 2];
+    capture::cmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline.getPipeline());
+    capture::cmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline.getPipelineLayout(), 0, 1, &computeSet, 0, nullptr);
+    
+    SimulationPushConstants pushConstants{deltaTime, PARTICLE_COUNT};
+    capture::cmdPushConstants(commandBuffer, computePipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+    
+    capture::cmdDispatch(commandBuffer, (PARTICLE_COUNT + PARTICLE_WORKGROUP_SIZE - 1) / PARTICLE_WORKGROUP_SIZE, 1, 1);
+    
+    timer.cmdEnd(commandBuffer, slot);
+    
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record compute command buffer!");
+    }
+}
+
+
+const VkCommandBuffer Simulation::recordFrame(const uint64_t frame, const float deltaTime)
+{
+    const VkCommandBuffer commandBuffer = commandPool.getCommandBuffer(static_cast<uint32_t>(frame % MAX_FRAMES_IN_FLIGHT));
+    vkResetCommandBuffer(commandBuffer, 0);
+    recordCommandBuffer(commandBuffer, frame, deltaTime);
+    
+    return commandBuffer;
+}
+
+
+bool Simulation::readTimings(const VkDevice device, const uint32_t slot, GpuInterval& interval)
+{
+    return timer.readInterval(device, slot, interval);
+}
+
+
+const VkDescriptorSet Simulation::getRenderSet(const uint64_t frame) const
+{
+    return renderSets[frame % 2];
+}
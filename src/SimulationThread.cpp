@@ -0,0 +1,144 @@
+#include "SimulationThread.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+
+void JitterStats::add(const double intervalMs)
+{
+    count++;
+    sumMs += intervalMs;
+    sumSquaresMs += intervalMs * intervalMs;
+    maxMs = std::max(maxMs, intervalMs);
+}
+
+
+double JitterStats::meanMs(void) const
+{
+    return count > 0 ? sumMs / static_cast<double>(count) : 0.0;
+}
+
+
+double JitterStats::jitterMs(void) const
+{
+    if (count < 2)
+    {
+        return 0.0;
+    }
+    
+    const double mean = meanMs();
+    return std::sqrt(std::max(sumSquaresMs / static_cast<double>(count) - mean * mean, 0.0));
+}
+
+
+void JitterStats::report(std::ostream& os, const char* label) const
+{
+    os << std::fixed << std::setprecision(3)
+       << label << meanMs() << " ms mean, " << jitterMs() << " ms jitter, " << maxMs << " ms max";
+}
+
+
+void SimulationThread::startThread(FramePacer& pacer)
+{
+    this->pacer = &pacer;
+    running.store(true);
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+
+void SimulationThread::stopThread(void)
+{
+    running.store(false);
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+
+bool SimulationThread::pushKey(const KeyEvent& event)
+{
+    return keyQueue.push(event);
+}
+
+
+const SimulationSnapshot& SimulationThread::acquireSnapshot(void)
+{
+    return snapshots.acquire();
+}
+
+
+SimulationState SimulationThread::interpolate(const SimulationSnapshot& snapshot, const std::chrono::steady_clock::time_point now)
+{
+    const double sincePublished = std::chrono::duration<double>(now - snapshot.publishedAt).count();
+    const double alpha = std::clamp(sincePublished * SIMULATION_TICK_RATE, 0.0, 1.0);
+    
+    SimulationState state = snapshot.current;
+    state.time = snapshot.previous.time + alpha * (snapshot.current.time - snapshot.previous.time);
+    return state;
+}
+
+
+void SimulationThread::run(void)
+{
+    using Clock = std::chrono::steady_clock;
+    
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / SIMULATION_TICK_RATE));
+    const double tickSeconds = 1.0 / SIMULATION_TICK_RATE;
+    
+    SimulationState state;
+    JitterStats tickJitter;
+    uint64_t droppedTicks = 0;
+    auto nextTick = Clock::now();
+    auto lastTickStart = nextTick;
+    
+    while (running.load())
+    {
+        const auto tickStart = Clock::now();
+        if (state.tick > 0)
+        {
+            tickJitter.add(std::chrono::duration<double, std::milli>(tickStart - lastTickStart).count());
+        }
+        lastTickStart = tickStart;
+        
+        const bool wasPaused = state.paused;
+        KeyEvent event;
+        while (keyQueue.pop(event))
+        {
+            if (event.key == GLFW_KEY_SPACE && event.action == GLFW_PRESS)
+            {
+                state.paused = !state.paused;
+            }
+        }
+        
+        const SimulationState previous = state;
+        state.tick++;
+        state.time += state.paused ? 0.0 : tickSeconds;
+        
+        SimulationSnapshot& snapshot = snapshots.getBack();
+        snapshot.previous = previous;
+        snapshot.current = state;
+        snapshot.publishedAt = Clock::now();
+        snapshot.tickJitter = tickJitter;
+        snapshot.droppedTicks = droppedTicks;
+        snapshots.publish();
+        
+        // Wakes an idle render loop, a running one picks the new state up with its next frame
+        if (state.paused != wasPaused)
+        {
+            pacer->setAnimating(!state.paused);
+        }
+        
+        // After a spike the missed ticks run back to back, up to a limit past which the clock skips ahead
+        nextTick += tickDuration;
+        const auto now = Clock::now();
+        if (now - nextTick > SIMULATION_MAX_CATCHUP_TICKS * tickDuration)
+        {
+            droppedTicks += static_cast<uint64_t>((now - nextTick) / tickDuration);
+            nextTick = now;
+        }
+        
+        std::this_thread::sleep_until(nextTick);
+    }
+}
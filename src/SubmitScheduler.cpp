@@ -0,0 +1,339 @@
+#include "SubmitScheduler.hpp"
+#include "CommandCapture.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+
+
+static std::atomic<uint64_t> nextSchedulerId{1};
+
+
+void SubmitRequest::addWait(const VkSemaphore semaphore, const VkPipelineStageFlags2KHR stageMask, const uint64_t value)
+{
+    VkSemaphoreSubmitInfoKHR waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+    waitInfo.semaphore = semaphore;
+    waitInfo.value = value;
+    waitInfo.stageMask = stageMask;
+    waitSemaphores.push_back(waitInfo);
+}
+
+
+void SubmitRequest::addSignal(const VkSemaphore semaphore, const VkPipelineStageFlags2KHR stageMask, const uint64_t value)
+{
+    VkSemaphoreSubmitInfoKHR signalInfo{};
+    signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+    signalInfo.semaphore = semaphore;
+    signalInfo.value = value;
+    signalInfo.stageMask = stageMask;
+    signalSemaphores.push_back(signalInfo);
+}
+
+
+void SubmitStats::report(std::ostream& os, const char* name) const
+{
+    if (frames == 0 || submitCalls == 0) return;
+    
+    os << std::fixed << std::setprecision(2)
+       << "[submit] " << name
+       << " | submits/frame: " << static_cast<double>(submitCalls) / static_cast<double>(frames)
+       << " | requests/batch: " << static_cast<double>(requests) / static_cast<double>(submitCalls)
+       << " (max " << maxBatchRequests << ")"
+       << " | submit infos/batch: " << static_cast<double>(submitInfos) / static_cast<double>(submitCalls)
+       << " | command buffers: " << commandBuffers
+       << " | last frame: " << lastFrameSubmitCalls << " submits, " << lastFrameRequests << " requests" << '\n';
+}
+
+
+void SubmitScheduler::setupScheduler(const VkDevice device, const VkQueue queue, const bool synchronization2, const VkAllocationCallbacks* pAllocator)
+{
+    this->queue = queue;
+    schedulerId = nextSchedulerId.fetch_add(1);
+    timeline.setupSemaphore(device, 0, pAllocator);
+    
+    if (synchronization2)
+    {
+        pfnQueueSubmit2 = (PFN_vkQueueSubmit2KHR) vkGetDeviceProcAddr(device, "vkQueueSubmit2KHR");
+    }
+}
+
+
+void SubmitScheduler::destroyScheduler(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    timeline.destroySemaphore(device, pAllocator);
+}
+
+
+SubmitScheduler::Lane& SubmitScheduler::getLane(void)
+{
+    // Scheduler ids are never reused, so entries of destroyed schedulers are never matched
+    thread_local std::vector<std::pair<uint64_t, Lane*>> threadLanes;
+    
+    for (const auto& entry : threadLanes)
+    {
+        if (entry.first == schedulerId)
+        {
+            return *entry.second;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(lanesMutex);
+    lanes.push_back(std::make_unique<Lane>());
+    threadLanes.emplace_back(schedulerId, lanes.back().get());
+    
+    return *lanes.back();
+}
+
+
+uint64_t SubmitScheduler::enqueue(SubmitRequest request)
+{
+    Lane& lane = getLane();
+    
+    std::lock_guard<std::mutex> lock(lane.mutex);
+    const uint64_t value = pendingValue.load(std::memory_order_acquire);
+    lane.requests.push_back({std::move(request), value, sequence.fetch_add(1, std::memory_order_relaxed)});
+    
+    return value;
+}
+
+
+void SubmitScheduler::collectBatch(const uint64_t value)
+{
+    batch.clear();
+    
+    std::lock_guard<std::mutex> lanesLock(lanesMutex);
+    for (auto& lane : lanes)
+    {
+        std::lock_guard<std::mutex> laneLock(lane->mutex);
+        
+        // Requests that read the value after flush() bumped it belong to the next flush
+        auto split = std::stable_partition(lane->requests.begin(), lane->requests.end(), [value](const PendingRequest& pending) { return pending.value <= value; });
+        std::move(lane->requests.begin(), split, std::back_inserter(batch));
+        lane->requests.erase(lane->requests.begin(), split);
+    }
+    
+    std::sort(batch.begin(), batch.end(), [](const PendingRequest& a, const PendingRequest& b) { return a.sequence < b.sequence; });
+}
+
+
+void SubmitScheduler::buildPlan(const uint64_t value)
+{
+    planCommandBuffers.clear();
+    planWaits.clear();
+    planSignals.clear();
+    planGroups.clear();
+    
+    for (const auto& pending : batch)
+    {
+        const SubmitRequest& request = pending.request;
+        
+        // Merging would either hoist this request's waits above earlier command buffers
+        // or delay the previous group's signals, so only merge when neither happens
+        if (planGroups.empty() || !request.waitSemaphores.empty() || planGroups.back().signalCount > 0)
+        {
+            planGroups.push_back({planCommandBuffers.size(), 0, planWaits.size(), 0, planSignals.size(), 0});
+        }
+        
+        SubmitGroup& group = planGroups.back();
+        
+        for (const auto& waitInfo : request.waitSemaphores)
+        {
+            planWaits.push_back(waitInfo);
+            group.waitCount++;
+        }
+        
+        for (const auto commandBuffer : request.commandBuffers)
+        {
+            VkCommandBufferSubmitInfoKHR commandBufferInfo{};
+            commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR;
+            commandBufferInfo.commandBuffer = commandBuffer;
+            planCommandBuffers.push_back(commandBufferInfo);
+            group.commandBufferCount++;
+        }
+        
+        for (const auto& signalInfo : request.signalSemaphores)
+        {
+            planSignals.push_back(signalInfo);
+            group.signalCount++;
+        }
+    }
+    
+    // The last group's signals are at the end of planSignals, so the timeline signal extends them
+    VkSemaphoreSubmitInfoKHR timelineSignal{};
+    timelineSignal.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineSignal.semaphore = timeline.getSemaphore();
+    timelineSignal.value = value;
+    timelineSignal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+    planSignals.push_back(timelineSignal);
+    planGroups.back().signalCount++;
+    
+    for (auto& semaphoreInfo : planWaits)
+    {
+        if (semaphoreInfo.stageMask == VK_PIPELINE_STAGE_2_NONE_KHR)
+        {
+            semaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+        }
+    }
+    
+    for (auto& semaphoreInfo : planSignals)
+    {
+        if (semaphoreInfo.stageMask == VK_PIPELINE_STAGE_2_NONE_KHR)
+        {
+            semaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+        }
+    }
+}
+
+
+void SubmitScheduler::submitBatch2(void)
+{
+    std::vector<VkSubmitInfo2KHR> submitInfos(planGroups.size());
+    
+    for (size_t i = 0; i < planGroups.size(); i++)
+    {
+        const SubmitGroup& group = planGroups[i];
+        
+        submitInfos[i].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR;
+        submitInfos[i].waitSemaphoreInfoCount = static_cast<uint32_t>(group.waitCount);
+        submitInfos[i].pWaitSemaphoreInfos = planWaits.data() + group.firstWait;
+        submitInfos[i].commandBufferInfoCount = static_cast<uint32_t>(group.commandBufferCount);
+        submitInfos[i].pCommandBufferInfos = planCommandBuffers.data() + group.firstCommandBuffer;
+        submitInfos[i].signalSemaphoreInfoCount = static_cast<uint32_t>(group.signalCount);
+        submitInfos[i].pSignalSemaphoreInfos = planSignals.data() + group.firstSignal;
+    }
+    
+    if (capture::queueSubmit2(pfnQueueSubmit2, queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit batched command buffers!");
+    }
+}
+
+
+void SubmitScheduler::submitBatch(void)
+{
+    // Without synchronization2 the plan is translated to VkSubmitInfo with timeline values chained
+    std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<VkSemaphore> waitSemaphores, signalSemaphores;
+    std::vector<VkPipelineStageFlags> waitStages;
+    std::vector<uint64_t> waitValues, signalValues;
+    
+    commandBuffers.reserve(planCommandBuffers.size());
+    for (const auto& commandBufferInfo : planCommandBuffers)
+    {
+        commandBuffers.push_back(commandBufferInfo.commandBuffer);
+    }
+    
+    waitSemaphores.reserve(planWaits.size());
+    for (const auto& waitInfo : planWaits)
+    {
+        // Synchronization2 stage bits below 32 match the original pipeline stage bits
+        const auto stageMask = static_cast<VkPipelineStageFlags>(waitInfo.stageMask & 0xFFFFFFFFULL);
+        
+        waitSemaphores.push_back(waitInfo.semaphore);
+        waitStages.push_back(stageMask != 0 ? stageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT));
+        waitValues.push_back(waitInfo.value);
+    }
+    
+    signalSemaphores.reserve(planSignals.size());
+    for (const auto& signalInfo : planSignals)
+    {
+        signalSemaphores.push_back(signalInfo.semaphore);
+        signalValues.push_back(signalInfo.value);
+    }
+    
+    std::vector<VkTimelineSemaphoreSubmitInfoKHR> timelineInfos(planGroups.size());
+    std::vector<VkSubmitInfo> submitInfos(planGroups.size());
+    
+    for (size_t i = 0; i < planGroups.size(); i++)
+    {
+        const SubmitGroup& group = planGroups[i];
+        
+        timelineInfos[i].sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+        timelineInfos[i].waitSemaphoreValueCount = static_cast<uint32_t>(group.waitCount);
+        timelineInfos[i].pWaitSemaphoreValues = waitValues.data() + group.firstWait;
+        timelineInfos[i].signalSemaphoreValueCount = static_cast<uint32_t>(group.signalCount);
+        timelineInfos[i].pSignalSemaphoreValues = signalValues.data() + group.firstSignal;
+        
+        submitInfos[i].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfos[i].pNext = &timelineInfos[i];
+        submitInfos[i].waitSemaphoreCount = static_cast<uint32_t>(group.waitCount);
+        submitInfos[i].pWaitSemaphores = waitSemaphores.data() + group.firstWait;
+        submitInfos[i].pWaitDstStageMask = waitStages.data() + group.firstWait;
+        submitInfos[i].commandBufferCount = static_cast<uint32_t>(group.commandBufferCount);
+        submitInfos[i].pCommandBuffers = commandBuffers.data() + group.firstCommandBuffer;
+        submitInfos[i].signalSemaphoreCount = static_cast<uint32_t>(group.signalCount);
+        submitInfos[i].pSignalSemaphores = signalSemaphores.data() + group.firstSignal;
+    }
+    
+    if (capture::queueSubmit(queue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit batched command buffers!");
+    }
+}
+
+
+uint64_t SubmitScheduler::flush(void)
+{
+    // Requests enqueued from now on are tagged with the next value
+    const uint64_t value = pendingValue.fetch_add(1, std::memory_order_acq_rel);
+    collectBatch(value);
+    
+    if (batch.empty())
+    {
+        return submittedValue;
+    }
+    
+    buildPlan(value);
+    
+    if (pfnQueueSubmit2 != nullptr)
+    {
+        submitBatch2();
+    } else
+    {
+        submitBatch();
+    }
+    
+    const uint32_t batchRequests = static_cast<uint32_t>(batch.size());
+    stats.submitCalls++;
+    stats.submitInfos += planGroups.size();
+    stats.requests += batchRequests;
+    stats.commandBuffers += planCommandBuffers.size();
+    stats.maxBatchRequests = std::max(stats.maxBatchRequests, batchRequests);
+    frameSubmitCalls++;
+    frameRequests += batchRequests;
+    
+    submittedValue = value;
+    return value;
+}
+
+
+void SubmitScheduler::endFrame(void)
+{
+    stats.frames++;
+    stats.lastFrameSubmitCalls = frameSubmitCalls;
+    stats.lastFrameRequests = frameRequests;
+    frameSubmitCalls = 0;
+    frameRequests = 0;
+}
+
+
+const SubmitStats& SubmitScheduler::getStats(void) const
+{
+    return stats;
+}
+
+
+void SubmitScheduler::waitFor(const VkDevice device, const uint64_t value) const
+{
+    if (value > 0)
+    {
+        timeline.wait(device, value);
+    }
+}
+
+
+const TimelineSemaphore& SubmitScheduler::getTimeline(void) const
+{
+    return timeline;
+}
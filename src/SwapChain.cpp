@@ -1,5 +1,5 @@
 #include "SwapChain.hpp"
-#include "Queue.hpp"
+#include "CommandCapture.hpp"
 
 #include <limits>
 #include <algorithm>
@@ -106,14 +106,20 @@ void SwapChain::populateSwapChainCreateInfo(VkSwapchainCreateInfoKHR& createInfo
     
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // The post chain copies its output in as a transfer destination. Transfer source lets FrameCapture copy
+    // presented images back to the host
+    if (!(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+    {
+        throw std::runtime_error("Swap chain images cannot be transfer destinations!");
+    }
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = retiredSwapChain;
 }
 
 
-void SwapChain::setupSwapChain(const VkPhysicalDevice physicalDevice, const VkDevice logicalDevice, GLFWwindow* window, const VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator)
+void SwapChain::setupSwapChain(const VkPhysicalDevice physicalDevice, const VkDevice logicalDevice, GLFWwindow* window, const VkSurfaceKHR surface, const QueueFamilyIndices& indices, const VkAllocationCallbacks* pAllocator)
 {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, surface);
 
@@ -122,7 +128,6 @@ void SwapChain::setupSwapChain(const VkPhysicalDevice physicalDevice, const VkDe
     scConfig.presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
     
     VkSwapchainCreateInfoKHR createInfo{};
-    QueueFamilyIndices indices = Queue::findQueueFamilies(physicalDevice, surface);
     uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
     populateSwapChainCreateInfo(createInfo, swapChainSupport, queueFamilyIndices);
     
@@ -132,16 +137,19 @@ void SwapChain::setupSwapChain(const VkPhysicalDevice physicalDevice, const VkDe
     createInfo.imageColorSpace = scConfig.surfaceFormat.colorSpace;
     createInfo.imageExtent = scConfig.extent;
     createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+    scConfig.imageUsage = createInfo.imageUsage;
     
     if (vkCreateSwapchainKHR(logicalDevice, &createInfo, pAllocator, &swapChain) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create swap chain!");
     }
+    retiredSwapChain = VK_NULL_HANDLE;
     
     uint32_t imageCount;
     vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imageCount, nullptr);
     swapChainImages.resize(imageCount);
     vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imageCount, swapChainImages.data());
+    capture::registerSwapchainImages(swapChain, createInfo, swapChainImages);
 }
 
 
@@ -168,10 +176,10 @@ void SwapChain::populateImageViewCreateInfo(VkImageViewCreateInfo& createInfo, c
 void SwapChain::setupImageViews(const VkDevice device, std::vector<const VkAllocationCallbacks*> pAllocators)
 {
     swapChainImageViews.resize(swapChainImages.size());
-    if (pAllocators[0] == nullptr)
+    // A single entry is shared by every image view
+    if (pAllocators.size() == 1)
     {
-        pAllocators.resize(swapChainImages.size());
-        std::fill(pAllocators.begin(), pAllocators.end(), nullptr);
+        pAllocators.resize(swapChainImages.size(), pAllocators[0]);
     }
     
     for (size_t i = 0; i < swapChainImages.size(); i++)
@@ -179,7 +187,7 @@ void SwapChain::setupImageViews(const VkDevice device, std::vector<const VkAlloc
         VkImageViewCreateInfo createInfo{};
         populateImageViewCreateInfo(createInfo, swapChainImages[i]);
         
-        if (vkCreateImageView(device, &createInfo, pAllocators[i], &swapChainImageViews[i]) != VK_SUCCESS) {
+        if (capture::createImageView(device, &createInfo, pAllocators[i], &swapChainImageViews[i]) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create image views!");
         }
     }
@@ -190,17 +198,18 @@ void SwapChain::destroySwapChain(const VkDevice device, const VkAllocationCallba
 {
     if (swapChain != VK_NULL_HANDLE)
     {
-        vkDestroySwapchainKHR(device, swapChain, pAllocator);
+        capture::destroySwapchain(device, swapChain, pAllocator);
+        swapChain = VK_NULL_HANDLE;
     }
 }
 
 
 void SwapChain::destroyImageViews(const VkDevice device, std::vector<const VkAllocationCallbacks*> pAllocators)
 {
-    if (pAllocators[0] == nullptr)
+    // A single entry is shared by every image view
+    if (pAllocators.size() == 1)
     {
-        pAllocators.resize(swapChainImages.size());
-        std::fill(pAllocators.begin(), pAllocators.end(), nullptr);
+        pAllocators.resize(swapChainImages.size(), pAllocators[0]);
     }
     
     for (size_t i = 0; i < swapChainImageViews.size(); i++)
@@ -208,9 +217,71 @@ void SwapChain::destroyImageViews(const VkDevice device, std::vector<const VkAll
         VkImageView imageView = swapChainImageViews[i];
         if (imageView != VK_NULL_HANDLE)
         {
-            vkDestroyImageView(device, imageView, pAllocators[i]);
+            capture::destroyImageView(device, imageView, pAllocators[i]);
+        }
+    }
+    swapChainImageViews.clear();
+}
+
+
+void SwapChain::setupFramebuffers(const VkDevice device, const VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator)
+{
+    swapChainFramebuffers.resize(swapChainImageViews.size());
+    
+    for (size_t i = 0; i < swapChainImageViews.size(); i++)
+    {
+        VkImageView attachments[] = {swapChainImageViews[i]};
+        
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = scConfig.extent.width;
+        framebufferInfo.height = scConfig.extent.height;
+        framebufferInfo.layers = 1;
+        
+        if (capture::createFramebuffer(device, &framebufferInfo, pAllocator, &swapChainFramebuffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create framebuffer!");
+        }
+    }
+}
+
+
+void SwapChain::destroyFramebuffers(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    for (auto framebuffer : swapChainFramebuffers)
+    {
+        if (framebuffer != VK_NULL_HANDLE)
+        {
+            capture::destroyFramebuffer(device, framebuffer, pAllocator);
         }
     }
+    swapChainFramebuffers.clear();
+}
+
+
+void SwapChain::retireSwapChain(DeletionQueue& deletionQueue, const uint32_t frame, const VkAllocationCallbacks* pSwapChainAllocator, const VkAllocationCallbacks* pImageViewAllocator, const VkAllocationCallbacks* pFramebufferAllocator)
+{
+    for (const VkFramebuffer framebuffer : swapChainFramebuffers)
+    {
+        deletionQueue.deferFramebuffer(frame, framebuffer, pFramebufferAllocator);
+    }
+    swapChainFramebuffers.clear();
+    
+    for (const VkImageView imageView : swapChainImageViews)
+    {
+        deletionQueue.deferImageView(frame, imageView, pImageViewAllocator);
+    }
+    swapChainImageViews.clear();
+    
+    if (swapChain != VK_NULL_HANDLE)
+    {
+        deletionQueue.deferSwapchain(frame, swapChain, pSwapChainAllocator);
+        retiredSwapChain = swapChain;
+        swapChain = VK_NULL_HANDLE;
+    }
 }
 
 
@@ -218,3 +289,21 @@ const SwapChainConfig SwapChain::getSwapChainConfig(void) const
 {
     return scConfig;
 }
+
+
+const VkSwapchainKHR SwapChain::getSwapChain(void) const
+{
+    return swapChain;
+}
+
+
+const VkFramebuffer SwapChain::getFramebuffer(const uint32_t imageIndex) const
+{
+    return swapChainFramebuffers[imageIndex];
+}
+
+
+const VkImage SwapChain::getImage(const uint32_t imageIndex) const
+{
+    return swapChainImages[imageIndex];
+}
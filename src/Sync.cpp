@@ -0,0 +1,127 @@
+#include "Sync.hpp"
+#include "DeletionQueue.hpp"
+#include "CommandCapture.hpp"
+
+
+void TimelineSemaphore::loadFunctions(const VkDevice device)
+{
+    pfnWaitSemaphores = (PFN_vkWaitSemaphoresKHR) vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+    pfnGetSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValueKHR) vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+    
+    if (pfnWaitSemaphores == nullptr || pfnGetSemaphoreCounterValue == nullptr)
+    {
+        throw std::runtime_error("Failed to load timeline semaphore functions!");
+    }
+}
+
+
+void TimelineSemaphore::setupSemaphore(const VkDevice device, const uint64_t initialValue, const VkAllocationCallbacks* pAllocator)
+{
+    loadFunctions(device);
+    
+    VkSemaphoreTypeCreateInfoKHR typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = initialValue;
+    
+    VkSemaphoreCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    createInfo.pNext = &typeInfo;
+    
+    if (capture::createSemaphore(device, &createInfo, pAllocator, &semaphore) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create timeline semaphore!");
+    }
+}
+
+
+void TimelineSemaphore::destroySemaphore(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    if (semaphore != VK_NULL_HANDLE)
+    {
+        capture::destroySemaphore(device, semaphore, pAllocator);
+    }
+}
+
+
+void TimelineSemaphore::wait(const VkDevice device, const uint64_t value, const uint64_t timeout) const
+{
+    VkSemaphoreWaitInfoKHR waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &semaphore;
+    waitInfo.pValues = &value;
+    
+    if (pfnWaitSemaphores(device, &waitInfo, timeout) == VK_ERROR_DEVICE_LOST)
+    {
+        throw std::runtime_error("Device lost while waiting on timeline semaphore!");
+    }
+}
+
+
+uint64_t TimelineSemaphore::getValue(const VkDevice device) const
+{
+    uint64_t value = 0;
+    pfnGetSemaphoreCounterValue(device, semaphore, &value);
+    
+    return value;
+}
+
+
+const VkSemaphore TimelineSemaphore::getSemaphore(void) const
+{
+    return semaphore;
+}
+
+
+void FrameSync::setupSyncObjects(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+    
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        if (vkCreateSemaphore(device, &semaphoreInfo, pAllocator, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+            vkCreateSemaphore(device, &semaphoreInfo, pAllocator, &renderFinishedSemaphores[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create synchronization objects for a frame!");
+        }
+    }
+}
+
+
+void FrameSync::destroySyncObjects(const VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    for (size_t i = 0; i < imageAvailableSemaphores.size(); i++)
+    {
+        capture::destroySemaphore(device, renderFinishedSemaphores[i], pAllocator);
+        capture::destroySemaphore(device, imageAvailableSemaphores[i], pAllocator);
+    }
+}
+
+
+void FrameSync::retireSyncObjects(DeletionQueue& deletionQueue, const uint32_t frame, const VkAllocationCallbacks* pAllocator)
+{
+    for (size_t i = 0; i < imageAvailableSemaphores.size(); i++)
+    {
+        deletionQueue.deferSemaphore(frame, renderFinishedSemaphores[i], pAllocator);
+        deletionQueue.deferSemaphore(frame, imageAvailableSemaphores[i], pAllocator);
+    }
+    imageAvailableSemaphores.clear();
+    renderFinishedSemaphores.clear();
+}
+
+
+const VkSemaphore FrameSync::getImageAvailableSemaphore(const uint32_t frame) const
+{
+    return imageAvailableSemaphores[frame];
+}
+
+
+const VkSemaphore FrameSync::getRenderFinishedSemaphore(const uint32_t frame) const
+{
+    return renderFinishedSemaphores[frame];
+}
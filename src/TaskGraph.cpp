@@ -0,0 +1,206 @@
+#include "TaskGraph.hpp"
+
+#include <iomanip>
+#include <stdexcept>
+
+
+TaskGraph::TaskId TaskGraph::addTask(const std::string& name, std::function<void(void)> work, const std::vector<TaskId>& dependencies, const bool mainThread)
+{
+    const TaskId id = static_cast<TaskId>(tasks.size());
+    
+    // Only edges to existing tasks are possible, which keeps the graph acyclic
+    for (const TaskId dependency : dependencies)
+    {
+        if (dependency >= id)
+        {
+            throw std::runtime_error("Task " + name + " depends on an unknown task!");
+        }
+        
+        tasks[dependency].dependents.push_back(id);
+    }
+    
+    Task task;
+    task.name = name;
+    task.work = std::move(work);
+    task.pendingDependencies = static_cast<uint32_t>(dependencies.size());
+    task.mainThread = mainThread;
+    tasks.push_back(std::move(task));
+    
+    return id;
+}
+
+
+bool TaskGraph::isDone(void) const
+{
+    return finishedCount == tasks.size() || (failure && runningCount == 0);
+}
+
+
+void TaskGraph::pushReady(const TaskId id, std::vector<TaskId>& jobTasks)
+{
+    if (tasks[id].mainThread)
+    {
+        readyMainTasks.push_back(id);
+    } else
+    {
+        jobTasks.push_back(id);
+    }
+}
+
+
+void TaskGraph::submitTasks(const std::vector<TaskId>& jobTasks)
+{
+    for (const TaskId id : jobTasks)
+    {
+        jobSystem->submit([this, id]
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (failure)
+                {
+                    return;
+                }
+                runningCount++;
+            }
+            
+            execute(id);
+        }, &taskJobs);
+    }
+}
+
+
+void TaskGraph::execute(const TaskId id)
+{
+    Task& task = tasks[id];
+    task.startMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    
+    std::exception_ptr error;
+    try
+    {
+        task.work();
+    } catch (...)
+    {
+        error = std::current_exception();
+    }
+    
+    std::vector<TaskId> jobTasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task.endMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        finishedCount++;
+        runningCount--;
+        
+        if (error && !failure)
+        {
+            failure = error;
+        }
+        
+        if (!failure)
+        {
+            for (const TaskId dependent : task.dependents)
+            {
+                if (--tasks[dependent].pendingDependencies == 0)
+                {
+                    pushReady(dependent, jobTasks);
+                }
+            }
+        }
+        
+        readyCondition.notify_all();
+    }
+    
+    // Submitting may run other jobs on this thread while the pool is full, which must not happen under the mutex
+    submitTasks(jobTasks);
+}
+
+
+void TaskGraph::run(JobSystem& jobSystem)
+{
+    this->jobSystem = &jobSystem;
+    workers = jobSystem.getWorkerCount();
+    startTime = std::chrono::steady_clock::now();
+    
+    std::vector<TaskId> jobTasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (TaskId id = 0; id < tasks.size(); id++)
+        {
+            if (tasks[id].pendingDependencies == 0)
+            {
+                pushReady(id, jobTasks);
+            }
+        }
+    }
+    submitTasks(jobTasks);
+    
+    // The calling thread serves main-thread tasks and takes jobs in between, sleeping only once it has found
+    // neither; the workers keep going with what is queued
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        
+        while (!isDone())
+        {
+            if (!failure && !readyMainTasks.empty())
+            {
+                const TaskId id = readyMainTasks.front();
+                readyMainTasks.pop_front();
+                runningCount++;
+                
+                lock.unlock();
+                execute(id);
+                lock.lock();
+                continue;
+            }
+            
+            lock.unlock();
+            const bool ranJob = jobSystem.runPendingJob();
+            lock.lock();
+            
+            if (!ranJob)
+            {
+                readyCondition.wait(lock, [this] { return isDone() || (!failure && !readyMainTasks.empty()); });
+            }
+        }
+    }
+    
+    // Jobs of tasks that were never started after a failure still hold the graph
+    jobSystem.wait(taskJobs);
+    
+    totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+
+void TaskGraph::run(const uint32_t workerCount)
+{
+    JobSystem jobSystem;
+    jobSystem.setupJobSystem({workerCount, JOB_PIN_THREADS});
+    
+    try
+    {
+        run(jobSystem);
+    } catch (...)
+    {
+        jobSystem.destroyJobSystem();
+        throw;
+    }
+    
+    jobSystem.destroyJobSystem();
+}
+
+
+void TaskGraph::report(std::ostream& os) const
+{
+    os << std::fixed << std::setprecision(2);
+    
+    for (const auto& task : tasks)
+    {
+        os << "[startup] " << task.name << ": " << task.startMs << " -> " << task.endMs << " ms" << (task.mainThread ? " (main thread)" : "") << '\n';
+    }
+    
+    os << "[startup] " << tasks.size() << " tasks on " << workers << " workers in " << totalMs << " ms" << std::endl;
+}
@@ -0,0 +1,83 @@
+#include "TransformSystem.hpp"
+
+#if defined(SIMD_X86)
+
+#include <immintrin.h>
+
+// Only the code below is built for AVX2 and FMA; it runs after TransformSystem checked the CPU. Every
+// header is included above so no inline function shared with other files picks up these instructions
+#if defined(__clang__)
+    #pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma")
+#endif
+
+#include "TransformKernels.hpp"
+
+
+namespace
+{
+    struct Avx2Lanes
+    {
+        using V = __m256;
+        static constexpr uint32_t WIDTH = 8;
+        
+        static V load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, const V v) { _mm256_storeu_ps(p, v); }
+        static V set1(const float f) { return _mm256_set1_ps(f); }
+        static V add(const V a, const V b) { return _mm256_add_ps(a, b); }
+        static V sub(const V a, const V b) { return _mm256_sub_ps(a, b); }
+        static V mul(const V a, const V b) { return _mm256_mul_ps(a, b); }
+        static V madd(const V a, const V b, const V c) { return _mm256_fmadd_ps(a, b, c); }
+        
+        static V gather(const float* base, const uint32_t* index)
+        {
+            return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), 4);
+        }
+        
+        static void storeInstances(const V rows[12], InstanceTransform* instances)
+        {
+            // Transposed one 128-bit half at a time, four instances each
+            for (int half = 0; half < 2; half++)
+            {
+                __m128 transposed[3][4];
+                for (int row = 0; row < 3; row++)
+                {
+                    __m128 c[4];
+                    for (int i = 0; i < 4; i++)
+                    {
+                        c[i] = half == 0 ? _mm256_castps256_ps128(rows[row * 4 + i]) : _mm256_extractf128_ps(rows[row * 4 + i], 1);
+                    }
+                    _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+                    for (int i = 0; i < 4; i++)
+                    {
+                        transposed[row][i] = c[i];
+                    }
+                }
+                
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    for (int row = 0; row < 3; row++)
+                    {
+                        _mm_storeu_ps(instances[half * 4 + lane].rows[row], transposed[row][lane]);
+                    }
+                }
+            }
+        }
+    };
+}
+
+
+void transformLevelAvx2(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances)
+{
+    transformLevel<Avx2Lanes>(streams, begin, end, hasParents, instances);
+}
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#else
+    #pragma GCC pop_options
+#endif
+
+#endif
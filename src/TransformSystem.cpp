@@ -0,0 +1,403 @@
+#include "TransformSystem.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#if defined(SIMD_X86)
+    #include <emmintrin.h>
+#elif defined(SIMD_NEON)
+    #include <arm_neon.h>
+#endif
+
+#include "TransformKernels.hpp"
+
+
+namespace
+{
+    struct ScalarLanes
+    {
+        using V = float;
+        static constexpr uint32_t WIDTH = 1;
+        
+        static V load(const float* p) { return *p; }
+        static void store(float* p, const V v) { *p = v; }
+        static V set1(const float f) { return f; }
+        static V add(const V a, const V b) { return a + b; }
+        static V sub(const V a, const V b) { return a - b; }
+        static V mul(const V a, const V b) { return a * b; }
+        static V madd(const V a, const V b, const V c) { return a * b + c; }
+        static V gather(const float* base, const uint32_t* index) { return base[*index]; }
+        
+        static void storeInstances(const V rows[12], InstanceTransform* instances)
+        {
+            std::memcpy(instances->rows, rows, sizeof(InstanceTransform));
+        }
+    };
+
+#if defined(SIMD_X86)
+    struct SseLanes
+    {
+        using V = __m128;
+        static constexpr uint32_t WIDTH = 4;
+        
+        static V load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, const V v) { _mm_storeu_ps(p, v); }
+        static V set1(const float f) { return _mm_set1_ps(f); }
+        static V add(const V a, const V b) { return _mm_add_ps(a, b); }
+        static V sub(const V a, const V b) { return _mm_sub_ps(a, b); }
+        static V mul(const V a, const V b) { return _mm_mul_ps(a, b); }
+        static V madd(const V a, const V b, const V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        
+        static V gather(const float* base, const uint32_t* index)
+        {
+            return _mm_setr_ps(base[index[0]], base[index[1]], base[index[2]], base[index[3]]);
+        }
+        
+        static void storeInstances(const V rows[12], InstanceTransform* instances)
+        {
+            // Each group of four components turns into one row of four instances
+            V transposed[3][4];
+            for (int row = 0; row < 3; row++)
+            {
+                V c0 = rows[row * 4 + 0], c1 = rows[row * 4 + 1], c2 = rows[row * 4 + 2], c3 = rows[row * 4 + 3];
+                _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+                transposed[row][0] = c0;
+                transposed[row][1] = c1;
+                transposed[row][2] = c2;
+                transposed[row][3] = c3;
+            }
+            
+            // Instance order keeps the stores sequential for write-combined memory
+            for (int lane = 0; lane < 4; lane++)
+            {
+                for (int row = 0; row < 3; row++)
+                {
+                    _mm_storeu_ps(instances[lane].rows[row], transposed[row][lane]);
+                }
+            }
+        }
+    };
+#endif
+
+#if defined(SIMD_NEON)
+    struct NeonLanes
+    {
+        using V = float32x4_t;
+        static constexpr uint32_t WIDTH = 4;
+        
+        static V load(const float* p) { return vld1q_f32(p); }
+        static void store(float* p, const V v) { vst1q_f32(p, v); }
+        static V set1(const float f) { return vdupq_n_f32(f); }
+        static V add(const V a, const V b) { return vaddq_f32(a, b); }
+        static V sub(const V a, const V b) { return vsubq_f32(a, b); }
+        static V mul(const V a, const V b) { return vmulq_f32(a, b); }
+        static V madd(const V a, const V b, const V c) { return vfmaq_f32(c, a, b); }
+        
+        static V gather(const float* base, const uint32_t* index)
+        {
+            const float values[4] = {base[index[0]], base[index[1]], base[index[2]], base[index[3]]};
+            return vld1q_f32(values);
+        }
+        
+        static void storeInstances(const V rows[12], InstanceTransform* instances)
+        {
+            V transposed[3][4];
+            for (int row = 0; row < 3; row++)
+            {
+                const float32x4x2_t t01 = vtrnq_f32(rows[row * 4 + 0], rows[row * 4 + 1]);
+                const float32x4x2_t t23 = vtrnq_f32(rows[row * 4 + 2], rows[row * 4 + 3]);
+                transposed[row][0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+                transposed[row][1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+                transposed[row][2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+                transposed[row][3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+            }
+            
+            for (int lane = 0; lane < 4; lane++)
+            {
+                for (int row = 0; row < 3; row++)
+                {
+                    vst1q_f32(instances[lane].rows[row], transposed[row][lane]);
+                }
+            }
+        }
+    };
+#endif
+}
+
+
+void transformLevelScalar(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances)
+{
+    transformLevel<ScalarLanes>(streams, begin, end, hasParents, instances);
+}
+
+
+#if defined(SIMD_X86)
+void transformLevelSse(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances)
+{
+    transformLevel<SseLanes>(streams, begin, end, hasParents, instances);
+}
+#endif
+
+
+#if defined(SIMD_NEON)
+void transformLevelNeon(const TransformStreams& streams, const uint32_t begin, const uint32_t end, const bool hasParents, InstanceTransform* instances)
+{
+    transformLevel<NeonLanes>(streams, begin, end, hasParents, instances);
+}
+#endif
+
+
+void TransformSystem::setKernel(const SimdKernel kernel)
+{
+    if (!simd::isKernelSupported(kernel))
+    {
+        throw std::runtime_error("Transform kernel " + simd::getKernelName(kernel) + " is not supported on this CPU!");
+    }
+    
+    this->kernel = kernel;
+    levelFunction = nullptr;
+}
+
+
+SimdKernel TransformSystem::getKernel(void) const
+{
+    return kernel;
+}
+
+
+void TransformSystem::reserve(const uint32_t count)
+{
+    forEachStream([count](auto& stream)
+    {
+        stream.reserve(count);
+    });
+}
+
+
+uint32_t TransformSystem::addNode(const uint32_t parent, const Transform& local)
+{
+    const uint32_t node = getNodeCount();
+    if (parent != NO_PARENT && parent >= node)
+    {
+        throw std::runtime_error("Transform parent does not exist!");
+    }
+    
+    const uint32_t level = parent == NO_PARENT ? 0 : levels[parent] + 1;
+    
+    forEachStream([](auto& stream)
+    {
+        stream.emplace_back();
+    });
+    parents.back() = parent;
+    levels.back() = level;
+    setLocal(node, local);
+    
+    // Appending at the deepest level or one below it keeps every level contiguous
+    if (!sorted)
+    {
+        return node;
+    }
+    
+    if (level == getLevelCount())
+    {
+        levelOffsets.push_back(node + 1);
+    } else if (level + 1 == getLevelCount())
+    {
+        levelOffsets.back() = node + 1;
+    } else
+    {
+        sorted = false;
+    }
+    
+    return node;
+}
+
+
+void TransformSystem::setLocal(const uint32_t node, const Transform& local)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        position[i][node] = local.position[i];
+        scale[i][node] = local.scale[i];
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        rotation[i][node] = local.rotation[i];
+    }
+}
+
+
+std::vector<uint32_t> TransformSystem::sortByLevel(void)
+{
+    const uint32_t count = getNodeCount();
+    
+    uint32_t levelCount = 0;
+    for (const uint32_t level : levels)
+    {
+        levelCount = std::max(levelCount, level + 1);
+    }
+    
+    // Counting sort, stable within a level
+    std::vector<uint32_t> offsets(levelCount + 1, 0);
+    for (const uint32_t level : levels)
+    {
+        offsets[level + 1]++;
+    }
+    for (uint32_t l = 0; l < levelCount; l++)
+    {
+        offsets[l + 1] += offsets[l];
+    }
+    
+    std::vector<uint32_t> remap(count);
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (uint32_t node = 0; node < count; node++)
+    {
+        remap[node] = cursor[levels[node]]++;
+    }
+    
+    forEachStream([&remap, count](auto& stream)
+    {
+        std::remove_reference_t<decltype(stream)> sortedStream(count);
+        for (uint32_t node = 0; node < count; node++)
+        {
+            sortedStream[remap[node]] = stream[node];
+        }
+        stream.swap(sortedStream);
+    });
+    
+    for (auto& parent : parents)
+    {
+        if (parent != NO_PARENT)
+        {
+            parent = remap[parent];
+        }
+    }
+    
+    levelOffsets = offsets;
+    sorted = true;
+    
+    return remap;
+}
+
+
+uint32_t TransformSystem::getNodeCount(void) const
+{
+    return static_cast<uint32_t>(parents.size());
+}
+
+
+uint32_t TransformSystem::getLevelCount(void) const
+{
+    return static_cast<uint32_t>(levelOffsets.size() - 1);
+}
+
+
+TransformStreams TransformSystem::getStreams(void)
+{
+    TransformStreams streams;
+    for (int i = 0; i < 3; i++)
+    {
+        streams.position[i] = position[i].data();
+        streams.scale[i] = scale[i].data();
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        streams.rotation[i] = rotation[i].data();
+    }
+    for (int i = 0; i < 12; i++)
+    {
+        streams.world[i] = world[i].data();
+    }
+    streams.parent = parents.data();
+    
+    return streams;
+}
+
+
+void TransformSystem::update(InstanceTransform* instances)
+{
+    if (!sorted)
+    {
+        throw std::runtime_error("Transform hierarchy is not sorted by level!");
+    }
+    
+    if (levelFunction == nullptr)
+    {
+        switch (kernel)
+        {
+#if defined(SIMD_X86)
+            case SimdKernel::Sse:
+                levelFunction = transformLevelSse;
+                break;
+            case SimdKernel::Avx2:
+                levelFunction = transformLevelAvx2;
+                break;
+#endif
+#if defined(SIMD_NEON)
+            case SimdKernel::Neon:
+                levelFunction = transformLevelNeon;
+                break;
+#endif
+            default:
+                levelFunction = transformLevelScalar;
+                break;
+        }
+    }
+    
+    // A level only reads world matrices of the levels before it
+    const TransformStreams streams = getStreams();
+    for (uint32_t level = 0; level < getLevelCount(); level++)
+    {
+        levelFunction(streams, levelOffsets[level], levelOffsets[level + 1], level > 0, instances);
+    }
+}
+
+
+void TransformSystem::getWorld(const uint32_t node, InstanceTransform& world) const
+{
+    for (int i = 0; i < 12; i++)
+    {
+        world.rows[i / 4][i % 4] = this->world[i][node];
+    }
+}
+
+
+void TransformSystem::setupInstanceBuffers(const VkPhysicalDevice physicalDevice, const VkDevice device, HostAllocator* hostAllocator)
+{
+    const VkDeviceSize bufferSize = sizeof(InstanceTransform) * std::max(getNodeCount(), 1u);
+    
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        instanceBuffers[i].setupBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}, hostAllocator);
+        mappedInstances[i] = static_cast<InstanceTransform*>(instanceBuffers[i].map(device));
+    }
+}
+
+
+void TransformSystem::destroyInstanceBuffers(const VkDevice device, HostAllocator* hostAllocator)
+{
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        instanceBuffers[i].destroyBuffer(device, hostAllocator);
+        mappedInstances[i] = nullptr;
+    }
+}
+
+
+void TransformSystem::updateFrame(const uint32_t slot)
+{
+    if (mappedInstances[slot] == nullptr || instanceBuffers[slot].getSize() < sizeof(InstanceTransform) * getNodeCount())
+    {
+        throw std::runtime_error("Instance buffer is missing or smaller than the hierarchy!");
+    }
+    
+    update(mappedInstances[slot]);
+    instanceBuffers[slot].markWritten(0, sizeof(InstanceTransform) * getNodeCount());
+}
+
+
+const VkBuffer TransformSystem::getInstanceBuffer(const uint32_t slot) const
+{
+    return instanceBuffers[slot].getBuffer();
+}
@@ -31,7 +31,11 @@ VKAPI_ATTR VkBool32 VKAPI_CALL ValidationLayers::debugCallback(
     const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
     void* pUserData)
 {
-    if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+    // The persistent messenger logs asynchronously, the one chained to vkCreateInstance has no log yet
+    if (pUserData != nullptr)
+    {
+        static_cast<DebugLog*>(pUserData)->push(messageSeverity, messageType, pCallbackData);
+    } else if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
     {
         std::cerr << "Validation layer: " << pCallbackData->pMessage << std::endl;
     }
@@ -57,7 +61,8 @@ VkResult ValidationLayers::CreateDebugUtilsMessengerEXT(const VkInstance instanc
 void ValidationLayers::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
 {
     createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-    createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    // VERBOSE and INFO are not subscribed, the layer would format every message only for the callback to drop it
+    createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
     createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
     createInfo.pfnUserCallback = debugCallback;
     createInfo.pUserData = nullptr; // Optional
@@ -79,8 +84,13 @@ void ValidationLayers::setupDebugMessenger(const VkInstance instance, const VkAl
 {
     if (!enableValidationLayers) return;
     
+    debugLog.setupLog(std::cerr);
+    
     VkDebugUtilsMessengerCreateInfoEXT createInfo{};
     populateDebugMessengerCreateInfo(createInfo);
+    // INFO only when the log keeps it, performance warnings bypass the filter so WARNING stays subscribed
+    createInfo.messageSeverity |= debugLog.getSeverityFilter() & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+    createInfo.pUserData = &debugLog;
     
     if (CreateDebugUtilsMessengerEXT(instance, &createInfo, pAllocator) != VK_SUCCESS)
     {
@@ -94,4 +104,11 @@ void ValidationLayers::destroyDebugMessenger(const VkInstance instance, const Vk
     if (!enableValidationLayers) return;
     
     DestroyDebugUtilsMessengerEXT(instance, pAllocator);
+    debugLog.destroyLog();
+}
+
+
+DebugLog& ValidationLayers::getDebugLog(void)
+{
+    return debugLog;
 }
@@ -0,0 +1,203 @@
+#include "VertexFormat.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+
+static int16_t toSnorm16(const float value)
+{
+    return static_cast<int16_t>(std::lround(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f));
+}
+
+
+static uint16_t toUnorm16(const float value)
+{
+    return static_cast<uint16_t>(std::lround(std::max(0.0f, std::min(1.0f, value)) * 65535.0f));
+}
+
+
+static uint8_t toUnorm8(const float value)
+{
+    return static_cast<uint8_t>(std::lround(std::max(0.0f, std::min(1.0f, value)) * 255.0f));
+}
+
+
+uint32_t vertex::getVertexStride(const VertexLayout layout)
+{
+    switch (layout)
+    {
+        case VertexLayout::Float:
+            return sizeof(MeshVertex);
+        case VertexLayout::Quantized:
+            return sizeof(QuantizedVertex);
+        case VertexLayout::Overlay:
+            return sizeof(OverlayVertex);
+        default:
+            return 0;
+    }
+}
+
+
+void vertex::populateVertexInputDescriptions(const VertexLayout layout, VkVertexInputBindingDescription& binding, std::vector<VkVertexInputAttributeDescription>& attributes)
+{
+    binding.binding = 0;
+    binding.stride = getVertexStride(layout);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    
+    if (layout == VertexLayout::Float)
+    {
+        attributes = {
+            {0, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, position))},
+            {1, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, normal))},
+            {2, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, tangent))},
+            {3, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, uv))},
+            {4, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(MeshVertex, color))}
+        };
+    } else if (layout == VertexLayout::Quantized)
+    {
+        // All of these formats have mandatory vertex buffer support
+        attributes = {
+            {0, 0, VK_FORMAT_R16G16B16A16_SNORM, static_cast<uint32_t>(offsetof(QuantizedVertex, position))},
+            {1, 0, VK_FORMAT_R16G16_SNORM, static_cast<uint32_t>(offsetof(QuantizedVertex, normal))},
+            {2, 0, VK_FORMAT_R16G16_SNORM, static_cast<uint32_t>(offsetof(QuantizedVertex, tangent))},
+            {3, 0, VK_FORMAT_R16G16_UNORM, static_cast<uint32_t>(offsetof(QuantizedVertex, uv))},
+            {4, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(QuantizedVertex, color))}
+        };
+    } else if (layout == VertexLayout::Overlay)
+    {
+        attributes = {
+            {0, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(OverlayVertex, position))},
+            {1, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(OverlayVertex, uv))},
+            {2, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(OverlayVertex, color))}
+        };
+    } else
+    {
+        attributes.clear();
+    }
+}
+
+
+void vertex::encodeOctahedral(const float direction[3], int16_t encoded[2])
+{
+    // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals
+    const float length = std::fabs(direction[0]) + std::fabs(direction[1]) + std::fabs(direction[2]);
+    if (length <= 0.0f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+    
+    float x = direction[0] / length;
+    float y = direction[1] / length;
+    if (direction[2] < 0.0f)
+    {
+        const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    
+    encoded[0] = toSnorm16(x);
+    encoded[1] = toSnorm16(y);
+}
+
+
+void vertex::decodeOctahedral(const int16_t encoded[2], float direction[3])
+{
+    // Same as decodeOctahedral in shaders/mesh.vert
+    const float x = std::max(-1.0f, static_cast<float>(encoded[0]) / 32767.0f);
+    const float y = std::max(-1.0f, static_cast<float>(encoded[1]) / 32767.0f);
+    
+    direction[0] = x;
+    direction[1] = y;
+    direction[2] = 1.0f - std::fabs(x) - std::fabs(y);
+    
+    const float t = std::max(-direction[2], 0.0f);
+    direction[0] += direction[0] >= 0.0f ? -t : t;
+    direction[1] += direction[1] >= 0.0f ? -t : t;
+    
+    const float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    for (int k = 0; k < 3; k++)
+    {
+        direction[k] /= length;
+    }
+}
+
+
+VertexDequantization vertex::quantizeVertices(const std::vector<MeshVertex>& vertices, std::vector<QuantizedVertex>& quantized)
+{
+    float positionMin[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float positionMax[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    float uvMin[2] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float uvMax[2] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    
+    for (const auto& vertex : vertices)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            positionMin[k] = std::min(positionMin[k], vertex.position[k]);
+            positionMax[k] = std::max(positionMax[k], vertex.position[k]);
+        }
+        for (int k = 0; k < 2; k++)
+        {
+            uvMin[k] = std::min(uvMin[k], vertex.uv[k]);
+            uvMax[k] = std::max(uvMax[k], vertex.uv[k]);
+        }
+    }
+    
+    // SNORM covers [-1, 1], so the centre maps to 0 and the half extent to 1
+    VertexDequantization dequantization;
+    for (int k = 0; k < 3 && !vertices.empty(); k++)
+    {
+        dequantization.positionOffset[k] = 0.5f * (positionMin[k] + positionMax[k]);
+        dequantization.positionScale[k] = std::max(0.5f * (positionMax[k] - positionMin[k]), std::numeric_limits<float>::min());
+    }
+    for (int k = 0; k < 2 && !vertices.empty(); k++)
+    {
+        dequantization.uvOffset[k] = uvMin[k];
+        dequantization.uvScale[k] = std::max(uvMax[k] - uvMin[k], std::numeric_limits<float>::min());
+    }
+    
+    quantized.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const MeshVertex& vertex = vertices[i];
+        QuantizedVertex& packed = quantized[i];
+        
+        for (int k = 0; k < 3; k++)
+        {
+            packed.position[k] = toSnorm16((vertex.position[k] - dequantization.positionOffset[k]) / dequantization.positionScale[k]);
+        }
+        packed.position[3] = vertex.tangent[3] < 0.0f ? -32767 : 32767;
+        
+        encodeOctahedral(vertex.normal, packed.normal);
+        encodeOctahedral(vertex.tangent, packed.tangent);
+        
+        for (int k = 0; k < 2; k++)
+        {
+            packed.uv[k] = toUnorm16((vertex.uv[k] - dequantization.uvOffset[k]) / dequantization.uvScale[k]);
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            packed.color[k] = toUnorm8(vertex.color[k]);
+        }
+    }
+    
+    return dequantization;
+}
+
+
+void vertex::quantizeMesh(MeshData& mesh)
+{
+    if (mesh.vertexLayout == VertexLayout::Quantized)
+    {
+        return;
+    }
+    
+    mesh.dequantization = quantizeVertices(mesh.vertices, mesh.quantizedVertices);
+    mesh.vertices = {};
+    mesh.vertexLayout = VertexLayout::Quantized;
+}
@@ -0,0 +1,885 @@
+#include "VulkanProject.hpp"
+#include "CommandCapture.hpp"
+#include "TaskGraph.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+void VulkanProject::run(void)
+{
+    setupApp();
+    mainLoop();
+    cleanup();
+}
+
+
+void VulkanProject::setupApp(const uint32_t startupWorkers, const uint32_t viewCount, const VertexLayout sceneLayout)
+{
+    startupTime = std::chrono::steady_clock::now();
+    timeToFirstFrameMs = 0.0;
+    
+    this->viewCount = std::max(viewCount, 1u);
+    views = std::make_unique<View[]>(this->viewCount);
+    this->sceneLayout = sceneLayout;
+    
+    Window::setupPlatform();
+    initVulkan(startupWorkers);
+    
+    lastFrameTime = std::chrono::steady_clock::now();
+    simulationThread.startThread(framePacer);
+}
+
+
+void VulkanProject::setSceneFeatures(const MeshShaderFeatures& features)
+{
+    meshRenderer.setShaderFeatures(features);
+}
+
+
+void VulkanProject::setPipelineLibrary(const bool enabled)
+{
+    pipelineLibrary = enabled;
+}
+
+
+void VulkanProject::setPostOverlap(const bool overlap)
+{
+    postOverlap = overlap;
+}
+
+
+void VulkanProject::setHud(const bool enabled)
+{
+    hudEnabled = enabled;
+}
+
+
+void VulkanProject::createInstance(void)
+{
+    if (enableValidationLayers && !VL.checkValidationLayerSupport())
+    {
+        throw std::runtime_error("Validation layers requested, but not available!");
+    }
+    
+    stringVector extensions = Instance::getRequiredInstanceExtensions();
+    instanceCapabilities = Instance::negotiateCapabilities(extensions);
+    
+    VkApplicationInfo appInfo{};
+    Instance::populateApplicationInfo(appInfo, instanceCapabilities.apiVersion);
+    
+    VkInstanceCreateInfo createInfo{};
+    
+    VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
+    
+    Instance::populateInstanceCreateInfo(createInfo, appInfo, debugCreateInfo, extensions, instanceCapabilities);
+    
+    if (vkCreateInstance(&createInfo, hostAllocator.getCallbacks(VK_OBJECT_TYPE_INSTANCE), &instance) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create instance!");
+    }
+}
+
+
+void VulkanProject::initVulkan(const uint32_t startupWorkers)
+{
+    hostAllocator.setupAllocator(HostAllocator::modeFromEnvironment(HostAllocatorMode::Driver));
+    jobSystem.setupJobSystem(JobSystem::configFromEnvironment(startupWorkers));
+    const bool libraryRequested = Pipeline::libraryFromEnvironment(pipelineLibrary);
+    hudEnabled = PerfHud::enabledFromEnvironment(hudEnabled);
+    
+    // File reads and the window overlap instance and device creation; pipelines compile as soon as the device exists
+    TaskGraph startup;
+    
+    const auto windowTask = startup.addTask("windows", [this]
+    {
+        // Tiled in a grid so a wall of views does not stack up
+        const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(viewCount))));
+        
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            const std::string title = viewCount > 1 ? "Vulkan " + std::to_string(i) : "Vulkan";
+            views[i].window.setupWindow(title.c_str());
+            
+            if (viewCount > 1)
+            {
+                glfwSetWindowPos(views[i].window.window, static_cast<int>((i % columns) * WIDTH), static_cast<int>((i / columns) * HEIGHT));
+            }
+        }
+    }, {}, true);
+    
+    const auto instanceTask = startup.addTask("instance", [this]
+    {
+        createInstance();
+        VL.setupDebugMessenger(instance, hostAllocator.getCallbacks(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT));
+    });
+    
+    const auto shaderTask = startup.addTask("shader files", [this]
+    {
+        assetPack.openPack(ASSET_PACK_PATH);
+        vertShaderCode = assetPack.getAsset("shaders/vert.spv");
+        fragShaderCode = assetPack.getAsset("shaders/frag.spv");
+        compShaderCode = assetPack.getAsset("shaders/comp.spv");
+        postShaderCode = {assetPack.getAsset("shaders/bloom_down_comp.spv"), assetPack.getAsset("shaders/bloom_up_comp.spv"), assetPack.getAsset("shaders/tonemap_comp.spv"), assetPack.getAsset("shaders/fxaa_comp.spv")};
+        
+        if (sceneLayout != VertexLayout::None)
+        {
+            meshVertShaderCode = assetPack.getAsset("shaders/mesh_vert.spv");
+            meshFragShaderCode = assetPack.getAsset("shaders/mesh_frag.spv");
+        }
+        if (hudEnabled)
+        {
+            hudVertShaderCode = assetPack.getAsset("shaders/hud_vert.spv");
+            hudFragShaderCode = assetPack.getAsset("shaders/hud_frag.spv");
+        }
+    });
+    
+    const auto cacheFileTask = startup.addTask("pipeline cache file", [this]
+    {
+        pipelineCache.loadCacheFile(PIPELINE_CACHE_PATH);
+    });
+    
+    const auto surfaceTask = startup.addTask("surfaces", [this]
+    {
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            views[i].window.setupSurface(instance, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SURFACE_KHR));
+        }
+    }, {windowTask, instanceTask}, true);
+    
+    const auto deviceTask = startup.addTask("device", [this]
+    {
+        std::vector<VkSurfaceKHR> surfaces;
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            surfaces.push_back(views[i].window.getSurface());
+        }
+        
+        device.setupDevices(instance, instanceCapabilities, surfaces, hostAllocator.getCallbacks(VK_OBJECT_TYPE_DEVICE));
+        device.getCapabilities().report(std::cout);
+        
+        const std::string capturePath = capture::pathFromEnvironment();
+        if (!capturePath.empty())
+        {
+            capture::openCapture(capturePath, device.getPhysicalDevice());
+        }
+        
+        queue.setupQueues(device.getLogicalDevice(), device.getQIndices(), device.getCapabilities().synchronization2, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+        layoutCache.setupLayoutCache(device.getLogicalDevice(), &hostAllocator);
+    }, {surfaceTask});
+    
+    const auto cacheTask = startup.addTask("pipeline cache", [this]
+    {
+        pipelineCache.setupCache(device.getPhysicalDevice(), device.getLogicalDevice(), hostAllocator.getCallbacks(VK_OBJECT_TYPE_PIPELINE_CACHE));
+    }, {deviceTask, cacheFileTask});
+    
+    // Main thread: the swapchain extent comes from glfwGetFramebufferSize
+    const auto swapChainTask = startup.addTask("swapchains", [this]
+    {
+        const VkDevice logicalDevice = device.getLogicalDevice();
+        
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            View& view = views[i];
+            view.swapChain.setupSwapChain(device.getPhysicalDevice(), logicalDevice, view.window.window, view.window.getSurface(), device.getQIndices(), hostAllocator.getCallbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+            view.swapChain.setupImageViews(logicalDevice, {hostAllocator.getCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW)});
+        }
+        
+        createRenderPass();
+        
+        // Capture records the first view
+        frameCapture.setupCapture(device.getPhysicalDevice(), logicalDevice, views[0].swapChain.getSwapChainConfig(), FrameCapture::configFromEnvironment(), &hostAllocator);
+    }, {deviceTask}, true);
+    
+    startup.addTask("frame resources", [this]
+    {
+        const VkDevice logicalDevice = device.getLogicalDevice();
+        const QueueFamilyIndices qIndices = device.getQIndices();
+        commandPool.setupCommandPool(logicalDevice, qIndices.graphicsFamily.value(), hostAllocator.getCallbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+        // Scene and composite buffer per frame slot
+        commandPool.setupCommandBuffers(logicalDevice, 2 * MAX_FRAMES_IN_FLIGHT);
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            views[i].frameSync.setupSyncObjects(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+        }
+        graphicsTimer.setupTimer(device.getPhysicalDevice(), logicalDevice, qIndices.graphicsFamily.value(), MAX_FRAMES_IN_FLIGHT);
+    }, {deviceTask});
+    
+    const auto simulationTask = startup.addTask("simulation", [this]
+    {
+        simulation.setupSimulation(device.getPhysicalDevice(), device.getLogicalDevice(), device.getQIndices(), queue, compShaderCode, layoutCache, pipelineCache.getCache(), &hostAllocator);
+    }, {deviceTask, shaderTask, cacheTask});
+    
+    startup.addTask("graphics pipeline", [this, libraryRequested]
+    {
+        pipeline.setPipelineLibrary(libraryRequested && device.getCapabilities().graphicsPipelineLibrary, &jobSystem);
+        pipeline.setupGraphicsPipeline(device.getLogicalDevice(), renderPass, vertShaderCode, fragShaderCode, layoutCache, pipelineCache.getCache(), hostAllocator.getCallbacks(VK_OBJECT_TYPE_PIPELINE));
+    }, {swapChainTask, shaderTask, cacheTask});
+    
+    // Records no setup commands, so it can run next to the simulation and the mesh renderer
+    startup.addTask("post chain", [this]
+    {
+        // The chain copies into every swap chain the same way, so they must agree on the format
+        const VkFormat outputFormat = views[0].swapChain.getSwapChainConfig().surfaceFormat.format;
+        std::vector<VkExtent2D> extents;
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            const SwapChainConfig config = views[i].swapChain.getSwapChainConfig();
+            if (config.surfaceFormat.format != outputFormat)
+            {
+                throw std::runtime_error("Views with different surface formats are not supported!");
+            }
+            extents.push_back(config.extent);
+        }
+        
+        postChain.setupPostChain(device.getPhysicalDevice(), device.getLogicalDevice(), device.getQIndices(), renderPass, extents, outputFormat, postShaderCode, layoutCache, pipelineCache.getCache(), &hostAllocator);
+    }, {swapChainTask, shaderTask, cacheTask});
+    
+    if (hudEnabled)
+    {
+        // Drawn into the swap chain images, whose formats the post chain checks agree
+        startup.addTask("hud", [this]
+        {
+            const VkDevice logicalDevice = device.getLogicalDevice();
+            const VkFormat outputFormat = views[0].swapChain.getSwapChainConfig().surfaceFormat.format;
+            hud.setupHud(device.getPhysicalDevice(), logicalDevice, device.getQIndices().graphicsFamily.value(), outputFormat, hudVertShaderCode, hudFragShaderCode, layoutCache, pipelineCache.getCache(), &hostAllocator);
+            for (uint32_t i = 0; i < viewCount; i++)
+            {
+                views[i].swapChain.setupFramebuffers(logicalDevice, hud.getRenderPass(), hostAllocator.getCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+            }
+        }, {swapChainTask, shaderTask, cacheTask});
+    }
+    
+    if (sceneLayout != VertexLayout::None)
+    {
+        const auto sceneMeshTask = startup.addTask("scene mesh", [this]
+        {
+            sceneMesh = mesh::createSphere(MESH_SCENE_RINGS, MESH_SCENE_SEGMENTS);
+        });
+        
+        // After the simulation, whose particle upload may go to the same queue
+        startup.addTask("mesh renderer", [this, libraryRequested]
+        {
+            meshRenderer.setPipelineLibrary(libraryRequested && device.getCapabilities().graphicsPipelineLibrary, &jobSystem);
+            meshRenderer.setupMeshRenderer(device.getPhysicalDevice(), device.getLogicalDevice(), device.getQIndices().graphicsFamily.value(), queue.getGraphicsQueue(), renderPass, sceneMesh, sceneLayout, meshVertShaderCode, meshFragShaderCode, layoutCache, pipelineCache.getCache(), &hostAllocator);
+            std::cout << "[mesh] " << sceneMesh.vertices.size() << " vertices of " << vertex::getVertexStride(sceneLayout) << " bytes, "
+                      << meshRenderer.getVertexBufferSize() / (1024.0 * 1024.0) << " MB" << std::endl;
+            sceneMesh = {};
+        }, {swapChainTask, simulationTask, shaderTask, sceneMeshTask});
+    }
+    
+    startup.run(jobSystem);
+    startup.report(std::cout);
+    
+    vertShaderCode = {};
+    fragShaderCode = {};
+    compShaderCode = {};
+    meshVertShaderCode = {};
+    meshFragShaderCode = {};
+    postShaderCode = {};
+    hudVertShaderCode = {};
+    hudFragShaderCode = {};
+    assetPack.closePack();
+}
+
+
+void VulkanProject::createRenderPass(void)
+{
+    // Renders into the HDR scene images of the post chain, which samples them once the pass is done
+    VkAttachmentDescription colorAttachment{};
+    colorAttachment.format = POST_HDR_FORMAT;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    
+    VkAttachmentReference colorAttachmentRef{};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    
+    // The chain of the previous use of a scene image must be done sampling it, and this pass must be done
+    // writing it before the next chain samples it
+    VkSubpassDependency dependencies[2]{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 2;
+    renderPassInfo.pDependencies = dependencies;
+    
+    if (capture::createRenderPass(device.getLogicalDevice(), &renderPassInfo, hostAllocator.getCallbacks(VK_OBJECT_TYPE_RENDER_PASS), &renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create render pass!");
+    }
+}
+
+
+bool VulkanProject::windowsMinimized(void) const
+{
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        int width, height;
+        glfwGetFramebufferSize(views[i].window.window, &width, &height);
+        if (width == 0 || height == 0)
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+
+void VulkanProject::recreateSwapChains(void)
+{
+    const VkDevice logicalDevice = device.getLogicalDevice();
+    
+    std::vector<VkExtent2D> extents(viewCount);
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        View& view = views[i];
+        // The retired swap chain becomes oldSwapchain of the new one
+        view.swapChain.retireSwapChain(deletionQueue, currentFrame, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR), hostAllocator.getCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW), hostAllocator.getCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+        view.swapChain.setupSwapChain(device.getPhysicalDevice(), logicalDevice, view.window.window, view.window.getSurface(), device.getQIndices(), hostAllocator.getCallbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+        view.swapChain.setupImageViews(logicalDevice, {hostAllocator.getCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW)});
+        if (hudEnabled)
+        {
+            view.swapChain.setupFramebuffers(logicalDevice, hud.getRenderPass(), hostAllocator.getCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+        }
+        
+        // Views that acquired before another one failed left their acquire semaphores signalled
+        view.frameSync.retireSyncObjects(deletionQueue, currentFrame, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+        view.frameSync.setupSyncObjects(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+        
+        extents[i] = view.swapChain.getSwapChainConfig().extent;
+    }
+    
+    postChain.resizeTargets(device.getPhysicalDevice(), logicalDevice, device.getQIndices(), renderPass, extents, layoutCache, deletionQueue, currentFrame, &hostAllocator);
+    chainStartFrame = frameIndex;
+    swapChainsOutOfDate = false;
+}
+
+
+void VulkanProject::recordCommandBuffer(const VkCommandBuffer commandBuffer)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    
+    if (capture::beginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin recording command buffer!");
+    }
+    
+    graphicsTimer.cmdBegin(commandBuffer, currentFrame);
+    descriptorBinder.reset();
+    
+    const VkDescriptorSet particleSet = simulation.getRenderSet(frameIndex);
+    
+    // Every view gets its own render pass in the one command buffer
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        const View& view = views[i];
+        const VkExtent2D extent = view.swapChain.getSwapChainConfig().extent;
+        
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = postChain.getFramebuffer(i, frameIndex);
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = extent;
+        
+        VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = &clearColor;
+        
+        capture::cmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        capture::cmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipeline());
+        
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        capture::cmdSetViewport(commandBuffer, 0, 1, &viewport);
+        
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = extent;
+        capture::cmdSetScissor(commandBuffer, 0, 1, &scissor);
+        
+        // Binding the mesh pipeline leaves the set alone, so only the first view binds it
+        descriptorBinder.cmdBindSets(commandBuffer, layoutCache, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipelineLayout(), 0, {particleSet});
+        
+        // One triangle instance per particle
+        capture::cmdDraw(commandBuffer, 3, PARTICLE_COUNT, 0, 0);
+        
+        if (sceneLayout != VertexLayout::None)
+        {
+            meshRenderer.cmdDraw(commandBuffer, extent, MESH_SCENE_INSTANCES);
+        }
+        capture::cmdEndRenderPass(commandBuffer);
+    }
+    
+    graphicsTimer.cmdEnd(commandBuffer, currentFrame);
+    
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record command buffer!");
+    }
+}
+
+
+void VulkanProject::recordCompositeCommandBuffer(const VkCommandBuffer commandBuffer, const uint64_t frame)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    
+    if (capture::beginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin recording composite command buffer!");
+    }
+    
+    if (hudEnabled)
+    {
+        hud.cmdBegin(commandBuffer, currentFrame);
+    }
+    
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        const View& view = views[i];
+        postChain.cmdComposite(commandBuffer, i, frame, view.swapChain.getImage(view.imageIndex));
+    }
+    
+    // Over the composite and under the capture, so captured frames show it
+    if (hudEnabled)
+    {
+        std::vector<HudTarget> targets(viewCount);
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            const View& view = views[i];
+            targets[i] = {view.swapChain.getFramebuffer(view.imageIndex), view.swapChain.getSwapChainConfig().extent};
+        }
+        hud.cmdDraw(commandBuffer, currentFrame, targets);
+    }
+    
+    frameCapture.cmdCapture(commandBuffer, views[0].swapChain.getImage(views[0].imageIndex), views[0].swapChain.getSwapChainConfig().extent);
+    
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record composite command buffer!");
+    }
+}
+
+
+void VulkanProject::collectTimings(const double cpuFrameMs, const SimulationSnapshot& snapshot)
+{
+    const VkDevice logicalDevice = device.getLogicalDevice();
+    
+    // Both slots now hold finished work from frame frameIndex - MAX_FRAMES_IN_FLIGHT
+    GpuInterval computeInterval, graphicsInterval;
+    const bool graphicsTimed = graphicsTimer.readInterval(logicalDevice, currentFrame, graphicsInterval);
+    const bool computeTimed = simulation.readTimings(logicalDevice, currentFrame, computeInterval);
+    if (computeTimed && graphicsTimed)
+    {
+        overlapStats.addFrame(computeInterval, graphicsInterval, cpuFrameMs);
+    }
+    
+    // The chain of a frame can only overlap the scene of the next one, read one slot earlier
+    if (hasPostTimings && graphicsTimed)
+    {
+        postStats.addFrame(postTimings, graphicsInterval);
+    }
+    hasPostTimings = postChain.readTimings(logicalDevice, currentFrame, postTimings);
+    
+    PerfMetrics metrics = hud.getMetrics();
+    metrics.frameMs = cpuFrameMs;
+    metrics.cpuMs = lastCpuMs;
+    metrics.gpuGraphicsMs = graphicsTimed ? graphicsInterval.durationMs() : 0.0;
+    metrics.gpuComputeMs = computeTimed ? computeInterval.durationMs() : 0.0;
+    metrics.gpuPostMs = hasPostTimings ? postTimings.chain.durationMs() : 0.0;
+    
+    const CommandCounts counts = capture::takeCommandCounts();
+    metrics.draws = counts.draws;
+    metrics.dispatches = counts.dispatches;
+    metrics.pipelineBinds = counts.pipelineBinds;
+    
+    // The budget query may go to the kernel, the last values stay in between
+    if (frameIndex % HUD_MEMORY_INTERVAL == 0)
+    {
+        const MemoryUsage memoryUsage = device.queryMemoryUsage();
+        metrics.memoryUsage = memoryUsage.usage;
+        metrics.memoryBudget = memoryUsage.budget;
+    }
+    metrics.presentMode = views[0].swapChain.getSwapChainConfig().presentMode;
+    hud.addFrame(metrics);
+    if (hudEnabled)
+    {
+        hud.readTimings(logicalDevice, currentFrame);
+    }
+    
+    if (overlapStats.getFrameCount() >= TIMING_REPORT_INTERVAL)
+    {
+        overlapStats.report(std::cout, device.getQIndices().hasAsyncCompute());
+        overlapStats.reset();
+        postStats.report(std::cout, postOverlap);
+        postStats.reset();
+        
+        queue.getGraphicsScheduler().getStats().report(std::cout, "graphics");
+        if (&queue.getComputeScheduler() != &queue.getGraphicsScheduler())
+        {
+            queue.getComputeScheduler().getStats().report(std::cout, "compute");
+        }
+        hostAllocator.report(std::cout);
+        std::cout << "[descriptors] " << descriptorBinder.getBoundCount() << " sets bound, " << descriptorBinder.getSkippedCount() << " binds skipped, "
+                  << layoutCache.getSetLayoutCount() << " set layouts, " << layoutCache.getPipelineLayoutCount() << " pipeline layouts" << std::endl;
+        descriptorBinder.resetStats();
+        VL.getDebugLog().reportPerformance(std::cout);
+        
+        renderJitter.report(std::cout, "[threads] render: ");
+        snapshot.tickJitter.report(std::cout, " | simulation: ");
+        std::cout << ", " << snapshot.droppedTicks << " ticks dropped" << std::endl;
+    }
+}
+
+
+void VulkanProject::drawFrame(void)
+{
+    const VkDevice logicalDevice = device.getLogicalDevice();
+    
+    // Nothing is rendered while a window is minimized, the swap chains are recreated once it is restored
+    swapChainsOutOfDate = framePacer.takeResized() || swapChainsOutOfDate;
+    if (swapChainsOutOfDate && windowsMinimized())
+    {
+        glfwWaitEvents();
+        return;
+    }
+    
+    const auto now = std::chrono::steady_clock::now();
+    const double cpuFrameMs = std::chrono::duration<double, std::milli>(now - lastFrameTime).count();
+    lastFrameTime = now;
+    if (frameIndex > 0)
+    {
+        renderJitter.add(cpuFrameMs);
+    }
+    
+    // The particles move by the simulated time that passed since the last frame, never backwards
+    const SimulationSnapshot& snapshot = simulationThread.acquireSnapshot();
+    const SimulationState simulationState = SimulationThread::interpolate(snapshot, now);
+    const double simulationMs = std::clamp((simulationState.time - renderedSimulationTime) * 1000.0, 0.0, 100.0);
+    renderedSimulationTime = std::max(renderedSimulationTime, simulationState.time);
+    
+    SubmitScheduler& computeScheduler = queue.getComputeScheduler();
+    SubmitScheduler& graphicsScheduler = queue.getGraphicsScheduler();
+    
+    const auto waitStart = std::chrono::steady_clock::now();
+    computeScheduler.waitFor(logicalDevice, computeValues[currentFrame]);
+    graphicsScheduler.waitFor(logicalDevice, graphicsValues[currentFrame]);
+    const double waitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+    deletionQueue.collect(logicalDevice, currentFrame);
+    // Recreated before anything is recorded against the old extents, frames still in flight keep the retired ones
+    if (swapChainsOutOfDate)
+    {
+        recreateSwapChains();
+    }
+    pipeline.updatePipelines(deletionQueue, currentFrame);
+    meshRenderer.updatePipelines(deletionQueue, currentFrame);
+    frameCapture.poll(logicalDevice, graphicsScheduler.getTimeline().getValue(logicalDevice));
+    collectTimings(cpuFrameMs, snapshot);
+    
+    // Overlapped, a frame presents the post chain of the previous one, which runs while this one renders
+    bool present = !postOverlap || frameIndex > chainStartFrame;
+    const uint64_t presentFrame = postOverlap ? frameIndex - 1 : frameIndex;
+    
+    if (present)
+    {
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            View& view = views[i];
+            const VkResult result = vkAcquireNextImageKHR(logicalDevice, view.swapChain.getSwapChain(), UINT64_MAX, view.frameSync.getImageAvailableSemaphore(currentFrame), VK_NULL_HANDLE, &view.imageIndex);
+            if (result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                // Nothing waits on the semaphores of this frame, the next one recreates the swap chains
+                swapChainsOutOfDate = true;
+                present = false;
+                break;
+            } else if (result == VK_SUBOPTIMAL_KHR)
+            {
+                swapChainsOutOfDate = true;
+            } else if (result != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to acquire swap chain image!");
+            }
+        }
+    }
+    
+    // Compute advances the simulation for the next frame while this frame draws the current state.
+    // It overwrites the buffer the previous graphics frame reads
+    SubmitRequest computeRequest;
+    computeRequest.commandBuffers.push_back(simulation.recordFrame(frameIndex, static_cast<float>(simulationMs * 1e-3)));
+    if (lastGeometryValue > 0)
+    {
+        computeRequest.addWait(graphicsScheduler.getTimeline().getSemaphore(), VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, lastGeometryValue);
+    }
+    
+    const VkCommandBuffer commandBuffer = commandPool.getCommandBuffer(currentFrame);
+    vkResetCommandBuffer(commandBuffer, 0);
+    recordCommandBuffer(commandBuffer);
+    
+    // Particles drawn by frame N were written by compute frame N - 1. One submission covers every view
+    SubmitRequest graphicsRequest;
+    graphicsRequest.commandBuffers.push_back(commandBuffer);
+    if (lastComputeValue > 0)
+    {
+        graphicsRequest.addWait(computeScheduler.getTimeline().getSemaphore(), VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR, lastComputeValue);
+    }
+    
+    lastComputeValue = computeScheduler.enqueue(std::move(computeRequest));
+    lastGeometryValue = graphicsScheduler.enqueue(std::move(graphicsRequest));
+    queue.flush();
+    
+    // Enqueued after the flush, so it can wait on the scene it post-processes
+    SubmitRequest postRequest;
+    postRequest.commandBuffers.push_back(postChain.recordFrame(frameIndex));
+    postRequest.addWait(graphicsScheduler.getTimeline().getSemaphore(), VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, lastGeometryValue);
+    computeValues[currentFrame] = postValues[currentFrame] = computeScheduler.enqueue(std::move(postRequest));
+    
+    std::vector<VkSemaphore> renderFinishedSemaphores(viewCount);
+    std::vector<VkSwapchainKHR> swapChains(viewCount);
+    std::vector<uint32_t> imageIndices(viewCount);
+    if (present)
+    {
+        // The slot's vertices were last drawn by the composite waited for above
+        if (hudEnabled)
+        {
+            hud.buildFrame(currentFrame);
+        }
+        
+        const VkCommandBuffer compositeBuffer = commandPool.getCommandBuffer(MAX_FRAMES_IN_FLIGHT + currentFrame);
+        vkResetCommandBuffer(compositeBuffer, 0);
+        recordCompositeCommandBuffer(compositeBuffer, presentFrame);
+        
+        SubmitRequest compositeRequest;
+        compositeRequest.commandBuffers.push_back(compositeBuffer);
+        // A shared scheduler submits the chain ahead of the copy in the same batch and cmdComposite orders them,
+        // waiting on its value would wait on the end of that batch
+        if (&computeScheduler != &graphicsScheduler)
+        {
+            compositeRequest.addWait(computeScheduler.getTimeline().getSemaphore(), VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, postValues[presentFrame % MAX_FRAMES_IN_FLIGHT]);
+        }
+        
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            const View& view = views[i];
+            renderFinishedSemaphores[i] = view.frameSync.getRenderFinishedSemaphore(currentFrame);
+            swapChains[i] = view.swapChain.getSwapChain();
+            imageIndices[i] = view.imageIndex;
+            
+            compositeRequest.addWait(view.frameSync.getImageAvailableSemaphore(currentFrame), VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR);
+            compositeRequest.addSignal(renderFinishedSemaphores[i], VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR);
+        }
+        
+        graphicsValues[currentFrame] = graphicsScheduler.enqueue(std::move(compositeRequest));
+        frameCapture.commitFrame(graphicsValues[currentFrame]);
+    } else
+    {
+        graphicsValues[currentFrame] = lastGeometryValue;
+    }
+    queue.flush();
+    
+    if (present)
+    {
+        // All swap chains go out in a single present
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = viewCount;
+        presentInfo.pWaitSemaphores = renderFinishedSemaphores.data();
+        presentInfo.swapchainCount = viewCount;
+        presentInfo.pSwapchains = swapChains.data();
+        presentInfo.pImageIndices = imageIndices.data();
+        
+        const VkResult result = vkQueuePresentKHR(queue.getPresentQueue(), &presentInfo);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+        {
+            swapChainsOutOfDate = true;
+        } else if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to present swap chain image!");
+        }
+    }
+    queue.endFrame();
+    
+    if (present && timeToFirstFrameMs == 0.0)
+    {
+        timeToFirstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupTime).count();
+        std::cout << "[startup] time to first frame: " << timeToFirstFrameMs << " ms" << std::endl;
+    }
+    hostAllocator.resetArena();
+    capture::endFrame();
+    
+    lastCpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - now).count() - waitMs;
+    frameIndex++;
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+
+void VulkanProject::waitIdle(void)
+{
+    vkDeviceWaitIdle(device.getLogicalDevice());
+}
+
+
+void VulkanProject::requestFrame(void)
+{
+    framePacer.markDirty(DirtyFlag::Scene);
+}
+
+
+const double VulkanProject::getTimeToFirstFrame(void) const
+{
+    return timeToFirstFrameMs;
+}
+
+
+const PostTimings& VulkanProject::getPostTimings(void) const
+{
+    return postTimings;
+}
+
+
+const PerfMetrics& VulkanProject::getPerfMetrics(void) const
+{
+    return hud.getMetrics();
+}
+
+
+bool VulkanProject::shouldClose(void) const
+{
+    // Closing any view ends the app
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        if (glfwWindowShouldClose(views[i].window.window))
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+
+void VulkanProject::mainLoop(void)
+{
+    std::vector<GLFWwindow*> windows(viewCount);
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        windows[i] = views[i].window.window;
+    }
+    
+    // Overlapped, the last change reaches the screen with the frame after it
+    const PacingMode pacingMode = FramePacer::modeFromEnvironment(RENDER_ON_DEMAND ? PacingMode::OnDemand : PacingMode::Continuous);
+    framePacer.setupPacer(pacingMode, windows, postOverlap ? 1 : 0, [this](const KeyEvent& event)
+    {
+        simulationThread.pushKey(event);
+    });
+    
+    while (!shouldClose())
+    {
+        if (framePacer.waitForFrame())
+        {
+            drawFrame();
+            framePacer.endFrame();
+        }
+    }
+    
+    waitIdle();
+}
+
+
+void VulkanProject::cleanup(void)
+{
+    const VkDevice logicalDevice = device.getLogicalDevice();
+    
+    simulationThread.stopThread();
+    
+    // Pipelines still compiling in the background use the job system and the pipeline cache
+    pipeline.report(std::cout, "particles");
+    meshRenderer.report(std::cout);
+    pipeline.destroyGraphicsPipeline(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_PIPELINE));
+    meshRenderer.destroyMeshRenderer(logicalDevice, &hostAllocator);
+    jobSystem.report(std::cout);
+    jobSystem.destroyJobSystem();
+    
+    // mainLoop has waited for the device to go idle
+    capture::closeCapture(std::cout);
+    deletionQueue.flush(logicalDevice);
+    frameCapture.destroyCapture(logicalDevice, &hostAllocator);
+    frameCapture.report(std::cout);
+    framePacer.report(std::cout);
+    pipelineCache.saveCacheFile(logicalDevice, PIPELINE_CACHE_PATH);
+    pipelineCache.destroyCache(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_PIPELINE_CACHE));
+    simulation.destroySimulation(logicalDevice, &hostAllocator);
+    postChain.destroyPostChain(logicalDevice, &hostAllocator);
+    hud.report(std::cout);
+    if (hudEnabled)
+    {
+        hud.destroyHud(logicalDevice, &hostAllocator);
+    }
+    layoutCache.destroyLayoutCache();
+    graphicsTimer.destroyTimer(logicalDevice);
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        views[i].frameSync.destroySyncObjects(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+    }
+    commandPool.destroyCommandPool(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+    capture::destroyRenderPass(logicalDevice, renderPass, hostAllocator.getCallbacks(VK_OBJECT_TYPE_RENDER_PASS));
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        views[i].swapChain.destroyFramebuffers(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+        views[i].swapChain.destroyImageViews(logicalDevice, {hostAllocator.getCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW)});
+        views[i].swapChain.destroySwapChain(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+    }
+    queue.destroyQueues(logicalDevice, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+    device.destroyDevices(hostAllocator.getCallbacks(VK_OBJECT_TYPE_DEVICE));
+    VL.destroyDebugMessenger(instance, hostAllocator.getCallbacks(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT));
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        views[i].window.destroySurface(instance, hostAllocator.getCallbacks(VK_OBJECT_TYPE_SURFACE_KHR));
+    }
+    vkDestroyInstance(instance, hostAllocator.getCallbacks(VK_OBJECT_TYPE_INSTANCE));
+    for (uint32_t i = 0; i < viewCount; i++)
+    {
+        views[i].window.destroyWindow();
+    }
+    glfwTerminate();
+    
+    hostAllocator.report(std::cout);
+    hostAllocator.destroyAllocator();
+}
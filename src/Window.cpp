@@ -1,17 +1,24 @@
 #include "Window.hpp"
 
 
-void Window::setupWindow(void)
+void Window::setupPlatform(void)
+{
+    if (glfwInit() != GLFW_TRUE)
+    {
+        throw std::runtime_error("Failed to initialize GLFW!");
+    }
+}
+
+
+void Window::setupWindow(const char* title)
 {
-    glfwInit();
-    
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
     glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
+    window = glfwCreateWindow(WIDTH, HEIGHT, title, nullptr, nullptr);
 }
 
 
-void Window::setupSurface(const VkInstance instance, VkAllocationCallbacks* pAllocator)
+void Window::setupSurface(const VkInstance instance, const VkAllocationCallbacks* pAllocator)
 {
     if (glfwCreateWindowSurface(instance, window, pAllocator, &surface) != VK_SUCCESS)
     {
@@ -29,7 +36,7 @@ void Window::destroyWindow(void)
 }
 
 
-void Window::destroySurface(const VkInstance instance, VkAllocationCallbacks* pAllocator)
+void Window::destroySurface(const VkInstance instance, const VkAllocationCallbacks* pAllocator)
 {
     if (surface != VK_NULL_HANDLE)
     {
@@ -0,0 +1,135 @@
+#include "AssetPack.hpp"
+#include "TaskGraph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+using Clock = std::chrono::steady_clock;
+
+struct AssetPackOptions
+{
+    std::vector<std::string> inputs;
+    std::string output = "assets.vpak";
+    // Inputs are read from here and named relative to it, the way the runtime looks them up
+    std::string root = ".";
+    uint32_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    AssetCompression compression = AssetCompression::None;
+    // Extensions kept uncompressed so they can be used straight from the mapping
+    std::vector<std::string> storedExtensions;
+};
+
+
+static bool hasExtension(const std::string& name, const std::vector<std::string>& extensions)
+{
+    for (const auto& extension : extensions)
+    {
+        if (name.size() >= extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static bool parseOptions(int argc, char** argv, AssetPackOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--output" && hasValue)
+        {
+            options.output = argv[++i];
+        } else if (arg == "--root" && hasValue)
+        {
+            options.root = argv[++i];
+        } else if (arg == "--jobs" && hasValue)
+        {
+            options.jobs = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--compress" && hasValue)
+        {
+            const std::string value = argv[++i];
+            if (value == "lz4")
+            {
+                options.compression = AssetCompression::Lz4;
+            } else if (value == "none")
+            {
+                options.compression = AssetCompression::None;
+            } else
+            {
+                return false;
+            }
+        } else if (arg == "--store" && hasValue)
+        {
+            options.storedExtensions.push_back(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-')
+        {
+            options.inputs.push_back(arg);
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return !options.inputs.empty();
+}
+
+
+// Packs loose asset files into one archive for AssetPack, reading and compressing them on --jobs threads
+int main(int argc, char** argv)
+{
+    AssetPackOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--output PACK] [--root DIR] [--jobs N] [--compress none|lz4] [--store .EXT]... asset..." << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::vector<PackedAsset> packedAssets(options.inputs.size());
+    TaskGraph graph;
+    for (size_t i = 0; i < options.inputs.size(); i++)
+    {
+        graph.addTask("pack " + options.inputs[i], [&options, &packedAssets, i]()
+        {
+            const std::string& name = options.inputs[i];
+            const AssetCompression compression = hasExtension(name, options.storedExtensions) ? AssetCompression::None : options.compression;
+            packedAssets[i] = assets::packAsset(name, utils::readFile(options.root + "/" + name), compression);
+        });
+    }
+    
+    const auto start = Clock::now();
+    try
+    {
+        graph.run(options.jobs - 1);
+        assets::writePack(options.output, packedAssets);
+    } catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    const double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    
+    uint64_t rawBytes = 0;
+    uint64_t storedBytes = 0;
+    size_t compressedCount = 0;
+    for (const PackedAsset& asset : packedAssets)
+    {
+        rawBytes += asset.rawSize;
+        storedBytes += asset.data.size();
+        compressedCount += asset.compression != AssetCompression::None ? 1 : 0;
+    }
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "[pack] " << packedAssets.size() << " assets (" << compressedCount << " compressed), " << rawBytes / 1024.0 << " KB in "
+              << storedBytes / 1024.0 << " KB, written to " << options.output << " in " << totalMs << " ms" << std::endl;
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+#include "CaptureReplay.hpp"
+#include "Instance.hpp"
+#include "Device.hpp"
+#include "Window.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+
+struct ReplayOptions
+{
+    bool headless = false;
+    bool paced = false;
+    std::string csvPath;
+    std::string capturePath;
+};
+
+struct ReplayStats
+{
+    double min = 0.0;
+    double median = 0.0;
+    double p95 = 0.0;
+    double max = 0.0;
+};
+
+
+static bool parseOptions(int argc, char** argv, ReplayOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--headless")
+        {
+            options.headless = true;
+        } else if (arg == "--paced")
+        {
+            options.paced = true;
+        } else if (arg == "--csv" && hasValue)
+        {
+            options.csvPath = argv[++i];
+        } else if (options.capturePath.empty() && arg.rfind("--", 0) != 0)
+        {
+            options.capturePath = arg;
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return !options.capturePath.empty();
+}
+
+
+static void setPlatformHint(const bool headless)
+{
+    if (!headless)
+    {
+        return;
+    }
+
+#if GLFW_VERSION_MAJOR > 3 || GLFW_VERSION_MINOR >= 4
+    // GLFW_PLATFORM_NULL is new in 3.4, it hands out VK_EXT_headless_surface surfaces, which lavapipe supports
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+    throw std::runtime_error("Headless runs need GLFW 3.4 or newer!");
+#endif
+}
+
+
+static VkInstance createInstance(InstanceCapabilities& capabilities)
+{
+    stringVector extensions = Instance::getRequiredInstanceExtensions();
+    capabilities = Instance::negotiateCapabilities(extensions);
+    
+    VkApplicationInfo appInfo{};
+    Instance::populateApplicationInfo(appInfo, capabilities.apiVersion);
+    
+    VkInstanceCreateInfo createInfo{};
+    VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
+    Instance::populateInstanceCreateInfo(createInfo, appInfo, debugCreateInfo, extensions, capabilities);
+    
+    VkInstance instance;
+    if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create instance!");
+    }
+    
+    return instance;
+}
+
+
+static ReplayStats summarize(std::vector<double> samples)
+{
+    ReplayStats stats;
+    if (samples.empty())
+    {
+        return stats;
+    }
+    
+    std::sort(samples.begin(), samples.end());
+    
+    const size_t count = samples.size();
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.median = (count % 2 == 1) ? samples[count / 2] : 0.5 * (samples[count / 2 - 1] + samples[count / 2]);
+    stats.p95 = samples[std::min(count - 1, static_cast<size_t>(0.95 * static_cast<double>(count)))];
+    return stats;
+}
+
+
+static void printDevice(const char* label, const std::string& name, const uint32_t apiVersion, const uint32_t driverVersion)
+{
+    std::cout << label << name << " (Vulkan " << VK_API_VERSION_MAJOR(apiVersion) << "." << VK_API_VERSION_MINOR(apiVersion) << "." << VK_API_VERSION_PATCH(apiVersion)
+              << ", driver " << driverVersion << ")" << std::endl;
+}
+
+
+static void printStats(const char* label, const ReplayStats& stats)
+{
+    std::cout << label << "min " << stats.min << " ms, median " << stats.median << " ms, p95 " << stats.p95 << " ms, max " << stats.max << " ms" << std::endl;
+}
+
+
+static void writeCsv(const std::string& path, const std::vector<ReplayFrame>& frames)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    
+    file << std::fixed << std::setprecision(4);
+    file << "frame,recorded_ms,cpu_ms,gpu_ms\n";
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        file << i << "," << frames[i].recordedMs << "," << frames[i].cpuMs << "," << frames[i].gpuMs << "\n";
+    }
+}
+
+
+// Replays a capture written with VULKAN_COMMAND_CAPTURE on whatever device this machine picks, so the same frames
+// can be timed across drivers and GPUs without the app's windowing, input or scene setup
+int main(int argc, char** argv)
+{
+    ReplayOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--headless] [--paced] [--csv FILE] capture.vcap" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::vector<ReplayFrame> frames;
+    
+    try
+    {
+        setPlatformHint(options.headless);
+        
+        // Only a surface for device selection, nothing is presented
+        Window window;
+        Window::setupPlatform();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window.setupWindow("capture_replay");
+        
+        InstanceCapabilities instanceCapabilities;
+        const VkInstance instance = createInstance(instanceCapabilities);
+        window.setupSurface(instance);
+        
+        Device device;
+        device.setupDevices(instance, instanceCapabilities, {window.getSurface()});
+        const VkDevice logicalDevice = device.getLogicalDevice();
+        
+        Queue queue;
+        queue.setupQueues(logicalDevice, device.getQIndices(), device.getCapabilities().synchronization2);
+        
+        CaptureReplayer replayer;
+        replayer.setupReplayer(device.getPhysicalDevice(), logicalDevice, device.getQIndices(), queue);
+        replayer.replay(options.capturePath, options.paced, frames);
+        
+        const CaptureHeader& header = replayer.getHeader();
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+        printDevice("[replay] captured on ", header.deviceName, header.apiVersion, header.driverVersion);
+        printDevice("[replay] replayed on ", properties.deviceName, properties.apiVersion, properties.driverVersion);
+        
+        replayer.destroyReplayer(logicalDevice);
+        queue.destroyQueues(logicalDevice);
+        device.destroyDevices();
+        window.destroySurface(instance);
+        vkDestroyInstance(instance, nullptr);
+        window.destroyWindow();
+        glfwTerminate();
+        
+        if (!options.csvPath.empty())
+        {
+            writeCsv(options.csvPath, frames);
+        }
+    } catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    // The first frame also creates every object and uploads the initial data
+    const size_t first = frames.size() > 1 ? 1 : 0;
+    std::vector<double> cpuSamples;
+    std::vector<double> gpuSamples;
+    for (size_t i = first; i < frames.size(); i++)
+    {
+        cpuSamples.push_back(frames[i].cpuMs);
+        gpuSamples.push_back(frames[i].gpuMs);
+    }
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "[replay] " << frames.size() << " frames" << (options.paced ? " paced" : "") << ", stats from frame " << first << std::endl;
+    printStats("[replay] cpu ", summarize(cpuSamples));
+    printStats("[replay] gpu ", summarize(gpuSamples));
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,462 @@
+#include "MeshOptimizer.hpp"
+#include "TaskGraph.hpp"
+#include "VertexFormat.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+
+using Clock = std::chrono::steady_clock;
+
+struct MeshOptimizerOptions
+{
+    std::vector<std::string> inputs;
+    std::string outputDir;
+    uint32_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    // Including the full detail one, each next level targets half the triangles
+    uint32_t lodCount = 4;
+    float lodError = 0.02f;
+    uint32_t cacheSize = mesh::DEFAULT_CACHE_SIZE;
+    // Writes QuantizedVertex instead of MeshVertex
+    bool quantize = false;
+};
+
+struct MeshJob
+{
+    std::string input;
+    std::string output;
+    MeshData mesh;
+    std::vector<std::vector<uint32_t>> lodIndices;
+    std::vector<float> lodErrors;
+    VertexCacheStats before;
+    VertexCacheStats after;
+    uint32_t vertexCount = 0;
+    Clock::time_point start;
+    double totalMs = 0.0;
+};
+
+// One corner of an OBJ face, indices are 1-based and 0 when missing
+struct ObjCorner
+{
+    int position;
+    int uv;
+    int normal;
+    
+    bool operator==(const ObjCorner& other) const
+    {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+struct ObjCornerHash
+{
+    size_t operator()(const ObjCorner& corner) const
+    {
+        return (static_cast<size_t>(corner.position) * 73856093u) ^ (static_cast<size_t>(corner.uv) * 19349663u) ^ (static_cast<size_t>(corner.normal) * 83492791u);
+    }
+};
+
+
+static double elapsedMs(const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+
+// Negative indices count back from the last element read so far
+static int resolveObjIndex(const int index, const size_t count)
+{
+    return index < 0 ? static_cast<int>(count) + index + 1 : index;
+}
+
+
+static ObjCorner parseObjCorner(const std::string& token, const size_t positionCount, const size_t uvCount, const size_t normalCount)
+{
+    ObjCorner corner{0, 0, 0};
+    const char* text = token.c_str();
+    char* end = nullptr;
+    
+    corner.position = resolveObjIndex(static_cast<int>(std::strtol(text, &end, 10)), positionCount);
+    if (*end == '/')
+    {
+        text = end + 1;
+        if (*text != '/')
+        {
+            corner.uv = resolveObjIndex(static_cast<int>(std::strtol(text, &end, 10)), uvCount);
+        }
+        
+        if (*end == '/')
+        {
+            corner.normal = resolveObjIndex(static_cast<int>(std::strtol(end + 1, &end, 10)), normalCount);
+        }
+    }
+    
+    if (corner.position <= 0 || static_cast<size_t>(corner.position) > positionCount || static_cast<size_t>(corner.uv) > uvCount || static_cast<size_t>(corner.normal) > normalCount)
+    {
+        throw std::runtime_error("Invalid face corner " + token + "!");
+    }
+    
+    return corner;
+}
+
+
+// Positions with optional vertex colors, texture coordinates, normals and polygon faces. Smooth normals are
+// generated when the file has none, tangents always
+static void loadObj(const std::string& path, MeshData& mesh)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + path + "!");
+    }
+    
+    std::vector<float> positions;
+    std::vector<float> colors;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners;
+    std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> cornerVertices;
+    
+    std::string line;
+    std::vector<uint32_t> polygon;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+        
+        if (type == "v")
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            positions.insert(positions.end(), {x, y, z});
+            
+            // Common extension: v x y z r g b
+            float r = 1.0f, g = 1.0f, b = 1.0f;
+            if (!(stream >> r >> g >> b))
+            {
+                r = g = b = 1.0f;
+            }
+            colors.insert(colors.end(), {r, g, b, 1.0f});
+        } else if (type == "vt")
+        {
+            float u = 0.0f, v = 0.0f;
+            stream >> u >> v;
+            // OBJ puts the origin at the bottom left, Vulkan samples from the top left
+            uvs.insert(uvs.end(), {u, 1.0f - v});
+        } else if (type == "vn")
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            normals.insert(normals.end(), {x, y, z});
+        } else if (type == "f")
+        {
+            polygon.clear();
+            std::string token;
+            while (stream >> token)
+            {
+                const ObjCorner corner = parseObjCorner(token, positions.size() / 3, uvs.size() / 2, normals.size() / 3);
+                const auto inserted = cornerVertices.emplace(corner, static_cast<uint32_t>(corners.size()));
+                if (inserted.second)
+                {
+                    corners.push_back(corner);
+                }
+                polygon.push_back(inserted.first->second);
+            }
+            
+            for (size_t i = 2; i < polygon.size(); i++)
+            {
+                mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i - 1], polygon[i]});
+            }
+        }
+    }
+    
+    if (mesh.indices.empty())
+    {
+        throw std::runtime_error(path + " has no faces!");
+    }
+    
+    // Area-weighted face normals summed per position, shared by every corner at that position
+    std::vector<float> smoothNormals;
+    if (normals.empty())
+    {
+        smoothNormals.assign(positions.size(), 0.0f);
+        for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        {
+            const float* p[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = &positions[(corners[mesh.indices[i + k]].position - 1) * 3];
+            }
+            
+            const float e1[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+            const float e2[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+            const float normal[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            
+            for (int k = 0; k < 3; k++)
+            {
+                float* target = &smoothNormals[(corners[mesh.indices[i + k]].position - 1) * 3];
+                target[0] += normal[0];
+                target[1] += normal[1];
+                target[2] += normal[2];
+            }
+        }
+        
+        for (size_t i = 0; i < smoothNormals.size(); i += 3)
+        {
+            const float length = std::sqrt(smoothNormals[i] * smoothNormals[i] + smoothNormals[i + 1] * smoothNormals[i + 1] + smoothNormals[i + 2] * smoothNormals[i + 2]);
+            for (int k = 0; k < 3; k++)
+            {
+                smoothNormals[i + k] = length > 0.0f ? smoothNormals[i + k] / length : 0.0f;
+            }
+        }
+    }
+    
+    mesh.vertices.resize(corners.size());
+    for (size_t v = 0; v < corners.size(); v++)
+    {
+        const ObjCorner& corner = corners[v];
+        MeshVertex& vertex = mesh.vertices[v];
+        const float* normal = corner.normal > 0 ? &normals[(corner.normal - 1) * 3] : nullptr;
+        if (normal == nullptr && !smoothNormals.empty())
+        {
+            normal = &smoothNormals[(corner.position - 1) * 3];
+        }
+        
+        for (int k = 0; k < 3; k++)
+        {
+            vertex.position[k] = positions[(corner.position - 1) * 3 + k];
+            vertex.normal[k] = normal != nullptr ? normal[k] : 0.0f;
+        }
+        vertex.uv[0] = corner.uv > 0 ? uvs[(corner.uv - 1) * 2] : 0.0f;
+        vertex.uv[1] = corner.uv > 0 ? uvs[(corner.uv - 1) * 2 + 1] : 0.0f;
+        std::copy(&colors[(corner.position - 1) * 4], &colors[(corner.position - 1) * 4] + 4, vertex.color);
+    }
+    
+    mesh::generateTangents(mesh.indices, mesh.vertices);
+}
+
+
+static std::string outputPath(const std::string& input, const std::string& outputDir)
+{
+    const size_t slash = input.find_last_of("/\\");
+    const size_t dot = input.find_last_of('.');
+    const std::string stem = input.substr(0, dot != std::string::npos && (slash == std::string::npos || dot > slash) ? dot : input.size());
+    
+    if (outputDir.empty())
+    {
+        return stem + ".vmesh";
+    }
+    
+    return outputDir + "/" + stem.substr(slash == std::string::npos ? 0 : slash + 1) + ".vmesh";
+}
+
+
+// Load and optimize the full detail level, then every coarser level in parallel from it, then pack and write the file
+static void addMeshTasks(TaskGraph& graph, MeshJob& job, const MeshOptimizerOptions& options)
+{
+    job.lodIndices.resize(options.lodCount);
+    job.lodErrors.assign(options.lodCount, 0.0f);
+    
+    const TaskGraph::TaskId load = graph.addTask("load " + job.input, [&job, &options]()
+    {
+        job.start = Clock::now();
+        loadObj(job.input, job.mesh);
+        
+        const uint32_t vertexCount = static_cast<uint32_t>(job.mesh.vertices.size());
+        job.before = mesh::analyzeVertexCache(job.mesh.indices, vertexCount, options.cacheSize);
+        
+        job.lodIndices[0] = job.mesh.indices;
+        mesh::optimizeVertexCache(job.lodIndices[0], vertexCount);
+        mesh::optimizeOverdraw(job.lodIndices[0], job.mesh.vertices);
+    });
+    
+    std::vector<TaskGraph::TaskId> lods;
+    for (uint32_t level = 1; level < options.lodCount; level++)
+    {
+        lods.push_back(graph.addTask("lod " + std::to_string(level) + " " + job.input, [&job, &options, level]()
+        {
+            const std::vector<uint32_t>& source = job.lodIndices[0];
+            const size_t target = (source.size() / 3 >> level) * 3;
+            
+            std::vector<uint32_t>& indices = job.lodIndices[level];
+            indices = mesh::simplify(source, job.mesh.vertices, target, options.lodError, job.lodErrors[level]);
+            mesh::optimizeVertexCache(indices, static_cast<uint32_t>(job.mesh.vertices.size()));
+            mesh::optimizeOverdraw(indices, job.mesh.vertices);
+        }, {load}));
+    }
+    
+    graph.addTask("pack " + job.input, [&job, &options]()
+    {
+        MeshData& mesh = job.mesh;
+        mesh.indices.clear();
+        
+        // Levels that failed to shrink by at least a tenth add nothing over the previous one
+        for (uint32_t level = 0; level < job.lodIndices.size(); level++)
+        {
+            const std::vector<uint32_t>& indices = job.lodIndices[level];
+            if (level > 0 && indices.size() * 10 > mesh.lods.back().indexCount * 9)
+            {
+                break;
+            }
+            
+            MeshLod lod{};
+            lod.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+            lod.indexCount = static_cast<uint32_t>(indices.size());
+            lod.error = job.lodErrors[level];
+            mesh.lods.push_back(lod);
+            mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+        }
+        
+        // One remap over all levels, the full detail one decides the vertex order
+        mesh::optimizeVertexFetch(mesh.vertices, mesh.indices);
+        
+        for (auto& lod : mesh.lods)
+        {
+            lod.meshletOffset = static_cast<uint32_t>(mesh.meshlets.size());
+            mesh::buildMeshlets(mesh.indices, lod.indexOffset, lod.indexCount, mesh);
+            lod.meshletCount = static_cast<uint32_t>(mesh.meshlets.size()) - lod.meshletOffset;
+        }
+        
+        for (int k = 0; k < 3; k++)
+        {
+            mesh.boundsMin[k] = mesh.boundsMax[k] = mesh.vertices[0].position[k];
+        }
+        for (const auto& vertex : mesh.vertices)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                mesh.boundsMin[k] = std::min(mesh.boundsMin[k], vertex.position[k]);
+                mesh.boundsMax[k] = std::max(mesh.boundsMax[k], vertex.position[k]);
+            }
+        }
+        
+        const std::vector<uint32_t> fullDetail(mesh.indices.begin(), mesh.indices.begin() + mesh.lods[0].indexCount);
+        job.after = mesh::analyzeVertexCache(fullDetail, static_cast<uint32_t>(mesh.vertices.size()), options.cacheSize);
+        job.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        
+        if (options.quantize)
+        {
+            vertex::quantizeMesh(mesh);
+        }
+        
+        mesh::saveMesh(job.output, mesh);
+        job.totalMs = elapsedMs(job.start);
+    }, lods.empty() ? std::vector<TaskGraph::TaskId>{load} : lods);
+}
+
+
+static void reportMesh(const MeshJob& job)
+{
+    const MeshData& mesh = job.mesh;
+    
+    std::cout << "[mesh] " << job.input << " -> " << job.output << ": " << job.vertexCount << " vertices of " << vertex::getVertexStride(mesh.vertexLayout) << " bytes, "
+              << mesh.lods[0].indexCount / 3 << " triangles, " << job.totalMs << " ms" << std::endl;
+    std::cout << "[mesh]   ACMR " << job.before.acmr << " -> " << job.after.acmr << ", ATVR " << job.before.atvr << " -> " << job.after.atvr << std::endl;
+    
+    for (size_t level = 0; level < mesh.lods.size(); level++)
+    {
+        const MeshLod& lod = mesh.lods[level];
+        std::cout << "[mesh]   LOD " << level << ": " << lod.indexCount / 3 << " triangles, error " << lod.error << ", " << lod.meshletCount << " meshlets";
+        
+        uint32_t coneCount = 0;
+        for (uint32_t i = lod.meshletOffset; i < lod.meshletOffset + lod.meshletCount; i++)
+        {
+            coneCount += mesh.meshlets[i].coneCutoff < 1.0f ? 1 : 0;
+        }
+        std::cout << " (" << coneCount << " with a culling cone)" << std::endl;
+    }
+}
+
+
+static bool parseOptions(int argc, char** argv, MeshOptimizerOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        
+        if (arg == "--jobs" && hasValue)
+        {
+            options.jobs = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--lods" && hasValue)
+        {
+            options.lodCount = static_cast<uint32_t>(std::min(8, std::max(1, std::atoi(argv[++i]))));
+        } else if (arg == "--lod-error" && hasValue)
+        {
+            options.lodError = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+        } else if (arg == "--cache-size" && hasValue)
+        {
+            options.cacheSize = static_cast<uint32_t>(std::max(3, std::atoi(argv[++i])));
+        } else if (arg == "--quantize")
+        {
+            options.quantize = true;
+        } else if (arg == "--output-dir" && hasValue)
+        {
+            options.outputDir = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-')
+        {
+            options.inputs.push_back(arg);
+        } else
+        {
+            return false;
+        }
+    }
+    
+    return !options.inputs.empty();
+}
+
+
+// Optimizes OBJ meshes offline into .vmesh files: cache, overdraw and fetch order, LODs, meshlets and
+// optionally quantized vertices
+int main(int argc, char** argv)
+{
+    MeshOptimizerOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--jobs N] [--lods N] [--lod-error E] [--cache-size N] [--quantize] [--output-dir DIR] mesh.obj..." << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::vector<std::unique_ptr<MeshJob>> jobs;
+    TaskGraph graph;
+    for (const auto& input : options.inputs)
+    {
+        jobs.push_back(std::make_unique<MeshJob>());
+        jobs.back()->input = input;
+        jobs.back()->output = outputPath(input, options.outputDir);
+        addMeshTasks(graph, *jobs.back(), options);
+    }
+    
+    std::cout << std::fixed << std::setprecision(3);
+    
+    const auto start = Clock::now();
+    try
+    {
+        graph.run(options.jobs - 1);
+    } catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    const double totalMs = elapsedMs(start);
+    
+    for (const auto& job : jobs)
+    {
+        reportMesh(*job);
+    }
+    std::cout << "[mesh] " << jobs.size() << " meshes on " << options.jobs << " threads in " << totalMs << " ms" << std::endl;
+    
+    return EXIT_SUCCESS;
+}